@@ -0,0 +1,142 @@
+// Compares ArcFitter::do_arc_fitting() with the pointwise fitter it replaced on the extrusion paths of sliced models.
+// Usage: arc_fitting [model.obj|model.stl|model.3mf ...], the models of tests/data are sliced by default.
+// The paths are sliced with arc fitting disabled, thus they are simplified by Douglas-Peucker at the resolution
+// of the config, a little sparser than the paths the fitter gets during slicing.
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "libslic3r/ArcFitter.hpp"
+#include "libslic3r/ExtrusionEntity.hpp"
+#include "libslic3r/ExtrusionEntityCollection.hpp"
+#include "libslic3r/Layer.hpp"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/Print.hpp"
+
+#include "libnest2d/tools/benchmark.h"
+
+namespace Slic3r {
+
+struct FittedPath
+{
+    Points points;
+    double tolerance;
+};
+
+static void collect_paths(const ExtrusionEntity &entity, double resolution, std::vector<FittedPath> &out)
+{
+    auto add = [resolution, &out](const ExtrusionPath &path) {
+        // The tolerances of LayerRegion::simplify_path().
+        out.push_back({ path.polyline.points, path.role() == erInternalInfill ? double(SCALED_SPARSE_INFILL_RESOLUTION) : resolution });
+    };
+    if (auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+        for (const ExtrusionEntity *e : collection->entities)
+            collect_paths(*e, resolution, out);
+    } else if (auto *path = dynamic_cast<const ExtrusionPath*>(&entity)) {
+        add(*path);
+    } else if (auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(&entity)) {
+        for (const ExtrusionPath &p : multipath->paths)
+            add(p);
+    } else if (auto *loop = dynamic_cast<const ExtrusionLoop*>(&entity)) {
+        for (const ExtrusionPath &p : loop->paths)
+            add(p);
+    }
+}
+
+static std::vector<FittedPath> slice_paths(const std::string &path)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "wall_generator",        "arachne" },
+        { "sparse_infill_pattern", "gyroid" },
+        { "sparse_infill_density", "15%" },
+        { "enable_arc_fitting",    "0" },
+    });
+
+    Model model = Model::read_from_file(path);
+    arrange_objects(model, InfiniteBed{}, ArrangeParams{ scaled(min_object_distance(config)) });
+    Print print;
+    for (ModelObject *mo : model.objects) {
+        mo->ensure_on_bed();
+        print.auto_assign_extruders(mo);
+    }
+    print.apply(model, config);
+    print.validate();
+    print.set_status_silent();
+    print.process();
+
+    std::vector<FittedPath> out;
+    const double resolution = scaled<double>(print.config().resolution.value);
+    for (const PrintObject *object : print.objects()) {
+        for (const Layer *layer : object->layers())
+            for (const LayerRegion *layerm : layer->regions()) {
+                collect_paths(layerm->perimeters, resolution, out);
+                collect_paths(layerm->fills, resolution, out);
+            }
+        for (const SupportLayer *layer : object->support_layers())
+            collect_paths(layer->support_fills, SCALED_SUPPORT_RESOLUTION, out);
+    }
+    return out;
+}
+
+template<typename Fitter>
+static double measure(const std::vector<FittedPath> &paths, std::vector<std::vector<PathFittingData>> &results, Fitter fitter)
+{
+    results.assign(paths.size(), {});
+    Benchmark b;
+    b.start();
+    for (size_t i = 0; i < paths.size(); ++ i)
+        fitter(paths[i].points, results[i], paths[i].tolerance);
+    b.stop();
+    return b.getElapsedSec();
+}
+
+static bool same_fitting(const std::vector<PathFittingData> &lhs, const std::vector<PathFittingData> &rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const PathFittingData &l, const PathFittingData &r) {
+        return l.start_point_index == r.start_point_index && l.end_point_index == r.end_point_index && l.path_type == r.path_type &&
+               l.arc_data.center == r.arc_data.center && l.arc_data.radius == r.arc_data.radius && l.arc_data.angle_radians == r.arc_data.angle_radians;
+    });
+}
+
+} // namespace Slic3r
+
+int main(int argc, char *argv[])
+{
+    using namespace Slic3r;
+
+    std::vector<std::string> models;
+    for (int i = 1; i < argc; ++ i)
+        models.emplace_back(argv[i]);
+    if (models.empty())
+        for (const char *name : { "20mm_cube.obj", "extruder_idler.obj", "frog_legs.obj", "ipadstand.obj", "pyramid.obj", "sloping_hole.obj" })
+            models.emplace_back(std::string(TEST_DATA_DIR) + "/" + name);
+
+    int status = 0;
+    std::cout << "model;paths;points;pointwise [s];batched [s];speedup;same result" << std::endl;
+    for (const std::string &model : models) {
+        std::vector<FittedPath> paths = slice_paths(model);
+        size_t num_points = 0;
+        for (const FittedPath &path : paths)
+            num_points += path.points.size();
+
+        std::vector<std::vector<PathFittingData>> pointwise, batched;
+        // Best of a few runs.
+        double t_pointwise = std::numeric_limits<double>::max();
+        double t_batched   = std::numeric_limits<double>::max();
+        for (int run = 0; run < 3; ++ run) {
+            t_pointwise = std::min(t_pointwise, measure(paths, pointwise, ArcFitter::do_arc_fitting_pointwise));
+            t_batched   = std::min(t_batched,   measure(paths, batched,   ArcFitter::do_arc_fitting));
+        }
+        bool same = std::equal(pointwise.begin(), pointwise.end(), batched.begin(), batched.end(), same_fitting);
+        if (! same)
+            status = 1;
+        std::cout << model << ";" << paths.size() << ";" << num_points << ";" << t_pointwise << ";" << t_batched << ";"
+                  << t_pointwise / std::max(t_batched, 1e-9) << ";" << (same ? "yes" : "NO") << std::endl;
+    }
+    return status;
+}
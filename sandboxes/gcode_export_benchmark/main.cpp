@@ -0,0 +1,215 @@
+// Slices a fixed set of models of tests/data with configs exercising the stages of the G-code export and writes
+// the wall time, number of calls, allocations and allocated bytes of each stage as JSON.
+// Usage: gcode_export_benchmark [--repeat N] [--output file.json] [case ...]
+// The export of each case is repeated N times (3 by default) and the fastest run is reported.
+// Allocations are counted by the replacement of the global operator new below, see AllocationCounters.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "nlohmann/json.hpp"
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r_version.h"
+#include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/ExportStats.hpp"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/Print.hpp"
+
+static void* counted_malloc(std::size_t size)
+{
+    Slic3r::AllocationCounters &counters = Slic3r::thread_allocation_counters();
+    ++ counters.allocations;
+    counters.bytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size)
+{
+    if (void *p = counted_malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept { return counted_malloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t &) noexcept { return counted_malloc(size); }
+void  operator delete(void *p) noexcept { std::free(p); }
+void  operator delete[](void *p) noexcept { std::free(p); }
+void  operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void  operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void  operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void  operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+namespace Slic3r {
+
+struct BenchmarkCase
+{
+    std::string                                      name;
+    std::vector<std::string>                         models;
+    std::vector<std::pair<std::string, std::string>> config;
+    // Objects after the first one are printed with the second filament.
+    bool                                             multi_material { false };
+};
+
+static const std::vector<BenchmarkCase>& benchmark_cases()
+{
+    static const std::vector<BenchmarkCase> cases {
+        { "default",            { "20mm_cube.obj" }, {} },
+        { "arc_fitting",        { "frog_legs.obj" }, { { "enable_arc_fitting", "1" }, { "wall_generator", "arachne" }, { "sparse_infill_pattern", "gyroid" } } },
+        { "pressure_equalizer", { "extruder_idler.obj" }, { { "max_volumetric_extrusion_rate_slope", "5" } } },
+        // Small layers, which are slowed down for cooling.
+        { "cooling",            { "pyramid.obj" }, { { "slow_down_for_layer_cooling", "1" }, { "slow_down_layer_time", "15" }, { "fan_cooling_layer_time", "60" } } },
+        { "fan_mover",          { "ipadstand.obj" }, { { "fan_speedup_time", "0.5" }, { "fan_kickstart", "0.1" } } },
+        { "adaptive_pa",        { "sloping_hole.obj" }, { { "enable_pressure_advance", "1" }, { "adaptive_pressure_advance", "1" } } },
+        { "wipe_tower",         { "20mm_cube.obj", "pyramid.obj" },
+                                { { "filament_diameter", "1.75,1.75" }, { "filament_colour", "#F2754E;#4E75F2" }, { "enable_prime_tower", "1" } }, true },
+        { "multi_material",     { "20mm_cube.obj", "extruder_idler.obj" },
+                                { { "filament_diameter", "1.75,1.75" }, { "filament_colour", "#F2754E;#4E75F2" }, { "enable_prime_tower", "0" } }, true },
+    };
+    return cases;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static nlohmann::json run_case(const BenchmarkCase &bc, int repeat)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    for (const auto &[key, value] : bc.config)
+        config.set_deserialize_strict(key, value);
+
+    Model model;
+    for (const std::string &name : bc.models) {
+        Model loaded = Model::read_from_file(std::string(TEST_DATA_DIR) + "/" + name);
+        for (ModelObject *mo : loaded.objects)
+            model.add_object(*mo);
+    }
+    for (size_t i = 1; bc.multi_material && i < model.objects.size(); ++ i)
+        model.objects[i]->config.set_key_value("extruder", new ConfigOptionInt(2));
+    arrange_objects(model, InfiniteBed{}, ArrangeParams{ scaled(min_object_distance(config)) });
+
+    Print print;
+    for (ModelObject *mo : model.objects) {
+        mo->ensure_on_bed();
+        print.auto_assign_extruders(mo);
+    }
+    print.apply(model, config);
+    print.validate();
+    print.set_status_silent();
+
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    const double slicing_s = seconds_since(start);
+
+    nlohmann::json   out;
+    double           best_export_s = std::numeric_limits<double>::max();
+    GCodeExportStats best_stats;
+    uint64_t         gcode_bytes = 0;
+    for (int run = 0; run < repeat; ++ run) {
+        // GCode::do_export() skips the export if the step is done and the file exists, thus a new file for each run.
+        const boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("gcode_export_benchmark_%%%%-%%%%.gcode");
+        GCodeProcessorResult result;
+        GCode gcode;
+        const Vec3d origin = print.get_plate_origin();
+        gcode.set_gcode_offset(origin.x(), origin.y());
+        start = std::chrono::steady_clock::now();
+        gcode.do_export(&print, path.string().c_str(), &result);
+        const double export_s = seconds_since(start);
+        if (export_s < best_export_s) {
+            best_export_s = export_s;
+            best_stats    = gcode.export_stats();
+            gcode_bytes   = boost::filesystem::file_size(path);
+        }
+        boost::filesystem::remove(path);
+    }
+
+    size_t num_layers = 0;
+    for (const PrintObject *object : print.objects())
+        num_layers = std::max(num_layers, object->layer_count());
+
+    out["name"]        = bc.name;
+    out["models"]      = bc.models;
+    out["config"]      = nlohmann::json::object();
+    for (const auto &[key, value] : bc.config)
+        out["config"][key] = value;
+    out["layers"]      = num_layers;
+    out["slicing_s"]   = slicing_s;
+    out["export_s"]    = best_export_s;
+    out["gcode_bytes"] = gcode_bytes;
+    nlohmann::json stages = nlohmann::json::object();
+    for (size_t i = 0; i < GCodeExportStats::Count; ++ i) {
+        GCodeExportStats::StageStats s = best_stats.stage(GCodeExportStats::Stage(i));
+        if (s.calls == 0)
+            continue;
+        stages[GCodeExportStats::stage_name(GCodeExportStats::Stage(i))] = {
+            { "time_ms",     double(s.ns) * 1e-6 },
+            { "calls",       s.calls },
+            { "allocations", s.allocations },
+            { "bytes",       s.bytes },
+        };
+    }
+    out["stages"] = std::move(stages);
+    return out;
+}
+
+} // namespace Slic3r
+
+int main(int argc, char *argv[])
+{
+    using namespace Slic3r;
+
+    int                      repeat = 3;
+    std::string              output;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++ i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, atoi(argv[++ i]));
+        else if (arg == "--output" && i + 1 < argc)
+            output = argv[++ i];
+        else
+            selected.emplace_back(std::move(arg));
+    }
+
+    nlohmann::json report;
+    report["version"]  = SLIC3R_VERSION;
+    report["repeat"]   = repeat;
+    report["cases"]    = nlohmann::json::array();
+    int status = 0;
+    for (const BenchmarkCase &bc : benchmark_cases()) {
+        if (! selected.empty() && std::find(selected.begin(), selected.end(), bc.name) == selected.end())
+            continue;
+        try {
+            report["cases"].push_back(run_case(bc, repeat));
+        } catch (const std::exception &ex) {
+            std::cerr << bc.name << ": " << ex.what() << std::endl;
+            report["cases"].push_back({ { "name", bc.name }, { "error", ex.what() } });
+            status = 1;
+        }
+    }
+
+    if (output.empty()) {
+        std::cout << report.dump(4) << std::endl;
+    } else {
+        boost::nowide::ofstream ofs(output);
+        ofs << report.dump(4) << std::endl;
+        if (! ofs.good()) {
+            std::cerr << "Failed to write " << output << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -21,6 +21,11 @@
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <atomic>
+#include <list>
+#include <optional>
+#include <set>
+#include <thread>
 #include <math.h>
 
 #if defined(__linux__) || defined(__LINUX__)
@@ -42,6 +47,13 @@ using namespace nlohmann;
 #include <boost/nowide/filesystem.hpp>
 #include <boost/dll/runtime_symbol_info.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/process.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include "nlohmann/json.hpp"
 
 #include "unix/fhs.hpp"  // Generated by CMake from ../dev-utils/platform/unix/fhs.hpp.in
 
@@ -49,6 +61,7 @@ using namespace nlohmann;
 #include "libslic3r/Config.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/GCodeMetadata.hpp"
 #include "libslic3r/GCode/PostProcessor.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/ModelArrange.hpp"
@@ -66,6 +79,9 @@ using namespace nlohmann;
 #include "libslic3r/Thread.hpp"
 #include "libslic3r/BlacklistedLibraryCheck.hpp"
 #include "libslic3r/FlushVolCalc.hpp"
+#include "libslic3r/InvoiceCost.hpp"
+#include "libslic3r/InvoiceEstimate.hpp"
+#include "libslic3r/InvoiceSweep.hpp"
 
 #include "libslic3r/Orient.hpp"
 #include "libslic3r/PNGReadWrite.hpp"
@@ -150,7 +166,8 @@ std::map<int, std::string> cli_errors = {
     {CLI_FILAMENTS_NOT_SUPPORTED_BY_EXTRUDER, "Some filaments cannot be printed on the extruder mapped to."},
     {CLI_SLICING_ERROR, "Failed slicing the model. Please verify the slicing of all plates on Orca Slicer before uploading."},
     {CLI_GCODE_PATH_CONFLICTS, " G-code conflicts detected after slicing. Please make sure the 3mf file can be successfully sliced in the latest Orca Slicer. If the file slices normally in Orca Slicer, try moving the wipe tower further from other models, as we use more conservative parameters for it during upload."},
-    {CLI_GCODE_PATH_IN_UNPRINTABLE_AREA, "Found G-code in unprintable area of multi-extruder printers after slicing. Please make sure the 3mf file can be successfully sliced in the latest Orca Slicer."}
+    {CLI_GCODE_PATH_IN_UNPRINTABLE_AREA, "Found G-code in unprintable area of multi-extruder printers after slicing. Please make sure the 3mf file can be successfully sliced in the latest Orca Slicer."},
+    {CLI_EXPORT_QUOTE_ERROR, "Failed pricing the sliced plates. Please check the job profile passed to --job-profile."}
 };
 
 typedef struct  _sliced_plate_info{
@@ -1216,6 +1233,11 @@ int CLI::run(int argc, char **argv)
     std::string temp_path = wxFileName::GetTempDir().utf8_str().data();
     set_temporary_dir(temp_path);
 
+    if (std::find(m_actions.begin(), m_actions.end(), "quote_batch") != m_actions.end())
+        return this->quote_batch(argc, argv);
+    if (std::find(m_actions.begin(), m_actions.end(), "quote_gcode") != m_actions.end())
+        return this->quote_gcode();
+
     m_extra_config.apply(m_config, true);
     m_extra_config.normalize_fdm();
 
@@ -5426,6 +5448,26 @@ int CLI::run(int argc, char **argv)
     std::vector<bool> plate_has_skips(partplate_list.get_plate_count(), false);
     std::vector<std::vector<size_t>> plate_skipped_objects(partplate_list.get_plate_count());
 
+    // Orca: price the sliced plates if a job profile was passed in.
+    std::optional<InvoiceJobProfile> invoice_job;
+    std::vector<InvoicePlateQuote>   invoice_quotes;
+    std::vector<InvoiceSweepAxis>    invoice_sweep;
+    if (const std::string &job_profile = m_config.opt_string("job_profile"); !job_profile.empty()) {
+        try {
+            invoice_job = load_invoice_job_profile(job_profile);
+            invoice_sweep = parse_invoice_sweep(m_config.opt_string("quote_sweep"));
+        } catch (const std::exception &ex) {
+            BOOST_LOG_TRIVIAL(error) << ex.what();
+            boost::nowide::cerr << ex.what() << std::endl;
+            record_exit_reson(outfile_dir, CLI_INVALID_PARAMS, 0, cli_errors[CLI_INVALID_PARAMS], sliced_info);
+            flush_and_exit(CLI_INVALID_PARAMS);
+        }
+    }
+
+    // Orca: collect calibration samples of the --quote-estimate estimator from the sliced plates.
+    const std::string                  estimate_calibration = m_config.opt_string("estimate_calibration");
+    std::vector<InvoiceEstimateSample> estimate_samples;
+
     global_current_time = (long long)Slic3r::Utils::get_current_time_utc();
     sliced_info.prepare_time = (size_t) (global_current_time - global_begin_time);
     global_begin_time = global_current_time;
@@ -5480,6 +5522,11 @@ int CLI::run(int argc, char **argv)
             max_triangle_count_per_plate = m_config.option<ConfigOptionInt>("mtcpp")->value;
         } else if (opt_key == "mstpp") {
             max_slicing_time_per_plate = m_config.option<ConfigOptionInt>("mstpp")->value;
+        } else if (opt_key == "quote_estimate") {
+            if (int ret = this->quote_estimate(outfile_dir); ret != CLI_SUCCESS) {
+                record_exit_reson(outfile_dir, ret, 0, cli_errors[ret], sliced_info);
+                flush_and_exit(ret);
+            }
         } else if (opt_key == "export_stl") {
             for (auto &model : m_models)
                 model.add_default_instances();
@@ -5944,6 +5991,8 @@ int CLI::run(int argc, char **argv)
 
                         StringObjectException warning;
                         print_fff->set_check_multi_filaments_compatibility(!allow_mix_temp);
+                        print_fff->set_slice_cache_dir(m_config.opt_string("slice_cache"));
+                        print_fff->set_slice_cache_max_size(size_t(std::max(0, m_config.opt_int("slice_cache_size"))) << 20);
                         auto err = print->validate(&warning);
                         if (!err.string.empty()) {
                             if ((STRING_EXCEPT_LAYER_HEIGHT_EXCEEDS_LIMIT == err.type) && no_check) {
@@ -6132,6 +6181,53 @@ int CLI::run(int argc, char **argv)
                                 //run_post_process_scripts(outfile, print->full_print_config());
                                 BOOST_LOG_TRIVIAL(info) << "Slicing result exported to " << outfile << std::endl;
                                 part_plate->update_slice_result_valid_state(true);
+                                if (invoice_job && printer_technology == ptFFF) {
+                                    const PrintStatistics &stats = print_fff->print_statistics();
+                                    double print_time_hours = gcode_result ?
+                                        gcode_result->print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].time / 3600. :
+                                        invoice_time_to_hours(stats.estimated_normal_print_time);
+                                    InvoicePlateQuote plate_quote { index + 1, outfile,
+                                        calculate_invoice_quote(*invoice_job, print_time_hours, invoice_filament_usage(stats, print_fff->full_print_config())) };
+                                    if (gcode_result)
+                                        plate_quote.objects = calculate_invoice_object_costs(plate_quote.quote, *invoice_job,
+                                            invoice_object_usage(*gcode_result, invoice_object_names(*print_fff)));
+                                    invoice_quotes.push_back(std::move(plate_quote));
+                                    if (!invoice_sweep.empty()) {
+                                        // Variants are sliced by their own Print objects, this plate's Print keeps the result exported above.
+                                        const std::string sweep_dir = outfile_dir.empty() ? fs::path(outfile).parent_path().string() : outfile_dir;
+                                        const std::string plate_name = "plate_" + std::to_string(index + 1);
+                                        std::vector<InvoiceSweepResult> sweep = run_invoice_sweep(model, new_print_config, *invoice_job, invoice_sweep, sweep_dir, plate_name,
+                                            [print_fff](Print &variant_print) {
+                                                variant_print.set_plate_origin(print_fff->get_plate_origin());
+                                                variant_print.is_BBL_printer() = print_fff->is_BBL_printer();
+                                                variant_print.set_no_check_flag(print_fff->get_no_check_flag());
+                                                variant_print.set_extruder_filament_info(print_fff->get_extruder_filament_info());
+                                                variant_print.set_slice_cache_dir(print_fff->slice_cache_dir());
+                                                variant_print.set_slice_cache_max_size(print_fff->slice_cache_max_size());
+                                            },
+                                            size_t(std::max(0, m_config.opt_int("quote_jobs"))));
+                                        std::string sweep_path = (fs::path(sweep_dir) / (plate_name + ".sweep.json")).string();
+                                        boost::nowide::ofstream sweep_file(sweep_path);
+                                        sweep_file << invoice_sweep_to_json(sweep).dump(4);
+                                        sweep_file.close();
+                                        if (sweep_file.fail()) {
+                                            BOOST_LOG_TRIVIAL(error) << "Failed to write " << sweep_path;
+                                            record_exit_reson(outfile_dir, CLI_EXPORT_QUOTE_ERROR, index + 1, cli_errors[CLI_EXPORT_QUOTE_ERROR], sliced_info);
+                                            flush_and_exit(CLI_EXPORT_QUOTE_ERROR);
+                                        }
+                                        BOOST_LOG_TRIVIAL(info) << "plate " << index + 1 << ": priced " << sweep.size() << " variants into " << sweep_path;
+                                    }
+                                }
+                                if (!estimate_calibration.empty() && printer_technology == ptFFF && gcode_result) {
+                                    // Orca: teach the estimator of --quote-estimate the statistics of this plate.
+                                    InvoiceEstimator        estimator(print_fff->full_print_config());
+                                    InvoiceEstimateFeatures features;
+                                    for (const PrintObject *print_object : print_fff->objects())
+                                        for (const PrintInstance &instance : print_object->instances())
+                                            features += estimator.features(*print_object->model_object(), *instance.model_instance);
+                                    estimate_samples.push_back({ features, print_fff->print_statistics().total_extruded_volume,
+                                        gcode_result->print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].time });
+                                }
 #if defined(__linux__) || defined(__LINUX__)
                                 if (g_cli_callback_mgr.is_started()) {
                                     PrintBase::SlicingStatus slicing_status{100, "Slicing finished"};
@@ -6142,7 +6238,9 @@ int CLI::run(int argc, char **argv)
                                     BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ":will export Slicing data to " << export_slice_data_dir;
                                     std::string plate_dir = export_slice_data_dir+"/"+std::to_string(index+1);
                                     bool with_space = (get_logging_level() >= 4)?true:false;
-                                    int ret = print->export_cached_data(plate_dir, with_space);
+                                    const ConfigOptionBool* slicedata_json_option = m_config.option<ConfigOptionBool>("export_slicedata_json");
+                                    bool as_json = slicedata_json_option && slicedata_json_option->value;
+                                    int ret = print->export_cached_data(plate_dir, with_space, as_json);
                                     if (ret) {
                                         BOOST_LOG_TRIVIAL(error) << "plate "<< index+1<< ": export Slicing data error, ret=" << ret;
                                         export_slicedata_error = true;
@@ -6226,6 +6324,27 @@ int CLI::run(int argc, char **argv)
         }
     }
 
+    if (invoice_job && !invoice_quotes.empty()) {
+        std::string quote_path = (outfile_dir.empty() ? std::string(".") : outfile_dir) + "/quote.json";
+        try {
+            save_invoice_quotes(quote_path, m_input_files.empty() ? std::string() : m_input_files.front(), *invoice_job, invoice_quotes);
+        } catch (const std::exception &ex) {
+            BOOST_LOG_TRIVIAL(error) << ex.what();
+            record_exit_reson(outfile_dir, CLI_EXPORT_QUOTE_ERROR, 0, cli_errors[CLI_EXPORT_QUOTE_ERROR], sliced_info);
+            flush_and_exit(CLI_EXPORT_QUOTE_ERROR);
+        }
+    }
+    if (!estimate_samples.empty()) {
+        try {
+            InvoiceEstimateCalibration calibration = load_invoice_estimate_calibration(estimate_calibration);
+            calibration.samples.insert(calibration.samples.end(), estimate_samples.begin(), estimate_samples.end());
+            calibration.coefficients = fit_invoice_estimate(calibration.samples);
+            save_invoice_estimate_calibration(estimate_calibration, calibration);
+        } catch (const std::exception &ex) {
+            // The slicing result is fine, don't fail the whole run.
+            BOOST_LOG_TRIVIAL(error) << ex.what();
+        }
+    }
     global_begin_time = (long long)Slic3r::Utils::get_current_time_utc();
     if (export_to_3mf) {
         //BBS: export as bbl 3mf
@@ -7092,6 +7211,251 @@ bool CLI::setup(int argc, char **argv)
     return true;
 }
 
+int CLI::quote_batch(int argc, char **argv)
+{
+    namespace bp = boost::process;
+
+    const std::string input_dir   = m_config.opt_string("quote_batch");
+    const std::string job_profile = m_config.opt_string("job_profile");
+    std::string       output_dir  = m_config.opt_string("outputdir");
+    if (job_profile.empty() || !fs::is_directory(input_dir)) {
+        boost::nowide::cerr << "--quote-batch needs an existing directory and a --job-profile" << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+    try {
+        // Fail early instead of in every child process.
+        load_invoice_job_profile(job_profile);
+    } catch (const std::exception &ex) {
+        boost::nowide::cerr << ex.what() << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+    if (output_dir.empty())
+        output_dir = (fs::path(input_dir) / "quotes").string();
+    fs::create_directories(output_dir);
+
+    std::vector<fs::path> projects;
+    for (const fs::directory_entry &entry : fs::directory_iterator(input_dir))
+        if (fs::is_regular_file(entry.status()) && boost::iends_with(entry.path().string(), ".3mf"))
+            projects.emplace_back(entry.path());
+    std::sort(projects.begin(), projects.end());
+
+    // Forward the command line to the child processes, except for the batch options, the output directory
+    // and the input files. Options taking a value may pass it in the next token.
+    std::map<std::string, const ConfigOptionDef*> cli_options;
+    for (const auto &[opt_key, optdef] : m_config.def()->options)
+        for (const std::string &arg : optdef.cli_args(opt_key))
+            cli_options[arg] = &optdef;
+    static const std::set<std::string> batch_options = { "quote-batch", "quote-jobs", "outputdir", "slice" };
+    std::vector<std::string> forwarded_args;
+    for (int i = 1; i < argc; ++ i) {
+        std::string token = argv[i];
+        if (!boost::starts_with(token, "-"))
+            continue;
+        std::string name = token.substr(boost::starts_with(token, "--") ? 2 : 1);
+        bool has_value = name.find('=') != std::string::npos;
+        name = name.substr(0, name.find('='));
+        auto it = cli_options.find(name);
+        bool takes_next = it != cli_options.end() && !has_value && it->second->type != coBool && it->second->type != coBools && i + 1 < argc;
+        if (batch_options.count(name) == 0) {
+            forwarded_args.emplace_back(token);
+            if (takes_next)
+                forwarded_args.emplace_back(argv[i + 1]);
+        }
+        if (takes_next)
+            ++ i;
+    }
+
+    size_t max_jobs = size_t(m_config.opt_int("quote_jobs"));
+    if (max_jobs == 0)
+        max_jobs = std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+    BOOST_LOG_TRIVIAL(info) << "quote_batch: " << projects.size() << " projects in " << input_dir << ", " << max_jobs << " concurrent jobs";
+
+    struct QuoteJob {
+        fs::path                   project;
+        fs::path                   job_dir;
+        std::unique_ptr<bp::child> child;
+    };
+    const fs::path     program = boost::dll::program_location();
+    std::list<QuoteJob> running;
+    nlohmann::json     summary = nlohmann::json::array();
+    size_t             next_project = 0;
+    int                failed = 0;
+    while (next_project < projects.size() || !running.empty()) {
+        while (next_project < projects.size() && running.size() < max_jobs) {
+            QuoteJob job;
+            job.project = projects[next_project ++];
+            job.job_dir = fs::path(output_dir) / job.project.stem();
+            fs::create_directories(job.job_dir);
+            std::vector<std::string> args = forwarded_args;
+            args.insert(args.end(), { "--slice", "0", "--outputdir", job.job_dir.string(), job.project.string() });
+            try {
+                job.child = std::make_unique<bp::child>(bp::exe = program.string(), bp::args = args, (bp::std_out & bp::std_err) > (job.job_dir / "log.txt").string());
+            } catch (const std::exception &ex) {
+                BOOST_LOG_TRIVIAL(error) << "quote_batch: failed to start slicing of " << job.project << ": " << ex.what();
+                summary.push_back({ { "source", job.project.string() }, { "error", ex.what() } });
+                ++ failed;
+                continue;
+            }
+            running.emplace_back(std::move(job));
+        }
+        for (auto it = running.begin(); it != running.end();) {
+            if (it->child->running()) {
+                ++ it;
+                continue;
+            }
+            it->child->wait();
+            int            exit_code = it->child->exit_code();
+            fs::path       quote_src = it->job_dir / "quote.json";
+            fs::path       quote_dst = fs::path(output_dir) / (it->project.stem().string() + ".quote.json");
+            nlohmann::json entry     = { { "source", it->project.string() }, { "exit_code", exit_code } };
+            boost::system::error_code ec;
+            if (exit_code == 0 && fs::exists(quote_src, ec)) {
+                fs::rename(quote_src, quote_dst, ec);
+                if (ec) {
+                    entry["error"] = ec.message();
+                    BOOST_LOG_TRIVIAL(error) << "quote_batch: failed to move the quote of " << it->project << " to " << quote_dst << ": " << ec.message();
+                    ++ failed;
+                } else {
+                    entry["quote"] = quote_dst.string();
+                    BOOST_LOG_TRIVIAL(info) << "quote_batch: priced " << it->project;
+                }
+            } else {
+                entry["log"] = (it->job_dir / "log.txt").string();
+                BOOST_LOG_TRIVIAL(error) << "quote_batch: slicing of " << it->project << " failed with exit code " << exit_code;
+                ++ failed;
+            }
+            summary.push_back(std::move(entry));
+            it = running.erase(it);
+        }
+        if (!running.empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    boost::nowide::ofstream summary_file((fs::path(output_dir) / "quotes.json").string());
+    summary_file << summary.dump(4);
+    summary_file.close();
+    boost::nowide::cout << "Priced " << projects.size() - failed << " of " << projects.size() << " projects into " << output_dir << std::endl;
+    return failed == 0 ? CLI_SUCCESS : CLI_SLICING_ERROR;
+}
+
+int CLI::quote_gcode()
+{
+    const std::string input_dir   = m_config.opt_string("quote_gcode");
+    const std::string job_profile = m_config.opt_string("job_profile");
+    std::string       output_dir  = m_config.opt_string("outputdir");
+    if (job_profile.empty() || !fs::is_directory(input_dir)) {
+        boost::nowide::cerr << "--quote-gcode needs an existing directory and a --job-profile" << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+    InvoiceJobProfile job;
+    try {
+        job = load_invoice_job_profile(job_profile);
+    } catch (const std::exception &ex) {
+        boost::nowide::cerr << ex.what() << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+    if (output_dir.empty())
+        output_dir = (fs::path(input_dir) / "quotes").string();
+    fs::create_directories(output_dir);
+
+    std::vector<fs::path> gcodes;
+    for (const fs::directory_entry &entry : fs::directory_iterator(input_dir))
+        if (fs::is_regular_file(entry.status()) && boost::iends_with(entry.path().string(), ".gcode"))
+            gcodes.emplace_back(entry.path());
+    std::sort(gcodes.begin(), gcodes.end());
+
+    size_t max_jobs = size_t(m_config.opt_int("quote_jobs"));
+    if (max_jobs == 0)
+        max_jobs = std::max<size_t>(1, std::thread::hardware_concurrency());
+    BOOST_LOG_TRIVIAL(info) << "quote_gcode: " << gcodes.size() << " G-code files in " << input_dir << ", " << max_jobs << " concurrent jobs";
+
+    // Only the header and the footer of each file are read, so the files are processed independently in parallel.
+    std::vector<nlohmann::json> entries(gcodes.size());
+    std::atomic<int>            failed { 0 };
+    tbb::task_arena             arena { int(max_jobs) };
+    arena.execute([&]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, gcodes.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                const fs::path &gcode = gcodes[i];
+                nlohmann::json &entry = entries[i];
+                entry["source"] = gcode.string();
+                try {
+                    GCodeMetadata metadata = read_gcode_metadata(gcode.string());
+                    InvoicePlateQuote plate;
+                    plate.plate_id   = 1;
+                    plate.gcode_path = gcode.string();
+                    plate.quote      = calculate_invoice_quote(job, metadata.print_time_hours(), invoice_filament_usage(metadata));
+                    fs::path quote_path = fs::path(output_dir) / (gcode.stem().string() + ".quote.json");
+                    save_invoice_quotes(quote_path.string(), gcode.string(), job, { plate });
+                    entry["quote"] = quote_path.string();
+                } catch (const std::exception &ex) {
+                    BOOST_LOG_TRIVIAL(error) << "quote_gcode: " << gcode << ": " << ex.what();
+                    entry["error"] = ex.what();
+                    ++ failed;
+                }
+            }
+        });
+    });
+
+    boost::nowide::ofstream summary_file((fs::path(output_dir) / "quotes.json").string());
+    summary_file << nlohmann::json(std::move(entries)).dump(4);
+    summary_file.close();
+    boost::nowide::cout << "Priced " << gcodes.size() - failed << " of " << gcodes.size() << " G-code files into " << output_dir << std::endl;
+    return failed == 0 ? CLI_SUCCESS : CLI_EXPORT_QUOTE_ERROR;
+}
+
+int CLI::quote_estimate(const std::string &output_dir)
+{
+    std::optional<InvoiceJobProfile> job;
+    InvoiceEstimateCalibration       calibration;
+    try {
+        if (const std::string &job_profile = m_config.opt_string("job_profile"); !job_profile.empty())
+            job = load_invoice_job_profile(job_profile);
+        if (const std::string &calibration_path = m_config.opt_string("estimate_calibration"); !calibration_path.empty())
+            calibration = load_invoice_estimate_calibration(calibration_path);
+    } catch (const std::exception &ex) {
+        boost::nowide::cerr << ex.what() << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+
+    InvoiceEstimator estimator(m_print_config, calibration.coefficients);
+    nlohmann::json   entries = nlohmann::json::array();
+    for (size_t i = 0; i < m_models.size(); ++ i) {
+        Model &model = m_models[i];
+        model.add_default_instances();
+        nlohmann::json entry;
+        entry["source"] = i < m_input_files.size() ? m_input_files[i] : std::string();
+        nlohmann::json &objects = entry["objects"] = nlohmann::json::array();
+        InvoiceEstimateFeatures features;
+        for (const ModelObject *object : model.objects) {
+            InvoiceEstimateFeatures object_features = estimator.features(*object);
+            objects.push_back({ { "name", object->name }, { "instances", object->instances.size() },
+                                { "estimate", invoice_estimate_to_json(estimator.estimate(object_features)) } });
+            features += object_features;
+        }
+        InvoiceEstimate estimate = estimator.estimate(features);
+        entry["estimate"] = invoice_estimate_to_json(estimate);
+        if (job) {
+            // Price the estimate like a sliced plate printed with the first filament.
+            PrintStatistics stats;
+            stats.filament_stats[0] = estimate.extruded_volume_mm3;
+            entry["quote"] = invoice_quote_to_json(calculate_invoice_quote(*job, estimate.print_time_s / 3600., invoice_filament_usage(stats, m_print_config)));
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    std::string estimate_path = ((output_dir.empty() ? fs::path(".") : fs::path(output_dir)) / "estimate.json").string();
+    boost::nowide::ofstream estimate_file(estimate_path);
+    estimate_file << entries.dump(4);
+    estimate_file.close();
+    if (estimate_file.fail()) {
+        BOOST_LOG_TRIVIAL(error) << "quote_estimate: failed to write " << estimate_path;
+        return CLI_EXPORT_QUOTE_ERROR;
+    }
+    BOOST_LOG_TRIVIAL(info) << "quote_estimate: estimated " << m_models.size() << " models into " << estimate_path;
+    return CLI_SUCCESS;
+}
+
 void attach_console_on_demand(){
 #ifdef _WIN32
     static bool console_attached = false;
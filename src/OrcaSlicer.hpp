@@ -131,6 +131,13 @@ private:
         std::vector<ThumbnailData*>& calibration_thumbnails,
         std::vector<PlateBBoxData*>& plate_bboxes, const DynamicPrintConfig* config, bool minimum_save, int plate_to_export = -1);
 
+    /// Slices all projects of the --quote-batch directory in child processes and collects their invoice quotes.
+    int quote_batch(int argc, char **argv);
+    /// Prices all G-code files of the --quote-gcode directory from their embedded statistics.
+    int quote_gcode();
+    /// Estimates filament and print time of the loaded models without slicing, see InvoiceEstimator.
+    int quote_estimate(const std::string &output_dir);
+
     bool has_print_action() const { return m_config.opt_bool("export_gcode") || m_config.opt_bool("export_sla"); }
 
     std::string output_filepath(const Model &model, IO::ExportFormat format) const;
@@ -4,26 +4,296 @@
 #include <cmath>
 #include <cassert>
 
+#if defined(__AVX__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ARC_FITTER_SSE2
+#endif
+
 namespace Slic3r {
 
-void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData>& result, double tolerance)
+namespace {
+
+// Deviations of a circle from the points of a fitting window, the same values Circle::get_deviation_sum_squared()
+// accumulates, evaluated several points at once. The points are passed as doubles in a structure of arrays,
+// the center of the circle is an integer point as in Circle.
+// Both functions store the deviations to out and return false as soon as a deviation exceeds tolerance.
+
+// Deviations of points [begin, end) from the circle.
+static bool radial_deviations(const double *x, const double *y, size_t begin, size_t end, const Circle &circle, double tolerance, double *out)
 {
-#ifdef DEBUG_ARC_FITTING
-    static int irun = 0;
-    BoundingBox bbox_svg;
-    bbox_svg.merge(get_extents(points));
-    Polyline temp = Polyline(points);
+    const double cx = double(circle.center.x());
+    const double cy = double(circle.center.y());
+    size_t       i  = begin;
+#if defined(__AVX__)
     {
-        std::stringstream stri;
-        stri << "debug_arc_fitting_" << irun << ".svg";
-        SVG svg(stri.str(), bbox_svg);
-        svg.draw(points, "blue", 50000);
-        svg.draw(temp, "red", 1);
-        svg.Close();
+        const __m256d vcx  = _mm256_set1_pd(cx);
+        const __m256d vcy  = _mm256_set1_pd(cy);
+        const __m256d vr   = _mm256_set1_pd(circle.radius);
+        const __m256d vtol = _mm256_set1_pd(tolerance);
+        const __m256d sign = _mm256_set1_pd(-0.);
+        for (; i + 4 <= end; i += 4) {
+            __m256d dx  = _mm256_sub_pd(_mm256_loadu_pd(x + i), vcx);
+            __m256d dy  = _mm256_sub_pd(_mm256_loadu_pd(y + i), vcy);
+            __m256d dev = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))), vr));
+            _mm256_storeu_pd(out + i, dev);
+            if (_mm256_movemask_pd(_mm256_cmp_pd(dev, vtol, _CMP_NLE_UQ)))
+                return false;
+        }
+    }
+#elif defined(ARC_FITTER_SSE2)
+    {
+        const __m128d vcx  = _mm_set1_pd(cx);
+        const __m128d vcy  = _mm_set1_pd(cy);
+        const __m128d vr   = _mm_set1_pd(circle.radius);
+        const __m128d vtol = _mm_set1_pd(tolerance);
+        const __m128d sign = _mm_set1_pd(-0.);
+        for (; i + 2 <= end; i += 2) {
+            __m128d dx  = _mm_sub_pd(_mm_loadu_pd(x + i), vcx);
+            __m128d dy  = _mm_sub_pd(_mm_loadu_pd(y + i), vcy);
+            __m128d dev = _mm_andnot_pd(sign, _mm_sub_pd(_mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))), vr));
+            _mm_storeu_pd(out + i, dev);
+            if (_mm_movemask_pd(_mm_cmpnle_pd(dev, vtol)))
+                return false;
+        }
     }
-    ++ irun;
 #endif
+    for (; i < end; ++ i) {
+        double dx = x[i] - cx;
+        double dy = y[i] - cy;
+        out[i] = std::fabs(std::sqrt(dx * dx + dy * dy) - circle.radius);
+        if (! (out[i] <= tolerance))
+            return false;
+    }
+    return true;
+}
+
+#if !defined(__AVX__) && defined(ARC_FITTER_SSE2)
+// Rounding towards zero for |x| < 2^52, SSE2 has no rounding instruction.
+static inline __m128d truncate_pd(__m128d x)
+{
+    const __m128d sign  = _mm_and_pd(x, _mm_set1_pd(-0.));
+    const __m128d magic = _mm_or_pd(_mm_set1_pd(4503599627370496.), sign);
+    // Round to nearest, then step back towards zero where it rounded away from zero.
+    const __m128d r     = _mm_sub_pd(_mm_add_pd(x, magic), magic);
+    const __m128d away  = _mm_cmpgt_pd(_mm_andnot_pd(_mm_set1_pd(-0.), r), _mm_andnot_pd(_mm_set1_pd(-0.), x));
+    return _mm_sub_pd(r, _mm_and_pd(away, _mm_or_pd(_mm_set1_pd(1.), sign)));
+}
+#endif
+
+// Deviations of the feet of the perpendiculars from the center to segments [begin, end), segment i running from point i to point i + 1.
+// As Circle::get_closest_perpendicular_point() calculates it, the foot is rounded towards zero to an integer point
+// and a foot not strictly inside its segment is skipped, its deviation is zero. The foot of a degenerate segment is NaN,
+// which counts as exceeding the tolerance.
+static bool perpendicular_deviations(const double *x, const double *y, size_t begin, size_t end, const Circle &circle, double tolerance, double *out)
+{
+    const double cx = double(circle.center.x());
+    const double cy = double(circle.center.y());
+    size_t       i  = begin;
+#if defined(__AVX__)
+    {
+        const __m256d vcx  = _mm256_set1_pd(cx);
+        const __m256d vcy  = _mm256_set1_pd(cy);
+        const __m256d vr   = _mm256_set1_pd(circle.radius);
+        const __m256d vtol = _mm256_set1_pd(tolerance);
+        const __m256d sign = _mm256_set1_pd(-0.);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one  = _mm256_set1_pd(1.);
+        const __m256d eps  = _mm256_set1_pd(ZERO_TOLERANCE);
+        for (; i + 4 <= end; i += 4) {
+            __m256d x1      = _mm256_loadu_pd(x + i);
+            __m256d y1      = _mm256_loadu_pd(y + i);
+            __m256d xd      = _mm256_sub_pd(_mm256_loadu_pd(x + i + 1), x1);
+            __m256d yd      = _mm256_sub_pd(_mm256_loadu_pd(y + i + 1), y1);
+            __m256d t       = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(vcx, x1), xd), _mm256_mul_pd(_mm256_sub_pd(vcy, y1), yd)),
+                                            _mm256_add_pd(_mm256_mul_pd(xd, xd), _mm256_mul_pd(yd, yd)));
+            __m256d outside = _mm256_or_pd(
+                _mm256_or_pd(_mm256_cmp_pd(t, zero, _CMP_LT_OQ), _mm256_cmp_pd(_mm256_andnot_pd(sign, t), eps, _CMP_LT_OQ)),
+                _mm256_or_pd(_mm256_cmp_pd(t, one, _CMP_GT_OQ), _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(t, one)), eps, _CMP_LT_OQ)));
+            __m256d dx      = _mm256_sub_pd(_mm256_round_pd(_mm256_add_pd(x1, _mm256_mul_pd(t, xd)), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), vcx);
+            __m256d dy      = _mm256_sub_pd(_mm256_round_pd(_mm256_add_pd(y1, _mm256_mul_pd(t, yd)), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), vcy);
+            __m256d dev     = _mm256_andnot_pd(outside,
+                _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))), vr)));
+            _mm256_storeu_pd(out + i, dev);
+            if (_mm256_movemask_pd(_mm256_cmp_pd(dev, vtol, _CMP_NLE_UQ)))
+                return false;
+        }
+    }
+#elif defined(ARC_FITTER_SSE2)
+    {
+        const __m128d vcx  = _mm_set1_pd(cx);
+        const __m128d vcy  = _mm_set1_pd(cy);
+        const __m128d vr   = _mm_set1_pd(circle.radius);
+        const __m128d vtol = _mm_set1_pd(tolerance);
+        const __m128d sign = _mm_set1_pd(-0.);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one  = _mm_set1_pd(1.);
+        const __m128d eps  = _mm_set1_pd(ZERO_TOLERANCE);
+        for (; i + 2 <= end; i += 2) {
+            __m128d x1      = _mm_loadu_pd(x + i);
+            __m128d y1      = _mm_loadu_pd(y + i);
+            __m128d xd      = _mm_sub_pd(_mm_loadu_pd(x + i + 1), x1);
+            __m128d yd      = _mm_sub_pd(_mm_loadu_pd(y + i + 1), y1);
+            __m128d t       = _mm_div_pd(_mm_add_pd(_mm_mul_pd(_mm_sub_pd(vcx, x1), xd), _mm_mul_pd(_mm_sub_pd(vcy, y1), yd)),
+                                         _mm_add_pd(_mm_mul_pd(xd, xd), _mm_mul_pd(yd, yd)));
+            __m128d outside = _mm_or_pd(
+                _mm_or_pd(_mm_cmplt_pd(t, zero), _mm_cmplt_pd(_mm_andnot_pd(sign, t), eps)),
+                _mm_or_pd(_mm_cmpgt_pd(t, one), _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_sub_pd(t, one)), eps)));
+            __m128d dx      = _mm_sub_pd(truncate_pd(_mm_add_pd(x1, _mm_mul_pd(t, xd))), vcx);
+            __m128d dy      = _mm_sub_pd(truncate_pd(_mm_add_pd(y1, _mm_mul_pd(t, yd))), vcy);
+            __m128d dev     = _mm_andnot_pd(outside,
+                _mm_andnot_pd(sign, _mm_sub_pd(_mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))), vr)));
+            _mm_storeu_pd(out + i, dev);
+            if (_mm_movemask_pd(_mm_cmpnle_pd(dev, vtol)))
+                return false;
+        }
+    }
+#endif
+    for (; i < end; ++ i) {
+        double x_dif = x[i + 1] - x[i];
+        double y_dif = y[i + 1] - y[i];
+        double t     = ((cx - x[i]) * x_dif + (cy - y[i]) * y_dif) / (x_dif * x_dif + y_dif * y_dif);
+        if (Circle::less_than_or_equal(t, 0) || Circle::greater_than_or_equal(t, 1)) {
+            out[i] = 0.;
+            continue;
+        }
+        double dx = std::trunc(x[i] + t * x_dif) - cx;
+        double dy = std::trunc(y[i] + t * y_dif) - cy;
+        out[i] = std::fabs(std::sqrt(dx * dx + dy * dy) - circle.radius);
+        if (! (out[i] <= tolerance))
+            return false;
+    }
+    return true;
+}
+
+// Window of the original fitter, refitted by ArcSegment::try_create_arc() from scratch for each point added.
+class PointwiseFittingWindow
+{
+public:
+    explicit PointwiseFittingWindow(size_t capacity) { m_points.reserve(capacity); }
+
+    void clear() { m_points.clear(); }
+    void push_back(const Point &pt) { m_points.push_back(pt); }
+    bool try_create_arc(ArcSegment &target_arc, double tolerance) const {
+        return ArcSegment::try_create_arc(m_points, target_arc, Polyline(m_points).length(),
+                                          DEFAULT_SCALED_MAX_RADIUS,
+                                          tolerance,
+                                          DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
+    }
+
+private:
+    Points m_points;
+};
 
+// Window evaluating the same candidate circles in the same order as ArcSegment::try_create_arc() and Circle::try_create_circle() do,
+// thus fitting the same arcs. The coordinates of the points are kept as doubles in a structure of arrays for radial_deviations()
+// and perpendicular_deviations(), the length of the window is updated as points are added and the deviations are summed
+// in the order of Circle::get_deviation_sum_squared() to get the same least deviation circle.
+class BatchedFittingWindow
+{
+public:
+    explicit BatchedFittingWindow(size_t capacity) {
+        m_points.reserve(capacity);
+        m_x.reserve(capacity);
+        m_y.reserve(capacity);
+        m_radial.reserve(capacity);
+        m_perpendicular.reserve(capacity);
+    }
+
+    void clear() {
+        m_points.clear();
+        m_x.clear();
+        m_y.clear();
+        m_length = 0.;
+    }
+
+    void push_back(const Point &pt) {
+        // Same summation as of Polyline::length().
+        if (! m_points.empty())
+            m_length += Line(m_points.back(), pt).length();
+        m_points.push_back(pt);
+        m_x.push_back(double(pt.x()));
+        m_y.push_back(double(pt.y()));
+    }
+
+    bool try_create_arc(ArcSegment &target_arc, double tolerance) {
+        Circle circle;
+        if (! this->try_create_circle(DEFAULT_SCALED_MAX_RADIUS, tolerance, circle))
+            return false;
+        const size_t mid_point_index = ((m_points.size() - 2) / 2) + 1;
+        ArcSegment   test_arc;
+        if (! ArcSegment::try_create_arc(circle, m_points.front(), m_points[mid_point_index], m_points.back(), test_arc, m_length, DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE) ||
+            ! ArcSegment::are_points_within_slice(test_arc, m_points))
+            return false;
+        target_arc = test_arc;
+        return true;
+    }
+
+private:
+    bool within_tolerance(const Circle &circle, double tolerance) {
+        const size_t count = m_points.size();
+        m_radial.resize(count);
+        m_perpendicular.resize(count - 1);
+        return radial_deviations(m_x.data(), m_y.data(), 1, count - 1, circle, tolerance, m_radial.data()) &&
+               perpendicular_deviations(m_x.data(), m_y.data(), 0, count - 1, circle, tolerance, m_perpendicular.data());
+    }
+
+    bool deviation_sum_squared(const Circle &circle, double tolerance, double &total_deviation) {
+        if (! this->within_tolerance(circle, tolerance))
+            return false;
+        total_deviation = 0;
+        for (size_t i = 1; i + 1 < m_points.size(); ++ i)
+            total_deviation += m_radial[i] * m_radial[i];
+        for (size_t i = 0; i + 1 < m_points.size(); ++ i)
+            total_deviation += m_perpendicular[i] * m_perpendicular[i];
+        return true;
+    }
+
+    bool try_create_circle(double max_radius, double tolerance, Circle &new_circle) {
+        const Points &points       = m_points;
+        const size_t  count        = points.size();
+        const size_t  middle_index = count / 2;
+        if (count == 3) {
+            return Circle::try_create_circle(points[0], points[middle_index], points[count - 1], max_radius, new_circle) &&
+                   this->within_tolerance(new_circle, tolerance);
+        } else {
+            Point middle_point = (count % 2 == 0) ? (points[middle_index] + points[middle_index - 1]) / 2 :
+                                                    (points[middle_index - 1] + points[middle_index + 1]) / 2;
+            if (Circle::try_create_circle(points[0], middle_point, points[count - 1], max_radius, new_circle) &&
+                this->within_tolerance(new_circle, tolerance))
+                return true;
+        }
+        Circle test_circle;
+        double least_deviation   = 0.;
+        double current_deviation = 0.;
+        bool   found_circle      = false;
+        for (size_t index = 1; index < count - 1; ++ index)
+            if (index != middle_index &&
+                Circle::try_create_circle(points[0], points[index], points[count - 1], max_radius, test_circle) &&
+                this->deviation_sum_squared(test_circle, tolerance, current_deviation) &&
+                (! found_circle || current_deviation < least_deviation)) {
+                found_circle    = true;
+                least_deviation = current_deviation;
+                new_circle      = test_circle;
+            }
+        return found_circle;
+    }
+
+    Points              m_points;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    double              m_length { 0. };
+    // Scratch space of within_tolerance().
+    std::vector<double> m_radial;
+    std::vector<double> m_perpendicular;
+};
+
+} // namespace
+
+template<typename Window>
+static void fit_arcs(const Points& points, std::vector<PathFittingData>& result, double tolerance)
+{
     result.clear();
     result.reserve(points.size() / 2);  //worst case size
     if (points.size() < 3) {
@@ -39,8 +309,7 @@ void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData
     size_t back_index = 0;
     ArcSegment last_arc;
     bool can_fit = false;
-    Points current_segment;
-    current_segment.reserve(points.size());
+    Window current_segment(points.size());
     ArcSegment target_arc;
     for (size_t i = 0; i < points.size(); i++) {
         //BBS: point in stack is not enough, build stack first
@@ -49,10 +318,7 @@ void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData
         if (back_index - front_index < 2)
             continue;
 
-        can_fit = ArcSegment::try_create_arc(current_segment, target_arc, Polyline(current_segment).length(),
-                                             DEFAULT_SCALED_MAX_RADIUS,
-                                             tolerance,
-                                             DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
+        can_fit = current_segment.try_create_arc(target_arc, tolerance);
         if (can_fit) {
             //BBS: can be fit as arc, then save arc data temperarily
             last_arc = target_arc;
@@ -94,6 +360,32 @@ void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData
     result.shrink_to_fit();
 }
 
+void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData>& result, double tolerance)
+{
+#ifdef DEBUG_ARC_FITTING
+    static int irun = 0;
+    BoundingBox bbox_svg;
+    bbox_svg.merge(get_extents(points));
+    Polyline temp = Polyline(points);
+    {
+        std::stringstream stri;
+        stri << "debug_arc_fitting_" << irun << ".svg";
+        SVG svg(stri.str(), bbox_svg);
+        svg.draw(points, "blue", 50000);
+        svg.draw(temp, "red", 1);
+        svg.Close();
+    }
+    ++ irun;
+#endif
+
+    fit_arcs<BatchedFittingWindow>(points, result, tolerance);
+}
+
+void ArcFitter::do_arc_fitting_pointwise(const Points& points, std::vector<PathFittingData>& result, double tolerance)
+{
+    fit_arcs<PointwiseFittingWindow>(points, result, tolerance);
+}
+
 void ArcFitter::do_arc_fitting_and_simplify(Points& points, std::vector<PathFittingData>& result, double tolerance)
 {
     //BBS: 1 do arc fit first
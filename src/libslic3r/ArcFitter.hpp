@@ -41,7 +41,11 @@ struct PathFittingData{
 class ArcFitter {
 public:
     //BBS: this function is used to check the point list and return which part can fit as arc, which part should be line
+    //The candidate circles are evaluated over the points of the fitting window several points at once (AVX or SSE2, scalar otherwise).
     static void do_arc_fitting(const Points& points, std::vector<PathFittingData> &result, double tolerance);
+    //The original fitter, refitting the window by ArcSegment::try_create_arc() for each point added.
+    //Gives the same result as do_arc_fitting(), kept to verify and benchmark it against.
+    static void do_arc_fitting_pointwise(const Points& points, std::vector<PathFittingData> &result, double tolerance);
     //BBS: this function is used to check the point list and return which part can fit as arc, which part should be line.
     //By the way, it also use DP simplify to reduce point of straight part and only keep the start and end point of arc.
     static void do_arc_fitting_and_simplify(Points& points, std::vector<PathFittingData>& result, double tolerance);
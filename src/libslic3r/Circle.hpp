@@ -112,14 +112,7 @@ public:
         double tolerance = DEFAULT_SCALED_RESOLUTION,
         double path_tolerance_percent = DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
 
-    static bool are_points_within_slice(const ArcSegment& test_arc, const Points &points);
-    // BBS: this function is used to detect whether a ray cross the segment
-    static bool ray_intersects_segment(const Point& rayOrigin, const Vec2d& rayDirection, const Line& segment);
-    // BBS: these three functions are used to calculate related arguments of arc in unscale_field.
-    static float calc_arc_radian(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
-    static float calc_arc_radius(Vec3f start_pos, Vec3f center_pos);
-    static float calc_arc_length(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
-private:
+    // Arc of the circle c from start_point through mid_point to end_point, the last step of the above try_create_arc().
     static bool try_create_arc(
         const Circle& c,
         const Point& start_point,
@@ -128,6 +121,14 @@ private:
         ArcSegment& target_arc,
         double approximate_length,
         double path_tolerance_percent = DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
+
+    static bool are_points_within_slice(const ArcSegment& test_arc, const Points &points);
+    // BBS: this function is used to detect whether a ray cross the segment
+    static bool ray_intersects_segment(const Point& rayOrigin, const Vec2d& rayDirection, const Line& segment);
+    // BBS: these three functions are used to calculate related arguments of arc in unscale_field.
+    static float calc_arc_radian(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
+    static float calc_arc_radius(Vec3f start_pos, Vec3f center_pos);
+    static float calc_arc_length(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
 };
 
 }
@@ -3,12 +3,14 @@
 #include "Utils.hpp"
 #include "LocalesUtils.hpp"
 #include "Preset.hpp"
+#include "GCode/BinaryGCode.hpp"
 
 #include <assert.h>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <regex>
+#include <sstream>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/erase.hpp>
@@ -1331,11 +1333,17 @@ ConfigSubstitutions ConfigBase::load_from_gcode_file(const std::string &file, Fo
     // Read a 64k block from the end of the G-code.
 	boost::nowide::ifstream ifs(file);
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  before parse_file %1%") % file.c_str();
+    // A binary G-code keeps the config block in a block of its own, which is parsed the same way as the config block of an ASCII G-code.
+    const bool         binary = BinaryGCodeReader::is_binary_gcode(file);
+    std::istringstream binary_config;
+    if (binary)
+        binary_config.str(BinaryGCodeReader(file).metadata(BinaryGCodeBlockType::SlicerConfig));
+    std::istream      &in = binary ? static_cast<std::istream&>(binary_config) : ifs;
     // Look for Slic3r or OrcaSlicer header.
     // Look for the header across the whole file as the G-code may have been extended at the start by a post-processing script or the user.
     //BBS
     bool has_delimiters = true;
-    {
+    if (! binary) {
         //BBS
         std::string bambuslicer_gcode_header = "; OrcaSlicer";
 
@@ -1379,7 +1387,7 @@ ConfigSubstitutions ConfigBase::load_from_gcode_file(const std::string &file, Fo
         bool begin_found = false;
         bool end_found   = false;
         std::string line;
-        while (std::getline(ifs, line))
+        while (std::getline(in, line))
             if (line.rfind("; CONFIG_BLOCK_START",0)==0) {
                 begin_found = true;
                 break;
@@ -1389,7 +1397,7 @@ ConfigSubstitutions ConfigBase::load_from_gcode_file(const std::string &file, Fo
             throw Slic3r::RuntimeError(format("Config tag \"; CONFIG_BLOCK_START\" not found"));
         }
         std::string key, value;
-        while (std::getline(ifs, line)) {
+        while (std::getline(in, line)) {
             if (line.rfind("; CONFIG_BLOCK_END",0)==0) {
                 end_found = true;
                 break;
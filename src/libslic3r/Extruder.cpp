@@ -121,6 +121,29 @@ void Extruder::set_retracted(double retracted, double restart_extra)
     }
 }
 
+Extruder::State Extruder::state() const
+{
+    State out;
+    out.E             = m_share_extruder ? m_share_E[extruder_id()] : m_E;
+    out.absolute_E    = m_absolute_E;
+    out.retracted     = m_share_extruder ? m_share_retracted[extruder_id()] : m_retracted;
+    out.restart_extra = m_restart_extra;
+    return out;
+}
+
+void Extruder::restore_state(const State &state)
+{
+    if (m_share_extruder) {
+        m_share_E[extruder_id()]         = state.E;
+        m_share_retracted[extruder_id()] = state.retracted;
+    } else {
+        m_E         = state.E;
+        m_retracted = state.retracted;
+    }
+    m_absolute_E    = state.absolute_E;
+    m_restart_extra = state.restart_extra;
+}
+
 // Used filament volume in mm^3.
 double Extruder::extruded_volume() const
 {
@@ -56,6 +56,16 @@ public:
     void   set_position(double e) { m_E = e; }
     // Sets current retraction value & restart extra filament amount if retracted > 0.
     void   set_retracted(double retracted, double restart_extra);
+
+    // Position, retraction and tachometer of the extruder axis, saved and restored by the incremental G-code export.
+    struct State {
+        double E             { 0. };
+        double absolute_E    { 0. };
+        double retracted     { 0. };
+        double restart_extra { 0. };
+    };
+    State  state() const;
+    void   restore_state(const State &state);
     
     double filament_diameter() const;
     double filament_crossection() const { return this->filament_diameter() * this->filament_diameter() * 0.25 * PI; }
@@ -261,10 +261,12 @@ struct Octree
     boost::object_pool<Cube>    pool;
     Cube*                       root_cube { nullptr };
     Vec3d                       origin;
+    // Origin in the coordinate system of the octree, from which encode_octree() derives the cube centers.
+    Vec3d                       origin_octree;
     std::vector<CubeProperties> cubes_properties;
 
     Octree(const Vec3d &origin, const std::vector<CubeProperties> &cubes_properties)
-        : root_cube(pool.construct(origin)), origin(origin), cubes_properties(cubes_properties) {}
+        : root_cube(pool.construct(origin)), origin(origin), origin_octree(origin), cubes_properties(cubes_properties) {}
 
     void insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth);
 };
@@ -1464,6 +1466,14 @@ static void transform_center(Cube *current_cube, const Eigen::Matrix3d &rot)
             transform_center(child, rot);
 }
 
+// Transform the octree to world coordinates to reduce computation when extracting infill lines.
+static void octree_to_world(Octree &octree)
+{
+    auto rot = transform_to_world().toRotationMatrix();
+    transform_center(octree.root_cube, rot);
+    octree.origin = rot * octree.origin;
+}
+
 OctreePtr build_octree(
     // Mesh is rotated to the coordinate system of the octree.
     const indexed_triangle_set  &triangle_mesh,
@@ -1479,7 +1489,7 @@ OctreePtr build_octree(
     BoundingBox3Base<Vec3f>     bbox(triangle_mesh.vertices);
     Vec3d                       cube_center      = bbox.center().cast<double>();
     std::vector<CubeProperties> cubes_properties = make_cubes_properties(double(bbox.size().maxCoeff()), line_spacing);
-    auto                        octree           = OctreePtr(new Octree(cube_center, cubes_properties));
+    auto                        octree           = OctreePtr(new Octree(cube_center, cubes_properties), OctreeDeleter());
 
     if (cubes_properties.size() > 1) {
         Octree *octree_ptr = octree.get();
@@ -1503,17 +1513,79 @@ OctreePtr build_octree(
         }
         for (size_t i = 0; i < overhang_triangles.size(); i += 3)
             process_triangle(overhang_triangles[i], overhang_triangles[i + 1], overhang_triangles[i + 2]);
-        {
-            // Transform the octree to world coordinates to reduce computation when extracting infill lines.
-            auto rot = transform_to_world().toRotationMatrix();
-            transform_center(octree->root_cube, rot);
-            octree->origin = rot * octree->origin;
-        }
+        octree_to_world(*octree);
     }
 
     return octree;
 }
 
+static void encode_cube(const Cube *cube, int depth, std::string &out)
+{
+    if (depth == 0)
+        return;
+    uint8_t mask = 0;
+    for (size_t i = 0; i < 8; ++ i)
+        if (cube->children[i])
+            mask |= uint8_t(1 << i);
+    out.push_back(char(mask));
+    for (const Cube *child : cube->children)
+        if (child)
+            encode_cube(child, depth - 1, out);
+}
+
+std::string encode_octree(const Octree &octree)
+{
+    std::string out;
+    auto append = [&out](const void *data, size_t size) { out.append(reinterpret_cast<const char*>(data), size); };
+    const uint32_t num_levels = uint32_t(octree.cubes_properties.size());
+    append(&num_levels, sizeof(num_levels));
+    append(octree.cubes_properties.data(), num_levels * sizeof(CubeProperties));
+    append(octree.origin_octree.data(), 3 * sizeof(double));
+    encode_cube(octree.root_cube, int(num_levels) - 1, out);
+    return out;
+}
+
+// Creates the children of a cube the same way Octree::insert_triangle() does, in the coordinate system of the octree.
+static void decode_cube(Octree &octree, Cube *cube, int depth, std::string_view data, size_t &offset)
+{
+    if (depth == 0)
+        return;
+    if (offset == data.size())
+        throw Slic3r::FileIOError("Truncated adaptive infill octree");
+    const uint8_t mask = uint8_t(data[offset ++]);
+    -- depth;
+    for (size_t i = 0; i < 8; ++ i)
+        if (mask & (1 << i)) {
+            cube->children[i] = octree.pool.construct(Vec3d(cube->center + (child_centers[i] * (octree.cubes_properties[depth].edge_length / 2.))));
+            decode_cube(octree, cube->children[i], depth, data, offset);
+        }
+}
+
+OctreePtr decode_octree(std::string_view data)
+{
+    uint32_t num_levels = 0;
+    if (data.size() < sizeof(num_levels))
+        throw Slic3r::FileIOError("Truncated adaptive infill octree");
+    memcpy(&num_levels, data.data(), sizeof(num_levels));
+    size_t offset = sizeof(num_levels);
+    if (num_levels == 0 || num_levels > 64 || data.size() - offset < num_levels * sizeof(CubeProperties) + 3 * sizeof(double))
+        throw Slic3r::FileIOError("Malformed adaptive infill octree");
+    std::vector<CubeProperties> cubes_properties(num_levels);
+    memcpy(cubes_properties.data(), data.data() + offset, num_levels * sizeof(CubeProperties));
+    offset += num_levels * sizeof(CubeProperties);
+    Vec3d origin;
+    memcpy(origin.data(), data.data() + offset, 3 * sizeof(double));
+    offset += 3 * sizeof(double);
+
+    auto octree = OctreePtr(new Octree(origin, cubes_properties), OctreeDeleter());
+    decode_cube(*octree, octree->root_cube, int(num_levels) - 1, data, offset);
+    if (offset != data.size())
+        throw Slic3r::FileIOError("Malformed adaptive infill octree");
+    if (num_levels > 1)
+        octree_to_world(*octree);
+    return octree;
+}
+
 void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth)
 {
     assert(current_cube);
@@ -11,6 +11,10 @@
 #ifndef slic3r_FillAdaptive_hpp_
 #define slic3r_FillAdaptive_hpp_
 
+#include <memory>
+#include <string>
+#include <string_view>
+
 #include "FillBase.hpp"
 
 struct indexed_triangle_set;
@@ -25,7 +29,9 @@ namespace FillAdaptive
 struct Octree;
 // To keep the definition of Octree opaque, we have to define a custom deleter.
 struct OctreeDeleter { void operator()(Octree *p); };
-using  OctreePtr = std::unique_ptr<Octree, OctreeDeleter>;
+// Shared by the objects of a Print built from the same mesh and overhangs, see Print::adaptive_fill_octree().
+// An octree is read only once built.
+using  OctreePtr = std::shared_ptr<Octree>;
 
 // Calculate line spacing for
 // 1) adaptive cubic infill
@@ -48,6 +54,12 @@ FillAdaptive::OctreePtr         build_octree(
     // If true, octree is densified below internal overhangs only.
     bool                         support_overhangs_only);
 
+// Compact binary encoding of an octree for the slice cache: the cube properties, the root center and a byte
+// with the bit mask of the children of each cube in depth first order. The encoding is in the native byte order.
+std::string                     encode_octree(const Octree &octree);
+// Restores the octree exactly as build_octree() built it. Throws Slic3r::FileIOError on malformed data.
+FillAdaptive::OctreePtr         decode_octree(std::string_view data);
+
 //
 // Some of the algorithms used by class FillAdaptive were inspired by
 // Cura Engine's class SubDivCube
@@ -29,7 +29,22 @@ struct ScalarField
 
     explicit ScalarField(const BoundingBox bb, const coordf_t z = 0.0, const float period = 10.0)
         : size{bb.size()}, offs{bb.min}, z{z}, freq{float(2 * PI) / period}
-    {}
+    {
+        // The field is a sum of products of functions of a single coordinate. Tabulate them for the raster columns,
+        // rows and z, so that a sample costs a few multiplications instead of nine trigonometric functions.
+        // The factors are evaluated the same way get_scalar(x, y, z) evaluates them, thus the samples do not change.
+        auto factors = [this](coordf_t v) {
+            const float fv = freq * v;
+            return Factors{cosf(2 * fv), sinf(fv), cosf(fv)};
+        };
+        fx.reserve(to_coordr(size.x()) + 1);
+        for (coordr_t c = 0; c <= to_coordr(size.x()); ++c)
+            fx.emplace_back(factors(unscaled(to_coord(c) + offs.x())));
+        fy.reserve(to_coordr(size.y()) + 1);
+        for (coordr_t r = 0; r <= to_coordr(size.y()); ++r)
+            fy.emplace_back(factors(unscaled(to_coord(r) + offs.y())));
+        fz = factors(z);
+    }
 
     // Get the scalar field value at x,y,z in coordf_t coordinates.
     float get_scalar(coordf_t x, coordf_t y, coordf_t z) const
@@ -46,8 +61,9 @@ struct ScalarField
     // Get the scalar field value at a Coord for the current z value.
     float get_scalar(Coord p) const
     {
-        Pointf pf = to_Pointf(p);
-        return get_scalar(pf.x(), pf.y(), z);
+        const Factors &x = fx[p.c];
+        const Factors &y = fy[p.r];
+        return x.cos2 * y.sin * fz.cos + y.cos2 * fz.sin * x.cos + fz.cos2 * x.sin * y.cos;
     }
 
     // Convert between dimension scales.
@@ -59,6 +75,18 @@ struct ScalarField
     inline Coord  to_Coord(const Point& p) const { return Coord(to_coordr(p.y() - offs.y()), to_coordr(p.x() - offs.x())); }
     inline Pointf to_Pointf(const Point& p) const { return Pointf(unscaled(p.x()), unscaled(p.y())); }
     inline Pointf to_Pointf(const Coord& p) const { return to_Pointf(to_Point(p)); }
+
+private:
+    // cos(2 * f * v), sin(f * v), cos(f * v) of a coordinate v.
+    struct Factors
+    {
+        float cos2;
+        float sin;
+        float cos;
+    };
+    std::vector<Factors> fx; // per raster column.
+    std::vector<Factors> fy; // per raster row.
+    Factors              fz;
 };
 
 // Register ScalarField as a RasterType for MarchingSquares.
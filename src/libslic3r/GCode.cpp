@@ -21,13 +21,18 @@
 #include "libslic3r/format.hpp"
 #include "Time.hpp"
 #include "GCode/ExtrusionProcessor.hpp"
+#include "LayerCache.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <math.h>
 #include <stdlib.h>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <string_view>
@@ -47,6 +52,7 @@
 #include "SVG.hpp"
 
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #include "calib.hpp"
 // Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
 // We are using quite an old TBB 2017 U7. Before we update our build servers, let's use the old API, which is deprecated in up to date TBB.
@@ -1839,6 +1845,7 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         return;
 
     BOOST_LOG_TRIVIAL(info) << boost::format("Will export G-code to %1% soon")%path;
+    m_export_stats.reset();
 
     GCodeProcessor::s_IsBBLPrinter = print->is_BBL_printer();
     m_writer.set_is_bbl_machine(print->is_BBL_printer());
@@ -1877,8 +1884,10 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 
     m_processor.initialize(path_tmp);
     m_processor.set_print(print);
-    GCodeOutputStream file(boost::nowide::fopen(path_tmp.c_str(), "wb"), m_processor);
-    if (! file.is_open()) {
+    // The G-code is kept in memory and the post-processing in GCodeProcessor::finalize() writes path_tmp in a single pass,
+    // unless the G-code grows too large and the output stream spills it into path_tmp.
+    FILE *file_tmp = boost::nowide::fopen(path_tmp.c_str(), "wb");
+    if (file_tmp == nullptr) {
         BOOST_LOG_TRIVIAL(error) << std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n" << std::endl;
         if (!fs::exists(folder)) {
             //fs::create_directory(folder);
@@ -1886,6 +1895,7 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         }
         throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n");
     }
+    GCodeOutputStream file(file_tmp, m_processor.output_buffer(), m_processor);
 
     try {
         this->_do_export(*print, file, thumbnail_cb);
@@ -1967,7 +1977,12 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
                                                  extruder_unprintable_polys, m_print->get_extruder_printable_height(),  m_print->get_filament_maps(),
                                                  m_print->get_physical_unprintable_filaments(m_print->get_slice_used_filaments(false)));
 
-    m_processor.finalize(true);
+    try {
+        m_processor.finalize(true, &m_export_stats);
+    } catch (std::exception & /* ex */) {
+        boost::nowide::remove(path_tmp.c_str());
+        throw;
+    }
 //    DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     DoExport::update_print_estimated_stats(m_processor, m_writer.extruders(), print->m_print_statistics, print->config());
     if (result != nullptr) {
@@ -2299,6 +2314,7 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
     this->apply_print_config(print.config());
     m_config.apply(print.default_object_config());
     m_config.apply(print.default_region_config());
+    m_region_config_idx = -1;
 
     //m_volumetric_speed = DoExport::autospeed_volumetric_limit(print);
     print.throw_if_canceled();
@@ -3351,6 +3367,392 @@ size_t GCode::get_extruder_id(unsigned int filament_id) const
     return 0;
 }
 
+// Number of layers in flight in the G-code export pipeline. The generator and the stateful filters are serial,
+// the token count has to be high enough to keep them busy while the parallel filters work on other layers.
+static size_t gcode_pipeline_max_tokens()
+{
+    return std::max<size_t>(12, 2 * size_t(tbb::this_task_arena::max_concurrency()));
+}
+
+// Stages of a single run of the G-code export pipeline, added to GCode::export_stats() once the pipeline finishes.
+class GCodePipelineTimings
+{
+public:
+    GCodePipelineTimings() : m_start(std::chrono::steady_clock::now()) {}
+
+    GCodeExportStats::Scope measure(GCodeExportStats::Stage stage) { return m_stats.measure(stage); }
+    const GCodeExportStats& stats() const { return m_stats; }
+
+    void log(size_t num_layers, size_t max_tokens) const
+    {
+        auto ms = [](int64_t ns) { return double(ns) * 1e-6; };
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < GCodeExportStats::Count; ++ i)
+            if (int64_t ns = m_stats.stage(GCodeExportStats::Stage(i)).ns; ns > 0)
+                ss << " " << GCodeExportStats::stage_name(GCodeExportStats::Stage(i)) << " " << ms(ns) << "ms";
+        BOOST_LOG_TRIVIAL(info) << "process_layers: " << num_layers << " layers, " << max_tokens << " tokens, "
+            << ms(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()) << "ms total;" << ss.str();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    GCodeExportStats                      m_stats;
+};
+
+// Layer G-code handed over to GCodeOutputStream together with its lines tokenized.
+struct TokenizedLayer
+{
+    std::string                             gcode;
+    std::vector<GCodeReader::TokenizedLine> lines;
+};
+
+// Index of a pointer into Print::objects(), PrintObject::layers() or PrintObject::support_layers(), -1 if not found.
+template<typename Ptrs, typename T>
+static int index_of(const Ptrs &ptrs, const T *ptr)
+{
+    auto it = std::find(ptrs.begin(), ptrs.end(), ptr);
+    return it == ptrs.end() ? -1 : int(it - ptrs.begin());
+}
+
+static GCode::LayerState::LayerRef layer_state_ref(const Print &print, const Layer *layer)
+{
+    GCode::LayerState::LayerRef out;
+    if (layer != nullptr) {
+        const PrintObject *object = layer->object();
+        if (const SupportLayer *support_layer = dynamic_cast<const SupportLayer*>(layer); support_layer != nullptr) {
+            out.layer_idx = index_of(object->support_layers(), support_layer);
+            out.support   = true;
+        } else
+            out.layer_idx = index_of(object->layers(), layer);
+        out.object_idx = out.layer_idx == -1 ? -1 : index_of(print.objects(), object);
+    }
+    return out;
+}
+
+static const Layer* layer_state_layer(const Print &print, const GCode::LayerState::LayerRef &ref)
+{
+    if (ref.object_idx < 0 || ref.object_idx >= int(print.objects().size()))
+        return nullptr;
+    const PrintObject &object = *print.objects()[ref.object_idx];
+    if (ref.support)
+        return ref.layer_idx >= 0 && ref.layer_idx < int(object.support_layers().size()) ? object.support_layers()[ref.layer_idx] : nullptr;
+    return ref.layer_idx >= 0 && ref.layer_idx < int(object.layers().size()) ? object.layers()[ref.layer_idx] : nullptr;
+}
+
+bool GCode::can_use_gcode_export_cache(const Print &print) const
+{
+    // The state of the wipe tower, of the vase mode, of the pressure equalizer and of the fan mover is not saved.
+    // The timelapse position is picked considering the whole print, not just the layers below.
+    return m_writer.extruders().size() == 1 && ! m_wipe_tower && ! m_spiral_vase && ! m_pressure_equalizer &&
+        m_config.fan_speedup_time.value == 0 && m_config.fan_kickstart.value <= 0 &&
+        m_config.time_lapse_gcode.value.empty() && print.calib_params().mode == CalibMode::Calib_None;
+}
+
+namespace {
+class GCodeExportCacheHasher
+{
+public:
+    GCodeExportCacheHasher() { MD5_Init(&m_ctx); }
+
+    void update(const void *data, size_t size) { MD5_Update(&m_ctx, data, size); }
+    template<typename T> void update(T value)
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        this->update(&value, sizeof(T));
+    }
+    void update_size(size_t size) { this->update(uint64_t(size)); }
+    void update_string(const std::string &str)
+    {
+        this->update_size(str.size());
+        this->update(str.data(), str.size());
+    }
+    void update_config(const ConfigBase &config)
+    {
+        t_config_option_keys keys = config.keys();
+        std::sort(keys.begin(), keys.end());
+        this->update_size(keys.size());
+        for (const std::string &opt_key : keys) {
+            this->update_string(opt_key);
+            this->update_string(config.opt_serialize(opt_key));
+        }
+    }
+    void update_points(const Points &pts)
+    {
+        this->update_size(pts.size());
+        for (const Point &pt : pts) {
+            this->update(pt.x());
+            this->update(pt.y());
+        }
+    }
+
+    std::string digest() { return md5_final_hex(m_ctx); }
+
+private:
+    MD5_CTX m_ctx;
+};
+} // namespace
+
+// The key of a layer covers its extrusions, the seams and the custom G-code placed on it, the config and the print-wide
+// extrusions. The layers are compared by their content, thus the layers below a change of an object are spliced
+// even though the object was sliced again.
+std::vector<std::string> GCode::gcode_export_cache_keys(
+    const Print                                                         &print,
+    const ToolOrdering                                                  &tool_ordering,
+    const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
+    const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print) const
+{
+    GCodeExportCacheHasher global;
+    global.update_string(SLIC3R_VERSION);
+    global.update_config(print.config());
+    global.update_config(print.default_object_config());
+    global.update_config(print.default_region_config());
+    const Vec3d plate_origin = print.get_plate_origin();
+    global.update(plate_origin.data(), sizeof(double) * 3);
+    // The layer count is emitted with the progress of each layer.
+    global.update_size(layers_to_print.size());
+    if (! layers_to_print.empty())
+        global.update(layers_to_print.back().first);
+    auto update_extrusions = [&global](const std::map<ObjectID, ExtrusionEntityCollection> &map, ObjectID id) {
+        auto it = map.find(id);
+        global.update_string(it == map.end() ? std::string() : encode_cached_extrusions(it->second));
+    };
+    global.update_size(print.objects().size());
+    for (const PrintObject *object : print.objects()) {
+        global.update_config(object->config());
+        global.update_string(object->model_object()->name);
+        global.update_size(object->get_id());
+        global.update_size(object->instances().size());
+        for (const PrintInstance &instance : object->instances()) {
+            global.update(instance.shift.x());
+            global.update(instance.shift.y());
+            global.update_size(instance.model_instance->get_labeled_id());
+        }
+        global.update_string(encode_cached_extrusions(object->object_skirt()));
+        update_extrusions(print.m_brimMap, object->id());
+        update_extrusions(print.m_supportBrimMap, object->id());
+    }
+    // The labels of the objects, which are listed in the header, are referenced by the exclude object blocks of each layer.
+    global.update(m_enable_exclude_object);
+    global.update_size(m_label_objects_ids.size());
+    for (size_t id : m_label_objects_ids)
+        global.update_size(id);
+    global.update_string(encode_cached_extrusions(print.skirt()));
+    global.update_points(print.first_layer_convex_hull().points);
+    global.update_points(print.m_skirt_convex_hull);
+    global.update_size(print_object_instances_ordering.size());
+    for (const PrintInstance *instance : print_object_instances_ordering) {
+        global.update(index_of(print.objects(), instance->print_object));
+        global.update_size(instance - instance->print_object->instances().data());
+    }
+
+    std::vector<std::string> layer_keys(layers_to_print.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layers_to_print.size()), [this, &print, &tool_ordering, &layers_to_print, &layer_keys](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+            const auto &[print_z, layers] = layers_to_print[layer_idx];
+            GCodeExportCacheHasher hasher;
+            hasher.update(print_z);
+            const LayerTools &layer_tools = tool_ordering.tools_for_layer(print_z);
+            hasher.update(layer_tools.has_object);
+            hasher.update(layer_tools.has_support);
+            hasher.update_size(layer_tools.extruders.size());
+            for (unsigned int extruder_id : layer_tools.extruders)
+                hasher.update(extruder_id);
+            if (const CustomGCode::Item *custom_gcode = layer_tools.custom_gcode; custom_gcode != nullptr) {
+                hasher.update(custom_gcode->print_z);
+                hasher.update(custom_gcode->type);
+                hasher.update(custom_gcode->extruder);
+                hasher.update_string(custom_gcode->color);
+                hasher.update_string(custom_gcode->extra);
+            } else
+                hasher.update(false);
+            hasher.update_size(layers.size());
+            for (const LayerToPrint &layer_to_print : layers) {
+                hasher.update(index_of(print.objects(), layer_to_print.original_object));
+                if (const Layer *layer = layer_to_print.object_layer; layer != nullptr) {
+                    hasher.update_string(encode_cached_layer(*layer));
+                    hasher.update_size(layer->curled_lines.size());
+                    for (const CurledLine &line : layer->curled_lines) {
+                        hasher.update_points({ line.a, line.b });
+                        hasher.update(line.curled_height);
+                    }
+                    // Seams of a layer depend on the layers around it, if aligned.
+                    const PrintObject *object = layer->object();
+                    const size_t       raft_layers = object->slicing_parameters().raft_layers();
+                    if (auto it = m_seam_placer.m_seam_per_object.find(object);
+                        it != m_seam_placer.m_seam_per_object.end() && layer->id() >= raft_layers && layer->id() - raft_layers < it->second.layers.size()) {
+                        const PrintObjectSeamData::LayerSeams &seams = it->second.layers[layer->id() - raft_layers];
+                        hasher.update_size(seams.perimeters.size());
+                        for (const SeamPlacerImpl::Perimeter &perimeter : seams.perimeters) {
+                            hasher.update_size(perimeter.start_index);
+                            hasher.update_size(perimeter.end_index);
+                            hasher.update_size(perimeter.seam_index);
+                            hasher.update(perimeter.flow_width);
+                            hasher.update(perimeter.finalized);
+                            hasher.update(perimeter.final_seam_position.data(), sizeof(float) * 3);
+                        }
+                        hasher.update_size(seams.points.size());
+                        for (const SeamPlacerImpl::SeamCandidate &point : seams.points) {
+                            hasher.update(point.position.data(), sizeof(float) * 3);
+                            hasher.update(point.visibility);
+                            hasher.update(point.overhang);
+                            hasher.update(point.unsupported_dist);
+                            hasher.update(point.embedded_distance);
+                            hasher.update(point.local_ccw_angle);
+                            hasher.update(point.type);
+                            hasher.update(point.central_enforcer);
+                        }
+                    } else
+                        hasher.update_size(0);
+                } else
+                    hasher.update(false);
+                if (layer_to_print.support_layer != nullptr)
+                    hasher.update_string(encode_cached_support_layer(*layer_to_print.support_layer));
+                else
+                    hasher.update(false);
+            }
+            layer_keys[layer_idx] = hasher.digest();
+        }
+    });
+
+    // Chain the keys, so that the key of a layer covers the layers below.
+    std::string key = global.digest();
+    for (std::string &layer_key : layer_keys) {
+        GCodeExportCacheHasher hasher;
+        hasher.update_string(key);
+        hasher.update_string(layer_key);
+        layer_key = key = hasher.digest();
+    }
+    return layer_keys;
+}
+
+void GCode::save_layer_state(const Print &print, const LayerState *below, LayerState &state) const
+{
+    state.writer = m_writer.state();
+    state.region_config_idx = m_region_config_idx;
+    // The global variables are only set by the custom G-code, thus they rarely change from layer to layer.
+    state.placeholder_globals.reset();
+    if (const DynamicConfig *globals = m_placeholder_parser_integration.context.global_config.get(); globals != nullptr && ! globals->empty())
+        state.placeholder_globals = below != nullptr && below->placeholder_globals && *below->placeholder_globals == *globals ?
+            below->placeholder_globals : std::make_shared<const DynamicConfig>(*globals);
+    state.wipe_path                       = m_wipe.path;
+    state.avoid_crossing_perimeters       = m_avoid_crossing_perimeters.state();
+    state.avoid_crossing_perimeters_layer = layer_state_ref(print, m_avoid_crossing_perimeters.layer());
+    state.quality_estimator_layers.clear();
+    for (const auto &[object, layers] : m_extrusion_quality_estimator.get_prepared_layers())
+        state.quality_estimator_layers.push_back({ index_of(print.objects(), object), layer_state_ref(print, layers.first), layer_state_ref(print, layers.second) });
+    state.origin                          = m_origin;
+    state.last_pos                        = m_last_pos;
+    state.last_pos_defined                = m_last_pos_defined;
+    state.layer                           = layer_state_ref(print, m_layer);
+    state.object_layer_over_raft          = m_object_layer_over_raft;
+    state.layer_index                     = m_layer_index;
+    state.last_processor_extrusion_role   = m_last_processor_extrusion_role;
+    state.last_extrusion_role             = m_last_extrusion_role;
+    state.last_notgapfill_extrusion_role  = m_last_notgapfill_extrusion_role;
+    state.last_height                     = m_last_height;
+    state.last_layer_z                    = m_last_layer_z;
+    state.max_layer_z                     = m_max_layer_z;
+    state.last_width                      = m_last_width;
+#if ENABLE_GCODE_VIEWER_DATA_CHECKING
+    state.last_mm3_per_mm                 = m_last_mm3_per_mm;
+#endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
+    state.skirt_done                      = m_skirt_done;
+    state.brim_done                       = m_brim_done;
+    state.second_layer_things_done        = m_second_layer_things_done;
+    state.objs_with_brim.clear();
+    state.obj_supports_with_brim.clear();
+    for (const PrintObject *object : print.objects()) {
+        if (m_objsWithBrim.count(object->id()))
+            state.objs_with_brim.emplace_back(index_of(print.objects(), object));
+        if (m_objSupportsWithBrim.count(object->id()))
+            state.obj_supports_with_brim.emplace_back(index_of(print.objects(), object));
+    }
+    state.last_obj_copy_object            = index_of(print.objects(), m_last_obj_copy.first);
+    state.last_obj_copy_point             = m_last_obj_copy.second;
+    state.toolchange_count                = m_toolchange_count;
+    state.nominal_z                       = m_nominal_z;
+    state.need_change_layer_lift_z        = m_need_change_layer_lift_z;
+    state.start_gcode_filament            = m_start_gcode_filament;
+    state.filament_instances_code         = m_filament_instances_code;
+    state.initial_layer_extruders         = m_initial_layer_extruders;
+    state.support_traditional_timelapse   = m_support_traditional_timelapse;
+    state.enable_loop_clipping            = m_enable_loop_clipping;
+    state.resonance_avoidance             = m_resonance_avoidance;
+    state.timelapse_warning_code          = m_timelapse_warning_code;
+    state.is_role_based_fan_on            = m_is_role_based_fan_on;
+    state.multi_flow_segment_path_average_mm3_per_mm = m_multi_flow_segment_path_average_mm3_per_mm;
+    state.multi_flow_segment_path_pa_set  = m_multi_flow_segment_path_pa_set;
+    state.last_mm3_mm                     = m_last_mm3_mm;
+}
+
+void GCode::restore_layer_state(const Print &print, const LayerState &state)
+{
+    m_writer.restore_state(state.writer);
+    m_region_config_idx = state.region_config_idx;
+    m_config.apply(m_region_config_idx == -1 ? print.default_region_config() : print.get_print_region(m_region_config_idx).config());
+    if (m_placeholder_parser_integration.context.global_config) {
+        if (state.placeholder_globals)
+            *m_placeholder_parser_integration.context.global_config = *state.placeholder_globals;
+        else
+            m_placeholder_parser_integration.context.global_config->clear();
+    }
+    m_wipe.path = state.wipe_path;
+    m_avoid_crossing_perimeters.restore_state(state.avoid_crossing_perimeters);
+    if (const Layer *layer = layer_state_layer(print, state.avoid_crossing_perimeters_layer); layer != nullptr)
+        m_avoid_crossing_perimeters.init_layer(*layer);
+    ExtrusionQualityEstimator::PreparedLayers quality_estimator_layers;
+    for (const LayerState::QualityEstimatorLayers &layers : state.quality_estimator_layers)
+        if (layers.object_idx != -1)
+            quality_estimator_layers[print.objects()[layers.object_idx]] = { layer_state_layer(print, layers.prev), layer_state_layer(print, layers.last) };
+    m_extrusion_quality_estimator.restore_prepared_layers(quality_estimator_layers);
+    // The islands cached for the last layer may belong to a layer, which was sliced again.
+    m_retract_when_crossing_perimeters.reset();
+    m_origin                          = state.origin;
+    m_last_pos                        = state.last_pos;
+    m_last_pos_defined                = state.last_pos_defined;
+    m_layer                           = layer_state_layer(print, state.layer);
+    m_object_layer_over_raft          = state.object_layer_over_raft;
+    m_layer_index                     = state.layer_index;
+    m_last_processor_extrusion_role   = state.last_processor_extrusion_role;
+    m_last_extrusion_role             = state.last_extrusion_role;
+    m_last_notgapfill_extrusion_role  = state.last_notgapfill_extrusion_role;
+    m_last_height                     = state.last_height;
+    m_last_layer_z                    = state.last_layer_z;
+    m_max_layer_z                     = state.max_layer_z;
+    m_last_width                      = state.last_width;
+#if ENABLE_GCODE_VIEWER_DATA_CHECKING
+    m_last_mm3_per_mm                 = state.last_mm3_per_mm;
+#endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
+    m_skirt_done                      = state.skirt_done;
+    m_brim_done                       = state.brim_done;
+    m_second_layer_things_done        = state.second_layer_things_done;
+    m_objsWithBrim.clear();
+    for (int object_idx : state.objs_with_brim)
+        m_objsWithBrim.insert(print.objects()[object_idx]->id());
+    m_objSupportsWithBrim.clear();
+    for (int object_idx : state.obj_supports_with_brim)
+        m_objSupportsWithBrim.insert(print.objects()[object_idx]->id());
+    m_last_obj_copy                   = { state.last_obj_copy_object == -1 ? nullptr : print.objects()[state.last_obj_copy_object], state.last_obj_copy_point };
+    m_toolchange_count                = state.toolchange_count;
+    m_nominal_z                       = state.nominal_z;
+    m_need_change_layer_lift_z        = state.need_change_layer_lift_z;
+    m_start_gcode_filament            = state.start_gcode_filament;
+    m_filament_instances_code         = state.filament_instances_code;
+    m_initial_layer_extruders         = state.initial_layer_extruders;
+    m_support_traditional_timelapse   = state.support_traditional_timelapse;
+    m_enable_loop_clipping            = state.enable_loop_clipping;
+    m_resonance_avoidance             = state.resonance_avoidance;
+    m_timelapse_warning_code          = state.timelapse_warning_code;
+    m_is_role_based_fan_on            = state.is_role_based_fan_on;
+    m_multi_flow_segment_path_average_mm3_per_mm = state.multi_flow_segment_path_average_mm3_per_mm;
+    m_multi_flow_segment_path_pa_set  = state.multi_flow_segment_path_pa_set;
+    m_last_mm3_mm                     = state.last_mm3_mm;
+    m_cooling_buffer->restore_parse_state(state.cooling_parse);
+    m_cooling_buffer->restore_apply_state(state.cooling_apply);
+    m_pa_processor->restore_state(state.pa_processor);
+}
+
 // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
 // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
 // and export G-code into file.
@@ -3362,9 +3764,67 @@ void GCode::process_layers(
     GCodeOutputStream                                                   &output_stream)
 {
     // The pipeline is variable: The vase mode filter is optional.
-    size_t layer_to_print_idx = 0;
+    size_t               layer_to_print_idx = 0;
+    GCodePipelineTimings timings;
+
+    // Incremental export: The leading layers, which did not change since the last export, are written from the cache,
+    // then the state after the last of them is restored and the pipeline continues with the next layer.
+    // The stages of the pipeline save their state after each layer into the new content of the cache.
+    GCodeExportCache                          *cache = print.m_gcode_export_cache.get();
+    std::vector<GCodeExportCache::CachedLayer> cached_layers;
+    if (cache != nullptr && ! this->can_use_gcode_export_cache(print)) {
+        cache->clear();
+        cache = nullptr;
+    }
+    if (cache != nullptr) {
+        std::vector<std::string> keys = this->gcode_export_cache_keys(print, tool_ordering, print_object_instances_ordering, layers_to_print);
+        const size_t num_cached = cache->matching_layers(keys);
+        // The cache stays empty until this export finishes, thus a canceled export leaves no stale layers behind.
+        cached_layers = std::move(cache->layers);
+        cache->clear();
+        cached_layers.resize(layers_to_print.size());
+        for (size_t i = 0; i < keys.size(); ++ i)
+            cached_layers[i].key = std::move(keys[i]);
+        if (num_cached > 0) {
+            using CachedLines = std::pair<size_t, std::vector<GCodeReader::TokenizedLine>>;
+            size_t cached_idx = 0;
+            tbb::parallel_pipeline(gcode_pipeline_max_tokens(),
+                tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order,
+                    [&cached_idx, num_cached](tbb::flow_control &fc) -> size_t {
+                        if (cached_idx == num_cached)
+                            fc.stop();
+                        return cached_idx ++;
+                    }) &
+                tbb::make_filter<size_t, CachedLines>(slic3r_tbb_filtermode::parallel,
+                    [&cached_layers, &timings](size_t idx) -> CachedLines {
+                        auto timer = timings.measure(GCodeExportStats::Tokenize);
+                        return { idx, GCodeReader::tokenize_buffer(cached_layers[idx].gcode) };
+                    }) &
+                tbb::make_filter<CachedLines, CachedLines>(slic3r_tbb_filtermode::serial_in_order,
+                    [&cached_layers, &output_stream, &timings](CachedLines layer) -> CachedLines {
+                        auto timer = timings.measure(GCodeExportStats::Output);
+                        output_stream.write_text(cached_layers[layer.first].gcode);
+                        return layer;
+                    }) &
+                tbb::make_filter<CachedLines, void>(slic3r_tbb_filtermode::serial_in_order,
+                    [&cached_layers, &output_stream, &timings](CachedLines layer) {
+                        auto timer = timings.measure(GCodeExportStats::Process);
+                        output_stream.process(cached_layers[layer.first].gcode, layer.second);
+                    }));
+            this->restore_layer_state(print, cached_layers[num_cached - 1].state);
+            layer_to_print_idx = num_cached;
+        }
+        BOOST_LOG_TRIVIAL(info) << "process_layers: " << num_cached << " of " << layers_to_print.size() << " layers written from the G-code export cache";
+    }
+    GCodeExportCache::CachedLayer *cached = cache != nullptr ? cached_layers.data() : nullptr;
+    // Layers passed by the stages, which save their state into the cache.
+    size_t cooling_parse_idx = layer_to_print_idx;
+    size_t cooling_apply_idx = layer_to_print_idx;
+    size_t pa_processor_idx  = layer_to_print_idx;
+    size_t write_idx         = layer_to_print_idx;
+
     const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> LayerResult {
+        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx, &timings, cached](tbb::flow_control& fc) -> LayerResult {
             if (layer_to_print_idx >= layers_to_print.size()) {
                 if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0)) {
                     fc.stop();
@@ -3384,7 +3844,11 @@ void GCode::process_layers(
                 //BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
-                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, tool_ordering.get_most_used_extruder(), size_t(-1));
+                auto timer = timings.measure(GCodeExportStats::Generate);
+                LayerResult result = this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, tool_ordering.get_most_used_extruder(), size_t(-1));
+                if (cached != nullptr)
+                    this->save_layer_state(print, layer_to_print_idx > 1 ? &cached[layer_to_print_idx - 2].state : nullptr, cached[layer_to_print_idx - 1].state);
+                return result;
             }
         });
     if (m_spiral_vase) {
@@ -3393,40 +3857,90 @@ void GCode::process_layers(
         this->m_spiral_vase->set_max_xy_smoothing(max_xy_smoothing);
     }
     const auto spiral_mode = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](LayerResult in) -> LayerResult {
+        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print, &timings](LayerResult in) -> LayerResult {
         	if (in.nop_layer_result)
                 return in;
-                
+            auto timer = timings.measure(GCodeExportStats::SpiralVase);
             spiral_mode.enable(in.spiral_vase_enable);
             bool last_layer = in.layer_id == layers_to_print.size() - 1;
             return { spiral_mode.process_layer(std::move(in.gcode), last_layer), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush};
         });
     const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
+        [pressure_equalizer = this->m_pressure_equalizer.get(), &timings](LayerResult in) -> LayerResult {
+            auto timer = timings.measure(GCodeExportStats::PressureEqualizer);
             return pressure_equalizer->process_layer(std::move(in));
         });
-    const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&cooling_buffer = *this->m_cooling_buffer.get()](LayerResult in) -> std::string {
-        	if (in.nop_layer_result)
-                return in.gcode;
-            return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+    // The cooling buffer parses and emits the layers in order, the slow down of a layer is independent of the other layers.
+    const auto cooling_parse = tbb::make_filter<LayerResult, CoolingBuffer::ParsedLayer>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get(), &timings, cached, &cooling_parse_idx](LayerResult in) -> CoolingBuffer::ParsedLayer {
+            if (in.nop_layer_result) {
+                // Passed through by CoolingBuffer::apply_layer().
+                CoolingBuffer::ParsedLayer out;
+                out.gcode = std::move(in.gcode);
+                return out;
+            }
+            auto timer = timings.measure(GCodeExportStats::CoolingParse);
+            CoolingBuffer::ParsedLayer out = cooling_buffer.parse_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+            if (cached != nullptr)
+                cached[cooling_parse_idx ++].state.cooling_parse = cooling_buffer.parse_state();
+            return out;
+        });
+    const auto cooling_slow_down = tbb::make_filter<CoolingBuffer::ParsedLayer, CoolingBuffer::ParsedLayer>(slic3r_tbb_filtermode::parallel,
+        [&timings](CoolingBuffer::ParsedLayer in) -> CoolingBuffer::ParsedLayer {
+            auto timer = timings.measure(GCodeExportStats::CoolingSlowDown);
+            CoolingBuffer::slow_down_layer(in);
+            return in;
         });
+    const auto cooling_apply = tbb::make_filter<CoolingBuffer::ParsedLayer, std::string>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get(), &timings, cached, &cooling_apply_idx](CoolingBuffer::ParsedLayer in) -> std::string {
+            auto timer = timings.measure(GCodeExportStats::CoolingApply);
+            std::string out = cooling_buffer.apply_layer(std::move(in));
+            if (cached != nullptr)
+                cached[cooling_apply_idx ++].state.cooling_apply = cooling_buffer.apply_state();
+            return out;
+        });
+    const auto cooling = cooling_parse & cooling_slow_down & cooling_apply;
     const auto pa_processor_filter = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-            [&pa_processor = *this->m_pa_processor](std::string in) -> std::string {
-                return pa_processor.process_layer(std::move(in));
+            [&pa_processor = *this->m_pa_processor, &timings, cached, &pa_processor_idx](std::string in) -> std::string {
+                auto timer = timings.measure(GCodeExportStats::PAProcessor);
+                std::string out = pa_processor.process_layer(std::move(in));
+                if (cached != nullptr)
+                    cached[pa_processor_idx ++].state.pa_processor = pa_processor.state();
+                return out;
             }
         );
     
-    const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+    // The layers are tokenized in parallel, the G-code processor of the output stream only replays the tokenized lines.
+    const auto tokenize = tbb::make_filter<std::string, TokenizedLayer>(slic3r_tbb_filtermode::parallel,
+        [&timings](std::string s) -> TokenizedLayer {
+            auto timer = timings.measure(GCodeExportStats::Tokenize);
+            std::vector<GCodeReader::TokenizedLine> lines = GCodeReader::tokenize_buffer(s);
+            return { std::move(s), std::move(lines) };
+        });
+    // Writing and processing are separate serial stages, thus the next layer is written while the G-code processor works on this one.
+    const auto write = tbb::make_filter<TokenizedLayer, TokenizedLayer>(slic3r_tbb_filtermode::serial_in_order,
+        [&output_stream, &timings, cached, &write_idx](TokenizedLayer layer) -> TokenizedLayer {
+            auto timer = timings.measure(GCodeExportStats::Output);
+            output_stream.write_text(layer.gcode);
+            if (cached != nullptr)
+                cached[write_idx ++].gcode = layer.gcode;
+            return layer;
+        });
+    const auto process = tbb::make_filter<TokenizedLayer, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&output_stream, &timings](TokenizedLayer layer) {
+            auto timer = timings.measure(GCodeExportStats::Process);
+            output_stream.process(layer.gcode, layer.lines);
+        }
     );
+    const auto output = tokenize & write & process;
 
     const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in)->std::string {
+            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer, &timings](std::string in)->std::string {
 
         CNumericLocalesSetter locales_setter;
 
         if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
+            auto timer = timings.measure(GCodeExportStats::FanMover);
             if (fan_mover.get() == nullptr)
                 fan_mover.reset(new Slic3r::FanMover(
                     writer,
@@ -3442,14 +3956,19 @@ void GCode::process_layers(
     });
 
     // The pipeline elements are joined using const references, thus no copying is performed.
+    const size_t max_tokens = gcode_pipeline_max_tokens();
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(max_tokens, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
     else if (m_spiral_vase)
-    	tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+    	tbb::parallel_pipeline(max_tokens, generator & spiral_mode & cooling & fan_mover & output);
     else if	(m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(max_tokens, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
     else
-    	tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+    	tbb::parallel_pipeline(max_tokens, generator & cooling & fan_mover & pa_processor_filter & output);
+    timings.log(layers_to_print.size(), max_tokens);
+    m_export_stats += timings.stats();
+    if (cache != nullptr)
+        cache->layers = std::move(cached_layers);
 
 }
 
@@ -3466,9 +3985,10 @@ void GCode::process_layers(
     const bool                               prime_extruder)
 {
     // The pipeline is variable: The vase mode filter is optional.
-    size_t layer_to_print_idx = 0;
+    size_t               layer_to_print_idx = 0;
+    GCodePipelineTimings timings;
     const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx, prime_extruder](tbb::flow_control& fc) -> LayerResult {
+        [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, &timings, single_object_idx, prime_extruder](tbb::flow_control& fc) -> LayerResult {
             if (layer_to_print_idx >= layers_to_print.size()) {
                 if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0)) {
                     fc.stop();
@@ -3485,6 +4005,7 @@ void GCode::process_layers(
                 //BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
+                auto timer = timings.measure(GCodeExportStats::Generate);
                 return this->process_layer(print, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, tool_ordering.get_most_used_extruder(), single_object_idx, prime_extruder);
             }
         });
@@ -3494,37 +4015,77 @@ void GCode::process_layers(
         this->m_spiral_vase->set_max_xy_smoothing(max_xy_smoothing);
     }
     const auto spiral_mode = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](LayerResult in)->LayerResult {
+        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print, &timings](LayerResult in)->LayerResult {
             if (in.nop_layer_result)
                 return in;
+            auto timer = timings.measure(GCodeExportStats::SpiralVase);
             spiral_mode.enable(in.spiral_vase_enable);
             bool last_layer = in.layer_id == layers_to_print.size() - 1;
             return { spiral_mode.process_layer(std::move(in.gcode), last_layer), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
         });
     const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
-             return pressure_equalizer->process_layer(std::move(in));
+        [pressure_equalizer = this->m_pressure_equalizer.get(), &timings](LayerResult in) -> LayerResult {
+            auto timer = timings.measure(GCodeExportStats::PressureEqualizer);
+            return pressure_equalizer->process_layer(std::move(in));
         });
-    const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&cooling_buffer = *this->m_cooling_buffer.get()](LayerResult in)->std::string {
-            if (in.nop_layer_result)
-                return in.gcode;
-            return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+    // The cooling buffer parses and emits the layers in order, the slow down of a layer is independent of the other layers.
+    const auto cooling_parse = tbb::make_filter<LayerResult, CoolingBuffer::ParsedLayer>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get(), &timings](LayerResult in) -> CoolingBuffer::ParsedLayer {
+            if (in.nop_layer_result) {
+                // Passed through by CoolingBuffer::apply_layer().
+                CoolingBuffer::ParsedLayer out;
+                out.gcode = std::move(in.gcode);
+                return out;
+            }
+            auto timer = timings.measure(GCodeExportStats::CoolingParse);
+            return cooling_buffer.parse_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+        });
+    const auto cooling_slow_down = tbb::make_filter<CoolingBuffer::ParsedLayer, CoolingBuffer::ParsedLayer>(slic3r_tbb_filtermode::parallel,
+        [&timings](CoolingBuffer::ParsedLayer in) -> CoolingBuffer::ParsedLayer {
+            auto timer = timings.measure(GCodeExportStats::CoolingSlowDown);
+            CoolingBuffer::slow_down_layer(in);
+            return in;
+        });
+    const auto cooling_apply = tbb::make_filter<CoolingBuffer::ParsedLayer, std::string>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get(), &timings](CoolingBuffer::ParsedLayer in) -> std::string {
+            auto timer = timings.measure(GCodeExportStats::CoolingApply);
+            return cooling_buffer.apply_layer(std::move(in));
         });
+    const auto cooling = cooling_parse & cooling_slow_down & cooling_apply;
     const auto pa_processor_filter = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&pa_processor = *this->m_pa_processor](std::string in) -> std::string {
+        [&pa_processor = *this->m_pa_processor, &timings](std::string in) -> std::string {
+            auto timer = timings.measure(GCodeExportStats::PAProcessor);
             return pa_processor.process_layer(std::move(in));
         }
     );
     
-    const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+    // The layers are tokenized in parallel, the G-code processor of the output stream only replays the tokenized lines.
+    const auto tokenize = tbb::make_filter<std::string, TokenizedLayer>(slic3r_tbb_filtermode::parallel,
+        [&timings](std::string s) -> TokenizedLayer {
+            auto timer = timings.measure(GCodeExportStats::Tokenize);
+            std::vector<GCodeReader::TokenizedLine> lines = GCodeReader::tokenize_buffer(s);
+            return { std::move(s), std::move(lines) };
+        });
+    // Writing and processing are separate serial stages, thus the next layer is written while the G-code processor works on this one.
+    const auto write = tbb::make_filter<TokenizedLayer, TokenizedLayer>(slic3r_tbb_filtermode::serial_in_order,
+        [&output_stream, &timings](TokenizedLayer layer) -> TokenizedLayer {
+            auto timer = timings.measure(GCodeExportStats::Output);
+            output_stream.write_text(layer.gcode);
+            return layer;
+        });
+    const auto process = tbb::make_filter<TokenizedLayer, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&output_stream, &timings](TokenizedLayer layer) {
+            auto timer = timings.measure(GCodeExportStats::Process);
+            output_stream.process(layer.gcode, layer.lines);
+        }
     );
+    const auto output = tokenize & write & process;
 
     const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in)->std::string {
+        [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer, &timings](std::string in)->std::string {
 
         if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
+            auto timer = timings.measure(GCodeExportStats::FanMover);
             if (fan_mover.get() == nullptr)
                 fan_mover.reset(new Slic3r::FanMover(
                     writer,
@@ -3540,14 +4101,17 @@ void GCode::process_layers(
     });
 
     // The pipeline elements are joined using const references, thus no copying is performed.
+    const size_t max_tokens = gcode_pipeline_max_tokens();
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(max_tokens, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
     else if (m_spiral_vase)
-    	tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+    	tbb::parallel_pipeline(max_tokens, generator & spiral_mode & cooling & fan_mover & output);
     else if	(m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(max_tokens, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
     else
-    	tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+    	tbb::parallel_pipeline(max_tokens, generator & cooling & fan_mover & pa_processor_filter & output);
+    timings.log(layers_to_print.size(), max_tokens);
+    m_export_stats += timings.stats();
 }
 
 std::string GCode::placeholder_parser_process(const std::string &name, const std::string &templ, unsigned int current_filament_id, const DynamicConfig *config_override)
@@ -4947,6 +5511,7 @@ LayerResult GCode::process_layer(
                     instance_to_print.print_object.slicing_parameters().raft_layers() == layer_to_print.object_layer->id();
                 m_config.apply(print.default_region_config());
                 m_config.apply(instance_to_print.print_object.config(), true);
+                m_region_config_idx = -1;
                 m_layer = layer_to_print.layer();
                 m_object_layer_over_raft = object_layer_over_raft;
                 if (m_config.reduce_crossing_wall)
@@ -5725,7 +6290,8 @@ std::string GCode::extrude_perimeters(const Print &print, const std::vector<Obje
     std::string gcode;
     for (const ObjectByExtruder::Island::Region &region : by_region)
         if (! region.perimeters.empty()) {
-            m_config.apply(print.get_print_region(&region - &by_region.front()).config());
+            m_region_config_idx = int(&region - &by_region.front());
+            m_config.apply(print.get_print_region(m_region_config_idx).config());
             // BBS: for first layer, we always print wall firstly to get better bed adhesive force
             // This behaviour is same with cura
             const bool should_print = is_first_layer ? !is_infill_first
@@ -5752,7 +6318,8 @@ std::string GCode::extrude_infill(const Print &print, const std::vector<ObjectBy
                 if ((ee->role() == erIroning) == ironing)
                     extrusions.emplace_back(ee);
             if (! extrusions.empty()) {
-                m_config.apply(print.get_print_region(&region - &by_region.front()).config());
+                m_region_config_idx = int(&region - &by_region.front());
+                m_config.apply(print.get_print_region(m_region_config_idx).config());
                 chain_and_reorder_extrusion_entities(extrusions, &m_last_pos);
                 for (const ExtrusionEntity *fill : extrusions) {
                     auto *eec = dynamic_cast<const ExtrusionEntityCollection*>(fill);
@@ -5826,12 +6393,13 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
 
 bool GCode::GCodeOutputStream::is_error() const
 {
-    return ::ferror(this->f);
+    return this->f != nullptr && ::ferror(this->f);
 }
 
 void GCode::GCodeOutputStream::flush()
 {
-    ::fflush(this->f);
+    if (this->f)
+        ::fflush(this->f);
 }
 
 void GCode::GCodeOutputStream::close()
@@ -5844,13 +6412,47 @@ void GCode::GCodeOutputStream::close()
 
 void GCode::GCodeOutputStream::write(const char *what)
 {
-    if (what != nullptr) {
-        const char* gcode = what;
-        // writes string to file
-        fwrite(gcode, 1, ::strlen(gcode), this->f);
-        //FIXME don't allocate a string, maybe process a batch of lines?
-        m_processor.process_buffer(std::string(gcode));
-    }
+    if (what != nullptr)
+        this->write(what, ::strlen(what));
+}
+
+void GCode::GCodeOutputStream::write(const char *what, size_t len)
+{
+    // writes string to file
+    this->write_raw(what, len);
+    // what is zero terminated, the G-code processor parses it in place.
+    m_processor.process_buffer(what, what + len);
+}
+
+void GCode::GCodeOutputStream::write(const std::string &what, const std::vector<GCodeReader::TokenizedLine> &lines)
+{
+    this->write_text(what);
+    this->process(what, lines);
+}
+
+void GCode::GCodeOutputStream::write_text(const std::string &what)
+{
+    // The same length as write(const char*), GCodeReader::tokenize_buffer() stops at the first zero character too.
+    this->write_raw(what.c_str(), ::strlen(what.c_str()));
+}
+
+void GCode::GCodeOutputStream::process(const std::string &what, const std::vector<GCodeReader::TokenizedLine> &lines)
+{
+    m_processor.process_buffer(what, lines);
+}
+
+void GCode::GCodeOutputStream::write_raw(const char *what, size_t len)
+{
+    if (m_buffer) {
+        m_buffer->append(what, len);
+        if (m_buffer->size() > max_buffer_size) {
+            BOOST_LOG_TRIVIAL(info) << "G-code output exceeds " << (max_buffer_size >> 20) << " MB, writing it to the file.";
+            fwrite(m_buffer->data(), 1, m_buffer->size(), this->f);
+            m_processor.release_output_buffer();
+            m_buffer = nullptr;
+        }
+    } else
+        fwrite(what, 1, len, this->f);
 }
 
 void GCode::GCodeOutputStream::writeln(const std::string &what)
@@ -10,6 +10,7 @@
 #include "PrintConfig.hpp"
 #include "GCode/AvoidCrossingPerimeters.hpp"
 #include "GCode/CoolingBuffer.hpp"
+#include "GCode/ExportStats.hpp"
 #include "GCode/FanMover.hpp"
 #include "GCode/RetractWhenCrossingPerimeters.hpp"
 #include "GCode/SpiralVase.hpp"
@@ -213,6 +214,8 @@ public:
     // throws CanceledException through print->throw_if_canceled().
     void            do_export(Print* print, const char* path, GCodeProcessorResult* result = nullptr, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
     void            export_layer_filaments(GCodeProcessorResult* result);
+    // Stages of the last do_export().
+    const GCodeExportStats& export_stats() const { return m_export_stats; }
     //BBS: set offset for gcode writer
     void set_gcode_offset(double x, double y) { m_writer.set_xy_offset(x, y); m_processor.set_xy_offset(x, y);}
 
@@ -299,21 +302,102 @@ public:
         }
     };
 
+    // State of the G-code generator and of its filters after a layer, saved and restored by the incremental G-code export.
+    // Layers and objects are referenced by indices, as they may be recreated by the next slicing with the same content.
+    struct LayerState
+    {
+        struct LayerRef {
+            // Index into Print::objects(), -1 for no layer.
+            int  object_idx { -1 };
+            // Index into PrintObject::layers() or PrintObject::support_layers().
+            int  layer_idx  { -1 };
+            bool support    { false };
+        };
+        struct QualityEstimatorLayers {
+            int      object_idx;
+            LayerRef prev;
+            LayerRef last;
+        };
+
+        GCodeWriter::State                  writer;
+        // The region config applied to m_config, see m_region_config_idx.
+        int                                 region_config_idx { -1 };
+        // Global variables of the custom G-code, shared with the state of the layer below if unchanged, null if none.
+        std::shared_ptr<const DynamicConfig> placeholder_globals;
+        Polyline                            wipe_path;
+        AvoidCrossingPerimeters::State      avoid_crossing_perimeters;
+        LayerRef                            avoid_crossing_perimeters_layer;
+        std::vector<QualityEstimatorLayers> quality_estimator_layers;
+        Vec2d                               origin { Vec2d::Zero() };
+        Point                               last_pos;
+        bool                                last_pos_defined { false };
+        LayerRef                            layer;
+        bool                                object_layer_over_raft { false };
+        int                                 layer_index { -1 };
+        ExtrusionRole                       last_processor_extrusion_role { erNone };
+        ExtrusionRole                       last_extrusion_role { erNone };
+        ExtrusionRole                       last_notgapfill_extrusion_role { erNone };
+        float                               last_height { 0.f };
+        float                               last_layer_z { 0.f };
+        float                               max_layer_z { 0.f };
+        float                               last_width { 0.f };
+#if ENABLE_GCODE_VIEWER_DATA_CHECKING
+        double                              last_mm3_per_mm { 0. };
+#endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
+        std::vector<coordf_t>               skirt_done;
+        bool                                brim_done { false };
+        bool                                second_layer_things_done { false };
+        // Indices into Print::objects().
+        std::vector<int>                    objs_with_brim;
+        std::vector<int>                    obj_supports_with_brim;
+        int                                 last_obj_copy_object { -1 };
+        Point                               last_obj_copy_point;
+        unsigned int                        toolchange_count { 0 };
+        coordf_t                            nominal_z { 0. };
+        bool                                need_change_layer_lift_z { false };
+        int                                 start_gcode_filament { -1 };
+        std::string                         filament_instances_code;
+        std::set<unsigned int>              initial_layer_extruders;
+        bool                                support_traditional_timelapse { true };
+        bool                                enable_loop_clipping { true };
+        bool                                resonance_avoidance { true };
+        int                                 timelapse_warning_code { 0 };
+        std::array<bool, ExtrusionRole::erCount> is_role_based_fan_on {};
+        double                              multi_flow_segment_path_average_mm3_per_mm { 0. };
+        bool                                multi_flow_segment_path_pa_set { false };
+        double                              last_mm3_mm { 0. };
+        // Saved by the pipeline stages of the filters, which run behind the G-code generator.
+        CoolingBuffer::ParseState           cooling_parse;
+        CoolingBuffer::ApplyState           cooling_apply;
+        AdaptivePAProcessor::State          pa_processor;
+    };
+
 private:
     class GCodeOutputStream {
     public:
         GCodeOutputStream(FILE *f, GCodeProcessor &processor) : f(f), m_processor(processor) {}
+        // Appends to GCodeProcessor::output_buffer() instead of writing f. Once the buffer grows over max_buffer_size,
+        // it is written to f and released, and the rest of the G-code is written to f.
+        GCodeOutputStream(FILE *f, std::string &buffer, GCodeProcessor &processor) : f(f), m_buffer(&buffer), m_processor(processor) {}
         ~GCodeOutputStream() { this->close(); }
 
-        bool is_open() const { return f; }
+        bool is_open() const { return f != nullptr || m_buffer != nullptr; }
         bool is_error() const;
 
         void flush();
         void close();
 
         // Write a string into a file.
+        // The string is handed over to the G-code processor in place, without copying.
+        // The G-code processor stops at the first zero character, thus the strings are written up to it as well.
         void write(const std::string& what) { this->write(what.c_str()); }
         void write(const char* what);
+        // Write a string with its lines tokenized by GCodeReader::tokenize_buffer(), the G-code processor does not parse it again.
+        void write(const std::string& what, const std::vector<GCodeReader::TokenizedLine>& lines);
+        // write() split in two, so that a pipeline may write the next layer while the G-code processor works on this one.
+        // Both have to be called for the same strings in the same order.
+        void write_text(const std::string& what);
+        void process(const std::string& what, const std::vector<GCodeReader::TokenizedLine>& lines);
 
         // Write a string into a file.
         // Add a newline, if the string does not end with a newline already.
@@ -324,7 +408,14 @@ private:
         void write_format(const char* format, ...);
 
     private:
+        void write(const char *what, size_t len);
+        void write_raw(const char *what, size_t len);
+
+        // Larger G-code is post-processed from the file, so that the memory used does not grow with the size of the G-code.
+        static constexpr const size_t max_buffer_size = size_t(128) << 20;
+
         FILE *f = nullptr;
+        std::string *m_buffer = nullptr;
         GCodeProcessor &m_processor;
     };
     void            _do_export(Print &print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb);
@@ -376,6 +467,18 @@ private:
         // BBS
         const bool                               prime_extruder = false);
 
+    // Incremental G-code export, see GCodeExportCache.
+    bool                     can_use_gcode_export_cache(const Print &print) const;
+    // Keys of the layers to print, each of them covering the layer and all the layers below.
+    std::vector<std::string> gcode_export_cache_keys(
+        const Print                                                         &print,
+        const ToolOrdering                                                  &tool_ordering,
+        const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
+        const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print) const;
+    // The state of the filters is left to the pipeline stages.
+    void                     save_layer_state(const Print &print, const LayerState *below, LayerState &state) const;
+    void                     restore_layer_state(const Print &print, const LayerState &state);
+
     //BBS
     void check_placeholder_parser_failed();
     size_t get_extruder_id(unsigned int filament_id) const;
@@ -561,6 +664,8 @@ private:
     const Layer*                        m_layer;
     // m_layer is an object layer and it is being printed over raft surface.
     bool                                m_object_layer_over_raft;
+    // Index into Print::print_regions() of the region config last applied to m_config, -1 for the default region config.
+    int                                 m_region_config_idx { -1 };
     //double                              m_volumetric_speed;
     // Support for the extrusion role markers. Which marker is active?
     ExtrusionRole                       m_last_extrusion_role;
@@ -621,6 +726,7 @@ private:
 
     // Processor
     GCodeProcessor m_processor;
+    GCodeExportStats m_export_stats;
 
     //some post-processing on the file, with their data class
     std::unique_ptr<FanMover> m_fan_mover;
@@ -677,6 +783,34 @@ private:
 
 std::vector<const PrintInstance*> sort_object_instances_by_model_order(const Print& print, bool init_order = false);
 
+// G-code of the layers of the last export of a Print together with the state of the G-code generator after each of them,
+// owned by the Print if enabled by Print::enable_gcode_export_cache(). The next export writes the leading layers, which did
+// not change, from the cache and generates the G-code from the first changed layer on.
+// Used by the export of a single filament print by layer only, see GCode::can_use_gcode_export_cache().
+class GCodeExportCache
+{
+public:
+    struct CachedLayer
+    {
+        // MD5 of the inputs of this layer and of all the layers below, see GCode::gcode_export_cache_keys().
+        std::string       key;
+        // Final G-code of the layer as written to the output.
+        std::string       gcode;
+        GCode::LayerState state;
+    };
+
+    // Number of the leading layers matching the keys.
+    size_t matching_layers(const std::vector<std::string> &keys) const {
+        size_t n = 0;
+        while (n < keys.size() && n < layers.size() && layers[n].key == keys[n])
+            ++ n;
+        return n;
+    }
+    void   clear() { layers.clear(); }
+
+    std::vector<CachedLayer> layers;
+};
+
 }
 
 #endif
@@ -8,6 +8,8 @@
 #include <sstream>
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <string_view>
 
 namespace Slic3r {
 
@@ -64,6 +66,30 @@ AdaptivePAInterpolator* AdaptivePAProcessor::getInterpolator(unsigned int tool_i
  * @return A string containing the processed G-code with adaptive pressure advance applied.
  */
 std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
+    // Without a PA change tag the layer is passed through, only the current feed rate is tracked as below.
+    // This avoids copying every layer through the string streams when adaptive pressure advance is disabled.
+    if (gcode.find("; PA_CHANGE") == std::string::npos) {
+        bool wipe_command = false;
+        for (size_t begin = 0; begin < gcode.size();) {
+            size_t end = std::min(gcode.find('\n', begin), gcode.size());
+            std::string_view line(gcode.data() + begin, end - begin);
+            if (line.find("WIPE_START") != std::string_view::npos)
+                wipe_command = true;
+            if (line.find("G1 F") == 0 && ! wipe_command)
+                m_current_feedrate = std::strtod(line.data() + 4, nullptr) / 60.0; // Convert from mm/min to mm/s
+            if (line.find("WIPE_END") != std::string_view::npos)
+                wipe_command = false;
+            begin = end + 1;
+        }
+        if (! gcode.empty()) {
+            m_next_feedrate = 0;
+            // std::getline() below terminates the last line.
+            if (gcode.back() != '\n')
+                gcode += '\n';
+        }
+        return std::move(gcode);
+    }
+
     std::istringstream stream(gcode);
     std::string line;
     std::ostringstream output;
@@ -53,6 +53,27 @@ public:
      * Call this when changing tools or in any other case where the internally assumed last PA value may be incorrect
      */
     void resetPreviousPA(double PA){ m_last_predicted_pa = PA; };
+
+    /**
+     * @brief State carried over from one layer to the next one.
+     *
+     * Saved after a layer and restored by the incremental G-code export, which resumes processing in the middle of a print.
+     */
+    struct State {
+        double last_predicted_pa { 0. };
+        double max_next_feedrate { 0. };
+        double next_feedrate     { 0. };
+        double current_feedrate  { 0. };
+        int    last_extruder_id  { -1 };
+    };
+    State state() const { return { m_last_predicted_pa, m_max_next_feedrate, m_next_feedrate, m_current_feedrate, m_last_extruder_id }; }
+    void restore_state(const State &state) {
+        m_last_predicted_pa = state.last_predicted_pa;
+        m_max_next_feedrate = state.max_next_feedrate;
+        m_next_feedrate     = state.next_feedrate;
+        m_current_feedrate  = state.current_feedrate;
+        m_last_extruder_id  = state.last_extruder_id;
+    }
     
 private:
     GCode &m_gcodegen; ///< Reference to the GCode object.
@@ -1317,6 +1317,7 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
 
 void AvoidCrossingPerimeters::init_layer(const Layer &layer)
 {
+    m_layer = &layer;
     m_internal.clear();
     m_external.clear();
 
@@ -25,6 +25,22 @@ public:
     void        reset_once_modifiers()  { m_use_external_mp_once = false; m_disabled_once = false; }
 
     void        init_layer(const Layer &layer);
+    // Layer passed to init_layer() last.
+    const Layer* layer() const          { return m_layer; }
+
+    // Modifiers of the next travel moves, saved and restored by the incremental G-code export
+    // together with the layer to call init_layer() with.
+    struct State {
+        bool use_external_mp      { false };
+        bool use_external_mp_once { false };
+        bool disabled_once        { true };
+    };
+    State       state() const                 { return { m_use_external_mp, m_use_external_mp_once, m_disabled_once }; }
+    void        restore_state(const State &state) {
+        m_use_external_mp      = state.use_external_mp;
+        m_use_external_mp_once = state.use_external_mp_once;
+        m_disabled_once        = state.disabled_once;
+    }
 
     Polyline    travel_to(const GCode& gcodegen, const Point& point)
     {
@@ -58,6 +74,7 @@ private:
     // this flag disables reduce_crossing_wall just for the next travel move
     // we enable it by default for the first travel move in print
     bool           m_disabled_once { true };
+    const Layer   *m_layer { nullptr };
 
     // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
     ExPolygons               m_lslices_offset;
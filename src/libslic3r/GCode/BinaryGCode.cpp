@@ -0,0 +1,363 @@
+#include "BinaryGCode.hpp"
+
+#include "../Exception.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include <boost/beast/core/detail/base64.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <miniz.h>
+
+namespace Slic3r {
+
+static constexpr char     binary_gcode_magic[8]   = { 'O', 'R', 'C', 'A', 'B', 'G', 'C', '\0' };
+static constexpr uint32_t binary_gcode_byte_order = 0x01020304;
+
+// Upper bound of the size of a decompressed block, so that a corrupted table does not make a reader allocate
+// gigabytes. The writer makes G-code blocks of about 64kB, the config block is the largest metadata block.
+static constexpr uint64_t max_block_size = 256 * 1024 * 1024;
+// Deflate does not compress more than about 1:1032.
+static constexpr uint64_t max_deflate_ratio = 1032;
+
+static constexpr std::string_view thumbnail_block_start = "; THUMBNAIL_BLOCK_START";
+static constexpr std::string_view thumbnail_block_end   = "; THUMBNAIL_BLOCK_END";
+static constexpr std::string_view config_block_start    = "; CONFIG_BLOCK_START";
+static constexpr std::string_view config_block_end      = "; CONFIG_BLOCK_END";
+
+static bool starts_with(std::string_view line, std::string_view prefix)
+{
+    return line.size() >= prefix.size() && line.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Line with the tag followed by the end of line only.
+static bool is_tag_line(std::string_view line, std::string_view tag)
+{
+    if (! starts_with(line, tag))
+        return false;
+    line.remove_prefix(tag.size());
+    return line.find_first_not_of(" \t\r\n") == std::string_view::npos;
+}
+
+std::string encode_binary_gcode_thumbnail(const BinaryGCodeThumbnail &thumbnail)
+{
+    std::string out;
+    auto put = [&out](uint32_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    put(thumbnail.width);
+    put(thumbnail.height);
+    put(uint32_t(thumbnail.tag.size()));
+    out += thumbnail.tag;
+    out += thumbnail.data;
+    return out;
+}
+
+BinaryGCodeThumbnail decode_binary_gcode_thumbnail(std::string_view data)
+{
+    uint32_t values[3];
+    if (data.size() < sizeof(values))
+        throw Slic3r::FileIOError("Binary G-code thumbnail is truncated");
+    std::memcpy(values, data.data(), sizeof(values));
+    data.remove_prefix(sizeof(values));
+    if (data.size() < values[2])
+        throw Slic3r::FileIOError("Binary G-code thumbnail is truncated");
+    BinaryGCodeThumbnail thumbnail;
+    thumbnail.width  = values[0];
+    thumbnail.height = values[1];
+    thumbnail.tag    = std::string(data.substr(0, values[2]));
+    thumbnail.data   = std::string(data.substr(values[2]));
+    return thumbnail;
+}
+
+BinaryGCodeWriter::BinaryGCodeWriter(const std::string &path, size_t gcode_block_size) :
+    m_path(path), m_gcode_block_size(gcode_block_size), m_header{}, m_offset(sizeof(BinaryGCodeHeader))
+{
+    std::memcpy(m_header.magic, binary_gcode_magic, sizeof(m_header.magic));
+    m_header.version    = BINARY_GCODE_VERSION;
+    m_header.byte_order = binary_gcode_byte_order;
+    m_gcode.reserve(m_gcode_block_size + 4096);
+    m_ofs.open(path, std::ios::binary | std::ios::trunc);
+    // The header is written again by finish() once the table offset is known.
+    if (! m_ofs.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header)))
+        throw Slic3r::FileIOError("Failed to write binary G-code " + m_path);
+}
+
+void BinaryGCodeWriter::add_metadata(BinaryGCodeBlockType type, std::string_view text)
+{
+    this->append_block(type, text, true);
+}
+
+void BinaryGCodeWriter::add_thumbnail(const BinaryGCodeThumbnail &thumbnail)
+{
+    // The images are compressed already.
+    this->append_block(BinaryGCodeBlockType::Thumbnail, encode_binary_gcode_thumbnail(thumbnail), false);
+}
+
+void BinaryGCodeWriter::append_gcode(std::string_view gcode)
+{
+    while (! gcode.empty()) {
+        size_t eol = gcode.find('\n');
+        if (eol == std::string_view::npos) {
+            m_line += gcode;
+            break;
+        }
+        if (m_line.empty()) {
+            this->append_line(gcode.substr(0, eol + 1));
+        } else {
+            m_line += gcode.substr(0, eol + 1);
+            this->append_line(m_line);
+            m_line.clear();
+        }
+        gcode.remove_prefix(eol + 1);
+    }
+}
+
+void BinaryGCodeWriter::append_line(std::string_view line)
+{
+    switch (m_section) {
+    case Section::GCode:
+        if (! line.empty() && line.front() == ';') {
+            if (is_tag_line(line, thumbnail_block_start)) {
+                m_section      = Section::Thumbnail;
+                m_section_text = line;
+                return;
+            }
+            if (is_tag_line(line, config_block_start)) {
+                m_section      = Section::Config;
+                m_section_text = line;
+                return;
+            }
+        }
+        m_gcode += line;
+        if (m_gcode.size() >= m_gcode_block_size)
+            this->flush_gcode();
+        break;
+    case Section::Thumbnail:
+        m_section_text += line;
+        if (is_tag_line(line, thumbnail_block_end)) {
+            if (! this->add_thumbnail_block(m_section_text))
+                // Keep what we do not understand in the G-code.
+                m_gcode += m_section_text;
+            m_section = Section::GCode;
+            m_section_text.clear();
+        }
+        break;
+    case Section::Config:
+        m_section_text += line;
+        if (is_tag_line(line, config_block_end)) {
+            this->append_block(BinaryGCodeBlockType::SlicerConfig, m_section_text, true);
+            m_section = Section::GCode;
+            m_section_text.clear();
+        }
+        break;
+    }
+}
+
+bool BinaryGCodeWriter::add_thumbnail_block(std::string_view text)
+{
+    // ; THUMBNAIL_BLOCK_START
+    // ;
+    // ; thumbnail begin 300x300 12345
+    // ; <base64 encoded image>
+    // ; thumbnail end
+    // ; THUMBNAIL_BLOCK_END
+    BinaryGCodeThumbnail thumbnail;
+    std::string          encoded;
+    bool                 in_image = false;
+    while (! text.empty()) {
+        size_t           eol  = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+        while (! line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (! starts_with(line, "; "))
+            continue;
+        line.remove_prefix(2);
+        if (! in_image) {
+            size_t begin = line.find(" begin ");
+            if (begin == std::string_view::npos)
+                continue;
+            unsigned int width = 0, height = 0;
+            if (std::sscanf(std::string(line.substr(begin + 7)).c_str(), "%ux%u", &width, &height) != 2)
+                return false;
+            thumbnail.tag    = std::string(line.substr(0, begin));
+            thumbnail.width  = width;
+            thumbnail.height = height;
+            in_image         = true;
+        } else if (line == thumbnail.tag + " end") {
+            thumbnail.data.resize(boost::beast::detail::base64::decoded_size(encoded.size()));
+            auto [written, read] = boost::beast::detail::base64::decode(thumbnail.data.data(), encoded.data(), encoded.size());
+            // The decoder stops at the padding.
+            if (read != std::min(encoded.find('='), encoded.size()))
+                return false;
+            thumbnail.data.resize(written);
+            this->add_thumbnail(thumbnail);
+            return true;
+        } else
+            encoded += line;
+    }
+    return false;
+}
+
+void BinaryGCodeWriter::flush_gcode()
+{
+    if (m_gcode.empty())
+        return;
+    this->append_block(BinaryGCodeBlockType::GCode, m_gcode, true);
+    ++ m_num_gcode_blocks;
+    m_gcode.clear();
+}
+
+void BinaryGCodeWriter::append_block(BinaryGCodeBlockType type, std::string_view data, bool compress)
+{
+    BinaryGCodeBlock block { type, BinaryGCodeCompression::None,
+        uint32_t(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(data.data()), data.size())),
+        m_offset, data.size(), data.size() };
+    std::string compressed;
+    if (compress && ! data.empty()) {
+        mz_ulong size = mz_compressBound(mz_ulong(data.size()));
+        compressed.resize(size);
+        if (mz_compress2(reinterpret_cast<unsigned char*>(compressed.data()), &size,
+                         reinterpret_cast<const unsigned char*>(data.data()), mz_ulong(data.size()), MZ_DEFAULT_LEVEL) == MZ_OK &&
+            size < data.size()) {
+            compressed.resize(size);
+            block.compression = BinaryGCodeCompression::Deflate;
+            block.size        = size;
+            data              = compressed;
+        }
+    }
+    if (! m_ofs.write(data.data(), std::streamsize(data.size())))
+        throw Slic3r::FileIOError("Failed to write binary G-code " + m_path);
+    m_blocks.push_back(block);
+    m_offset += data.size();
+}
+
+void BinaryGCodeWriter::finish()
+{
+    // An unterminated thumbnail or config block is kept in the G-code.
+    if (m_section != Section::GCode) {
+        m_gcode += m_section_text;
+        m_section = Section::GCode;
+        m_section_text.clear();
+    }
+    m_gcode += m_line;
+    m_line.clear();
+    this->flush_gcode();
+
+    m_header.num_blocks   = m_blocks.size();
+    m_header.table_offset = m_offset;
+    m_ofs.write(reinterpret_cast<const char*>(m_blocks.data()), std::streamsize(m_blocks.size() * sizeof(BinaryGCodeBlock)));
+    m_ofs.seekp(0);
+    m_ofs.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_ofs.close();
+    if (m_ofs.fail())
+        throw Slic3r::FileIOError("Failed to write binary G-code " + m_path);
+    BOOST_LOG_TRIVIAL(debug) << "BinaryGCodeWriter: " << m_path << ", " << m_blocks.size() << " blocks, " << m_num_gcode_blocks
+                             << " G-code blocks, " << m_offset << " bytes";
+}
+
+BinaryGCodeReader::BinaryGCodeReader(const std::string &path) : m_path(path)
+{
+    try {
+        m_file.open(path);
+    } catch (const std::exception &err) {
+        throw Slic3r::FileIOError("Cannot map binary G-code " + path + ": " + err.what());
+    }
+    if (m_file.size() < sizeof(BinaryGCodeHeader))
+        throw Slic3r::FileIOError("Binary G-code " + path + " is truncated");
+    std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+    if (std::memcmp(m_header.magic, binary_gcode_magic, sizeof(m_header.magic)) != 0)
+        throw Slic3r::FileIOError(path + " is not a binary G-code");
+    if (m_header.version != BINARY_GCODE_VERSION || m_header.byte_order != binary_gcode_byte_order)
+        throw Slic3r::FileIOError("Binary G-code " + path + " was written by an incompatible version, version " + std::to_string(m_header.version));
+    if (m_header.table_offset < sizeof(BinaryGCodeHeader) || m_header.table_offset > m_file.size() ||
+        m_file.size() - m_header.table_offset != m_header.num_blocks * sizeof(BinaryGCodeBlock))
+        throw Slic3r::FileIOError("Binary G-code " + path + " is truncated");
+    m_blocks.resize(m_header.num_blocks);
+    std::memcpy(reinterpret_cast<char*>(m_blocks.data()), m_file.data() + m_header.table_offset, m_blocks.size() * sizeof(BinaryGCodeBlock));
+    m_gcode_offsets.emplace_back(0);
+    for (size_t i = 0; i < m_blocks.size(); ++ i) {
+        const BinaryGCodeBlock &block = m_blocks[i];
+        if (block.offset < sizeof(BinaryGCodeHeader) || block.offset > m_header.table_offset || block.size > m_header.table_offset - block.offset ||
+            block.uncompressed_size > max_block_size ||
+            (block.compression == BinaryGCodeCompression::Deflate && block.uncompressed_size > block.size * max_deflate_ratio))
+            throw Slic3r::FileIOError("Binary G-code " + path + " is corrupted");
+        if (block.type == BinaryGCodeBlockType::GCode) {
+            m_gcode_blocks.emplace_back(i);
+            m_gcode_offsets.emplace_back(m_gcode_offsets.back() + block.uncompressed_size);
+        }
+    }
+}
+
+bool BinaryGCodeReader::is_binary_gcode(const std::string &path)
+{
+    boost::nowide::ifstream ifs(path, std::ios::binary);
+    char                    magic[sizeof(binary_gcode_magic)];
+    return ifs.read(magic, sizeof(magic)) && std::memcmp(magic, binary_gcode_magic, sizeof(magic)) == 0;
+}
+
+std::string BinaryGCodeReader::decode(const BinaryGCodeBlock &block) const
+{
+    const char *data = m_file.data() + block.offset;
+    std::string out;
+    if (block.compression == BinaryGCodeCompression::None) {
+        if (block.size != block.uncompressed_size)
+            throw Slic3r::FileIOError("Binary G-code " + m_path + " is corrupted");
+        out.assign(data, size_t(block.size));
+    } else if (block.compression == BinaryGCodeCompression::Deflate) {
+        // The size was checked against max_block_size by the constructor, check again, the table is not trusted.
+        if (block.uncompressed_size > max_block_size || block.uncompressed_size > block.size * max_deflate_ratio)
+            throw Slic3r::FileIOError("Binary G-code " + m_path + " is corrupted");
+        out.resize(size_t(block.uncompressed_size));
+        mz_ulong size = mz_ulong(out.size());
+        if (mz_uncompress(reinterpret_cast<unsigned char*>(out.data()), &size, reinterpret_cast<const unsigned char*>(data), mz_ulong(block.size)) != MZ_OK ||
+            size != block.uncompressed_size)
+            throw Slic3r::FileIOError("Binary G-code " + m_path + " is corrupted");
+    } else
+        throw Slic3r::FileIOError("Binary G-code " + m_path + " uses an unknown compression");
+    if (mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(out.data()), out.size()) != block.checksum)
+        throw Slic3r::FileIOError("Binary G-code " + m_path + " is corrupted, checksum mismatch");
+    return out;
+}
+
+std::string BinaryGCodeReader::metadata(BinaryGCodeBlockType type) const
+{
+    std::string out;
+    for (const BinaryGCodeBlock &block : m_blocks)
+        if (block.type == type)
+            out += this->decode(block);
+    return out;
+}
+
+std::vector<BinaryGCodeThumbnail> BinaryGCodeReader::thumbnails() const
+{
+    std::vector<BinaryGCodeThumbnail> out;
+    for (const BinaryGCodeBlock &block : m_blocks)
+        if (block.type == BinaryGCodeBlockType::Thumbnail)
+            out.emplace_back(decode_binary_gcode_thumbnail(this->decode(block)));
+    return out;
+}
+
+std::string BinaryGCodeReader::gcode_block(size_t idx) const
+{
+    assert(idx < m_gcode_blocks.size());
+    return this->decode(m_blocks[m_gcode_blocks[idx]]);
+}
+
+std::string BinaryGCodeReader::gcode_text(uint64_t offset, size_t size) const
+{
+    assert(offset + size <= this->gcode_size());
+    std::string out;
+    // The first block ending past the offset.
+    size_t idx = std::upper_bound(m_gcode_offsets.begin() + 1, m_gcode_offsets.end(), offset) - m_gcode_offsets.begin() - 1;
+    for (; out.size() < size && idx < m_gcode_blocks.size(); ++ idx) {
+        std::string block = this->gcode_block(idx);
+        size_t      from  = size_t(offset + out.size() - m_gcode_offsets[idx]);
+        out.append(block, from, std::min(block.size() - from, size - out.size()));
+    }
+    return out;
+}
+
+} // namespace Slic3r
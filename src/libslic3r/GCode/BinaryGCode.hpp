@@ -0,0 +1,162 @@
+#ifndef slic3r_GCode_BinaryGCode_hpp_
+#define slic3r_GCode_BinaryGCode_hpp_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+
+// Binary G-code, written by GCodeProcessor::run_post_process() instead of the ASCII G-code if orca_binary_gcode is enabled.
+// The file is a sequence of blocks followed by a table of contents:
+//     BinaryGCodeHeader
+//     block, block, ...                          payload of the blocks, deflated if that makes them smaller
+//     BinaryGCodeBlock[header.num_blocks]        at header.table_offset
+// The metadata blocks are written first, so a reader of a partially transferred file gets the statistics first.
+// The G-code is split at line ends into blocks of about 64kB, which are compressed and decompressed independently.
+// The G-code viewer addresses the lines by their offsets into the G-code text, thus it decompresses just the blocks
+// of the lines it shows, and GCodeProcessor decompresses and tokenizes the blocks in parallel.
+// Numbers are stored in the byte order of the writer, a reader refuses files of a different byte order.
+static constexpr uint32_t BINARY_GCODE_VERSION = 2;
+// Extension of the exported files, so that the container is not taken for a G-code of PrusaSlicer or of a printer.
+static constexpr const char *BINARY_GCODE_EXTENSION = ".orcabgc";
+
+enum class BinaryGCodeBlockType : uint16_t {
+    // "; key = value" lines describing the producer.
+    FileMetadata,
+    // "; key = value" lines with the print statistics, formatted the same way as the comments of the ASCII G-code.
+    PrintMetadata,
+    // The config block of the ASCII G-code including its "; CONFIG_BLOCK_START" and "; CONFIG_BLOCK_END" delimiters.
+    SlicerConfig,
+    // BinaryGCodeThumbnail encoded by encode_binary_gcode_thumbnail().
+    Thumbnail,
+    // G-code text, the thumbnail and config blocks excluded.
+    GCode,
+};
+
+enum class BinaryGCodeCompression : uint16_t {
+    None,
+    Deflate,
+};
+
+struct BinaryGCodeHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t num_blocks;
+    uint64_t table_offset;
+};
+
+struct BinaryGCodeBlock
+{
+    BinaryGCodeBlockType   type;
+    BinaryGCodeCompression compression;
+    // mz_crc32() of the uncompressed payload.
+    uint32_t               checksum;
+    uint64_t               offset;
+    uint64_t               size;
+    uint64_t               uncompressed_size;
+};
+
+struct BinaryGCodeThumbnail
+{
+    // Tag of the ASCII thumbnail block: "thumbnail", "thumbnail_JPG" or "thumbnail_QOI".
+    std::string  tag;
+    unsigned int width  { 0 };
+    unsigned int height { 0 };
+    // The image file.
+    std::string  data;
+};
+
+// Throws Slic3r::FileIOError on failure.
+class BinaryGCodeWriter
+{
+public:
+    BinaryGCodeWriter(const std::string &path, size_t gcode_block_size = 65536);
+
+    // Complete "; key = value" lines.
+    void add_metadata(BinaryGCodeBlockType type, std::string_view text);
+    void add_thumbnail(const BinaryGCodeThumbnail &thumbnail);
+    // G-code text, a line may be split between two calls. The thumbnail and config blocks of the ASCII G-code
+    // are recognized by their delimiters and moved into blocks of their own.
+    void append_gcode(std::string_view gcode);
+    // Flushes the pending G-code, writes the table of contents and closes the file.
+    void finish();
+
+private:
+    void append_block(BinaryGCodeBlockType type, std::string_view data, bool compress);
+    void append_line(std::string_view line);
+    void flush_gcode();
+    // Moves a thumbnail block of the ASCII G-code into a thumbnail block, returns false if it cannot be parsed.
+    bool add_thumbnail_block(std::string_view text);
+
+    enum class Section {
+        GCode,
+        Thumbnail,
+        Config,
+    };
+
+    std::string                   m_path;
+    size_t                        m_gcode_block_size;
+    boost::nowide::ofstream       m_ofs;
+    BinaryGCodeHeader             m_header;
+    std::vector<BinaryGCodeBlock> m_blocks;
+    uint64_t                      m_offset;
+    uint32_t                      m_num_gcode_blocks { 0 };
+    // G-code of the next G-code block.
+    std::string                   m_gcode;
+    // Unterminated line of the last append_gcode() call.
+    std::string                   m_line;
+    Section                       m_section { Section::GCode };
+    std::string                   m_section_text;
+};
+
+// Maps a file written by BinaryGCodeWriter. Throws Slic3r::FileIOError if the file cannot be mapped,
+// was written by an incompatible version or is truncated. The blocks are decompressed on demand
+// and their checksums verified, a corrupted block throws Slic3r::FileIOError. Thread safe.
+class BinaryGCodeReader
+{
+public:
+    explicit BinaryGCodeReader(const std::string &path);
+
+    // Checks the magic of the file only.
+    static bool is_binary_gcode(const std::string &path);
+
+    // Blocks of the given type concatenated.
+    std::string                       metadata(BinaryGCodeBlockType type) const;
+    std::vector<BinaryGCodeThumbnail> thumbnails() const;
+
+    size_t      gcode_blocks_count() const { return m_gcode_blocks.size(); }
+    std::string gcode_block(size_t idx) const;
+    // Offset of a G-code block into the G-code text, that is into the G-code blocks concatenated.
+    uint64_t    gcode_block_offset(size_t idx) const { return m_gcode_offsets[idx]; }
+    // Size of the G-code text.
+    uint64_t    gcode_size() const { return m_gcode_offsets.back(); }
+    // G-code text at [offset, offset + size), only the blocks holding it are decompressed.
+    std::string gcode_text(uint64_t offset, size_t size) const;
+
+private:
+    std::string decode(const BinaryGCodeBlock &block) const;
+
+    std::string                          m_path;
+    boost::iostreams::mapped_file_source m_file;
+    BinaryGCodeHeader                    m_header;
+    std::vector<BinaryGCodeBlock>        m_blocks;
+    // Indices of the G-code blocks into m_blocks.
+    std::vector<size_t>                  m_gcode_blocks;
+    // Offsets of the G-code blocks into the G-code text followed by the size of the G-code text.
+    std::vector<uint64_t>                m_gcode_offsets;
+};
+
+std::string          encode_binary_gcode_thumbnail(const BinaryGCodeThumbnail &thumbnail);
+// Throws Slic3r::FileIOError on a malformed thumbnail.
+BinaryGCodeThumbnail decode_binary_gcode_thumbnail(std::string_view data);
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_BinaryGCode_hpp_
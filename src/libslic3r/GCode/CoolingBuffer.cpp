@@ -18,7 +18,7 @@
 
 namespace Slic3r {
 
-CoolingBuffer::CoolingBuffer(GCode &gcodegen) : m_config(gcodegen.config()), m_toolchange_prefix(gcodegen.writer().toolchange_prefix()), m_current_extruder(0)
+CoolingBuffer::CoolingBuffer(GCode &gcodegen) : m_config(gcodegen.config()), m_toolchange_prefix(gcodegen.writer().toolchange_prefix()), m_current_extruder(0), m_parsed_extruder(0)
 {
     this->reset(gcodegen.writer().get_position());
 
@@ -313,7 +313,21 @@ finished:
 	return new_feedrate;
 }
 
+CoolingBuffer::ParsedLayer::ParsedLayer() = default;
+CoolingBuffer::ParsedLayer::ParsedLayer(const ParsedLayer &) = default;
+CoolingBuffer::ParsedLayer::ParsedLayer(ParsedLayer &&) = default;
+CoolingBuffer::ParsedLayer::~ParsedLayer() = default;
+CoolingBuffer::ParsedLayer& CoolingBuffer::ParsedLayer::operator=(const ParsedLayer &) = default;
+CoolingBuffer::ParsedLayer& CoolingBuffer::ParsedLayer::operator=(ParsedLayer &&) = default;
+
 std::string CoolingBuffer::process_layer(std::string &&gcode, size_t layer_id, bool flush)
+{
+    ParsedLayer layer = this->parse_layer(std::move(gcode), layer_id, flush);
+    slow_down_layer(layer);
+    return this->apply_layer(std::move(layer));
+}
+
+CoolingBuffer::ParsedLayer CoolingBuffer::parse_layer(std::string &&gcode, size_t layer_id, bool flush)
 {
     // Cache the input G-code.
     if (m_gcode.empty())
@@ -321,21 +335,35 @@ std::string CoolingBuffer::process_layer(std::string &&gcode, size_t layer_id, b
     else
         m_gcode += gcode;
 
-    std::string out;
+    ParsedLayer out;
+    out.layer_id = layer_id;
+    out.flush    = flush;
     if (flush) {
         // This is either an object layer or the very last print layer. Calculate cool down over the collected support layers
         // and one object layer.
-        std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(m_gcode, m_current_pos);
-        float layer_time_stretched = this->calculate_layer_slowdown(per_extruder_adjustments);
-        out = this->apply_layer_cooldown(m_gcode, layer_id, layer_time_stretched, per_extruder_adjustments);
+        out.per_extruder_adjustments = this->parse_layer_gcode(m_gcode, m_current_pos, m_parsed_extruder);
+        out.gcode = std::move(m_gcode);
         m_gcode.clear();
     }
     return out;
 }
 
+void CoolingBuffer::slow_down_layer(ParsedLayer &layer)
+{
+    if (layer.flush)
+        layer.layer_time = calculate_layer_slowdown(layer.per_extruder_adjustments);
+}
+
+std::string CoolingBuffer::apply_layer(ParsedLayer &&layer)
+{
+    if (! layer.flush)
+        return std::move(layer.gcode);
+    return this->apply_layer_cooldown(layer.gcode, layer.layer_id, layer.layer_time, layer.per_extruder_adjustments);
+}
+
 // Parse the layer G-code for the moves, which could be adjusted.
 // Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos, unsigned int &current_extruder) const
 {
     std::vector<PerExtruderAdjustments> per_extruder_adjustments(m_extruder_ids.size());
     std::vector<size_t>                 map_extruder_to_per_extruder_adjustment(m_num_extruders, 0);
@@ -351,7 +379,6 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
         map_extruder_to_per_extruder_adjustment[extruder_id] = i;
     }
 
-    unsigned int      current_extruder  = m_current_extruder;
     PerExtruderAdjustments *adjustment  = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
     const char       *line_start = gcode.c_str();
     const char       *line_end   = line_start;
@@ -4,6 +4,7 @@
 #include "../libslic3r.h"
 #include <map>
 #include <string>
+#include <vector>
 #include <cfloat>
 
 namespace Slic3r {
@@ -23,15 +24,64 @@ struct PerExtruderAdjustments;
 //
 class CoolingBuffer {
 public:
+    // A layer collected and parsed by parse_layer(), to be slowed down by slow_down_layer() and emitted by apply_layer().
+    struct ParsedLayer {
+        // Defined out of line, PerExtruderAdjustments is private to CoolingBuffer.cpp.
+        ParsedLayer();
+        ParsedLayer(const ParsedLayer &);
+        ParsedLayer(ParsedLayer &&);
+        ~ParsedLayer();
+        ParsedLayer& operator=(const ParsedLayer &);
+        ParsedLayer& operator=(ParsedLayer &&);
+
+        // Collected G-code of the support layers and of the object layer if flush, otherwise G-code to be passed through.
+        std::string                         gcode;
+        size_t                              layer_id   { 0 };
+        bool                                flush      { false };
+        // Total time of the layer after slow down.
+        float                               layer_time { 0.f };
+        std::vector<PerExtruderAdjustments> per_extruder_adjustments;
+    };
+
     CoolingBuffer(GCode &gcodegen);
     void        reset(const Vec3d &position);
-    void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
+    void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = m_parsed_extruder = extruder_id; }
     std::string process_layer(std::string &&gcode, size_t layer_id, bool flush);
 
+    // process_layer() split into stages to be run by a pipeline: parse_layer() and apply_layer() have to be called
+    // for the layers in order, slow_down_layer() does not touch the CoolingBuffer and it may run in parallel for different layers.
+    ParsedLayer parse_layer(std::string &&gcode, size_t layer_id, bool flush);
+    static void slow_down_layer(ParsedLayer &layer);
+    std::string apply_layer(ParsedLayer &&layer);
+
+    // State of parse_layer() and of apply_layer() between two layers, saved and restored by the incremental G-code export.
+    // They are separate, as the two stages work on different layers in a pipeline.
+    struct ParseState {
+        std::string         gcode;
+        std::vector<float>  current_pos;
+        unsigned int        parsed_extruder { 0 };
+    };
+    struct ApplyState {
+        int                 fan_speed            { -1 };
+        int                 additional_fan_speed { -1 };
+        int                 current_fan_speed    { -1 };
+        unsigned int        current_extruder     { 0 };
+    };
+    ParseState  parse_state() const { return { m_gcode, m_current_pos, m_parsed_extruder }; }
+    void        restore_parse_state(const ParseState &state) { m_gcode = state.gcode; m_current_pos = state.current_pos; m_parsed_extruder = state.parsed_extruder; }
+    ApplyState  apply_state() const { return { m_fan_speed, m_additional_fan_speed, m_current_fan_speed, m_current_extruder }; }
+    void        restore_apply_state(const ApplyState &state) {
+        m_fan_speed            = state.fan_speed;
+        m_additional_fan_speed = state.additional_fan_speed;
+        m_current_fan_speed    = state.current_fan_speed;
+        m_current_extruder     = state.current_extruder;
+    }
+
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
-    float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    // current_extruder is updated to the extruder active at the end of the G-code.
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos, unsigned int &current_extruder) const;
+    static float calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
     // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
     // Returns the adjusted G-code.
     std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
@@ -54,7 +104,10 @@ private:
     // Referencs GCode::m_config, which is FullPrintConfig. While the PrintObjectConfig slice of FullPrintConfig is being modified,
     // the PrintConfig slice of FullPrintConfig is constant, thus no thread synchronization is required.
     const PrintConfig          &m_config;
+    // Extruder at the end of the layer emitted last by apply_layer().
     unsigned int                m_current_extruder;
+    // Extruder at the end of the layer parsed last by parse_layer(), it runs ahead of m_current_extruder in a pipeline.
+    unsigned int                m_parsed_extruder;
     //BBS: current fan speed
     int                         m_current_fan_speed;
 };
@@ -0,0 +1,62 @@
+#include "ExportStats.hpp"
+
+namespace Slic3r {
+
+AllocationCounters& thread_allocation_counters()
+{
+    // Constant initialized, thus safe to be touched from operator new.
+    static thread_local AllocationCounters counters;
+    return counters;
+}
+
+GCodeExportStats::Scope::Scope(GCodeExportStats &stats, Stage stage) :
+    m_stats(stats), m_stage(stage), m_start(std::chrono::steady_clock::now()), m_allocations(thread_allocation_counters())
+{}
+
+GCodeExportStats::Scope::~Scope()
+{
+    const AllocationCounters &allocations = thread_allocation_counters();
+    Counters                 &counters    = m_stats.m_stages[m_stage];
+    counters.ns          += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    counters.calls       += 1;
+    counters.allocations += allocations.allocations - m_allocations.allocations;
+    counters.bytes       += allocations.bytes - m_allocations.bytes;
+}
+
+GCodeExportStats& GCodeExportStats::operator+=(const GCodeExportStats &rhs)
+{
+    for (size_t i = 0; i < Count; ++ i) {
+        StageStats s = rhs.stage(Stage(i));
+        m_stages[i].ns          += s.ns;
+        m_stages[i].calls       += s.calls;
+        m_stages[i].allocations += s.allocations;
+        m_stages[i].bytes       += s.bytes;
+    }
+    return *this;
+}
+
+GCodeExportStats::StageStats GCodeExportStats::stage(Stage stage) const
+{
+    const Counters &c = m_stages[stage];
+    return { c.ns.load(), c.calls.load(), c.allocations.load(), c.bytes.load() };
+}
+
+void GCodeExportStats::reset()
+{
+    for (Counters &c : m_stages) {
+        c.ns          = 0;
+        c.calls       = 0;
+        c.allocations = 0;
+        c.bytes       = 0;
+    }
+}
+
+const char* GCodeExportStats::stage_name(Stage stage)
+{
+    static constexpr const char *names[Count] = { "process_layer", "spiral_vase", "pressure_equalizer", "cooling_parse", "cooling_slow_down",
+                                                  "cooling_apply", "fan_mover", "pa_processor", "tokenize", "output", "gcode_processor",
+                                                  "gcode_processor_finalize", "post_process" };
+    return names[stage];
+}
+
+} // namespace Slic3r
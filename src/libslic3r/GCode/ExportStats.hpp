@@ -0,0 +1,97 @@
+#ifndef slic3r_GCode_ExportStats_hpp_
+#define slic3r_GCode_ExportStats_hpp_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Slic3r {
+
+// Allocations of the calling thread. libslic3r does not count allocations by itself, an executable replacing
+// the global operator new increments the counters of the allocating thread, as the G-code export benchmark does.
+// Allocations by the TBB scalable allocator, which is used for Points, do not pass through operator new and are not counted.
+struct AllocationCounters
+{
+    uint64_t allocations { 0 };
+    uint64_t bytes       { 0 };
+};
+
+AllocationCounters& thread_allocation_counters();
+
+// Wall time, number of calls and allocations of the stages of the G-code export, summed over the layers.
+// The time of a parallel stage is summed over the threads, thus it may exceed the duration of the export.
+// Allocations are attributed to a stage if made by the thread running the stage.
+class GCodeExportStats
+{
+public:
+    enum Stage {
+        // GCode::process_layer()
+        Generate,
+        SpiralVase,
+        PressureEqualizer,
+        CoolingParse,
+        CoolingSlowDown,
+        CoolingApply,
+        FanMover,
+        PAProcessor,
+        Tokenize,
+        Output,
+        // GCodeProcessor::process_buffer() of the layers.
+        Process,
+        // GCodeProcessor::finalize() except for the post-processing.
+        Finalize,
+        // GCodeProcessor::run_post_process()
+        PostProcess,
+        Count
+    };
+
+    struct StageStats
+    {
+        int64_t  ns          { 0 };
+        uint64_t calls       { 0 };
+        uint64_t allocations { 0 };
+        uint64_t bytes       { 0 };
+    };
+
+    class Scope
+    {
+    public:
+        Scope(GCodeExportStats &stats, Stage stage);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope& operator=(const Scope &) = delete;
+
+    private:
+        GCodeExportStats                     &m_stats;
+        Stage                                 m_stage;
+        std::chrono::steady_clock::time_point m_start;
+        AllocationCounters                    m_allocations;
+    };
+
+    GCodeExportStats() = default;
+    GCodeExportStats(const GCodeExportStats &rhs) { *this += rhs; }
+    GCodeExportStats& operator=(const GCodeExportStats &rhs) { this->reset(); return *this += rhs; }
+    GCodeExportStats& operator+=(const GCodeExportStats &rhs);
+
+    Scope       measure(Stage stage) { return Scope(*this, stage); }
+    StageStats  stage(Stage stage) const;
+    void        reset();
+
+    // "process_layer", "cooling_parse", ...
+    static const char* stage_name(Stage stage);
+
+private:
+    struct Counters
+    {
+        std::atomic<int64_t>  ns          { 0 };
+        std::atomic<uint64_t> calls       { 0 };
+        std::atomic<uint64_t> allocations { 0 };
+        std::atomic<uint64_t> bytes       { 0 };
+    };
+    std::array<Counters, Count> m_stages;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_ExportStats_hpp_
@@ -290,11 +290,17 @@ struct ProcessedPoint
 
 class ExtrusionQualityEstimator
 {
+public:
+    // The previous and the last layer passed to prepare_for_new_layer() per object.
+    using PreparedLayers = std::unordered_map<const PrintObject *, std::pair<const Layer *, const Layer *>>;
+
+private:
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<Linef>> prev_layer_boundaries;
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<Linef>> next_layer_boundaries;
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<CurledLine>> prev_curled_extrusions;
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<CurledLine>> next_curled_extrusions;
     const PrintObject                                                            *current_object;
+    PreparedLayers                                                                prepared_layers;
 
 public:
     void set_current_object(const PrintObject *object) { current_object = object; }
@@ -303,12 +309,29 @@ public:
     {
         if (layer == nullptr) return;
         const PrintObject *object = obj;
+        auto &prepared = prepared_layers[object];
+        prepared = { prepared.second, layer };
         prev_layer_boundaries[object] = next_layer_boundaries[object];
         next_layer_boundaries[object] = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(layer->lslices)};
         prev_curled_extrusions[object] = next_curled_extrusions[object];
         next_curled_extrusions[object] = AABBTreeLines::LinesDistancer<CurledLine>{layer->curled_lines};
     }
 
+    const PreparedLayers& get_prepared_layers() const { return prepared_layers; }
+    // Rebuilds the state left by prepare_for_new_layer() called with the given layers, for the incremental G-code export.
+    void restore_prepared_layers(const PreparedLayers &layers)
+    {
+        prev_layer_boundaries.clear();
+        next_layer_boundaries.clear();
+        prev_curled_extrusions.clear();
+        next_curled_extrusions.clear();
+        prepared_layers.clear();
+        for (const auto &[object, object_layers] : layers) {
+            this->prepare_for_new_layer(object, object_layers.first);
+            this->prepare_for_new_layer(object, object_layers.second);
+        }
+    }
+
     std::vector<ProcessedPoint> estimate_extrusion_quality(const ExtrusionPath                &path,
                                                            const ConfigOptionPercents         &overlaps,
                                                            const ConfigOptionFloatsOrPercents &speeds,
@@ -0,0 +1,172 @@
+#include "GCodeMetadata.hpp"
+#include "BinaryGCode.hpp"
+
+#include "../Config.hpp"
+#include "../Exception.hpp"
+#include "../InvoiceCost.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/log/trivial.hpp>
+
+namespace Slic3r {
+
+double GCodeMetadata::print_time_hours() const
+{
+    return invoice_time_to_hours(estimated_time_normal);
+}
+
+static std::string_view trim(std::string_view s)
+{
+    while (! s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (! s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// "1.20, 0, 3.45" as written by update_print_stats_and_format_filament_stats().
+static std::vector<double> parse_number_list(std::string_view value)
+{
+    std::vector<double> out;
+    std::string         str(value);
+    const char         *p = str.c_str();
+    while (*p != 0) {
+        char  *end;
+        double v = std::strtod(p, &end);
+        if (end == p)
+            break;
+        out.emplace_back(v);
+        p = end;
+        while (*p == ' ' || *p == ',')
+            ++ p;
+    }
+    return out;
+}
+
+template<typename T, typename Option>
+static void deserialize_config_value(std::string_view value, std::vector<T> &out)
+{
+    Option opt;
+    if (opt.deserialize(std::string(value)))
+        out = std::move(opt.values);
+}
+
+static void parse_metadata_line(std::string_view line, GCodeMetadata &metadata)
+{
+    // "; key = value" or "; key: value"
+    line.remove_prefix(1);
+    size_t sep     = line.find(" = ");
+    size_t sep_len = 3;
+    if (sep == std::string_view::npos) {
+        sep     = line.find(": ");
+        sep_len = 2;
+    }
+    if (sep == std::string_view::npos)
+        return;
+    std::string_view key   = trim(line.substr(0, sep));
+    std::string_view value = trim(line.substr(sep + sep_len));
+
+    if (key == "filament used [mm]")
+        metadata.filament_used_mm = parse_number_list(value);
+    else if (key == "filament used [cm3]")
+        metadata.filament_used_cm3 = parse_number_list(value);
+    else if (key == "filament used [g]")
+        metadata.filament_used_g = parse_number_list(value);
+    else if (key == "filament cost")
+        metadata.filament_cost = parse_number_list(value);
+    else if (key == "total filament used [g]")
+        metadata.total_filament_used_g = std::atof(std::string(value).c_str());
+    else if (key == "total filament cost")
+        metadata.total_filament_cost = std::atof(std::string(value).c_str());
+    else if (key == "estimated printing time (normal mode)")
+        metadata.estimated_time_normal = std::string(value);
+    else if (key == "estimated printing time (silent mode)")
+        metadata.estimated_time_silent = std::string(value);
+    else if (key == "model printing time") {
+        // BBL printers: "; model printing time: 1h 2m 3s; total estimated time: 1h 10m 3s", normal mode first.
+        static constexpr std::string_view total_tag = "total estimated time:";
+        if (size_t pos = value.find(total_tag); pos != std::string_view::npos) {
+            std::string total(trim(value.substr(pos + total_tag.size())));
+            (metadata.estimated_time_normal.empty() ? metadata.estimated_time_normal : metadata.estimated_time_silent) = std::move(total);
+        }
+    } else if (key == "total layer number" || key == "total layers count")
+        metadata.total_layers = std::atoi(std::string(value).c_str());
+    else if (key == "filament_settings_id")
+        deserialize_config_value<std::string, ConfigOptionStrings>(value, metadata.filament_settings_id);
+    else if (key == "filament_colour")
+        deserialize_config_value<std::string, ConfigOptionStrings>(value, metadata.filament_colour);
+    else if (key == "filament_type")
+        deserialize_config_value<std::string, ConfigOptionStrings>(value, metadata.filament_type);
+    else if (key == "filament_density")
+        deserialize_config_value<double, ConfigOptionFloats>(value, metadata.filament_density);
+    else if (key == "filament_cost")
+        deserialize_config_value<double, ConfigOptionFloats>(value, metadata.filament_cost_per_kg);
+}
+
+void parse_gcode_metadata(std::string_view gcode, GCodeMetadata &metadata)
+{
+    while (! gcode.empty()) {
+        size_t           eol  = gcode.find('\n');
+        std::string_view line = gcode.substr(0, eol);
+        gcode.remove_prefix(eol == std::string_view::npos ? gcode.size() : eol + 1);
+        if (line.size() > 2 && line[0] == ';')
+            parse_metadata_line(line, metadata);
+    }
+}
+
+GCodeMetadata read_gcode_metadata(const std::string &path, size_t window_size)
+{
+    boost::system::error_code ec;
+    const uintmax_t           file_size = boost::filesystem::file_size(path, ec);
+    if (ec || file_size == 0)
+        throw Slic3r::RuntimeError("Cannot read G-code " + path);
+
+    GCodeMetadata metadata;
+    if (BinaryGCodeReader::is_binary_gcode(path)) {
+        // Only the statistics and the config blocks are decompressed.
+        try {
+            BinaryGCodeReader reader(path);
+            parse_gcode_metadata(reader.metadata(BinaryGCodeBlockType::PrintMetadata), metadata);
+            parse_gcode_metadata(reader.metadata(BinaryGCodeBlockType::SlicerConfig), metadata);
+        } catch (const Slic3r::FileIOError &err) {
+            throw Slic3r::RuntimeError(err.what());
+        }
+        if (! metadata.has_statistics())
+            throw Slic3r::RuntimeError("No filament statistics found in G-code " + path);
+        return metadata;
+    }
+
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(path);
+    } catch (const std::exception &err) {
+        throw Slic3r::RuntimeError("Cannot map G-code " + path + ": " + err.what());
+    }
+    std::string_view data(file.data(), file.size());
+
+    if (data.size() <= 2 * window_size) {
+        parse_gcode_metadata(data, metadata);
+    } else {
+        // Drop the lines cut by the window boundaries. The tail is parsed last, so that the statistics
+        // at the end of the file override anything a post-processing script may have left in the header.
+        std::string_view head = data.substr(0, window_size);
+        head = head.substr(0, head.rfind('\n') + 1);
+        std::string_view tail = data.substr(data.size() - window_size);
+        tail.remove_prefix(std::min(tail.size(), tail.find('\n') + 1));
+        parse_gcode_metadata(head, metadata);
+        parse_gcode_metadata(tail, metadata);
+    }
+    file.close();
+
+    if (! metadata.has_statistics())
+        throw Slic3r::RuntimeError("No filament statistics found in G-code " + path);
+    BOOST_LOG_TRIVIAL(debug) << "read_gcode_metadata: " << path << ", " << metadata.filament_used_g.size() << " extruders, "
+                             << metadata.estimated_time_normal;
+    return metadata;
+}
+
+} // namespace Slic3r
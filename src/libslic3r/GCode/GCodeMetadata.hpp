@@ -0,0 +1,52 @@
+#ifndef slic3r_GCode_GCodeMetadata_hpp_
+#define slic3r_GCode_GCodeMetadata_hpp_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Slic3r {
+
+// Print statistics embedded as comments into an exported G-code: the header block, the filament statistics
+// written after "; EXECUTABLE_BLOCK_END" and the filament related keys of the config block.
+// Per extruder vectors are indexed by the extruder id, non printing extruders are zero.
+struct GCodeMetadata
+{
+    // "; filament used [mm] / [cm3] / [g] = ..." and "; filament cost = ..."
+    std::vector<double>      filament_used_mm;
+    std::vector<double>      filament_used_cm3;
+    std::vector<double>      filament_used_g;
+    std::vector<double>      filament_cost;
+    // Only written for non BBL printers, zero if missing.
+    double                   total_filament_used_g { 0. };
+    double                   total_filament_cost   { 0. };
+    // Print time in the get_time_dhms() format ("1d 2h 3m 4s"), empty if missing.
+    std::string              estimated_time_normal;
+    std::string              estimated_time_silent;
+    int                      total_layers { 0 };
+
+    // Filament presets from the config block.
+    std::vector<std::string> filament_settings_id;
+    std::vector<std::string> filament_colour;
+    std::vector<std::string> filament_type;
+    std::vector<double>      filament_density;
+    std::vector<double>      filament_cost_per_kg;
+
+    bool   has_statistics() const { return ! filament_used_g.empty() || ! filament_used_cm3.empty(); }
+    double print_time_hours() const;
+};
+
+// Parse the metadata comments of a block of G-code. Lines other than "; key = value" or "; key: value" comments are ignored,
+// later occurences of a key override earlier ones.
+void parse_gcode_metadata(std::string_view gcode, GCodeMetadata &metadata);
+
+// Read the metadata of a G-code file without processing its moves. The file is memory mapped
+// and only the first and the last window_size bytes are scanned, which is where the header,
+// the statistics and the config block are placed by GCode::_do_export(). Of a binary G-code, only the statistics
+// and the config blocks are read.
+// Throws Slic3r::RuntimeError if the file cannot be opened or contains no filament statistics.
+GCodeMetadata read_gcode_metadata(const std::string &path, size_t window_size = 4 * 1024 * 1024);
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_GCodeMetadata_hpp_
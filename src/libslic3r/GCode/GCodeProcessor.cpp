@@ -8,6 +8,7 @@
 #include "libslic3r/LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
 #include "GCodeProcessor.hpp"
+#include "BinaryGCode.hpp"
 
 #include <boost/log/trivial.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -18,6 +19,8 @@
 
 #include <fast_float/fast_float.h>
 
+#include <tbb/task_group.h>
+
 #include <float.h>
 #include <assert.h>
 #include <regex>
@@ -31,6 +34,13 @@
 #endif
 
 #include <chrono>
+#include <memory>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define GCODE_PROCESSOR_SSE2
+#endif
 
 static const float DEFAULT_TOOLPATH_WIDTH = 0.4f;
 static const float DEFAULT_TOOLPATH_HEIGHT = 0.2f;
@@ -288,6 +298,92 @@ float GCodeProcessor::TimeBlock::time() const
         + trapezoid.deceleration_time(distance, acceleration);
 }
 
+void GCodeProcessor::TimeBlockBatch::clear()
+{
+    entry.clear();
+    cruise.clear();
+    exit.clear();
+    acceleration.clear();
+    distance.clear();
+}
+
+void GCodeProcessor::TimeBlockBatch::append(const TimeBlock& block)
+{
+    entry.push_back(block.feedrate_profile.entry);
+    cruise.push_back(block.feedrate_profile.cruise);
+    exit.push_back(block.feedrate_profile.exit);
+    acceleration.push_back(block.acceleration);
+    distance.push_back(block.distance);
+}
+
+#ifdef GCODE_PROCESSOR_SSE2
+// TimeBlock::calculate_trapezoid() followed by TimeBlock::time() for four blocks. Both branches of calculate_trapezoid()
+// are evaluated and blended, the operations are the same and in the same order as in the scalar code,
+// thus the results are bit identical.
+static __m128 trapezoid_times(__m128 entry, __m128 cruise, __m128 exit, __m128 acceleration, __m128 distance)
+{
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 two   = _mm_set1_ps(2.0f);
+    const __m128 four  = _mm_set1_ps(4.0f);
+    const __m128 deceleration = _mm_xor_ps(acceleration, _mm_set1_ps(-0.0f));
+    const __m128 no_acceleration = _mm_cmpeq_ps(acceleration, zero);
+    const __m128 entry2  = _mm_mul_ps(entry, entry);
+    const __m128 cruise2 = _mm_mul_ps(cruise, cruise);
+    const __m128 exit2   = _mm_mul_ps(exit, exit);
+    const __m128 two_acceleration = _mm_mul_ps(two, acceleration);
+    const __m128 two_deceleration = _mm_mul_ps(two, deceleration);
+
+    // estimated_acceleration_distance()
+    __m128 accelerate_distance = _mm_max_ps(_mm_andnot_ps(no_acceleration, _mm_div_ps(_mm_sub_ps(cruise2, entry2), two_acceleration)), zero);
+    __m128 decelerate_distance = _mm_max_ps(_mm_andnot_ps(no_acceleration, _mm_div_ps(_mm_sub_ps(exit2, cruise2), two_deceleration)), zero);
+    __m128 cruise_distance     = _mm_sub_ps(_mm_sub_ps(distance, accelerate_distance), decelerate_distance);
+
+    // Not enough space to reach the nominal feedrate, intersection_distance() clamped to [0, distance].
+    const __m128 no_cruise = _mm_cmplt_ps(cruise_distance, zero);
+    __m128 intersection = _mm_andnot_ps(no_acceleration,
+        _mm_div_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(two_acceleration, distance), entry2), exit2), _mm_mul_ps(four, acceleration)));
+    intersection = _mm_min_ps(distance, _mm_andnot_ps(_mm_cmplt_ps(intersection, zero), intersection));
+    const __m128 intersection_feedrate = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(entry2, _mm_mul_ps(two_acceleration, intersection)), zero));
+
+    accelerate_distance = _mm_or_ps(_mm_and_ps(no_cruise, intersection), _mm_andnot_ps(no_cruise, accelerate_distance));
+    cruise_distance     = _mm_andnot_ps(no_cruise, cruise_distance);
+    const __m128 cruise_feedrate  = _mm_or_ps(_mm_and_ps(no_cruise, intersection_feedrate), _mm_andnot_ps(no_cruise, cruise));
+    const __m128 accelerate_until = accelerate_distance;
+    const __m128 decelerate_after = _mm_add_ps(accelerate_distance, cruise_distance);
+
+    // Trapezoid::acceleration_time(), cruise_time() and deceleration_time().
+    const __m128 acceleration_time = _mm_andnot_ps(no_acceleration, _mm_div_ps(
+        _mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(_mm_add_ps(entry2, _mm_mul_ps(two_acceleration, accelerate_until)), zero)), entry), acceleration));
+    const __m128 cruise_time = _mm_andnot_ps(_mm_cmpeq_ps(cruise_feedrate, zero),
+        _mm_div_ps(_mm_sub_ps(decelerate_after, accelerate_until), cruise_feedrate));
+    const __m128 deceleration_time = _mm_andnot_ps(no_acceleration, _mm_div_ps(
+        _mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(cruise_feedrate, cruise_feedrate),
+            _mm_mul_ps(two_deceleration, _mm_sub_ps(distance, decelerate_after))), zero)), cruise_feedrate), deceleration));
+
+    return _mm_add_ps(_mm_add_ps(acceleration_time, cruise_time), deceleration_time);
+}
+#endif // GCODE_PROCESSOR_SSE2
+
+void GCodeProcessor::TimeBlockBatch::solve(std::vector<float>& times) const
+{
+    const size_t n = this->size();
+    times.resize(n);
+    size_t i = 0;
+#ifdef GCODE_PROCESSOR_SSE2
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(times.data() + i, trapezoid_times(_mm_loadu_ps(entry.data() + i), _mm_loadu_ps(cruise.data() + i),
+            _mm_loadu_ps(exit.data() + i), _mm_loadu_ps(acceleration.data() + i), _mm_loadu_ps(distance.data() + i)));
+#endif // GCODE_PROCESSOR_SSE2
+    for (; i < n; ++i) {
+        TimeBlock block;
+        block.feedrate_profile = { entry[i], cruise[i], exit[i] };
+        block.acceleration = acceleration[i];
+        block.distance = distance[i];
+        block.calculate_trapezoid();
+        times[i] = block.time();
+    }
+}
+
 void GCodeProcessor::TimeMachine::State::reset()
 {
     feedrate = 0.0f;
@@ -322,10 +418,15 @@ void GCodeProcessor::TimeMachine::reset()
     prev.reset();
     gcode_time.reset();
     blocks = std::vector<TimeBlock>();
+    planned_blocks = std::vector<TimeBlock>();
+    planned_additional_times = std::vector<float>();
     g1_times_cache = std::vector<G1LinesCacheItem>();
     std::fill(moves_time.begin(), moves_time.end(), 0.0f);
     std::fill(roles_time.begin(), roles_time.end(), 0.0f);
     layers_time = std::vector<float>();
+    objects_time.clear();
+    objects_time_label = -1;
+    objects_time_cache = 0.0f;
     prepare_time = 0.0f;
 }
 
@@ -373,40 +474,6 @@ void planner_reverse_pass_kernel(GCodeProcessor::TimeBlock& curr, GCodeProcessor
     }
 }
 
-static void recalculate_trapezoids(std::vector<GCodeProcessor::TimeBlock>& blocks)
-{
-    GCodeProcessor::TimeBlock* curr = nullptr;
-    GCodeProcessor::TimeBlock* next = nullptr;
-
-    for (size_t i = 0; i < blocks.size(); ++i) {
-        GCodeProcessor::TimeBlock& b = blocks[i];
-
-        curr = next;
-        next = &b;
-
-        if (curr != nullptr) {
-            // Recalculate if current block entry or exit junction speed has changed.
-            if (curr->flags.recalculate || next->flags.recalculate) {
-                // NOTE: Entry and exit factors always > 0 by all previous logic operations.
-                GCodeProcessor::TimeBlock block = *curr;
-                block.feedrate_profile.exit = next->feedrate_profile.entry;
-                block.calculate_trapezoid();
-                curr->trapezoid = block.trapezoid;
-                curr->flags.recalculate = false; // Reset current only to ensure next trapezoid is computed
-            }
-        }
-    }
-
-    // Last/newest block in buffer. Always recalculated.
-    if (next != nullptr) {
-        GCodeProcessor::TimeBlock block = *next;
-        block.feedrate_profile.exit = next->safe_feedrate;
-        block.calculate_trapezoid();
-        next->trapezoid = block.trapezoid;
-        next->flags.recalculate = false;
-    }
-}
-
 void GCodeProcessor::TimeMachine::calculate_time(size_t keep_last_n_blocks, float additional_time)
 {
     if (!enabled || blocks.size() < 2)
@@ -423,38 +490,16 @@ void GCodeProcessor::TimeMachine::calculate_time(size_t keep_last_n_blocks, floa
     for (int i = static_cast<int>(blocks.size()) - 1; i > 0; --i)
         planner_reverse_pass_kernel(blocks[i - 1], blocks[i]);
 
-    recalculate_trapezoids(blocks);
-
+    // The entry feedrates of the processed blocks and of the block following them are final,
+    // thus are the trapezoids of the processed blocks, which are left to the solver.
     size_t n_blocks_process = blocks.size() - keep_last_n_blocks;
     for (size_t i = 0; i < n_blocks_process; ++i) {
-        const TimeBlock& block = blocks[i];
-        float block_time = block.time();
-        if (i == 0)
-            block_time += additional_time;
-
-        time += block_time;
-        gcode_time.cache += block_time;
-        //BBS: don't calculate travel of start gcode into travel time
-        if (!block.flags.prepare_stage || block.move_type != EMoveType::Travel)
-            moves_time[static_cast<size_t>(block.move_type)] += block_time;
-        roles_time[static_cast<size_t>(block.role)] += block_time;
-        if (block.layer_id >= layers_time.size()) {
-            const size_t curr_size = layers_time.size();
-            layers_time.resize(block.layer_id);
-            for (size_t i = curr_size; i < layers_time.size(); ++i) {
-                layers_time[i] = 0.0f;
-            }
-        }
-        layers_time[block.layer_id - 1] += block_time;
-        //BBS
-        if (block.flags.prepare_stage)
-            prepare_time += block_time;
-        g1_times_cache.push_back({ block.g1_line_id, block.remaining_internal_g1_lines, time });
-        // update times for remaining time to printer stop placeholders
-        auto it_stop_time = std::lower_bound(stop_times.begin(), stop_times.end(), block.g1_line_id,
-            [](const StopTime& t, unsigned int value) { return t.g1_line_id < value; });
-        if (it_stop_time != stop_times.end() && it_stop_time->g1_line_id == block.g1_line_id)
-            it_stop_time->elapsed_time = time;
+        TimeBlock& block = blocks[i];
+        // Last/newest block in buffer stops.
+        block.feedrate_profile.exit = (i + 1 < blocks.size()) ? blocks[i + 1].feedrate_profile.entry : block.safe_feedrate;
+        block.flags.recalculate = false;
+        planned_blocks.push_back(block);
+        planned_additional_times.push_back((i == 0) ? additional_time : 0.0f);
     }
 
     if (keep_last_n_blocks)
@@ -463,8 +508,132 @@ void GCodeProcessor::TimeMachine::calculate_time(size_t keep_last_n_blocks, floa
         blocks.clear();
 }
 
+void GCodeProcessor::TimeMachine::accumulate_time(const TimeBlock& block, float block_time)
+{
+    time += block_time;
+    gcode_time.cache += block_time;
+    //BBS: don't calculate travel of start gcode into travel time
+    if (!block.flags.prepare_stage || block.move_type != EMoveType::Travel)
+        moves_time[static_cast<size_t>(block.move_type)] += block_time;
+    roles_time[static_cast<size_t>(block.role)] += block_time;
+    if (block.layer_id >= layers_time.size()) {
+        const size_t curr_size = layers_time.size();
+        layers_time.resize(block.layer_id);
+        for (size_t i = curr_size; i < layers_time.size(); ++i) {
+            layers_time[i] = 0.0f;
+        }
+    }
+    layers_time[block.layer_id - 1] += block_time;
+    if (block.object_label_id != objects_time_label) {
+        flush_objects_time();
+        objects_time_label = block.object_label_id;
+    }
+    objects_time_cache += block_time;
+    //BBS
+    if (block.flags.prepare_stage)
+        prepare_time += block_time;
+    g1_times_cache.push_back({ block.g1_line_id, block.remaining_internal_g1_lines, time });
+    // update times for remaining time to printer stop placeholders
+    auto it_stop_time = std::lower_bound(stop_times.begin(), stop_times.end(), block.g1_line_id,
+        [](const StopTime& t, unsigned int value) { return t.g1_line_id < value; });
+    if (it_stop_time != stop_times.end() && it_stop_time->g1_line_id == block.g1_line_id)
+        it_stop_time->elapsed_time = time;
+}
+
+void GCodeProcessor::TimeMachine::flush_objects_time()
+{
+    if (objects_time_cache != 0.0f) {
+        objects_time[objects_time_label] += objects_time_cache;
+        objects_time_cache = 0.0f;
+    }
+}
+
+class GCodeProcessor::TimeProcessor::Solver
+{
+public:
+    using Machines = std::array<TimeMachine, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)>;
+
+    ~Solver() { this->wait(); }
+
+    // Takes over the planned blocks of the machines after the previous batch has been solved.
+    void run(Machines& machines)
+    {
+        this->wait();
+        for (size_t i = 0; i < machines.size(); ++i) {
+            m_blocks[i].clear();
+            m_additional_times[i].clear();
+            m_blocks[i].swap(machines[i].planned_blocks);
+            m_additional_times[i].swap(machines[i].planned_additional_times);
+        }
+        m_running = true;
+        m_task_group.run([this, &machines]() { this->solve(machines); });
+    }
+
+    void wait()
+    {
+        if (m_running) {
+            m_running = false;
+            m_task_group.wait();
+        }
+    }
+
+private:
+    // Both time modes are solved in a single pass, then the times are accumulated in the order of the blocks.
+    void solve(Machines& machines)
+    {
+        m_batch.clear();
+        for (const std::vector<TimeBlock>& blocks : m_blocks)
+            for (const TimeBlock& block : blocks)
+                m_batch.append(block);
+        m_batch.solve(m_times);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < machines.size(); ++i) {
+            for (size_t j = 0; j < m_blocks[i].size(); ++j)
+                machines[i].accumulate_time(m_blocks[i][j], m_times[offset + j] + m_additional_times[i][j]);
+            offset += m_blocks[i].size();
+        }
+    }
+
+    tbb::task_group                                                                         m_task_group;
+    bool                                                                                    m_running { false };
+    std::array<std::vector<TimeBlock>, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)> m_blocks;
+    std::array<std::vector<float>, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)>     m_additional_times;
+    TimeBlockBatch                                                                          m_batch;
+    std::vector<float>                                                                      m_times;
+};
+
+GCodeProcessor::TimeProcessor::TimeProcessor(const TimeProcessor &rhs)
+{
+    *this = rhs;
+}
+
+GCodeProcessor::TimeProcessor::~TimeProcessor() = default;
+
+GCodeProcessor::TimeProcessor& GCodeProcessor::TimeProcessor::operator=(const TimeProcessor &rhs)
+{
+    if (this != &rhs) {
+        // The times accumulated by the machines are only consistent once the running batches are solved.
+        if (rhs.solver)
+            rhs.solver->wait();
+        if (solver)
+            solver->wait();
+        extruder_unloaded                   = rhs.extruder_unloaded;
+        machine_envelope_processing_enabled = rhs.machine_envelope_processing_enabled;
+        machine_limits                      = rhs.machine_limits;
+        filament_load_times                 = rhs.filament_load_times;
+        filament_unload_times               = rhs.filament_unload_times;
+        machine_tool_change_time            = rhs.machine_tool_change_time;
+        machines                            = rhs.machines;
+    }
+    return *this;
+}
+
 void GCodeProcessor::TimeProcessor::reset()
 {
+    if (solver)
+        solver->wait();
+
     extruder_unloaded = true;
     machine_envelope_processing_enabled = false;
     machine_limits = MachineEnvelopeConfig();
@@ -479,6 +648,30 @@ void GCodeProcessor::TimeProcessor::reset()
     machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].enabled = true;
 }
 
+void GCodeProcessor::TimeProcessor::solve_planned_blocks()
+{
+    for (const TimeMachine& machine : machines)
+        if (machine.planned_blocks.size() >= Planner::solver_batch_size) {
+            if (!solver)
+                solver = std::make_unique<Solver>();
+            solver->run(machines);
+            return;
+        }
+}
+
+void GCodeProcessor::TimeProcessor::synchronize()
+{
+    for (const TimeMachine& machine : machines)
+        if (!machine.planned_blocks.empty()) {
+            if (!solver)
+                solver = std::make_unique<Solver>();
+            solver->run(machines);
+            break;
+        }
+    if (solver)
+        solver->wait();
+}
+
 #if __has_include(<charconv>)
     template <typename T, typename = void>
     struct is_from_chars_convertible : std::false_type {};
@@ -601,6 +794,8 @@ private:
 
     size_t m_times_cache_id{0};
     size_t m_out_file_pos{0};
+    // If set, the lines are written into the binary G-code instead of the file.
+    BinaryGCodeWriter* m_binary_writer{nullptr};
 
 public:
     ExportLines(EWriteType type, const std::array<GCodeProcessor::TimeMachine, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)>& machines)
@@ -808,11 +1003,20 @@ public:
 
     size_t get_size() const { return m_size; }
 
+    void set_binary_writer(BinaryGCodeWriter* writer) { m_binary_writer = writer; }
+
 private:
     void write_to_file(FilePtr& out, const std::string& out_string, GCodeProcessorResult& result, const std::string& out_path)
     {
         if (!out_string.empty()) {
-            if (true) {
+            if (m_binary_writer != nullptr) {
+                try {
+                    m_binary_writer->append_gcode(out_string);
+                } catch (const std::exception&) {
+                    boost::nowide::remove(out_path.c_str());
+                    throw Slic3r::RuntimeError("GCode processor post process export failed.\nIs the disk full?");
+                }
+            } else {
                 fwrite((const void*) out_string.c_str(), 1, out_string.length(), out.f);
                 if (ferror(out.f)) {
                     out.close();
@@ -826,15 +1030,28 @@ private:
 
 void GCodeProcessor::run_post_process()
 {
-    FilePtr in{ boost::nowide::fopen(m_result.filename.c_str(), "rb") };
-    if (in.f == nullptr)
+    // The G-code is read either from the output buffer, then the file is written straight away,
+    // or from the file written by the caller, then it is rewritten through a temporary file.
+    const bool output_buffered = m_output_buffered;
+    FilePtr in{ output_buffered ? nullptr : boost::nowide::fopen(m_result.filename.c_str(), "rb") };
+    if (! output_buffered && in.f == nullptr)
         throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for reading.\n"));
 
     // temporary file to contain modified gcode
-    std::string out_path = m_result.filename + ".postprocess";
-    FilePtr out{ boost::nowide::fopen(out_path.c_str(), "wb") };
-    if (out.f == nullptr)
-        throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for writing.\n"));
+    std::string out_path = output_buffered ? m_result.filename : m_result.filename + ".postprocess";
+    FilePtr out{ nullptr };
+    std::unique_ptr<BinaryGCodeWriter> binary_writer;
+    if (m_binary_gcode) {
+        try {
+            binary_writer = std::make_unique<BinaryGCodeWriter>(out_path);
+        } catch (const std::exception&) {
+            throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for writing.\n"));
+        }
+    } else {
+        out.f = boost::nowide::fopen(out_path.c_str(), "wb");
+        if (out.f == nullptr)
+            throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for writing.\n"));
+    }
 
     std::vector<double> filament_mm(m_result.filaments_count, 0.0);
     std::vector<double> filament_cm3(m_result.filaments_count, 0.0);
@@ -855,6 +1072,13 @@ void GCodeProcessor::run_post_process()
 
     double total_g_wipe_tower = m_print->print_statistics().total_wipe_tower_filament;
 
+    if (binary_writer) {
+        // The statistics are known before the G-code is rewritten, thus they are placed in front of the G-code blocks
+        // to be read without decompressing the G-code.
+        binary_writer->add_metadata(BinaryGCodeBlockType::FileMetadata, "; generated by " + header_slic3r_generated() + "\n");
+        binary_writer->add_metadata(BinaryGCodeBlockType::PrintMetadata, this->format_print_metadata(filament_mm, filament_cm3, filament_g, filament_cost));
+    }
+
 
     auto time_in_minutes = [](float time_in_seconds) {
         assert(time_in_seconds >= 0.f);
@@ -919,6 +1143,7 @@ void GCodeProcessor::run_post_process()
 
     ExportLines export_line(m_result.backtrace_enabled ? ExportLines::EWriteType::ByTime : ExportLines::EWriteType::BySize,
         m_time_processor.machines);
+    export_line.set_binary_writer(binary_writer.get());
 
     // replace placeholder lines with the proper final value
     // gcode_line is in/out parameter, to reduce expensive memory allocation
@@ -1199,16 +1424,26 @@ void GCodeProcessor::run_post_process()
 
     {
         // Read the input stream 64kB at a time, extract lines and process them.
-        std::vector<char> buffer(65536 * 10, 0);
+        std::vector<char> buffer(output_buffered ? 0 : 65536 * 10, 0);
+        size_t            buffered_pos = 0;
         // Line buffer.
         assert(gcode_line.empty());
         for (;;) {
-            size_t cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f);
-            if (::ferror(in.f))
-                throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while reading from file.\n"));
-            bool eof       = cnt_read == 0;
-            auto it        = buffer.begin();
-            auto it_bufend = buffer.begin() + cnt_read;
+            const char *it;
+            size_t      cnt_read;
+            if (output_buffered) {
+                // Lines are extracted from the output buffer in place.
+                it            = m_output_buffer.data() + buffered_pos;
+                cnt_read      = std::min<size_t>(65536 * 10, m_output_buffer.size() - buffered_pos);
+                buffered_pos += cnt_read;
+            } else {
+                it       = buffer.data();
+                cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f);
+                if (::ferror(in.f))
+                    throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while reading from file.\n"));
+            }
+            bool        eof       = cnt_read == 0;
+            const char *it_bufend = it + cnt_read;
             while (it != it_bufend || (eof && ! gcode_line.empty())) {
                 // Find end of line.
                 bool eol    = false;
@@ -1273,17 +1508,66 @@ void GCodeProcessor::run_post_process()
 
     export_line.flush(out, m_result, out_path);
 
+    if (binary_writer) {
+        try {
+            binary_writer->finish();
+        } catch (const std::exception&) {
+            throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while writing to file.\n"));
+        }
+        // The line ends index the ASCII G-code, which is not there to be shown by the G-code viewer.
+        m_result.lines_ends.clear();
+    } else if (::ferror(out.f))
+        throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while writing to file.\n"));
     out.close();
     in.close();
 
     const std::string result_filename = m_result.filename;
     export_line.synchronize_moves(m_result);
 
+    if (output_buffered) {
+        m_output_buffered = false;
+        m_output_buffer.clear();
+        m_output_buffer.shrink_to_fit();
+        return;
+    }
     if (rename_file(out_path, result_filename))
         throw Slic3r::RuntimeError(std::string("Failed to rename the output G-code file from ") + out_path + " to " + result_filename + '\n' +
             "Is " + out_path + " locked?" + '\n');
 }
 
+std::string GCodeProcessor::format_print_metadata(const std::vector<double>& filament_mm, const std::vector<double>& filament_cm3,
+                                                  const std::vector<double>& filament_g, const std::vector<double>& filament_cost) const
+{
+    auto format_list = [](const std::vector<double>& values) {
+        std::string out;
+        for (double value : values) {
+            if (!out.empty())
+                out += ", ";
+            out += float_to_string_decimal_point(value, 2);
+        }
+        return out;
+    };
+
+    std::string out;
+    for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+        const TimeMachine&                  machine = m_time_processor.machines[i];
+        PrintEstimatedStatistics::ETimeMode mode    = static_cast<PrintEstimatedStatistics::ETimeMode>(i);
+        if (mode == PrintEstimatedStatistics::ETimeMode::Normal || machine.enabled) {
+            const char* mode_name = (mode == PrintEstimatedStatistics::ETimeMode::Normal) ? "normal" : "silent";
+            out += std::string("; estimated printing time (") + mode_name + " mode) = " + get_time_dhms(machine.time) + "\n";
+            out += std::string("; estimated first layer printing time (") + mode_name + " mode) = " + get_time_dhms(machine.prepare_time) + "\n";
+        }
+    }
+    out += "; total layer number: " + std::to_string(m_layer_id) + "\n";
+    out += "; filament used [mm] = " + format_list(filament_mm) + "\n";
+    out += "; filament used [cm3] = " + format_list(filament_cm3) + "\n";
+    out += "; filament used [g] = " + format_list(filament_g) + "\n";
+    out += "; filament cost = " + format_list(filament_cost) + "\n";
+    out += "; total filament used [g] = " + float_to_string_decimal_point(std::accumulate(filament_g.begin(), filament_g.end(), 0.), 2) + "\n";
+    out += "; total filament cost = " + float_to_string_decimal_point(std::accumulate(filament_cost.begin(), filament_cost.end(), 0.), 2) + "\n";
+    return out;
+}
+
 void GCodeProcessor::UsedFilaments::reset()
 {
     color_change_cache = 0.0f;
@@ -1305,6 +1589,9 @@ void GCodeProcessor::UsedFilaments::reset()
 
     total_volume_cache = 0.0f;
     total_volumes_per_filament.clear();
+
+    object_cache = 0.0f;
+    volumes_per_object.clear();
 }
 
 void GCodeProcessor::UsedFilaments::increase_support_caches(double extruded_volume)
@@ -1312,6 +1599,7 @@ void GCodeProcessor::UsedFilaments::increase_support_caches(double extruded_volu
     support_volume_cache += extruded_volume;
     role_cache += extruded_volume;
     total_volume_cache += extruded_volume;
+    object_cache += extruded_volume;
 }
 
 void GCodeProcessor::UsedFilaments::increase_model_caches(double extruded_volume)
@@ -1320,6 +1608,7 @@ void GCodeProcessor::UsedFilaments::increase_model_caches(double extruded_volume
     model_extrude_cache += extruded_volume;
     role_cache += extruded_volume;
     total_volume_cache += extruded_volume;
+    object_cache += extruded_volume;
 }
 
 void GCodeProcessor::UsedFilaments::increase_wipe_tower_caches(double extruded_volume)
@@ -1386,6 +1675,14 @@ void GCodeProcessor::UsedFilaments::process_support_cache(GCodeProcessor* proces
     }
 }
 
+void GCodeProcessor::UsedFilaments::process_object_cache(GCodeProcessor* processor)
+{
+    if (object_cache != 0.0f) {
+        volumes_per_object[processor->m_object_label_id][processor->get_filament_id()] += object_cache;
+        object_cache = 0.0f;
+    }
+}
+
 void GCodeProcessor::UsedFilaments::update_flush_per_filament(size_t filament_id, float flush_volume)
 {
     if (flush_volume != 0.f) {
@@ -1429,6 +1726,7 @@ void GCodeProcessor::UsedFilaments::process_caches(GCodeProcessor* processor)
     process_wipe_tower_cache(processor);
     process_support_cache(processor);
     process_total_volume_cache(processor);
+    process_object_cache(processor);
 }
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -1437,6 +1735,7 @@ void GCodeProcessorResult::reset() {
     lock();
 
     moves = std::vector<GCodeProcessorResult::MoveVertex>();
+    arc_interpolation_points = std::vector<Vec3f>();
     printable_area = Pointfs();
     //BBS: add bed exclude area
     bed_exclude_area = Pointfs();
@@ -1465,6 +1764,7 @@ void GCodeProcessorResult::reset() {
     lock();
 
     moves.clear();
+    arc_interpolation_points.clear();
     lines_ends.clear();
     printable_area = Pointfs();
     //BBS: add bed exclude area
@@ -1703,8 +2003,8 @@ bool GCodeProcessor::check_multi_extruder_gcode_valid(const int
         if (move.type == EMoveType::Extrude /* && move.extrusion_role != ExtrusionRole::erFlush || move.type == EMoveType::Travel*/)
             if (move.extrusion_role == ExtrusionRole::erCustom) {
                 if (move.is_arc_move_with_interpolation_points()) {
-                    for (int i = 0; i < move.interpolation_points.size(); i++) {
-                        gcode_path_pos[move.object_label_id][int(move.extruder_id)].pos_custom.emplace_back(to_2d(move.interpolation_points[i].cast<double>()));
+                    for (const Vec3f &point : m_result.interpolation_points(move)) {
+                        gcode_path_pos[move.object_label_id][int(move.extruder_id)].pos_custom.emplace_back(to_2d(point.cast<double>()));
                     }
                 } else {
                     gcode_path_pos[move.object_label_id][int(move.extruder_id)].pos_custom.emplace_back(to_2d(move.position.cast<double>()));
@@ -1713,8 +2013,8 @@ bool GCodeProcessor::check_multi_extruder_gcode_valid(const int
                     std::max(gcode_path_pos[move.object_label_id][int(move.extruder_id)].max_print_z_custom, move.print_z);
             } else {
                 if (move.is_arc_move_with_interpolation_points()) {
-                    for (int i = 0; i < move.interpolation_points.size(); i++) {
-                        gcode_path_pos[move.object_label_id][int(move.extruder_id)].pos.emplace_back(to_2d(move.interpolation_points[i].cast<double>()));
+                    for (const Vec3f &point : m_result.interpolation_points(move)) {
+                        gcode_path_pos[move.object_label_id][int(move.extruder_id)].pos.emplace_back(to_2d(point.cast<double>()));
                     }
                 } else {
                     gcode_path_pos[move.object_label_id][int(move.extruder_id)].pos.emplace_back(to_2d(move.position.cast<double>()));
@@ -1929,6 +2229,7 @@ void GCodeProcessor::apply_config(const PrintConfig& config)
     }
 
     m_disable_m73 = config.disable_m73;
+    m_binary_gcode = config.orca_binary_gcode;
 
     const ConfigOptionFloat* initial_layer_print_height = config.option<ConfigOptionFloat>("initial_layer_print_height");
     if (initial_layer_print_height != nullptr)
@@ -2408,26 +2709,34 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     m_start_time = std::chrono::high_resolution_clock::now();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
+    // A binary G-code is read by blocks, its producer is the file metadata.
+    std::unique_ptr<BinaryGCodeReader> binary_reader;
+    if (BinaryGCodeReader::is_binary_gcode(filename))
+        binary_reader = std::make_unique<BinaryGCodeReader>(filename);
+
     // pre-processing
     // parse the gcode file to detect its producer
     {
-        m_parser.parse_file_raw(filename, [this](GCodeReader& reader, const char *begin, const char *end) {
-            begin = skip_whitespaces(begin, end);
-            if (begin != end && *begin == ';') {
-                // Comment.
-                begin = skip_whitespaces(++ begin, end);
-                end   = remove_eols(begin, end);
-                if (begin != end) {
-                    if (m_producer == EProducer::Unknown) {
-                        if (detect_producer(std::string_view(begin, end - begin))) {
+        if (binary_reader)
+            detect_producer(binary_reader->metadata(BinaryGCodeBlockType::FileMetadata));
+        else
+            m_parser.parse_file_raw(filename, [this](GCodeReader& reader, const char *begin, const char *end) {
+                begin = skip_whitespaces(begin, end);
+                if (begin != end && *begin == ';') {
+                    // Comment.
+                    begin = skip_whitespaces(++ begin, end);
+                    end   = remove_eols(begin, end);
+                    if (begin != end) {
+                        if (m_producer == EProducer::Unknown) {
+                            if (detect_producer(std::string_view(begin, end - begin))) {
+                                m_parser.quit_parsing();
+                            }
+                        } else if (std::string(begin, end).find("CONFIG_BLOCK_END") != std::string::npos) {
                             m_parser.quit_parsing();
                         }
-                    } else if (std::string(begin, end).find("CONFIG_BLOCK_END") != std::string::npos) {
-                        m_parser.quit_parsing();
                     }
                 }
-            }
-        });
+            });
         m_parser.reset();
 
         // if the gcode was produced by OrcaSlicer,
@@ -2467,7 +2776,7 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     // 1st move must be a dummy move
     m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
     size_t parse_line_callback_cntr = 10000;
-    m_parser.parse_file(filename, [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
+    auto process_line = [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
         if (-- parse_line_callback_cntr == 0) {
             // Don't call the cancel_callback() too often, do it every at every 10000'th line.
             parse_line_callback_cntr = 10000;
@@ -2475,7 +2784,15 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
                 cancel_callback();
         }
         this->process_gcode_line(line, true);
-    }, m_result.lines_ends);
+    };
+    if (binary_reader) {
+        // The blocks end at line ends, they are decompressed and tokenized in parallel. The line ends are offsets into
+        // the G-code text, which the G-code viewer reads through BinaryGCodeReader::gcode_text().
+        m_parser.parse_chunks_parallel(binary_reader->gcode_blocks_count(),
+            [&binary_reader](size_t idx) { return binary_reader->gcode_block(idx); }, process_line, m_result.lines_ends);
+    } else
+        // The lines are tokenized in parallel, the moves are simulated here in the order of the lines.
+        m_parser.parse_file_parallel(filename, process_line, m_result.lines_ends);
 
     // Don't post-process the G-code to update time stamps.
     this->finalize(false);
@@ -2494,18 +2811,38 @@ void GCodeProcessor::initialize(const std::string& filename)
     m_result.id = ++s_result_id;
     // 1st move must be a dummy move
     m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
+    // Drop the G-code of an export that failed before finalize(), the buffer is kept by reset() as the exporter
+    // requests it before resetting the processor.
+    m_output_buffered = false;
+    m_output_buffer.clear();
 }
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
+{
+    this->process_buffer(buffer.c_str(), buffer.c_str() + buffer.size());
+}
+
+void GCodeProcessor::process_buffer(const char *begin, const char *end)
 {
     //FIXME maybe cache GCodeLine gline to be over multiple parse_buffer() invocations.
-    m_parser.parse_buffer(buffer, [this](GCodeReader&, const GCodeReader::GCodeLine& line) {
+    m_parser.parse_buffer(begin, end, [this](GCodeReader&, const GCodeReader::GCodeLine& line) {
         this->process_gcode_line(line, false);
     });
 }
 
-void GCodeProcessor::finalize(bool post_process)
+void GCodeProcessor::process_buffer(const std::string &buffer, const std::vector<GCodeReader::TokenizedLine> &lines)
 {
+    m_parser.parse_buffer(buffer, lines, [this](GCodeReader&, const GCodeReader::GCodeLine& line) {
+        this->process_gcode_line(line, false);
+    });
+}
+
+void GCodeProcessor::finalize(bool post_process, GCodeExportStats *stats)
+{
+    std::optional<GCodeExportStats::Scope> timer;
+    if (stats != nullptr)
+        timer.emplace(*stats, GCodeExportStats::Finalize);
+
     // update width/height of wipe moves
     for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
         if (move.type == EMoveType::Wipe) {
@@ -2515,12 +2852,15 @@ void GCodeProcessor::finalize(bool post_process)
     }
 
     // process the time blocks
+    for (TimeMachine& machine : m_time_processor.machines)
+        machine.calculate_time();
+    m_time_processor.synchronize();
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
         TimeMachine& machine = m_time_processor.machines[i];
         TimeMachine::CustomGCodeTime& gcode_time = machine.gcode_time;
-        machine.calculate_time();
         if (gcode_time.needed && gcode_time.cache != 0.0f)
             gcode_time.times.push_back({ CustomGCode::ColorChange, gcode_time.cache });
+        machine.flush_objects_time();
     }
 
     m_used_filaments.process_caches(this);
@@ -2551,6 +2891,9 @@ void GCodeProcessor::finalize(bool post_process)
     m_width_compare.output();
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
     if (post_process){
+        timer.reset();
+        if (stats != nullptr)
+            timer.emplace(*stats, GCodeExportStats::PostProcess);
         run_post_process();
     }
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -2990,12 +3333,14 @@ void GCodeProcessor::process_tags(const std::string_view comment, bool producers
 
     // ; OBJECT_ID  start
     if (boost::starts_with(comment, " start printing object")) {
+        m_used_filaments.process_object_cache(this);
         m_object_label_id = get_object_label_id(comment);
         return;
     }
 
     // ; OBJECT_ID  end
     if (boost::starts_with(comment, " stop printing object")) {
+        m_used_filaments.process_object_cache(this);
         m_object_label_id = -1;
         return;
     }
@@ -3881,6 +4226,7 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line, const std::o
         block.g1_line_id = m_g1_line_id;
         block.remaining_internal_g1_lines = remaining_internal_g1_lines.has_value() ? *remaining_internal_g1_lines : 0;
         block.layer_id = std::max<unsigned int>(1, m_layer_id);
+        block.object_label_id = m_object_label_id;
         block.flags.prepare_stage = m_processing_start_custom_gcode;
 
         //BBS: limite the cruise according to centripetal acceleration
@@ -4052,9 +4398,6 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line, const std::o
         block.flags.recalculate = true;
         block.safe_feedrate = curr.safe_feedrate;
 
-        // calculates block trapezoid
-        block.calculate_trapezoid();
-
         // updates previous
         prev = curr;
 
@@ -4063,6 +4406,7 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line, const std::o
         if (blocks.size() > TimeProcessor::Planner::refresh_threshold)
             machine.calculate_time(TimeProcessor::Planner::queue_size);
     }
+    m_time_processor.solve_planned_blocks();
 
     const Vec3f plate_offset = {(float) m_x_offset, (float) m_y_offset, 0.0f};
 
@@ -4314,6 +4658,7 @@ void GCodeProcessor::process_VG1(const GCodeReader::GCodeLine& line)
         block.distance = distance;
         block.g1_line_id = m_g1_line_id;
         block.layer_id = std::max<unsigned int>(1, m_layer_id);
+        block.object_label_id = m_object_label_id;
         block.flags.prepare_stage = m_processing_start_custom_gcode;
 
         //BBS: limite the cruise according to centripetal acceleration
@@ -4485,9 +4830,6 @@ void GCodeProcessor::process_VG1(const GCodeReader::GCodeLine& line)
         block.flags.recalculate = true;
         block.safe_feedrate = curr.safe_feedrate;
 
-        // calculates block trapezoid
-        block.calculate_trapezoid();
-
         // updates previous
         prev = curr;
 
@@ -4496,6 +4838,7 @@ void GCodeProcessor::process_VG1(const GCodeReader::GCodeLine& line)
         if (blocks.size() > TimeProcessor::Planner::refresh_threshold)
             machine.calculate_time(TimeProcessor::Planner::queue_size);
     }
+    m_time_processor.solve_planned_blocks();
 
     // do not save the move
 }
@@ -4711,6 +5054,7 @@ void  GCodeProcessor::process_G2_G3(const GCodeReader::GCodeLine& line)
         block.distance = delta_xyz;
         block.g1_line_id = m_g1_line_id;
         block.layer_id = std::max<unsigned int>(1, m_layer_id);
+        block.object_label_id = m_object_label_id;
         block.flags.prepare_stage = m_processing_start_custom_gcode;
 
         // BBS: calculates block cruise feedrate
@@ -4863,9 +5207,6 @@ void  GCodeProcessor::process_G2_G3(const GCodeReader::GCodeLine& line)
         block.flags.recalculate = true;
         block.safe_feedrate = curr.safe_feedrate;
 
-        //BBS: calculates block trapezoid
-        block.calculate_trapezoid();
-
         //BBS: updates previous
         prev = curr;
 
@@ -4874,6 +5215,7 @@ void  GCodeProcessor::process_G2_G3(const GCodeReader::GCodeLine& line)
         if (blocks.size() > TimeProcessor::Planner::refresh_threshold)
             machine.calculate_time(TimeProcessor::Planner::queue_size);
     }
+    m_time_processor.solve_planned_blocks();
 
     //BBS: seam detector
     Vec3f plate_offset = {(float) m_x_offset, (float) m_y_offset, 0.0f};
@@ -5639,14 +5981,17 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
         ((type == EMoveType::Seam) ? m_last_line_id : m_line_id);
 
     //BBS: apply plate's and extruder's offset to arc interpolation points
+    const uint32_t interpolation_points_begin = uint32_t(m_result.arc_interpolation_points.size());
+    uint32_t       interpolation_points_count = 0;
     if (path_type == EMovePathType::Arc_move_cw ||
         path_type == EMovePathType::Arc_move_ccw) {
-        for (size_t i = 0; i < m_interpolation_points.size(); i++)
-            m_interpolation_points[i] =
-                Vec3f(m_interpolation_points[i].x() + m_x_offset,
-                      m_interpolation_points[i].y() + m_y_offset,
-                      m_processing_start_custom_gcode ? m_first_layer_height : m_interpolation_points[i].z()) +
-                m_extruder_offsets[filament_id];
+        for (const Vec3f &point : m_interpolation_points)
+            m_result.arc_interpolation_points.emplace_back(
+                Vec3f(point.x() + m_x_offset,
+                      point.y() + m_y_offset,
+                      m_processing_start_custom_gcode ? m_first_layer_height : point.z()) +
+                m_extruder_offsets[filament_id]);
+        interpolation_points_count = uint32_t(m_interpolation_points.size());
     }
 
     m_result.moves.push_back({
@@ -5669,8 +6014,8 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
         static_cast<float>(m_layer_id), //layer_duration: set later
         //BBS: add arc move related data
         path_type,
-        Vec3f(m_arc_center(0, 0) + m_x_offset, m_arc_center(1, 0) + m_y_offset, m_arc_center(2, 0)) + m_extruder_offsets[filament_id],
-        m_interpolation_points,
+        interpolation_points_begin,
+        interpolation_points_count,
         m_object_label_id,
         m_print_z
     });
@@ -5681,6 +6026,7 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
 
     // stores stop time placeholders for later use
     if (type == EMoveType::Color_change || type == EMoveType::Pause_Print) {
+        m_time_processor.synchronize();
         for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
             TimeMachine& machine = m_time_processor.machines[i];
             if (!machine.enabled)
@@ -5835,6 +6181,12 @@ int GCodeProcessor::get_filament_vitrification_temperature(size_t extrude_id)
 
 void GCodeProcessor::process_custom_gcode_time(CustomGCode::Type code)
 {
+    //FIXME this simulates st_synchronize! is it correct?
+    // The estimated time may be longer than the real print time.
+    for (TimeMachine& machine : m_time_processor.machines)
+        machine.simulate_st_synchronize();
+    m_time_processor.synchronize();
+
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
         TimeMachine& machine = m_time_processor.machines[i];
         if (!machine.enabled)
@@ -5842,9 +6194,6 @@ void GCodeProcessor::process_custom_gcode_time(CustomGCode::Type code)
 
         TimeMachine::CustomGCodeTime& gcode_time = machine.gcode_time;
         gcode_time.needed = true;
-        //FIXME this simulates st_synchronize! is it correct?
-        // The estimated time may be longer than the real print time.
-        machine.simulate_st_synchronize();
         if (gcode_time.cache != 0.0f) {
             gcode_time.times.push_back({ code, gcode_time.cache });
             gcode_time.cache = 0.0f;
@@ -5861,6 +6210,7 @@ void GCodeProcessor::process_filaments(CustomGCode::Type code)
         m_used_filaments.process_model_cache(this);
         m_used_filaments.process_support_cache(this);
         m_used_filaments.process_total_volume_cache(this);
+        m_used_filaments.process_object_cache(this);
         //BBS: reset remaining filament
         size_t last_extruder_id = get_extruder_id();
         m_remaining_volume[last_extruder_id] = m_nozzle_volume[last_extruder_id];
@@ -5872,6 +6222,7 @@ void GCodeProcessor::simulate_st_synchronize(float additional_time)
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
         m_time_processor.machines[i].simulate_st_synchronize(additional_time);
     }
+    m_time_processor.solve_planned_blocks();
 }
 
 void GCodeProcessor::update_estimated_times_stats()
@@ -5899,6 +6250,40 @@ void GCodeProcessor::update_estimated_times_stats()
     m_result.print_statistics.flush_per_filament      = m_used_filaments.flush_per_filament;
     m_result.print_statistics.used_filaments_per_role   = m_used_filaments.filaments_per_role;
     m_result.print_statistics.total_volumes_per_extruder = m_used_filaments.total_volumes_per_filament;
+    update_objects_stats();
+}
+
+void GCodeProcessor::update_objects_stats()
+{
+    std::map<int, PrintEstimatedStatistics::ObjectStatistics> &objects = m_result.print_statistics.objects;
+    objects.clear();
+    for (const auto &[label_id, volumes] : m_used_filaments.volumes_per_object)
+        objects[label_id].volumes_per_extruder = volumes;
+    for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+        const TimeMachine &machine = m_time_processor.machines[i];
+        if (!machine.enabled)
+            continue;
+        for (const auto &[label_id, time] : machine.objects_time)
+            objects[label_id].time[i] = time;
+    }
+
+    // Split the flushes and the wipe tower of each filament between the labeled objects using that filament.
+    std::map<size_t, double> purged = m_used_filaments.flush_per_filament;
+    for (const auto &[filament_id, volume] : m_used_filaments.wipe_tower_volumes_per_filament)
+        purged[filament_id] += volume;
+    for (const auto &[filament_id, volume] : purged) {
+        double labeled_volume = 0.;
+        for (const auto &[label_id, object] : objects)
+            if (label_id != -1)
+                if (auto it = object.volumes_per_extruder.find(filament_id); it != object.volumes_per_extruder.end())
+                    labeled_volume += it->second;
+        if (labeled_volume <= 0.)
+            continue;
+        for (auto &[label_id, object] : objects)
+            if (label_id != -1)
+                if (auto it = object.volumes_per_extruder.find(filament_id); it != object.volumes_per_extruder.end())
+                    object.flush_per_extruder[filament_id] = volume * it->second / labeled_volume;
+    }
 }
 
 //BBS: ugly code...
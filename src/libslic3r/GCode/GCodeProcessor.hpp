@@ -6,10 +6,12 @@
 #include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/PrintConfig.hpp"
 #include "libslic3r/CustomGCode.hpp"
+#include "libslic3r/GCode/ExportStats.hpp"
 
 #include <cstdint>
 #include <array>
 #include <vector>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
@@ -75,6 +77,16 @@ class Print;
             }
         };
 
+        // Filament and time spent on a single labeled object of the plate.
+        struct ObjectStatistics
+        {
+            // model and support volumes, in mm^3
+            std::map<size_t, double>                                  volumes_per_extruder;
+            // share of the flushes and of the wipe tower of each filament, proportional to the object's volume of that filament
+            std::map<size_t, double>                                  flush_per_extruder;
+            std::array<float, static_cast<size_t>(ETimeMode::Count)> time { 0.0f, 0.0f };
+        };
+
         std::vector<double>                                 volumes_per_color_change;
         std::map<size_t, double>                            model_volumes_per_extruder;
         std::map<size_t, double>                            wipe_tower_volumes_per_extruder;
@@ -83,6 +95,8 @@ class Print;
         //BBS: the flush amount of every filament
         std::map<size_t, double>                            flush_per_filament;
         std::map<ExtrusionRole, std::pair<double, double>>  used_filaments_per_role;
+        // by object_label_id, -1 collects what was printed outside of any object label (start gcode, travels between objects, skirt ...)
+        std::map<int, ObjectStatistics>                     objects;
 
         std::array<Mode, static_cast<size_t>(ETimeMode::Count)> modes;
         unsigned int                                        total_filament_changes;
@@ -102,6 +116,7 @@ class Print;
             total_volumes_per_extruder.clear();
             flush_per_filament.clear();
             used_filaments_per_role.clear();
+            objects.clear();
             total_filament_changes = 0;
             total_extruder_changes = 0;
         }
@@ -198,21 +213,40 @@ class Print;
 
             //BBS: arc move related data
             EMovePathType move_path_type{ EMovePathType::Noop_move };
-            Vec3f arc_center_position{ Vec3f::Zero() };      // mm
-            std::vector<Vec3f> interpolation_points;     // interpolation points of arc for drawing
+            // Interpolation points of arc for drawing, stored in GCodeProcessorResult::arc_interpolation_points
+            // and accessed through GCodeProcessorResult::interpolation_points(), so that a move owns no heap memory.
+            uint32_t interpolation_points_begin{ 0 };
+            uint32_t interpolation_points_count{ 0 };
             int  object_label_id{-1};
             float print_z{0.0f};
 
             float volumetric_rate() const { return feedrate * mm3_per_mm; }
             //BBS: new function to support arc move
             bool is_arc_move_with_interpolation_points() const {
-                return (move_path_type == EMovePathType::Arc_move_ccw || move_path_type == EMovePathType::Arc_move_cw) && interpolation_points.size();
+                return (move_path_type == EMovePathType::Arc_move_ccw || move_path_type == EMovePathType::Arc_move_cw) && interpolation_points_count > 0;
             }
             bool is_arc_move() const {
                 return move_path_type == EMovePathType::Arc_move_ccw || move_path_type == EMovePathType::Arc_move_cw;
             }
         };
 
+        // Read only view of the interpolation points of a move, empty for a move which is not an arc.
+        class InterpolationPoints
+        {
+        public:
+            InterpolationPoints(const Vec3f *begin, size_t size) : m_begin(begin), m_size(size) {}
+
+            size_t       size() const { return m_size; }
+            bool         empty() const { return m_size == 0; }
+            const Vec3f& operator[](size_t idx) const { assert(idx < m_size); return m_begin[idx]; }
+            const Vec3f* begin() const { return m_begin; }
+            const Vec3f* end() const { return m_begin + m_size; }
+
+        private:
+            const Vec3f *m_begin;
+            size_t       m_size;
+        };
+
         struct SliceWarning {
             int         level;                  // 0: normal tips, 1: warning; 2: error
             std::string msg;                    // enum string
@@ -223,6 +257,8 @@ class Print;
         std::string filename;
         unsigned int id;
         std::vector<MoveVertex> moves;
+        // Interpolation points of all the arc moves, one range per move in the order of the moves.
+        std::vector<Vec3f> arc_interpolation_points;
         // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code.
         std::vector<size_t> lines_ends;
         Pointfs printable_area;
@@ -269,6 +305,11 @@ class Print;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
         void reset();
 
+        InterpolationPoints interpolation_points(const MoveVertex &move) const {
+            assert(size_t(move.interpolation_points_begin) + move.interpolation_points_count <= arc_interpolation_points.size());
+            return { arc_interpolation_points.data() + move.interpolation_points_begin, move.interpolation_points_count };
+        }
+
         //BBS: add mutex for protection of gcode result
         mutable std::mutex result_mutex;
         GCodeProcessorResult& operator=(const GCodeProcessorResult &other)
@@ -276,6 +317,7 @@ class Print;
             filename = other.filename;
             id = other.id;
             moves = other.moves;
+            arc_interpolation_points = other.arc_interpolation_points;
             lines_ends = other.lines_ends;
             printable_area = other.printable_area;
             bed_exclude_area = other.bed_exclude_area;
@@ -449,6 +491,7 @@ class Print;
             unsigned int g1_line_id{ 0 };
             unsigned int remaining_internal_g1_lines{ 0 };
             unsigned int layer_id{ 0 };
+            int object_label_id{ -1 };
             float distance{ 0.0f }; // mm
             float acceleration{ 0.0f }; // mm/s^2
             float max_entry_speed{ 0.0f }; // mm/s
@@ -463,6 +506,22 @@ class Print;
             float time() const;
         };
 
+        // Blocks leaving the planner in SoA layout, their trapezoids and times are solved several blocks at once.
+        struct TimeBlockBatch
+        {
+            std::vector<float> entry; // mm/s
+            std::vector<float> cruise; // mm/s
+            std::vector<float> exit; // mm/s
+            std::vector<float> acceleration; // mm/s^2
+            std::vector<float> distance; // mm
+
+            size_t size() const { return entry.size(); }
+            void clear();
+            void append(const TimeBlock& block);
+            // Same times as TimeBlock::calculate_trapezoid() followed by TimeBlock::time() block by block.
+            void solve(std::vector<float>& times) const;
+        };
+
 
     private:
         friend class ExportLines;
@@ -529,14 +588,26 @@ class Print;
             std::array<float, static_cast<size_t>(EMoveType::Count)> moves_time;
             std::array<float, static_cast<size_t>(ExtrusionRole::erCount)> roles_time;
             std::vector<float> layers_time;
+            std::map<int, float> objects_time;
+            // Time of the consecutive blocks of the same object, added to objects_time when the object changes.
+            int objects_time_label { -1 };
+            float objects_time_cache { 0.0f };
             //BBS: prepare stage time before print model, including start gcode time and mostly same with start gcode time
             float prepare_time;
+            // Blocks which left the planner with their final feedrate profile, waiting for TimeProcessor to solve them.
+            std::vector<TimeBlock> planned_blocks;
+            // Delays of the simulated st_synchronize() calls, added to the times of planned_blocks.
+            std::vector<float> planned_additional_times;
 
             void reset();
+            void flush_objects_time();
 
             // Simulates firmware st_synchronize() call
             void simulate_st_synchronize(float additional_time = 0.0f);
+            // Plans the blocks and moves all but the last keep_last_n_blocks to planned_blocks.
+            // Their times are accumulated once TimeProcessor solves them.
             void calculate_time(size_t keep_last_n_blocks = 0, float additional_time = 0.0f);
+            void accumulate_time(const TimeBlock& block, float block_time);
         };
 
         struct UsedFilaments  // filaments per ColorChange
@@ -562,6 +633,10 @@ class Print;
             double role_cache;
             std::map<ExtrusionRole, std::pair<double, double>> filaments_per_role;
 
+            // model and support volume extruded since the last object label or filament change
+            double object_cache;
+            std::map<int, std::map<size_t, double>> volumes_per_object;
+
             void reset();
 
             void increase_support_caches(double extruded_volume);
@@ -573,6 +648,7 @@ class Print;
             void process_wipe_tower_cache(GCodeProcessor* processor);
             void process_support_cache(GCodeProcessor* processor);
             void process_total_volume_cache(GCodeProcessor* processor);
+            void process_object_cache(GCodeProcessor* processor);
 
             void update_flush_per_filament(size_t extrude_id, float flush_length);
             void process_role_cache(GCodeProcessor* processor);
@@ -591,8 +667,13 @@ class Print;
                 // The firmware recalculates last planner_queue_size trapezoidal blocks each time a new block is added.
                 // We are not simulating the firmware exactly, we calculate a sequence of blocks once a reasonable number of blocks accumulate.
                 static constexpr size_t refresh_threshold = queue_size * 4;
+                // Number of planned blocks of a machine handed over to the solver at once.
+                static constexpr size_t solver_batch_size = 4096;
             };
 
+            // Solves the planned blocks of all the machines in a single pass on a worker thread, while the parser continues.
+            class Solver;
+
             // extruder_id is currently used to correctly calculate filament load / unload times into the total print time.
             // This is currently only really used by the MK3 MMU2:
             // extruder_unloaded = true means no filament is loaded yet, all the filaments are parked in the MK3 MMU2 unit.
@@ -607,8 +688,20 @@ class Print;
             float machine_tool_change_time;
 
             std::array<TimeMachine, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)> machines;
+            // Declared after the machines, so that it finishes the running batch before the machines are destroyed.
+            // Owned by a single TimeProcessor, a copy creates its own solver once needed.
+            std::unique_ptr<Solver> solver;
+
+            TimeProcessor() = default;
+            TimeProcessor(const TimeProcessor &rhs);
+            ~TimeProcessor();
+            TimeProcessor& operator=(const TimeProcessor &rhs);
 
             void reset();
+            // Hands the planned blocks over to the solver once a batch is complete.
+            void solve_planned_blocks();
+            // Solves all the planned blocks and waits for the solver, the times accumulated by the machines are up to date afterwards.
+            void synchronize();
         };
     public:
         class SeamsDetector
@@ -807,6 +900,11 @@ class Print;
         float m_preheat_time;
         int m_preheat_steps;
         bool m_disable_m73;
+        // Post-processing writes a binary G-code, see BinaryGCode.hpp.
+        bool m_binary_gcode { false };
+        // G-code streamed by the caller into output_buffer() instead of into the file, see output_buffer().
+        bool m_output_buffered { false };
+        std::string m_output_buffer;
 #if ENABLE_GCODE_VIEWER_STATISTICS
         std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
@@ -877,7 +975,18 @@ class Print;
         // Streaming interface, for processing G-codes just generated by PrusaSlicer in a pipelined fashion.
         void initialize(const std::string& filename);
         void process_buffer(const std::string& buffer);
-        void finalize(bool post_process);
+        // The text at [begin, end) has to be followed by a zero character, it is parsed in place.
+        void process_buffer(const char* begin, const char* end);
+        // The buffer with its lines tokenized by GCodeReader::tokenize_buffer(), possibly on another thread.
+        void process_buffer(const std::string& buffer, const std::vector<GCodeReader::TokenizedLine>& lines);
+        // To be called after initialize(): the caller appends the G-code to the returned buffer instead of writing the file
+        // passed to initialize(), and finalize(true) writes the post-processed file in a single pass.
+        std::string& output_buffer() { m_output_buffered = true; return m_output_buffer; }
+        // The caller wrote the content of the output buffer into the file passed to initialize() and continues writing the file,
+        // finalize(true) post-processes the file through a temporary file then.
+        void release_output_buffer() { m_output_buffered = false; m_output_buffer.clear(); m_output_buffer.shrink_to_fit(); }
+        // Stages of the finalization and of the post-processing are added to stats if not null.
+        void finalize(bool post_process, GCodeExportStats *stats = nullptr);
 
         float get_time(PrintEstimatedStatistics::ETimeMode mode) const;
         float get_prepare_time(PrintEstimatedStatistics::ETimeMode mode) const;
@@ -1048,10 +1157,13 @@ class Print;
 
         void process_filament_change(int id);
 
-        // post process the file with the given filename to:
+        // post process the file with the given filename (or the output buffer) to:
         // 1) add remaining time lines M73 and update moves' gcode ids accordingly
         // 2) update used filament data
         void run_post_process();
+        // Print statistics of the binary G-code, formatted as the comments of the ASCII G-code.
+        std::string format_print_metadata(const std::vector<double>& filament_mm, const std::vector<double>& filament_cm3,
+                                          const std::vector<double>& filament_g, const std::vector<double>& filament_cost) const;
 
         //BBS: different path_type is only used for arc move
         void store_move_vertex(EMoveType type, EMovePathType path_type = EMovePathType::Noop_move);
@@ -1081,6 +1193,7 @@ class Print;
         void simulate_st_synchronize(float additional_time = 0.0f);
 
         void update_estimated_times_stats();
+        void update_objects_stats();
         //BBS:
         void update_slice_warnings();
 
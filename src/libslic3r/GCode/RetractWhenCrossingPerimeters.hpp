@@ -16,10 +16,12 @@ class RetractWhenCrossingPerimeters
 {
 public:
     bool    travel_inside_internal_regions(const Layer &layer, const Polyline &travel);
+    // Drop the cache of the last layer visited.
+    void    reset() { m_layer = nullptr; m_internal_islands.clear(); m_aabbtree_internal_islands.clear(); }
 
 private:
     // Last object layer visited, for which a cache of internal islands was created.
-    const Layer                        *m_layer;
+    const Layer                        *m_layer { nullptr };
     // Internal islands only, referencing data owned by m_layer->regions()->surfaces().
     std::vector<const ExPolygon*>       m_internal_islands;
     // Search structure over internal islands.
@@ -4,9 +4,15 @@
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include "Exception.hpp"
 #include "Utils.hpp"
 
 #include "LocalesUtils.hpp"
@@ -14,6 +20,19 @@
 #include <Shiny/Shiny.h>
 #include <fast_float/fast_float.h>
 
+#include <tbb/task_arena.h>
+// Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 void GCodeReader::apply_config(const GCodeConfig &config)
@@ -26,7 +45,7 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
     m_config.apply(config, true);
 }
 
-const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+const char* GCodeReader::tokenize_line(const char *ptr, const char *end, float *axis_values, uint32_t &mask, std::pair<const char*, const char*> &command)
 {
     PROFILE_FUNC();
 
@@ -71,8 +90,8 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 if (pend != c && is_end_of_word(*pend)) {
                     // The axis value has been parsed correctly.
                     if (axis != UNKNOWN_AXIS)
-	                    gline.m_axis[int(axis)] = float(v);
-                    gline.m_mask |= 1 << int(axis);
+	                    axis_values[int(axis)] = float(v);
+                    mask |= 1 << int(axis);
                     c = pend;
                 } else
                     // Skip the rest of the word.
@@ -82,12 +101,18 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
+    return c;
+}
+
+const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+{
+    const char *c = tokenize_line(ptr, end, gline.m_axis, gline.m_mask, command);
+
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
 
     // Copy the raw string including the comment, without the trailing newlines.
     if (c > ptr) {
@@ -107,6 +132,36 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
     return c;
 }
 
+std::vector<GCodeReader::TokenizedLine> GCodeReader::tokenize_range(const char *begin, const char *end, bool skip_line_numbers)
+{
+    if (end - begin >= std::ptrdiff_t(MAX_TOKENIZED_RANGE))
+        throw Slic3r::RuntimeError("G-code buffer too long to be tokenized");
+    std::vector<TokenizedLine> lines;
+    lines.reserve(std::count(begin, end, '\n') + 1);
+    for (const char *ptr = begin; ptr != end && *ptr != 0;) {
+        TokenizedLine                       &line = lines.emplace_back();
+        std::pair<const char*, const char*>  cmd;
+        if (skip_line_numbers) {
+            ptr = skip_whitespaces(ptr);
+            if (std::toupper(*ptr) == 'N')
+                ptr = skip_word(ptr);
+            ptr = skip_whitespaces(ptr);
+        }
+        const char *c = tokenize_line(ptr, end, line.axis, line.mask, cmd);
+        line.begin     = uint32_t(ptr - begin);
+        line.end       = uint32_t(c - begin);
+        line.cmd_begin = uint32_t(cmd.first - begin);
+        line.cmd_end   = uint32_t(cmd.second - begin);
+        // Skip the trailing newlines.
+        if (*c == '\r')
+            ++ c;
+        if (*c == '\n')
+            ++ c;
+        ptr = c;
+    }
+    return lines;
+}
+
 void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command)
 {
     PROFILE_FUNC();
@@ -215,6 +270,193 @@ bool GCodeReader::parse_file(const std::string &file, callback_t callback, std::
     return ret;
 }
 
+bool GCodeReader::parse_file_parallel(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends, size_t chunk_size)
+{
+    boost::iostreams::mapped_file_source mapped;
+    try {
+        boost::system::error_code ec;
+        if (boost::filesystem::file_size(file, ec) > 0 && ! ec)
+            mapped.open(file);
+    } catch (const std::exception &err) {
+        BOOST_LOG_TRIVIAL(warning) << "GCodeReader::parse_file_parallel: cannot map " << file << ", " << err.what();
+    }
+    if (! mapped.is_open())
+        return this->parse_file(file, callback, lines_ends);
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  before parse_file %1%") % file.c_str();
+    lines_ends.clear();
+
+    // Chunks end with a newline, except for the last chunk of a file not ending with a newline, which is copied
+    // to be terminated by a zero character.
+    struct FileChunk
+    {
+        size_t                     offset { 0 };
+        const char                *begin  { nullptr };
+        const char                *end    { nullptr };
+        std::string                tail;
+        // The chunk does not fit the offsets of TokenizedLine, it is parsed line by line by the replay stage.
+        bool                       oversized { false };
+        std::vector<TokenizedLine> lines;
+        std::vector<size_t>        lines_ends;
+    };
+    const char  *data = mapped.data();
+    const size_t size = mapped.size();
+    size_t       pos  = 0;
+    m_parsing = true;
+    // m_parsing is owned by the replay stage, which tells the split stage running on another thread to stop through this flag.
+    std::atomic<bool> stop { false };
+
+    const auto split = tbb::make_filter<void, FileChunk>(slic3r_tbb_filtermode::serial_in_order,
+        [data, size, chunk_size, &pos, &stop](tbb::flow_control &fc) -> FileChunk {
+            if (pos == size || stop.load(std::memory_order_relaxed)) {
+                fc.stop();
+                return {};
+            }
+            size_t chunk_end = std::min(size, pos + chunk_size);
+            if (const void *eol = chunk_end < size ? memchr(data + chunk_end, '\n', size - chunk_end) : nullptr; eol != nullptr)
+                chunk_end = static_cast<const char*>(eol) - data + 1;
+            else
+                chunk_end = size;
+            FileChunk chunk;
+            chunk.offset = pos;
+            if (chunk_end == size && data[size - 1] != '\n') {
+                chunk.tail.assign(data + pos, data + size);
+                chunk.begin = chunk.tail.c_str();
+                chunk.end   = chunk.begin + chunk.tail.size();
+            } else {
+                chunk.begin = data + pos;
+                chunk.end   = data + chunk_end;
+            }
+            // Only a line longer than 4GB makes a chunk that long.
+            chunk.oversized = chunk_end - pos >= MAX_TOKENIZED_RANGE;
+            pos = chunk_end;
+            return chunk;
+        });
+    const auto tokenize = tbb::make_filter<FileChunk, FileChunk>(slic3r_tbb_filtermode::parallel,
+        [](FileChunk chunk) -> FileChunk {
+            if (! chunk.tail.empty()) {
+                // A short string moves with the chunk.
+                chunk.begin = chunk.tail.c_str();
+                chunk.end   = chunk.begin + chunk.tail.size();
+            }
+            if (chunk.oversized)
+                return chunk;
+            chunk.lines = tokenize_range(chunk.begin, chunk.end, true);
+            chunk.lines_ends.reserve(chunk.lines.size());
+            for (const char *c = chunk.begin; (c = static_cast<const char*>(memchr(c, '\n', chunk.end - c))) != nullptr; ++ c)
+                chunk.lines_ends.emplace_back(chunk.offset + (c - chunk.begin) + 1);
+            return chunk;
+        });
+    const auto replay = tbb::make_filter<FileChunk, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &callback, &lines_ends, &stop](FileChunk chunk) {
+            if (! m_parsing)
+                return;
+            if (! chunk.tail.empty()) {
+                chunk.begin = chunk.tail.c_str();
+                chunk.end   = chunk.begin + chunk.tail.size();
+            }
+            if (chunk.oversized)
+                this->parse_range_by_lines(chunk.begin, chunk.end, chunk.offset, callback, lines_ends);
+            else {
+                lines_ends.insert(lines_ends.end(), chunk.lines_ends.begin(), chunk.lines_ends.end());
+                this->parse_buffer(chunk.begin, chunk.lines, callback);
+            }
+            if (! m_parsing)
+                stop.store(true, std::memory_order_relaxed);
+        });
+    // Limit the number of chunks in flight, thus the memory held by the tokenized lines.
+    tbb::parallel_pipeline(2 * size_t(tbb::this_task_arena::max_concurrency()), split & tokenize & replay);
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  finished parse_file %1%") % file.c_str();
+    return true;
+}
+
+void GCodeReader::parse_chunks_parallel(size_t num_chunks, const std::function<std::string(size_t)> &get_chunk, callback_t callback, std::vector<size_t> &lines_ends)
+{
+    lines_ends.clear();
+
+    struct Chunk
+    {
+        size_t                     idx { 0 };
+        std::string                text;
+        bool                       oversized { false };
+        std::vector<TokenizedLine> lines;
+        // Relative to the start of the chunk, the replay stage knows the offset of the chunk.
+        std::vector<size_t>        lines_ends;
+    };
+    size_t   next_idx = 0;
+    size_t   offset   = 0;
+    m_parsing = true;
+    std::atomic<bool> stop { false };
+
+    const auto split = tbb::make_filter<void, Chunk>(slic3r_tbb_filtermode::serial_in_order,
+        [num_chunks, &next_idx, &stop](tbb::flow_control &fc) -> Chunk {
+            if (next_idx == num_chunks || stop.load(std::memory_order_relaxed)) {
+                fc.stop();
+                return {};
+            }
+            Chunk chunk;
+            chunk.idx = next_idx ++;
+            return chunk;
+        });
+    const auto tokenize = tbb::make_filter<Chunk, Chunk>(slic3r_tbb_filtermode::parallel,
+        [&get_chunk](Chunk chunk) -> Chunk {
+            chunk.text      = get_chunk(chunk.idx);
+            chunk.oversized = chunk.text.size() >= MAX_TOKENIZED_RANGE;
+            if (chunk.oversized)
+                return chunk;
+            const char *begin = chunk.text.c_str();
+            const char *end   = begin + chunk.text.size();
+            chunk.lines = tokenize_range(begin, end, true);
+            chunk.lines_ends.reserve(chunk.lines.size());
+            for (const char *c = begin; (c = static_cast<const char*>(memchr(c, '\n', end - c))) != nullptr; ++ c)
+                chunk.lines_ends.emplace_back(c - begin + 1);
+            return chunk;
+        });
+    const auto replay = tbb::make_filter<Chunk, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &callback, &lines_ends, &offset, &stop](Chunk chunk) {
+            if (! m_parsing)
+                return;
+            if (chunk.oversized)
+                this->parse_range_by_lines(chunk.text.c_str(), chunk.text.c_str() + chunk.text.size(), offset, callback, lines_ends);
+            else {
+                for (size_t line_end : chunk.lines_ends)
+                    lines_ends.emplace_back(offset + line_end);
+                this->parse_buffer(chunk.text.c_str(), chunk.lines, callback);
+            }
+            offset += chunk.text.size();
+            if (! m_parsing)
+                stop.store(true, std::memory_order_relaxed);
+        });
+    tbb::parallel_pipeline(2 * size_t(tbb::this_task_arena::max_concurrency()), split & tokenize & replay);
+}
+
+void GCodeReader::parse_range_by_lines(const char *begin, const char *end, size_t offset, callback_t &callback, std::vector<size_t> &lines_ends)
+{
+    GCodeLine   gline;
+    std::string line;
+    m_parsing = true;
+    for (const char *ptr = begin; m_parsing && ptr != end;) {
+        const char *eol  = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+        const char *next = eol ? eol + 1 : end;
+        if (eol)
+            lines_ends.emplace_back(offset + (next - begin));
+        else
+            eol = end;
+        if (eol != ptr && eol[-1] == '\r')
+            -- eol;
+        // The line parser expects a zero terminated line.
+        line.assign(ptr, eol);
+        const char *line_begin = skip_whitespaces(line.c_str());
+        if (std::toupper(*line_begin) == 'N')
+            line_begin = skip_word(line_begin);
+        line_begin = skip_whitespaces(line_begin);
+        gline.reset();
+        this->parse_line(line_begin, line.c_str() + line.size(), gline, callback);
+        ptr = next;
+    }
+}
+
 bool GCodeReader::parse_file_raw(const std::string &filename, raw_line_callback_t line_callback)
 {
     return this->parse_file_raw_internal(filename,
@@ -5,8 +5,10 @@
 #include <cmath>
 #include <cstdlib>
 #include <functional>
+#include <limits>
 #include <string>
 #include <string_view>
+#include <vector>
 #include "PrintConfig.hpp"
 
 namespace Slic3r {
@@ -96,6 +98,17 @@ public:
         friend class GCodeReader;
     };
 
+    // A line of a buffer tokenized by tokenize_buffer(): the command and the axes are parsed, the raw line is referenced by offsets.
+    struct TokenizedLine {
+        // Raw line without the trailing newlines.
+        uint32_t begin     { 0 };
+        uint32_t end       { 0 };
+        uint32_t cmd_begin { 0 };
+        uint32_t cmd_end   { 0 };
+        uint32_t mask      { 0 };
+        float    axis[NUM_AXES] {};
+    };
+
     typedef std::function<void(GCodeReader&, const GCodeLine&)> callback_t;
     typedef std::function<void(GCodeReader&, const char*, const char*)> raw_line_callback_t;
     
@@ -107,9 +120,13 @@ public:
 
     template<typename Callback>
     void parse_buffer(const std::string &buffer, Callback callback)
+        { this->parse_buffer(buffer.c_str(), buffer.c_str() + buffer.size(), callback); }
+
+    // The text at [ptr, end) has to be followed by a zero character, as a std::string or a C string is.
+    template<typename Callback>
+    void parse_buffer(const char *ptr, const char *end, Callback callback)
     {
-        const char *ptr = buffer.c_str();
-        const char *end = ptr + buffer.size();
+        assert(*end == 0);
         GCodeLine gline;
         m_parsing = true;
         while (m_parsing && *ptr != 0) {
@@ -121,6 +138,40 @@ public:
     void parse_buffer(const std::string &buffer)
         { this->parse_buffer(buffer, [](GCodeReader&, const GCodeReader::GCodeLine&){}); }
 
+    // Tokenizing does not depend on the state of a reader, thus a buffer may be tokenized on another thread
+    // and then handed over to parse_buffer() below, which only replays the lines.
+    static std::vector<TokenizedLine> tokenize_buffer(const std::string &buffer)
+        { return tokenize_range(buffer.c_str(), buffer.c_str() + buffer.size(), false); }
+    // The text at [begin, end) has to end with a newline or to be followed by a zero character.
+    // The offsets of the lines are relative to begin. If skip_line_numbers is set, "N123" line numbers are not part
+    // of the lines, as with parse_file().
+    // Throws Slic3r::RuntimeError if the range is not shorter than MAX_TOKENIZED_RANGE, as the offsets would not fit.
+    static std::vector<TokenizedLine> tokenize_range(const char *begin, const char *end, bool skip_line_numbers);
+    static constexpr const size_t MAX_TOKENIZED_RANGE = std::numeric_limits<uint32_t>::max();
+
+    // Same as parse_buffer() above with lines returned by tokenize_buffer(buffer).
+    template<typename Callback>
+    void parse_buffer(const std::string &buffer, const std::vector<TokenizedLine> &lines, Callback callback)
+        { this->parse_buffer(buffer.data(), lines, callback); }
+
+    // Lines returned by tokenize_range(buffer, ...).
+    template<typename Callback>
+    void parse_buffer(const char *buffer, const std::vector<TokenizedLine> &lines, Callback callback)
+    {
+        GCodeLine gline;
+        m_parsing = true;
+        for (auto it = lines.begin(); m_parsing && it != lines.end(); ++ it) {
+            gline.m_mask = it->mask;
+            memcpy(gline.m_axis, it->axis, sizeof(gline.m_axis));
+            if (gline.has(E) && m_config.use_relative_e_distances)
+                m_position[E] = 0;
+            gline.m_raw.assign(buffer + it->begin, buffer + it->end);
+            callback(*this, gline);
+            std::pair<const char*, const char*> cmd(buffer + it->cmd_begin, buffer + it->cmd_end);
+            update_coordinates(gline, cmd);
+        }
+    }
+
     template<typename Callback>
     const char* parse_line(const char *ptr, const char *end, GCodeLine &gline, Callback &callback)
     {
@@ -140,6 +191,14 @@ public:
     // Collect positions of line ends in the binary G-code to be used by the G-code viewer when memory mapping and displaying section of G-code
     // as an overlay in the 3D scene.
     bool parse_file(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
+    // Same as parse_file() above, the file is memory mapped and tokenized by chunks of about chunk_size bytes in parallel,
+    // while the callback is called for the lines of the chunks tokenized already on a single thread at a time, in the order of the lines.
+    // Falls back to parse_file() if the file cannot be mapped.
+    bool parse_file_parallel(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends, size_t chunk_size = 4 * 1024 * 1024);
+    // Same as parse_file_parallel() above for a text split into num_chunks chunks ending with a newline, except for the last one.
+    // The chunks are produced by get_chunk(idx) in parallel, for example by decompressing the G-code blocks of a binary G-code,
+    // lines_ends are the offsets into the chunks concatenated.
+    void parse_chunks_parallel(size_t num_chunks, const std::function<std::string(size_t)> &get_chunk, callback_t callback, std::vector<size_t> &lines_ends);
     // Just read the G-code file line by line, calls callback (const char *begin, const char *end). Returns false if reading the file failed.
     bool parse_file_raw(const std::string &file, raw_line_callback_t callback);
 
@@ -173,6 +232,8 @@ private:
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
+    // Parses the command and the axes of a line starting at ptr, returns the end of the line without the trailing newlines.
+    static const char* tokenize_line(const char *ptr, const char *end, float *axis, uint32_t &mask, std::pair<const char*, const char*> &command);
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
@@ -191,6 +252,9 @@ private:
         return c;
     }
 
+    // Parses the lines of [begin, end) one by one without tokenizing them first, appends their ends shifted by offset to lines_ends.
+    void parse_range_by_lines(const char *begin, const char *end, size_t offset, callback_t &callback, std::vector<size_t> &lines_ends);
+
     GCodeConfig m_config;
     float       m_position[NUM_AXES];
     bool        m_verbose;
@@ -1097,6 +1097,60 @@ void GCodeWriter::init_extruder(unsigned int filament_id)
     }
 }
 
+GCodeWriter::State GCodeWriter::state() const
+{
+    State out;
+    out.extruders.reserve(m_filament_extruders.size());
+    for (const Extruder &extruder : m_filament_extruders)
+        out.extruders.emplace_back(extruder.state());
+    out.curr_filament_extruder.reserve(m_curr_filament_extruder.size());
+    for (const Extruder *extruder : m_curr_filament_extruder)
+        out.curr_filament_extruder.emplace_back(extruder == nullptr ? -1 : int(extruder - m_filament_extruders.data()));
+    out.curr_extruder_id             = m_curr_extruder_id;
+    out.last_acceleration            = m_last_acceleration;
+    out.last_travel_acceleration     = m_last_travel_acceleration;
+    out.last_jerk                    = m_last_jerk;
+    out.last_additional_fan_speed    = m_last_additional_fan_speed;
+    out.last_bed_temperature         = m_last_bed_temperature;
+    out.last_bed_temperature_reached = m_last_bed_temperature_reached;
+    out.lifted                       = m_lifted;
+    out.to_lift                      = m_to_lift;
+    out.to_lift_type                 = m_to_lift_type;
+    out.pos                          = m_pos;
+    out.is_current_pos_clear         = m_is_current_pos_clear;
+    out.gcode_label_objects_start    = m_gcode_label_objects_start;
+    out.gcode_label_objects_end      = m_gcode_label_objects_end;
+    out.current_speed                = m_current_speed;
+    out.is_first_layer               = m_is_first_layer;
+    return out;
+}
+
+void GCodeWriter::restore_state(const State &state)
+{
+    assert(state.extruders.size() == m_filament_extruders.size());
+    assert(state.curr_filament_extruder.size() == m_curr_filament_extruder.size());
+    for (size_t i = 0; i < m_filament_extruders.size(); ++ i)
+        m_filament_extruders[i].restore_state(state.extruders[i]);
+    for (size_t i = 0; i < m_curr_filament_extruder.size(); ++ i)
+        m_curr_filament_extruder[i] = state.curr_filament_extruder[i] == -1 ? nullptr : &m_filament_extruders[state.curr_filament_extruder[i]];
+    m_curr_extruder_id             = state.curr_extruder_id;
+    m_last_acceleration            = state.last_acceleration;
+    m_last_travel_acceleration     = state.last_travel_acceleration;
+    m_last_jerk                    = state.last_jerk;
+    m_last_additional_fan_speed    = state.last_additional_fan_speed;
+    m_last_bed_temperature         = state.last_bed_temperature;
+    m_last_bed_temperature_reached = state.last_bed_temperature_reached;
+    m_lifted                       = state.lifted;
+    m_to_lift                      = state.to_lift;
+    m_to_lift_type                 = state.to_lift_type;
+    m_pos                          = state.pos;
+    m_is_current_pos_clear         = state.is_current_pos_clear;
+    m_gcode_label_objects_start    = state.gcode_label_objects_start;
+    m_gcode_label_objects_end      = state.gcode_label_objects_end;
+    m_current_speed                = state.current_speed;
+    m_is_first_layer               = state.is_first_layer;
+}
+
 bool GCodeWriter::need_toolchange(unsigned int filament_id)const
 {
     return filament()==nullptr || filament()->id()!=filament_id;
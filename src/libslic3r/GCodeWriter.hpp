@@ -126,6 +126,35 @@ public:
 
     // Returns whether this flavor supports separate print and travel acceleration.
     static bool supports_separate_travel_acceleration(GCodeFlavor flavor);
+
+    // State changed by emitting G-code, saved after a layer and restored by the incremental G-code export.
+    // The machine limits and the config are not part of the state, they are set up before the first layer.
+    struct State {
+        // In the order of extruders().
+        std::vector<Extruder::State> extruders;
+        // Index into extruders() of the filament loaded in each extruder, -1 if none.
+        std::vector<int>    curr_filament_extruder;
+        int                 curr_extruder_id                { -1 };
+        unsigned int        last_acceleration               { 0 };
+        unsigned int        last_travel_acceleration        { 0 };
+        double              last_jerk                       { 0. };
+        unsigned int        last_additional_fan_speed       { 0 };
+        int                 last_bed_temperature            { 0 };
+        bool                last_bed_temperature_reached    { true };
+        double              lifted                          { 0. };
+        double              to_lift                         { 0. };
+        LiftType            to_lift_type                    { LiftType::NormalLift };
+        Vec3d               pos                             { Vec3d::Zero() };
+        bool                is_current_pos_clear            { false };
+        std::string         gcode_label_objects_start;
+        std::string         gcode_label_objects_end;
+        double              current_speed                   { 0. };
+        bool                is_first_layer                  { true };
+    };
+    State       state() const;
+    // The state has to be saved by a writer with the same extruders.
+    void        restore_state(const State &state);
+
   private:
 	// Extruders are sorted by their ID, so that binary search is possible.
     std::vector<Extruder> m_filament_extruders;
@@ -0,0 +1,468 @@
+#include "InvoiceCost.hpp"
+
+#include "Exception.hpp"
+#include "GCode/GCodeMetadata.hpp"
+#include "GCode/GCodeProcessor.hpp"
+#include "Print.hpp"
+#include "PrintConfig.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include <boost/nowide/fstream.hpp>
+#include <boost/log/trivial.hpp>
+
+using namespace nlohmann;
+
+namespace Slic3r {
+
+double invoice_time_to_hours(const std::string &time_str)
+{
+    double      hours = 0.0;
+    const char *p     = time_str.c_str();
+    while (*p != 0) {
+        if (! std::isdigit((unsigned char)*p) && *p != '.') {
+            ++ p;
+            continue;
+        }
+        char  *end;
+        double value = std::strtod(p, &end);
+        if (end == p) {
+            ++ p;
+            continue;
+        }
+        p = end;
+        while (*p == ' ')
+            ++ p;
+        switch (*p) {
+        case 'd': hours += value * 24.0;   break;
+        case 'h': hours += value;          break;
+        case 'm': hours += value / 60.0;   break;
+        case 's': hours += value / 3600.0; break;
+        default:  break;
+        }
+    }
+    return hours;
+}
+
+std::vector<InvoiceFilamentUsage> invoice_filament_usage(const PrintStatistics &stats, const DynamicPrintConfig &config, const std::vector<std::string> &filament_names)
+{
+    std::vector<InvoiceFilamentUsage> out;
+
+    auto get_float = [&config](const char *key, size_t idx, double def) {
+        const auto *opt = config.option<ConfigOptionFloats>(key);
+        return (opt != nullptr && idx < opt->values.size()) ? opt->values[idx] : def;
+    };
+    auto get_string = [&config](const char *key, size_t idx, const std::string &def) {
+        const auto *opt = config.option<ConfigOptionStrings>(key);
+        return (opt != nullptr && idx < opt->values.size() && ! opt->values[idx].empty()) ? opt->values[idx] : def;
+    };
+
+    // filament_stats holds the extruded model volume per extruder in mm^3.
+    for (const auto &[extruder_id, volume_mm3] : stats.filament_stats) {
+        InvoiceFilamentUsage usage;
+        usage.extruder_id = extruder_id;
+        if (extruder_id < filament_names.size())
+            usage.name = filament_names[extruder_id];
+        else
+            usage.name = get_string("filament_settings_id", extruder_id, "Filament " + std::to_string(extruder_id + 1));
+        usage.color       = get_string("filament_colour", extruder_id, "#808080");
+        usage.cost_per_kg = get_float("filament_cost", extruder_id, 20.0);
+        usage.weight_g    = volume_mm3 * get_float("filament_density", extruder_id, 1.24) * 0.001;
+        out.emplace_back(std::move(usage));
+    }
+
+    // total_weight also accounts for the wipe tower and flushing, prefer it if there is nothing to split.
+    if (out.size() == 1 && stats.total_weight > 0.)
+        out.front().weight_g = stats.total_weight;
+
+    if (out.empty() && stats.total_weight > 0.) {
+        InvoiceFilamentUsage usage;
+        usage.name        = "Default Filament";
+        usage.color       = "#808080";
+        usage.weight_g    = stats.total_weight;
+        usage.cost_per_kg = 20.0;
+        out.emplace_back(std::move(usage));
+    }
+    return out;
+}
+
+std::vector<InvoiceFilamentUsage> invoice_filament_usage(const GCodeMetadata &metadata)
+{
+    std::vector<InvoiceFilamentUsage> out;
+
+    auto get_float = [](const std::vector<double> &values, size_t idx, double def) {
+        return idx < values.size() ? values[idx] : def;
+    };
+    auto get_string = [](const std::vector<std::string> &values, size_t idx, const std::string &def) {
+        return (idx < values.size() && ! values[idx].empty()) ? values[idx] : def;
+    };
+
+    // The weight is only written for filaments with a density, fall back to the volume otherwise.
+    const size_t num_extruders = std::max(metadata.filament_used_g.size(), metadata.filament_used_cm3.size());
+    for (size_t extruder_id = 0; extruder_id < num_extruders; ++ extruder_id) {
+        double weight_g = get_float(metadata.filament_used_g, extruder_id, 0.);
+        if (weight_g <= 0.)
+            weight_g = get_float(metadata.filament_used_cm3, extruder_id, 0.) * get_float(metadata.filament_density, extruder_id, 1.24);
+        if (weight_g <= 0.)
+            continue;
+        InvoiceFilamentUsage usage;
+        usage.extruder_id = extruder_id;
+        usage.name        = get_string(metadata.filament_settings_id, extruder_id, "Filament " + std::to_string(extruder_id + 1));
+        usage.color       = get_string(metadata.filament_colour, extruder_id, "#808080");
+        usage.cost_per_kg = get_float(metadata.filament_cost_per_kg, extruder_id, 20.0);
+        usage.weight_g    = weight_g;
+        out.emplace_back(std::move(usage));
+    }
+    return out;
+}
+
+InvoiceQuote calculate_invoice_quote(const InvoiceJobProfile &job, double print_time_hours, std::vector<InvoiceFilamentUsage> filaments)
+{
+    InvoiceQuote quote;
+    quote.print_time_hours = print_time_hours;
+
+    double total_filament_kg = 0.0;
+    for (InvoiceFilamentUsage &usage : filaments) {
+        if (auto it = job.filament_costs.find(usage.extruder_id); it != job.filament_costs.end())
+            usage.cost_per_kg = it->second;
+        usage.cost           = (usage.weight_g / 1000.0) * usage.cost_per_kg;
+        quote.material_cost += usage.cost;
+        total_filament_kg   += usage.weight_g / 1000.0;
+    }
+    quote.filaments      = std::move(filaments);
+    quote.total_weight_g = total_filament_kg * 1000.0;
+
+    double labor_time_minutes = job.prep_time + job.setup_time + (job.finishing_per_part * job.parts_per_plate) + job.finishing_per_plate;
+    quote.labor_cost = (labor_time_minutes / 60.0) * job.labor_rate;
+
+    double depreciation_per_hour = job.printer_lifespan > 0. ? job.printer_cost / job.printer_lifespan : 0.;
+    double power_cost_per_hour   = (job.power_watts / 1000.0) * job.electricity_cost;
+    double machine_hourly_rate   = depreciation_per_hour + job.maintenance_cost + power_cost_per_hour;
+    quote.machine_cost = machine_hourly_rate * print_time_hours;
+
+    double c_bed    = job.bed_lifespan > 0. ? (job.bed_cost / job.bed_lifespan) * print_time_hours : 0.;
+    double c_nozzle = job.nozzle_lifespan_kg > 0. ? (job.nozzle_cost / job.nozzle_lifespan_kg) * total_filament_kg : 0.;
+    quote.tooling_cost = c_bed + c_nozzle;
+
+    double c_tank_power = (job.tank_power / 1000.0) * job.electricity_cost * job.solving_time;
+    quote.postprocess_cost = c_tank_power + job.finishing_materials;
+
+    quote.subtotal = quote.material_cost + quote.labor_cost + quote.machine_cost + quote.tooling_cost + quote.postprocess_cost;
+
+    double failure_rate = job.failure_rate / 100.0;
+    if (failure_rate < 1.0)
+        quote.failure_adjustment = (quote.subtotal / (1.0 - failure_rate)) - quote.subtotal;
+
+    double total_plate_cost = quote.subtotal + quote.failure_adjustment;
+    quote.cost_per_part = (job.parts_per_plate > 0) ? total_plate_cost / job.parts_per_plate : total_plate_cost;
+
+    quote.markup_amount = quote.cost_per_part * job.markup_percent / 100.0;
+    quote.final_price   = quote.cost_per_part + quote.markup_amount;
+
+    quote.total_parts    = job.parts_per_plate * job.num_plates;
+    quote.total_job_cost = quote.final_price * quote.total_parts;
+    return quote;
+}
+
+InvoiceQuote sum_invoice_plate_quotes(const InvoiceJobProfile &job, const std::vector<InvoicePlateQuote> &plates)
+{
+    InvoiceQuote job_quote;
+    for (const InvoicePlateQuote &plate : plates) {
+        const InvoiceQuote &quote = plate.quote;
+        for (const InvoiceFilamentUsage &usage : quote.filaments) {
+            auto it = std::find_if(job_quote.filaments.begin(), job_quote.filaments.end(),
+                [&usage](const InvoiceFilamentUsage &u) { return u.extruder_id == usage.extruder_id; });
+            if (it == job_quote.filaments.end())
+                job_quote.filaments.emplace_back(usage);
+            else {
+                it->weight_g += usage.weight_g;
+                it->cost     += usage.cost;
+            }
+        }
+        job_quote.print_time_hours   += quote.print_time_hours;
+        job_quote.total_weight_g     += quote.total_weight_g;
+        job_quote.material_cost      += quote.material_cost;
+        job_quote.labor_cost         += quote.labor_cost;
+        job_quote.machine_cost       += quote.machine_cost;
+        job_quote.tooling_cost       += quote.tooling_cost;
+        job_quote.postprocess_cost   += quote.postprocess_cost;
+        job_quote.subtotal           += quote.subtotal;
+        job_quote.failure_adjustment += quote.failure_adjustment;
+        job_quote.total_parts        += quote.total_parts;
+    }
+    std::sort(job_quote.filaments.begin(), job_quote.filaments.end(),
+        [](const InvoiceFilamentUsage &a, const InvoiceFilamentUsage &b) { return a.extruder_id < b.extruder_id; });
+
+    double total_job_plate_cost = job_quote.subtotal + job_quote.failure_adjustment;
+    job_quote.cost_per_part  = job_quote.total_parts > 0 ? total_job_plate_cost / job_quote.total_parts : total_job_plate_cost;
+    job_quote.markup_amount  = job_quote.cost_per_part * job.markup_percent / 100.0;
+    job_quote.final_price    = job_quote.cost_per_part + job_quote.markup_amount;
+    job_quote.total_job_cost = job_quote.total_parts > 0 ? job_quote.final_price * job_quote.total_parts : job_quote.final_price;
+    return job_quote;
+}
+
+std::vector<InvoiceObjectUsage> invoice_object_usage(const GCodeProcessorResult &result, const std::map<int, std::string> &object_names)
+{
+    std::vector<InvoiceObjectUsage> out;
+    const size_t normal = static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal);
+    for (const auto &[label_id, stats] : result.print_statistics.objects) {
+        if (label_id == -1)
+            continue;
+        InvoiceObjectUsage object;
+        object.object_label_id  = label_id;
+        object.print_time_hours = stats.time[normal] / 3600.;
+        if (auto it = object_names.find(label_id); it != object_names.end())
+            object.name = it->second;
+        else
+            object.name = "Object " + std::to_string(label_id);
+        for (const auto &[extruder_id, volume] : stats.volumes_per_extruder) {
+            double purged = 0.;
+            if (auto it = stats.flush_per_extruder.find(extruder_id); it != stats.flush_per_extruder.end())
+                purged = it->second;
+            InvoiceFilamentUsage usage;
+            usage.extruder_id = extruder_id;
+            usage.weight_g    = (volume + purged) * (extruder_id < result.filament_densities.size() ? result.filament_densities[extruder_id] : 1.24f) * 0.001;
+            object.filaments.emplace_back(std::move(usage));
+        }
+        out.emplace_back(std::move(object));
+    }
+    return out;
+}
+
+std::map<int, std::string> invoice_object_names(const Print &print)
+{
+    std::map<int, std::string> names;
+    for (const PrintObject *object : print.objects())
+        for (const PrintInstance &instance : object->instances())
+            names[int(instance.model_instance->get_labeled_id())] = object->model_object()->name;
+    return names;
+}
+
+std::vector<InvoiceObjectCost> calculate_invoice_object_costs(const InvoiceQuote &quote, const InvoiceJobProfile &job, const std::vector<InvoiceObjectUsage> &objects)
+{
+    std::vector<InvoiceObjectCost> out;
+    if (objects.empty())
+        return out;
+
+    // Price the filaments of each object with the cost per kg of the plate quote, which already has the job overrides applied.
+    std::map<size_t, double> cost_per_kg;
+    for (const InvoiceFilamentUsage &usage : quote.filaments)
+        cost_per_kg[usage.extruder_id] = usage.cost_per_kg;
+
+    double total_material = 0.;
+    double total_time     = 0.;
+    out.reserve(objects.size());
+    for (const InvoiceObjectUsage &object : objects) {
+        InvoiceObjectCost cost;
+        cost.object_label_id  = object.object_label_id;
+        cost.name             = object.name;
+        cost.print_time_hours = object.print_time_hours;
+        for (const InvoiceFilamentUsage &usage : object.filaments) {
+            cost.weight_g += usage.weight_g;
+            if (auto it = cost_per_kg.find(usage.extruder_id); it != cost_per_kg.end())
+                cost.material_cost += usage.weight_g / 1000.0 * it->second;
+        }
+        total_material += cost.material_cost;
+        total_time     += cost.print_time_hours;
+        out.emplace_back(std::move(cost));
+    }
+
+    // Filament and time outside of the object labels (skirt, travels, start G-code) are spread proportionally.
+    const double n_objects    = double(out.size());
+    const double machine_cost = quote.machine_cost + quote.tooling_cost;
+    const double failure      = quote.subtotal > 0. ? (quote.subtotal + quote.failure_adjustment) / quote.subtotal : 1.;
+    const double markup       = 1. + job.markup_percent / 100.0;
+    for (InvoiceObjectCost &cost : out) {
+        cost.material_cost    = total_material > 0. ? quote.material_cost * cost.material_cost / total_material : quote.material_cost / n_objects;
+        cost.machine_cost     = total_time > 0. ? machine_cost * cost.print_time_hours / total_time : machine_cost / n_objects;
+        cost.labor_cost       = quote.labor_cost / n_objects;
+        cost.postprocess_cost = quote.postprocess_cost / n_objects;
+        cost.subtotal         = cost.material_cost + cost.machine_cost + cost.labor_cost + cost.postprocess_cost;
+        cost.price            = cost.subtotal * failure * markup;
+    }
+    return out;
+}
+
+json invoice_job_profile_to_json(const InvoiceJobProfile &job)
+{
+    json j;
+    j["job_name"]            = job.job_name;
+    j["customer_name"]       = job.customer_name;
+    j["customer_email"]      = job.customer_email;
+    j["customer_phone"]      = job.customer_phone;
+    j["job_description"]     = job.job_description;
+    j["parts_per_plate"]     = job.parts_per_plate;
+    j["num_plates"]          = job.num_plates;
+    j["failure_rate"]        = job.failure_rate;
+    j["labor_rate"]          = job.labor_rate;
+    j["prep_time"]           = job.prep_time;
+    j["setup_time"]          = job.setup_time;
+    j["finishing_per_part"]  = job.finishing_per_part;
+    j["finishing_per_plate"] = job.finishing_per_plate;
+    j["printer_cost"]        = job.printer_cost;
+    j["printer_lifespan"]    = job.printer_lifespan;
+    j["maintenance_cost"]    = job.maintenance_cost;
+    j["power_watts"]         = job.power_watts;
+    j["electricity_cost"]    = job.electricity_cost;
+    j["bed_cost"]            = job.bed_cost;
+    j["bed_lifespan"]        = job.bed_lifespan;
+    j["nozzle_cost"]         = job.nozzle_cost;
+    j["nozzle_lifespan_kg"]  = job.nozzle_lifespan_kg;
+    j["solvent_cost"]        = job.solvent_cost;
+    j["solving_time"]        = job.solving_time;
+    j["tank_power"]          = job.tank_power;
+    j["finishing_materials"] = job.finishing_materials;
+    j["markup_percent"]      = job.markup_percent;
+    json costs = json::object();
+    for (const auto &[extruder_id, cost] : job.filament_costs)
+        costs[std::to_string(extruder_id)] = cost;
+    j["filament_costs"] = std::move(costs);
+    return j;
+}
+
+InvoiceJobProfile invoice_job_profile_from_json(const json &j)
+{
+    InvoiceJobProfile job;
+    auto get = [&j](const char *key, auto &value) {
+        if (auto it = j.find(key); it != j.end() && ! it->is_null())
+            it->get_to(value);
+    };
+    get("job_name",            job.job_name);
+    get("customer_name",       job.customer_name);
+    get("customer_email",      job.customer_email);
+    get("customer_phone",      job.customer_phone);
+    get("job_description",     job.job_description);
+    get("parts_per_plate",     job.parts_per_plate);
+    get("num_plates",          job.num_plates);
+    get("failure_rate",        job.failure_rate);
+    get("labor_rate",          job.labor_rate);
+    get("prep_time",           job.prep_time);
+    get("setup_time",          job.setup_time);
+    get("finishing_per_part",  job.finishing_per_part);
+    get("finishing_per_plate", job.finishing_per_plate);
+    get("printer_cost",        job.printer_cost);
+    get("printer_lifespan",    job.printer_lifespan);
+    get("maintenance_cost",    job.maintenance_cost);
+    get("power_watts",         job.power_watts);
+    get("electricity_cost",    job.electricity_cost);
+    get("bed_cost",            job.bed_cost);
+    get("bed_lifespan",        job.bed_lifespan);
+    get("nozzle_cost",         job.nozzle_cost);
+    get("nozzle_lifespan_kg",  job.nozzle_lifespan_kg);
+    get("solvent_cost",        job.solvent_cost);
+    get("solving_time",        job.solving_time);
+    get("tank_power",          job.tank_power);
+    get("finishing_materials", job.finishing_materials);
+    get("markup_percent",      job.markup_percent);
+    if (auto it = j.find("filament_costs"); it != j.end() && it->is_object())
+        for (const auto &[extruder_id, cost] : it->items())
+            job.filament_costs[size_t(std::stoul(extruder_id))] = cost.get<double>();
+    return job;
+}
+
+json invoice_quote_to_json(const InvoiceQuote &quote)
+{
+    json j;
+    json filaments = json::array();
+    for (const InvoiceFilamentUsage &usage : quote.filaments) {
+        json f;
+        f["extruder_id"] = usage.extruder_id;
+        f["name"]        = usage.name;
+        f["color"]       = usage.color;
+        f["weight_g"]    = usage.weight_g;
+        f["cost_per_kg"] = usage.cost_per_kg;
+        f["cost"]        = usage.cost;
+        filaments.push_back(std::move(f));
+    }
+    j["filaments"]          = std::move(filaments);
+    j["print_time_hours"]   = quote.print_time_hours;
+    j["total_weight_g"]     = quote.total_weight_g;
+    j["material_cost"]      = quote.material_cost;
+    j["labor_cost"]         = quote.labor_cost;
+    j["machine_cost"]       = quote.machine_cost;
+    j["tooling_cost"]       = quote.tooling_cost;
+    j["postprocess_cost"]   = quote.postprocess_cost;
+    j["subtotal"]           = quote.subtotal;
+    j["failure_adjustment"] = quote.failure_adjustment;
+    j["cost_per_part"]      = quote.cost_per_part;
+    j["markup_amount"]      = quote.markup_amount;
+    j["final_price"]        = quote.final_price;
+    j["total_parts"]        = quote.total_parts;
+    j["total_job_cost"]     = quote.total_job_cost;
+    return j;
+}
+
+InvoiceJobProfile load_invoice_job_profile(const std::string &path)
+{
+    boost::nowide::ifstream ifs(path);
+    if (! ifs.good())
+        throw Slic3r::RuntimeError("Cannot open job profile " + path);
+    try {
+        json j;
+        ifs >> j;
+        return invoice_job_profile_from_json(j);
+    } catch (const std::exception &err) {
+        throw Slic3r::RuntimeError("Failed to parse job profile " + path + ": " + err.what());
+    }
+}
+
+void save_invoice_quotes(const std::string &path, const std::string &source, const InvoiceJobProfile &job, const std::vector<InvoicePlateQuote> &plates)
+{
+    json j;
+    j["version"]       = 1;
+    j["source"]        = source;
+    j["job_name"]      = job.job_name;
+    j["customer_name"] = job.customer_name;
+
+    json   plates_json    = json::array();
+    double total_job_cost = 0.0;
+    double total_hours    = 0.0;
+    double total_weight_g = 0.0;
+    int    total_parts    = 0;
+    for (const InvoicePlateQuote &plate : plates) {
+        json p     = invoice_quote_to_json(plate.quote);
+        p["plate"] = plate.plate_id;
+        p["gcode"] = plate.gcode_path;
+        if (! plate.objects.empty()) {
+            json objects = json::array();
+            for (const InvoiceObjectCost &cost : plate.objects) {
+                json o;
+                o["label_id"]         = cost.object_label_id;
+                o["name"]             = cost.name;
+                o["weight_g"]         = cost.weight_g;
+                o["print_time_hours"] = cost.print_time_hours;
+                o["material_cost"]    = cost.material_cost;
+                o["labor_cost"]       = cost.labor_cost;
+                o["machine_cost"]     = cost.machine_cost;
+                o["postprocess_cost"] = cost.postprocess_cost;
+                o["subtotal"]         = cost.subtotal;
+                o["price"]            = cost.price;
+                objects.push_back(std::move(o));
+            }
+            p["objects"] = std::move(objects);
+        }
+        plates_json.push_back(std::move(p));
+        total_job_cost += plate.quote.total_job_cost;
+        total_hours    += plate.quote.print_time_hours;
+        total_weight_g += plate.quote.total_weight_g;
+        total_parts    += plate.quote.total_parts;
+    }
+    j["plates"]           = std::move(plates_json);
+    j["print_time_hours"] = total_hours;
+    j["total_weight_g"]   = total_weight_g;
+    j["total_parts"]      = total_parts;
+    j["total_job_cost"]   = total_job_cost;
+
+    boost::nowide::ofstream ofs(path);
+    if (! ofs.good())
+        throw Slic3r::RuntimeError("Cannot write quote " + path);
+    ofs << j.dump(4);
+    ofs.close();
+    if (ofs.fail())
+        throw Slic3r::RuntimeError("Failed to write quote " + path);
+    BOOST_LOG_TRIVIAL(info) << "Invoice quote written to " << path;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,176 @@
+#ifndef slic3r_InvoiceCost_hpp_
+#define slic3r_InvoiceCost_hpp_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace Slic3r {
+
+class DynamicPrintConfig;
+class Print;
+struct PrintStatistics;
+struct GCodeMetadata;
+struct GCodeProcessorResult;
+
+// Customer data and shop rates used to turn slicer statistics into a price.
+// Times are in minutes unless the name says otherwise, rates are per hour, money is in the shop currency.
+struct InvoiceJobProfile
+{
+    std::string job_name;
+    std::string customer_name;
+    std::string customer_email;
+    std::string customer_phone;
+    std::string job_description;
+
+    // Job parameters
+    int    parts_per_plate     { 1 };
+    int    num_plates          { 1 };
+    double failure_rate        { 5.0 };     // percent
+
+    // Labor
+    double labor_rate          { 20.0 };
+    double prep_time           { 15.0 };
+    double setup_time          { 10.0 };
+    double finishing_per_part  { 5.0 };
+    double finishing_per_plate { 0.0 };
+
+    // Machine
+    double printer_cost        { 300.0 };
+    double printer_lifespan    { 15000.0 }; // hours
+    double maintenance_cost    { 0.10 };
+    double power_watts         { 130.0 };
+    double electricity_cost    { 0.15 };    // per kWh
+
+    // Tooling
+    double bed_cost            { 30.0 };
+    double bed_lifespan        { 5000.0 };  // hours
+    double nozzle_cost         { 2.0 };
+    double nozzle_lifespan_kg  { 25.0 };
+
+    // Post-Processing
+    double solvent_cost        { 0.0 };
+    double solving_time        { 0.0 };     // hours
+    double tank_power          { 0.0 };     // Watts
+    double finishing_materials { 0.0 };     // per plate
+
+    // Markup
+    double markup_percent      { 50.0 };
+
+    // Per-filament cost overrides (extruder_id -> cost_per_kg)
+    std::map<size_t, double> filament_costs;
+};
+
+struct InvoiceFilamentUsage
+{
+    size_t      extruder_id { 0 };
+    std::string name;
+    std::string color;
+    double      weight_g    { 0.0 };
+    double      cost_per_kg { 0.0 };
+    double      cost        { 0.0 };
+};
+
+// Price of a single plate, as shown on the Results tab of the invoice dialog.
+struct InvoiceQuote
+{
+    std::vector<InvoiceFilamentUsage> filaments;
+
+    double print_time_hours   { 0.0 };
+    double total_weight_g     { 0.0 };
+    double material_cost      { 0.0 };
+    double labor_cost         { 0.0 };
+    double machine_cost       { 0.0 };
+    double tooling_cost       { 0.0 };
+    double postprocess_cost   { 0.0 };
+    double subtotal           { 0.0 };
+    double failure_adjustment { 0.0 };
+    double cost_per_part      { 0.0 };
+    double markup_amount      { 0.0 };
+    double final_price        { 0.0 };
+    double total_job_cost     { 0.0 };
+    int    total_parts        { 0 };
+};
+
+// Filament and machine time spent on one labeled object of a plate.
+struct InvoiceObjectUsage
+{
+    int                               object_label_id { -1 };
+    std::string                       name;
+    // Weight includes the object's share of flushes and of the wipe tower.
+    std::vector<InvoiceFilamentUsage> filaments;
+    double                            print_time_hours { 0.0 };
+};
+
+// Share of a plate quote billed to one object of the plate.
+struct InvoiceObjectCost
+{
+    int         object_label_id { -1 };
+    std::string name;
+    double      weight_g         { 0.0 };
+    double      print_time_hours { 0.0 };
+    double      material_cost    { 0.0 };
+    double      labor_cost       { 0.0 };
+    double      machine_cost     { 0.0 };   // machine and tooling
+    double      postprocess_cost { 0.0 };
+    double      subtotal         { 0.0 };
+    // subtotal with the failure adjustment and the markup of the plate
+    double      price            { 0.0 };
+};
+
+// Quote of one sliced plate of a project, tagged with the plate index (1 based) and the exported G-code.
+struct InvoicePlateQuote
+{
+    int                            plate_id { 0 };
+    std::string                    gcode_path;
+    InvoiceQuote                   quote;
+    // Optional split of the quote between the objects of the plate.
+    std::vector<InvoiceObjectCost> objects;
+};
+
+// Parse the "1d 2h 3m 4s" print time strings produced by get_time_dhms() into hours.
+double invoice_time_to_hours(const std::string &time_str);
+
+// Collect per-extruder filament weight and price from the statistics of an exported print.
+// Filament colour, cost, density and diameter are read from the full print config,
+// filament names default to the filament_settings_id of the config if not provided.
+std::vector<InvoiceFilamentUsage> invoice_filament_usage(const PrintStatistics          &stats,
+                                                         const DynamicPrintConfig       &config,
+                                                         const std::vector<std::string> &filament_names = {});
+// Same as above, from the statistics and the filament presets embedded into an exported G-code.
+std::vector<InvoiceFilamentUsage> invoice_filament_usage(const GCodeMetadata &metadata);
+
+// The cost model of the invoice generator. Filament costs overridden by the job profile
+// take precedence over the cost_per_kg of the passed in filaments.
+InvoiceQuote calculate_invoice_quote(const InvoiceJobProfile &job, double print_time_hours, std::vector<InvoiceFilamentUsage> filaments);
+
+// Sum the quotes of all plates of a project into one job quote. Each plate is expected to be quoted
+// for a single copy of the plate (num_plates == 1) with the number of parts printed on that plate.
+// Filaments are merged by extruder, the markup is applied to the average cost per part of the job.
+InvoiceQuote sum_invoice_plate_quotes(const InvoiceJobProfile &job, const std::vector<InvoicePlateQuote> &plates);
+
+// Per object statistics collected by GCodeProcessor, object names are looked up by object_label_id.
+// Extrusions outside of any object label are not reported, calculate_invoice_object_costs() spreads them over the objects.
+std::vector<InvoiceObjectUsage> invoice_object_usage(const GCodeProcessorResult &result, const std::map<int, std::string> &object_names = {});
+// Names of the object instances of a print by the object_label_id written into the G-code.
+std::map<int, std::string> invoice_object_names(const Print &print);
+
+// Split a plate quote between the objects of the plate, so that the object subtotals add up to the plate subtotal:
+// material by the filament cost of each object, machine and tooling by print time, labor and post-processing evenly.
+std::vector<InvoiceObjectCost> calculate_invoice_object_costs(const InvoiceQuote &quote, const InvoiceJobProfile &job, const std::vector<InvoiceObjectUsage> &objects);
+
+nlohmann::json invoice_job_profile_to_json(const InvoiceJobProfile &job);
+// Missing keys keep the defaults of InvoiceJobProfile.
+InvoiceJobProfile invoice_job_profile_from_json(const nlohmann::json &j);
+nlohmann::json invoice_quote_to_json(const InvoiceQuote &quote);
+
+// Load a job profile from a JSON file. Throws Slic3r::RuntimeError on failure.
+InvoiceJobProfile load_invoice_job_profile(const std::string &path);
+// Write a machine readable quote of all plates of one input file. Throws Slic3r::RuntimeError on failure.
+void save_invoice_quotes(const std::string &path, const std::string &source, const InvoiceJobProfile &job, const std::vector<InvoicePlateQuote> &plates);
+
+} // namespace Slic3r
+
+#endif // slic3r_InvoiceCost_hpp_
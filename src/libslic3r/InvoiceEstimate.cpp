@@ -0,0 +1,294 @@
+#include "InvoiceEstimate.hpp"
+
+#include "Exception.hpp"
+#include "Model.hpp"
+#include "PrintConfig.hpp"
+#include "TriangleMesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <Eigen/Dense>
+
+namespace Slic3r {
+
+InvoiceEstimateFeatures& InvoiceEstimateFeatures::operator+=(const InvoiceEstimateFeatures &rhs)
+{
+    volume_mm3           += rhs.volume_mm3;
+    perimeter_mm3        += rhs.perimeter_mm3;
+    solid_infill_mm3     += rhs.solid_infill_mm3;
+    sparse_infill_mm3    += rhs.sparse_infill_mm3;
+    perimeter_time_s     += rhs.perimeter_time_s;
+    solid_infill_time_s  += rhs.solid_infill_time_s;
+    sparse_infill_time_s += rhs.sparse_infill_time_s;
+    layers                = std::max(layers, rhs.layers);
+    return *this;
+}
+
+InvoiceEstimator::InvoiceEstimator(const DynamicPrintConfig &config, const InvoiceEstimateCoefficients &coefficients) :
+    m_coefficients(coefficients)
+{
+    PrintConfig       print_config;
+    PrintObjectConfig object_config;
+    PrintRegionConfig region_config;
+    print_config.apply(config, true);
+    object_config.apply(config, true);
+    region_config.apply(config, true);
+
+    const double nozzle_diameter = print_config.nozzle_diameter.values.empty() ? 0.4 : print_config.nozzle_diameter.values.front();
+    const double default_width   = object_config.line_width.value > 0. ? object_config.line_width.get_abs_value(nozzle_diameter) : 1.125 * nozzle_diameter;
+    auto width = [nozzle_diameter, default_width](const ConfigOptionFloatOrPercent &opt) {
+        return opt.value > 0. ? opt.get_abs_value(nozzle_diameter) : default_width;
+    };
+
+    m_layer_height          = std::max(object_config.layer_height.value, 0.01);
+    m_perimeter_width       = 0.5 * (width(region_config.outer_wall_line_width) + width(region_config.inner_wall_line_width));
+    m_solid_infill_width    = width(region_config.internal_solid_infill_line_width);
+    m_sparse_infill_width   = width(region_config.sparse_infill_line_width);
+    m_wall_loops            = region_config.wall_loops.value;
+    m_top_layers            = std::max<double>(region_config.top_shell_layers.value, std::ceil(region_config.top_shell_thickness.value / m_layer_height));
+    m_bottom_layers         = std::max<double>(region_config.bottom_shell_layers.value, std::ceil(region_config.bottom_shell_thickness.value / m_layer_height));
+    m_sparse_infill_density = std::clamp(region_config.sparse_infill_density.value / 100., 0., 1.);
+
+    // Machine limits, 0 means not set.
+    auto limit = [](double value, const ConfigOptionFloats &opt, double fallback) {
+        double max = opt.values.empty() ? 0. : opt.values.front();
+        value = value > 0. ? value : fallback;
+        return max > 0. ? std::min(value, max) : value;
+    };
+    const double max_speed = std::min(
+        print_config.machine_max_speed_x.values.empty() ? 0. : print_config.machine_max_speed_x.values.front(),
+        print_config.machine_max_speed_y.values.empty() ? 0. : print_config.machine_max_speed_y.values.front());
+    auto speed = [max_speed](double value) { return max_speed > 0. ? std::min(std::max(value, 1.), max_speed) : std::max(value, 1.); };
+    m_perimeter_speed     = speed(0.5 * (region_config.outer_wall_speed.value + region_config.inner_wall_speed.value));
+    m_solid_infill_speed  = speed(region_config.internal_solid_infill_speed.value);
+    m_sparse_infill_speed = speed(region_config.sparse_infill_speed.value);
+    m_acceleration        = limit(object_config.default_acceleration.value, print_config.machine_max_acceleration_extruding, 1000.);
+
+    const ConfigOptionFloats *filament_density = config.option<ConfigOptionFloats>("filament_density");
+    m_filament_density = filament_density && ! filament_density->values.empty() && filament_density->values.front() > 0. ?
+        filament_density->values.front() : 1.24;
+}
+
+// Extrude volume_mm3 along straight segments of about segment_length, accelerating to speed and back to stop on each of them.
+double InvoiceEstimator::extrusion_time(double volume_mm3, double line_width, double speed, double segment_length) const
+{
+    const double length = volume_mm3 / (line_width * m_layer_height);
+    if (length <= 0.)
+        return 0.;
+    const double segments = std::max(1., std::round(length / segment_length));
+    const double s        = length / segments;
+    const double a        = m_acceleration;
+    // Trapezoid if the segment is long enough to reach the speed, triangle otherwise.
+    const double time = s * a >= speed * speed ? s / speed + speed / a : 2. * std::sqrt(s / a);
+    return segments * time;
+}
+
+InvoiceEstimateFeatures InvoiceEstimator::features(const indexed_triangle_set &its, const Transform3d &trafo) const
+{
+    InvoiceEstimateFeatures out;
+    if (its.indices.empty())
+        return out;
+
+    std::vector<Vec3d> pts;
+    pts.reserve(its.vertices.size());
+    double zmin = std::numeric_limits<double>::max();
+    double zmax = std::numeric_limits<double>::lowest();
+    for (const stl_vertex &v : its.vertices) {
+        pts.emplace_back(trafo * v.cast<double>());
+        zmin = std::min(zmin, pts.back().z());
+        zmax = std::max(zmax, pts.back().z());
+    }
+
+    // Surface areas facing up, down and sideways, weighted by the projection onto the respective plane.
+    double volume = 0., area_up = 0., area_down = 0., area_side = 0.;
+    for (const stl_triangle_vertex_indices &face : its.indices) {
+        const Vec3d &p0 = pts[face(0)];
+        const Vec3d &p1 = pts[face(1)];
+        const Vec3d &p2 = pts[face(2)];
+        const Vec3d  n  = (p1 - p0).cross(p2 - p0);
+        volume += p0.dot(p1.cross(p2));
+        const double n_len = n.norm();
+        if (n_len == 0.)
+            continue;
+        const double area = 0.5 * n_len;
+        const double nz   = n.z() / n_len;
+        (nz > 0. ? area_up : area_down) += area * std::abs(nz);
+        area_side += area * std::sqrt(std::max(0., 1. - nz * nz));
+    }
+    // Mirroring instances flips the orientation of the faces.
+    volume = std::abs(volume) / 6.;
+    const double height = zmax - zmin;
+    if (volume <= 0. || height <= 0.)
+        return out;
+
+    out.volume_mm3        = volume;
+    out.layers            = std::ceil(height / m_layer_height);
+    out.perimeter_mm3     = std::min(volume, area_side * m_wall_loops * m_perimeter_width);
+    out.solid_infill_mm3  = std::min(volume - out.perimeter_mm3, (area_up * m_top_layers + area_down * m_bottom_layers) * m_layer_height);
+    out.sparse_infill_mm3 = (volume - out.perimeter_mm3 - out.solid_infill_mm3) * m_sparse_infill_density;
+
+    // Side of the square of the average cross section.
+    const double segment_length = std::sqrt(std::max(volume / height, 1.));
+    out.perimeter_time_s     = this->extrusion_time(out.perimeter_mm3, m_perimeter_width, m_perimeter_speed, segment_length);
+    out.solid_infill_time_s  = this->extrusion_time(out.solid_infill_mm3, m_solid_infill_width, m_solid_infill_speed, segment_length);
+    out.sparse_infill_time_s = this->extrusion_time(out.sparse_infill_mm3, m_sparse_infill_width, m_sparse_infill_speed, segment_length);
+    return out;
+}
+
+InvoiceEstimateFeatures InvoiceEstimator::features(const ModelObject &object, const ModelInstance &instance) const
+{
+    // Model parts of one object are sliced together, thus the layer count and the cross section are those of the union.
+    // Overlapping parts are rare enough to just add the parts up.
+    InvoiceEstimateFeatures out;
+    for (const ModelVolume *volume : object.volumes)
+        if (volume->is_model_part())
+            out += this->features(volume->mesh().its, instance.get_matrix() * volume->get_matrix());
+    return out;
+}
+
+InvoiceEstimateFeatures InvoiceEstimator::features(const ModelObject &object) const
+{
+    InvoiceEstimateFeatures out;
+    for (const ModelInstance *instance : object.instances)
+        out += this->features(object, *instance);
+    return out;
+}
+
+InvoiceEstimate InvoiceEstimator::estimate(const InvoiceEstimateFeatures &features) const
+{
+    InvoiceEstimate out;
+    if (features.volume_mm3 <= 0.)
+        return out;
+    const std::array<double, 3> &v = m_coefficients.volume;
+    const std::array<double, 5> &t = m_coefficients.time;
+    out.extruded_volume_mm3 = v[0] * features.perimeter_mm3 + v[1] * features.solid_infill_mm3 + v[2] * features.sparse_infill_mm3;
+    out.weight_g            = out.extruded_volume_mm3 * m_filament_density * 0.001;
+    out.print_time_s        = t[0] * features.perimeter_time_s + t[1] * features.solid_infill_time_s + t[2] * features.sparse_infill_time_s +
+                              t[3] * features.layers + t[4];
+    return out;
+}
+
+// Solve (A^T A + k D) x = A^T b + k D x0 with D the mean squared column of A. Each of the coefficients is pulled
+// towards its default as if the defaults were backed by k average samples.
+template<size_t N>
+static std::array<double, N> fit_ridge(const Eigen::MatrixXd &A, const Eigen::VectorXd &b, const std::array<double, N> &x0)
+{
+    static constexpr double k = 0.5;
+    Eigen::Matrix<double, N, 1> prior;
+    for (size_t i = 0; i < N; ++ i)
+        prior(i) = x0[i];
+    Eigen::Matrix<double, N, N> AtA = A.transpose() * A;
+    Eigen::Matrix<double, N, 1> D   = (AtA.diagonal() / double(A.rows())).cwiseMax(1e-9);
+    AtA.diagonal() += k * D;
+    Eigen::Matrix<double, N, 1> x = AtA.ldlt().solve(A.transpose() * b + k * D.cwiseProduct(prior));
+    std::array<double, N> out;
+    for (size_t i = 0; i < N; ++ i)
+        // A negative coefficient would be an artifact of correlated features.
+        out[i] = std::isfinite(x(i)) ? std::max(0., x(i)) : x0[i];
+    return out;
+}
+
+InvoiceEstimateCoefficients fit_invoice_estimate(const std::vector<InvoiceEstimateSample> &samples)
+{
+    InvoiceEstimateCoefficients out;
+    if (samples.empty())
+        return out;
+
+    const Eigen::Index n = Eigen::Index(samples.size());
+    Eigen::MatrixXd    A_volume(n, 3), A_time(n, 5);
+    Eigen::VectorXd    b_volume(n), b_time(n);
+    for (Eigen::Index i = 0; i < n; ++ i) {
+        const InvoiceEstimateSample   &sample = samples[i];
+        const InvoiceEstimateFeatures &f      = sample.features;
+        A_volume.row(i) << f.perimeter_mm3, f.solid_infill_mm3, f.sparse_infill_mm3;
+        b_volume(i) = sample.extruded_volume_mm3;
+        A_time.row(i) << f.perimeter_time_s, f.solid_infill_time_s, f.sparse_infill_time_s, f.layers, 1.;
+        b_time(i) = sample.print_time_s;
+    }
+    out.volume = fit_ridge(A_volume, b_volume, out.volume);
+    out.time   = fit_ridge(A_time, b_time, out.time);
+    return out;
+}
+
+static nlohmann::json features_to_json(const InvoiceEstimateFeatures &f)
+{
+    return {
+        { "volume_mm3",           f.volume_mm3 },
+        { "perimeter_mm3",        f.perimeter_mm3 },
+        { "solid_infill_mm3",     f.solid_infill_mm3 },
+        { "sparse_infill_mm3",    f.sparse_infill_mm3 },
+        { "perimeter_time_s",     f.perimeter_time_s },
+        { "solid_infill_time_s",  f.solid_infill_time_s },
+        { "sparse_infill_time_s", f.sparse_infill_time_s },
+        { "layers",               f.layers },
+    };
+}
+
+static InvoiceEstimateFeatures features_from_json(const nlohmann::json &j)
+{
+    InvoiceEstimateFeatures f;
+    f.volume_mm3           = j.value("volume_mm3", 0.);
+    f.perimeter_mm3        = j.value("perimeter_mm3", 0.);
+    f.solid_infill_mm3     = j.value("solid_infill_mm3", 0.);
+    f.sparse_infill_mm3    = j.value("sparse_infill_mm3", 0.);
+    f.perimeter_time_s     = j.value("perimeter_time_s", 0.);
+    f.solid_infill_time_s  = j.value("solid_infill_time_s", 0.);
+    f.sparse_infill_time_s = j.value("sparse_infill_time_s", 0.);
+    f.layers               = j.value("layers", 0.);
+    return f;
+}
+
+InvoiceEstimateCalibration load_invoice_estimate_calibration(const std::string &path)
+{
+    InvoiceEstimateCalibration calibration;
+    if (! boost::filesystem::exists(path))
+        return calibration;
+    try {
+        boost::nowide::ifstream ifs(path);
+        nlohmann::json j = nlohmann::json::parse(ifs);
+        if (auto it = j.find("volume"); it != j.end())
+            it->get_to(calibration.coefficients.volume);
+        if (auto it = j.find("time"); it != j.end())
+            it->get_to(calibration.coefficients.time);
+        if (auto it = j.find("samples"); it != j.end())
+            for (const nlohmann::json &s : *it)
+                calibration.samples.push_back({ features_from_json(s.at("features")), s.value("extruded_volume_mm3", 0.), s.value("print_time_s", 0.) });
+    } catch (const std::exception &err) {
+        throw Slic3r::RuntimeError("Failed to parse estimate calibration " + path + ": " + err.what());
+    }
+    return calibration;
+}
+
+void save_invoice_estimate_calibration(const std::string &path, const InvoiceEstimateCalibration &calibration)
+{
+    nlohmann::json j;
+    j["volume"]  = calibration.coefficients.volume;
+    j["time"]    = calibration.coefficients.time;
+    j["samples"] = nlohmann::json::array();
+    for (const InvoiceEstimateSample &s : calibration.samples)
+        j["samples"].push_back({ { "features", features_to_json(s.features) },
+                                 { "extruded_volume_mm3", s.extruded_volume_mm3 },
+                                 { "print_time_s", s.print_time_s } });
+    boost::nowide::ofstream ofs(path);
+    ofs << j.dump(1);
+    ofs.close();
+    if (ofs.fail())
+        throw Slic3r::RuntimeError("Failed to write estimate calibration " + path);
+    BOOST_LOG_TRIVIAL(info) << "Saved estimate calibration of " << calibration.samples.size() << " samples to " << path;
+}
+
+nlohmann::json invoice_estimate_to_json(const InvoiceEstimate &estimate)
+{
+    return {
+        { "extruded_volume_mm3", estimate.extruded_volume_mm3 },
+        { "weight_g",            estimate.weight_g },
+        { "print_time_hours",    estimate.print_time_s / 3600. },
+    };
+}
+
+} // namespace Slic3r
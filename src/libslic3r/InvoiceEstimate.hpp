@@ -0,0 +1,122 @@
+#ifndef slic3r_InvoiceEstimate_hpp_
+#define slic3r_InvoiceEstimate_hpp_
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Point.hpp"
+#include "InvoiceCost.hpp"
+
+struct indexed_triangle_set;
+
+namespace Slic3r {
+
+class DynamicPrintConfig;
+class ModelInstance;
+class ModelObject;
+
+// Volume and motion time of the extrusion roles of a model, derived from its mesh and the print config without slicing.
+// Features of several objects add up, except for the layer count of which the maximum is kept.
+struct InvoiceEstimateFeatures
+{
+    double volume_mm3           { 0. };
+    double perimeter_mm3        { 0. };
+    double solid_infill_mm3     { 0. };
+    double sparse_infill_mm3    { 0. };
+    // Time to extrude the above along straight segments at the configured speed and acceleration, seconds.
+    double perimeter_time_s     { 0. };
+    double solid_infill_time_s  { 0. };
+    double sparse_infill_time_s { 0. };
+    double layers               { 0. };
+
+    InvoiceEstimateFeatures& operator+=(const InvoiceEstimateFeatures &rhs);
+};
+
+// Linear model on top of the features:
+//     extruded volume = volume . [perimeter_mm3, solid_infill_mm3, sparse_infill_mm3]
+//     print time      = time . [perimeter_time_s, solid_infill_time_s, sparse_infill_time_s, layers, 1]
+// The defaults were picked to be in the ballpark of the G-code estimate, fit_invoice_estimate() refines them.
+struct InvoiceEstimateCoefficients
+{
+    std::array<double, 3> volume { 1., 1., 1. };
+    // Accounts for travels, retractions and layer changes per layer and for the start G-code.
+    std::array<double, 5> time   { 1.1, 1.1, 1.1, 2., 120. };
+};
+
+// Features of a sliced print together with the statistics of its exported G-code.
+struct InvoiceEstimateSample
+{
+    InvoiceEstimateFeatures features;
+    double                  extruded_volume_mm3 { 0. };
+    double                  print_time_s        { 0. };
+};
+
+struct InvoiceEstimateCalibration
+{
+    InvoiceEstimateCoefficients        coefficients;
+    std::vector<InvoiceEstimateSample> samples;
+};
+
+struct InvoiceEstimate
+{
+    double extruded_volume_mm3 { 0. };
+    double weight_g            { 0. };
+    double print_time_s        { 0. };
+};
+
+// Ballpark filament and time estimate of a model in a single pass over its triangles.
+// A cross section of the model is approximated by a square of the same area: walls cover the vertical surfaces,
+// top and bottom shells the horizontal surfaces, sparse infill the rest. Support, brim and per-object
+// config overrides are ignored, the coefficients of a calibration pick up their average contribution.
+class InvoiceEstimator
+{
+public:
+    explicit InvoiceEstimator(const DynamicPrintConfig &config, const InvoiceEstimateCoefficients &coefficients = {});
+
+    // Mesh transformed by trafo into the print coordinate system.
+    InvoiceEstimateFeatures features(const indexed_triangle_set &its, const Transform3d &trafo = Transform3d::Identity()) const;
+    // Model parts of an object placed by one of its instances.
+    InvoiceEstimateFeatures features(const ModelObject &object, const ModelInstance &instance) const;
+    // All instances of an object.
+    InvoiceEstimateFeatures features(const ModelObject &object) const;
+
+    InvoiceEstimate         estimate(const InvoiceEstimateFeatures &features) const;
+
+    const InvoiceEstimateCoefficients& coefficients() const { return m_coefficients; }
+
+private:
+    double extrusion_time(double volume_mm3, double line_width, double speed, double segment_length) const;
+
+    InvoiceEstimateCoefficients m_coefficients;
+    double m_layer_height;
+    double m_perimeter_width;
+    double m_solid_infill_width;
+    double m_sparse_infill_width;
+    double m_wall_loops;
+    double m_top_layers;
+    double m_bottom_layers;
+    double m_sparse_infill_density;
+    double m_perimeter_speed;
+    double m_solid_infill_speed;
+    double m_sparse_infill_speed;
+    double m_acceleration;
+    // g/cm3 of the first filament
+    double m_filament_density;
+};
+
+// Least squares fit of the coefficients to the samples, regularized towards the default coefficients,
+// so that coefficients not determined by the samples keep their defaults.
+InvoiceEstimateCoefficients fit_invoice_estimate(const std::vector<InvoiceEstimateSample> &samples);
+
+// A missing file is an empty calibration with the default coefficients.
+// Throws Slic3r::RuntimeError if the file cannot be read or parsed.
+InvoiceEstimateCalibration load_invoice_estimate_calibration(const std::string &path);
+// Throws Slic3r::RuntimeError on failure.
+void save_invoice_estimate_calibration(const std::string &path, const InvoiceEstimateCalibration &calibration);
+
+nlohmann::json invoice_estimate_to_json(const InvoiceEstimate &estimate);
+
+} // namespace Slic3r
+
+#endif // slic3r_InvoiceEstimate_hpp_
@@ -0,0 +1,172 @@
+#include "InvoiceJobStore.hpp"
+
+#include "Exception.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+
+// Don't bother compacting small stores.
+static constexpr size_t min_records_to_compact = 64;
+
+InvoiceJobStore::InvoiceJobStore(std::string path) : m_path(std::move(path))
+{
+    if (! boost::filesystem::exists(m_path))
+        return;
+
+    uint64_t line_start = 0;
+    bool     truncated  = false;
+    {
+        // Closed before compacting, the store cannot be replaced on Windows while it is open.
+        boost::nowide::ifstream ifs(m_path, std::ios::binary);
+        if (! ifs.good())
+            throw Slic3r::RuntimeError("Cannot open invoice job store " + m_path);
+
+        std::string line;
+        while (std::getline(ifs, line)) {
+            const uint64_t line_end = line_start + line.size() + 1;
+            if (ifs.eof()) {
+                // The last line was not terminated, the application likely crashed while appending it.
+                truncated = true;
+                break;
+            }
+            size_t tab = line.find('\t');
+            std::string name;
+            try {
+                if (tab != std::string::npos)
+                    name = nlohmann::json::parse(line.begin(), line.begin() + tab).get<std::string>();
+            } catch (const std::exception &) {
+                tab = std::string::npos;
+            }
+            if (tab == std::string::npos) {
+                BOOST_LOG_TRIVIAL(error) << "Invoice job store " << m_path << ": skipping invalid record at offset " << line_start;
+            } else {
+                ++ m_num_records;
+                std::string_view payload(line.data() + tab + 1, line.size() - tab - 1);
+                if (payload == "null")
+                    m_index.erase(name);
+                else
+                    m_index[name] = { line_start + tab + 1, uint32_t(payload.size()) };
+            }
+            line_start = line_end;
+        }
+    }
+    m_file_size = line_start;
+
+    if (truncated)
+        this->compact();
+    else
+        this->compact_if_needed();
+}
+
+std::vector<std::string> InvoiceJobStore::names() const
+{
+    std::vector<std::string> out;
+    out.reserve(m_index.size());
+    for (const auto &[name, record] : m_index)
+        out.emplace_back(name);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+std::optional<InvoiceJobProfile> InvoiceJobStore::load(const std::string &name) const
+{
+    auto it = m_index.find(name);
+    if (it == m_index.end())
+        return std::nullopt;
+
+    boost::nowide::ifstream ifs(m_path, std::ios::binary);
+    std::string payload(it->second.length, '\0');
+    if (! ifs.seekg(std::streamoff(it->second.offset)) || ! ifs.read(payload.data(), payload.size()))
+        throw Slic3r::RuntimeError("Cannot read job profile " + name + " from " + m_path);
+    try {
+        return invoice_job_profile_from_json(nlohmann::json::parse(payload));
+    } catch (const std::exception &err) {
+        throw Slic3r::RuntimeError("Failed to parse job profile " + name + " from " + m_path + ": " + err.what());
+    }
+}
+
+void InvoiceJobStore::save(const std::string &name, const InvoiceJobProfile &profile)
+{
+    this->append(name, invoice_job_profile_to_json(profile).dump());
+    this->compact_if_needed();
+}
+
+bool InvoiceJobStore::erase(const std::string &name)
+{
+    if (! this->has(name))
+        return false;
+    this->append(name, "null");
+    this->compact_if_needed();
+    return true;
+}
+
+void InvoiceJobStore::append(const std::string &name, const std::string &payload)
+{
+    if (m_file_size == 0) {
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(boost::filesystem::path(m_path).parent_path(), ec);
+    }
+    const std::string key = nlohmann::json(name).dump();
+    {
+        boost::nowide::ofstream ofs(m_path, std::ios::binary | std::ios::app);
+        ofs << key << '\t' << payload << '\n';
+        ofs.close();
+        if (ofs.fail())
+            throw Slic3r::RuntimeError("Failed to write invoice job store " + m_path);
+    }
+    if (payload == "null")
+        m_index.erase(name);
+    else
+        m_index[name] = { m_file_size + key.size() + 1, uint32_t(payload.size()) };
+    m_file_size += key.size() + payload.size() + 2;
+    ++ m_num_records;
+}
+
+void InvoiceJobStore::compact_if_needed()
+{
+    if (m_num_records >= min_records_to_compact && m_num_records > 2 * m_index.size())
+        this->compact();
+}
+
+void InvoiceJobStore::compact()
+{
+    // Read the live records in the order of the old file, so that the file is read sequentially.
+    std::vector<std::pair<std::string, Record>> records(m_index.begin(), m_index.end());
+    std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) { return a.second.offset < b.second.offset; });
+
+    const std::string tmp_path = m_path + ".tmp";
+    std::unordered_map<std::string, Record> index;
+    uint64_t file_size = 0;
+    {
+        boost::nowide::ifstream ifs(m_path, std::ios::binary);
+        boost::nowide::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        std::string payload;
+        for (const auto &[name, record] : records) {
+            payload.resize(record.length);
+            if (! ifs.seekg(std::streamoff(record.offset)) || ! ifs.read(payload.data(), payload.size()))
+                throw Slic3r::RuntimeError("Cannot read job profile " + name + " from " + m_path);
+            const std::string key = nlohmann::json(name).dump();
+            ofs << key << '\t' << payload << '\n';
+            index[name] = { file_size + key.size() + 1, record.length };
+            file_size += key.size() + payload.size() + 2;
+        }
+        ofs.close();
+        if (ofs.fail())
+            throw Slic3r::RuntimeError("Failed to write invoice job store " + tmp_path);
+    }
+    if (std::error_code ec = rename_file(tmp_path, m_path); ec)
+        throw Slic3r::RuntimeError("Failed to replace invoice job store " + m_path + ": " + ec.message());
+
+    BOOST_LOG_TRIVIAL(info) << "Invoice job store " << m_path << " compacted from " << m_num_records << " to " << index.size() << " records";
+    m_index       = std::move(index);
+    m_file_size   = file_size;
+    m_num_records = m_index.size();
+}
+
+} // namespace Slic3r
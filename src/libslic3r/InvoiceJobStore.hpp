@@ -0,0 +1,61 @@
+#ifndef slic3r_InvoiceJobStore_hpp_
+#define slic3r_InvoiceJobStore_hpp_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "InvoiceCost.hpp"
+
+namespace Slic3r {
+
+// Named invoice job profiles kept in an append-only file, one record per line:
+//     "<name as JSON string>"\t<profile as JSON object>
+//     "<name as JSON string>"\tnull                      (the profile was deleted)
+// Opening the store only parses the names and indexes the position of the latest record of every profile,
+// the profiles themselves are parsed on demand. Saving or deleting a profile appends a single line.
+// The file is rewritten when less than half of its records are live.
+class InvoiceJobStore
+{
+public:
+    // Reads the index of an existing store, a missing file is an empty store.
+    // Throws Slic3r::RuntimeError if the file exists but cannot be read.
+    explicit InvoiceJobStore(std::string path);
+
+    const std::string&               path() const { return m_path; }
+    size_t                           size() const { return m_index.size(); }
+    bool                             empty() const { return m_index.empty(); }
+    bool                             has(const std::string &name) const { return m_index.find(name) != m_index.end(); }
+    // Names of all profiles, sorted.
+    std::vector<std::string>         names() const;
+
+    // Returns nothing if there is no such profile. Throws Slic3r::RuntimeError on I/O or parsing failure.
+    std::optional<InvoiceJobProfile> load(const std::string &name) const;
+    // Add or replace a profile. Throws Slic3r::RuntimeError on I/O failure.
+    void                             save(const std::string &name, const InvoiceJobProfile &profile);
+    // Returns false if there was no such profile. Throws Slic3r::RuntimeError on I/O failure.
+    bool                             erase(const std::string &name);
+
+    // Rewrite the file with the live records only.
+    void                             compact();
+
+private:
+    struct Record {
+        uint64_t offset { 0 };  // of the profile JSON
+        uint32_t length { 0 };
+    };
+
+    void append(const std::string &name, const std::string &payload);
+    void compact_if_needed();
+
+    std::string                             m_path;
+    std::unordered_map<std::string, Record> m_index;
+    uint64_t                                m_file_size { 0 };
+    size_t                                  m_num_records { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_InvoiceJobStore_hpp_
@@ -0,0 +1,168 @@
+#include "InvoiceSweep.hpp"
+
+#include "Exception.hpp"
+#include "Model.hpp"
+#include "Print.hpp"
+#include "PrintConfig.hpp"
+#include "GCode/GCodeProcessor.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+namespace Slic3r {
+
+std::vector<InvoiceSweepAxis> parse_invoice_sweep(const std::string &spec)
+{
+    std::vector<InvoiceSweepAxis> axes;
+    std::vector<std::string>      items;
+    boost::split(items, spec, [](char c) { return c == ';'; });
+    for (std::string &item : items) {
+        boost::trim(item);
+        if (item.empty())
+            continue;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
+            throw Slic3r::RuntimeError("Invalid sweep \"" + item + "\", expected <option>=<value>,<value>...");
+        InvoiceSweepAxis axis;
+        axis.opt_key = boost::trim_copy(item.substr(0, eq));
+        boost::split(axis.values, item.substr(eq + 1), [](char c) { return c == ','; });
+        for (std::string &value : axis.values)
+            boost::trim(value);
+        axis.values.erase(std::remove(axis.values.begin(), axis.values.end(), std::string()), axis.values.end());
+        if (axis.values.empty())
+            throw Slic3r::RuntimeError("No values to sweep " + axis.opt_key + " over");
+        DynamicPrintConfig check;
+        for (const std::string &value : axis.values) {
+            try {
+                check.set_deserialize_strict(axis.opt_key, value);
+            } catch (const std::exception &err) {
+                throw Slic3r::RuntimeError("Invalid sweep value " + axis.opt_key + "=" + value + ": " + err.what());
+            }
+        }
+        axes.emplace_back(std::move(axis));
+    }
+    return axes;
+}
+
+// Options of the objects invalidate posSlice mostly, options of the regions the perimeters and the infill,
+// the rest only the G-code export.
+static int sweep_axis_rank(const std::string &opt_key)
+{
+    if (PrintObjectConfig::defaults().option(opt_key) != nullptr)
+        return 0;
+    if (PrintRegionConfig::defaults().option(opt_key) != nullptr)
+        return 1;
+    return 2;
+}
+
+static double print_time_hours(const Print &print, const GCodeProcessorResult &result)
+{
+    float time = result.print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].time;
+    return time > 0.f ? time / 3600. : invoice_time_to_hours(print.print_statistics().estimated_normal_print_time);
+}
+
+std::vector<InvoiceSweepResult> run_invoice_sweep(const Model                   &model,
+                                                  const DynamicPrintConfig      &config,
+                                                  const InvoiceJobProfile       &job,
+                                                  std::vector<InvoiceSweepAxis>  axes,
+                                                  const std::string             &output_dir,
+                                                  const std::string             &gcode_prefix,
+                                                  const InvoiceSweepPrintSetup  &setup,
+                                                  size_t                         max_concurrency)
+{
+    if (axes.empty())
+        return {};
+    std::stable_sort(axes.begin(), axes.end(), [](const InvoiceSweepAxis &a, const InvoiceSweepAxis &b) {
+        return sweep_axis_rank(a.opt_key) < sweep_axis_rank(b.opt_key);
+    });
+
+    // Cartesian product of the axes, the last axis varies fastest.
+    const size_t num_inner  = axes.back().values.size();
+    const size_t num_groups = std::accumulate(axes.begin(), axes.end() - 1, size_t(1),
+        [](size_t n, const InvoiceSweepAxis &axis) { return n * axis.values.size(); });
+    std::vector<InvoiceSweepResult> results(num_groups * num_inner);
+    for (size_t idx = 0; idx < results.size(); ++ idx) {
+        size_t rest = idx;
+        results[idx].overrides.resize(axes.size());
+        for (size_t i = axes.size(); i > 0; -- i) {
+            const InvoiceSweepAxis &axis = axes[i - 1];
+            results[idx].overrides[i - 1] = { axis.opt_key, axis.values[rest % axis.values.size()] };
+            rest /= axis.values.size();
+        }
+        results[idx].gcode_path = (boost::filesystem::path(output_dir) / (gcode_prefix + "_variant_" + std::to_string(idx + 1) + ".gcode")).string();
+    }
+    BOOST_LOG_TRIVIAL(info) << "run_invoice_sweep: " << results.size() << " variants in " << num_groups << " groups";
+
+    auto slice_group = [&](size_t group) {
+        Print print;
+        if (setup)
+            setup(print);
+        for (size_t idx = group * num_inner; idx < (group + 1) * num_inner; ++ idx) {
+            InvoiceSweepResult &result = results[idx];
+            try {
+                DynamicPrintConfig variant_config = config;
+                for (const auto &[opt_key, value] : result.overrides)
+                    variant_config.set_deserialize_strict(opt_key, value);
+                print.apply(model, variant_config);
+                if (StringObjectException err = print.validate(); ! err.string.empty())
+                    throw Slic3r::RuntimeError(err.string);
+
+                result.reused_slices     = ! print.objects().empty();
+                result.reused_perimeters = result.reused_slices;
+                for (const PrintObject *object : print.objects()) {
+                    result.reused_slices     &= object->is_step_done(posSlice);
+                    result.reused_perimeters &= object->is_step_done(posPerimeters);
+                }
+                print.process();
+                GCodeProcessorResult gcode_result;
+                result.gcode_path = print.export_gcode(result.gcode_path, &gcode_result, nullptr);
+                result.quote = calculate_invoice_quote(job, print_time_hours(print, gcode_result),
+                                                       invoice_filament_usage(print.print_statistics(), print.full_print_config()));
+            } catch (const std::exception &err) {
+                result.error = err.what();
+                BOOST_LOG_TRIVIAL(error) << "run_invoice_sweep: variant " << idx + 1 << " failed: " << result.error;
+            }
+        }
+    };
+
+    tbb::task_arena arena { max_concurrency == 0 ? tbb::task_arena::automatic : int(max_concurrency) };
+    arena.execute([&]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_groups, 1), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t group = range.begin(); group < range.end(); ++ group)
+                slice_group(group);
+        });
+    });
+    return results;
+}
+
+nlohmann::json invoice_sweep_to_json(const std::vector<InvoiceSweepResult> &results)
+{
+    nlohmann::json out = nlohmann::json::array();
+    for (const InvoiceSweepResult &result : results) {
+        nlohmann::json j;
+        nlohmann::json &overrides = j["overrides"] = nlohmann::json::object();
+        for (const auto &[opt_key, value] : result.overrides)
+            overrides[opt_key] = value;
+        if (! result.error.empty()) {
+            j["error"] = result.error;
+        } else {
+            j["gcode"]             = result.gcode_path;
+            j["reused_slices"]     = result.reused_slices;
+            j["reused_perimeters"] = result.reused_perimeters;
+            j["quote"]             = invoice_quote_to_json(result.quote);
+        }
+        out.emplace_back(std::move(j));
+    }
+    return out;
+}
+
+} // namespace Slic3r
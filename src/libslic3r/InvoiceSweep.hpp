@@ -0,0 +1,67 @@
+#ifndef slic3r_InvoiceSweep_hpp_
+#define slic3r_InvoiceSweep_hpp_
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "InvoiceCost.hpp"
+
+namespace Slic3r {
+
+class DynamicPrintConfig;
+class Model;
+class Print;
+
+// One dimension of a what-if sweep: a print config option and the values to price it at.
+struct InvoiceSweepAxis
+{
+    std::string              opt_key;
+    std::vector<std::string> values;
+};
+
+// Price of the plate sliced with one combination of the sweep axes.
+struct InvoiceSweepResult
+{
+    // (opt_key, value) for every axis of the sweep.
+    std::vector<std::pair<std::string, std::string>> overrides;
+    std::string  gcode_path;
+    InvoiceQuote quote;
+    // Slices / perimeters of all objects were kept from the previous variant sliced by the same Print.
+    bool         reused_slices     { false };
+    bool         reused_perimeters { false };
+    // Non-empty if the variant failed to validate or to slice, the quote is empty then.
+    std::string  error;
+};
+
+// Parse "sparse_infill_density=15%,30%,50%;layer_height=0.2,0.28". Values must not contain ',' or ';'.
+// Throws Slic3r::RuntimeError on unknown options or values the option does not accept.
+std::vector<InvoiceSweepAxis> parse_invoice_sweep(const std::string &spec);
+
+// Called on every Print created by the sweep before its first variant is applied, to set what Print::apply()
+// does not carry over from the model and the config (plate origin, BBL printer flag, ...).
+using InvoiceSweepPrintSetup = std::function<void(Print&)>;
+
+// Slice, export and price the model for every combination of the axes.
+// Print::apply() only invalidates the steps depending on the changed options, thus the variants are grouped
+// by the values of all axes but the one cheapest to change, which is the last axis after sorting by
+// PrintObjectConfig < PrintRegionConfig < other options. The variants of a group are sliced one after another
+// by a single Print, so that for example infill variants keep the slices and perimeters of the first one.
+// Groups are sliced concurrently, at most max_concurrency at a time (0 for no limit).
+// G-codes are exported into output_dir as <gcode_prefix>_variant_<n>.gcode, n being the 1 based index
+// of the variant in the order of the returned results, which is the order of the cartesian product of the sorted axes.
+std::vector<InvoiceSweepResult> run_invoice_sweep(const Model                   &model,
+                                                  const DynamicPrintConfig      &config,
+                                                  const InvoiceJobProfile       &job,
+                                                  std::vector<InvoiceSweepAxis>  axes,
+                                                  const std::string             &output_dir,
+                                                  const std::string             &gcode_prefix,
+                                                  const InvoiceSweepPrintSetup  &setup           = {},
+                                                  size_t                         max_concurrency = 0);
+
+nlohmann::json invoice_sweep_to_json(const std::vector<InvoiceSweepResult> &results);
+
+} // namespace Slic3r
+
+#endif // slic3r_InvoiceSweep_hpp_
@@ -0,0 +1,559 @@
+#include "LayerCache.hpp"
+
+#include "Exception.hpp"
+#include "ExtrusionEntityCollection.hpp"
+#include "Layer.hpp"
+#include "Print.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace Slic3r {
+
+static constexpr char     layer_cache_magic[8]   = { 'O', 'R', 'C', 'A', 'L', 'C', 'H', '\0' };
+static constexpr uint32_t layer_cache_byte_order = 0x01020304;
+
+static_assert(sizeof(Point) == 2 * sizeof(coord_t), "Points are written as arrays of coordinate pairs");
+
+enum class LayerCacheEntityType : uint8_t {
+    Path,
+    MultiPath,
+    Loop,
+    Collection,
+    PathOriented,
+};
+
+namespace {
+
+class Encoder
+{
+public:
+    explicit Encoder(std::string &out) : m_out(out) {}
+
+    template<typename T> void put(T value)
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        m_out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void put_size(size_t n) { this->put(uint64_t(n)); }
+
+    void put(const Point &pt) { this->put(pt.x()); this->put(pt.y()); }
+    void put(const Points &pts)
+    {
+        this->put_size(pts.size());
+        m_out.append(reinterpret_cast<const char*>(pts.data()), pts.size() * sizeof(Point));
+    }
+    void put(const BoundingBox &bbox)
+    {
+        this->put(bbox.min);
+        this->put(bbox.max);
+        this->put(uint8_t(bbox.defined));
+    }
+    void put(const ExPolygon &expoly)
+    {
+        this->put(expoly.contour.points);
+        this->put_size(expoly.holes.size());
+        for (const Polygon &hole : expoly.holes)
+            this->put(hole.points);
+    }
+    void put(const ExPolygons &expolys)
+    {
+        this->put_size(expolys.size());
+        for (const ExPolygon &expoly : expolys)
+            this->put(expoly);
+    }
+    void put(const Surfaces &surfaces)
+    {
+        this->put_size(surfaces.size());
+        for (const Surface &surface : surfaces) {
+            this->put(surface.expolygon);
+            this->put(uint8_t(surface.surface_type));
+            this->put(surface.thickness);
+            this->put(surface.thickness_layers);
+            this->put(surface.bridge_angle);
+            this->put(surface.extra_perimeters);
+        }
+    }
+    void put(const Polyline &polyline)
+    {
+        this->put(polyline.points);
+        this->put_size(polyline.fitting_result.size());
+        for (const PathFittingData &fitting : polyline.fitting_result) {
+            this->put_size(fitting.start_point_index);
+            this->put_size(fitting.end_point_index);
+            this->put(fitting.path_type);
+            const ArcSegment &arc = fitting.arc_data;
+            this->put(uint8_t(arc.is_arc));
+            if (arc.is_arc) {
+                this->put(arc.length);
+                this->put(arc.angle_radians);
+                this->put(arc.polar_start_theta);
+                this->put(arc.polar_end_theta);
+                this->put(arc.start_point);
+                this->put(arc.end_point);
+                this->put(arc.direction);
+                this->put(arc.radius);
+                this->put(arc.center);
+            }
+        }
+    }
+    void put(const Polylines &polylines)
+    {
+        this->put_size(polylines.size());
+        for (const Polyline &polyline : polylines)
+            this->put(polyline);
+    }
+    void put(const ExtrusionPath &path)
+    {
+        this->put(path.polyline);
+        this->put(path.mm3_per_mm);
+        this->put(path.width);
+        this->put(path.height);
+        this->put(path.role());
+        this->put(uint8_t(path.is_force_no_extrusion()));
+        // The flag set by set_reverse(), not the one of the subtype, which is tagged by the caller.
+        this->put(uint8_t(path.ExtrusionPath::can_reverse()));
+    }
+    void put(const ExtrusionPaths &paths)
+    {
+        this->put_size(paths.size());
+        for (const ExtrusionPath &path : paths)
+            this->put(path);
+    }
+    // Entities of a collection, the collection itself is not tagged.
+    void put(const ExtrusionEntityCollection &collection)
+    {
+        this->put(uint8_t(collection.no_sort));
+        this->put_size(collection.entities.size());
+        for (const ExtrusionEntity *entity : collection.entities)
+            this->put(*entity);
+    }
+    void put(const ExtrusionEntity &entity)
+    {
+        if (auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+            this->put(LayerCacheEntityType::Collection);
+            this->put(*collection);
+        } else if (auto *path = dynamic_cast<const ExtrusionPath*>(&entity)) {
+            this->put(dynamic_cast<const ExtrusionPathOriented*>(path) ? LayerCacheEntityType::PathOriented : LayerCacheEntityType::Path);
+            this->put(*path);
+        } else if (auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(&entity)) {
+            this->put(LayerCacheEntityType::MultiPath);
+            this->put(uint8_t(multipath->can_reverse()));
+            this->put(multipath->paths);
+        } else if (auto *loop = dynamic_cast<const ExtrusionLoop*>(&entity)) {
+            this->put(LayerCacheEntityType::Loop);
+            this->put(loop->loop_role());
+            this->put(loop->paths);
+        } else
+            throw Slic3r::FileIOError("Unknown extrusion entity type");
+    }
+
+private:
+    std::string &m_out;
+};
+
+class Decoder
+{
+public:
+    explicit Decoder(std::string_view data) : m_ptr(data.data()), m_end(data.data() + data.size()) {}
+
+    bool at_end() const { return m_ptr == m_end; }
+
+    template<typename T> T get()
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        T value;
+        std::memcpy(&value, this->take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    // Number of elements of an array of elements at least element_size bytes each.
+    size_t get_size(size_t element_size)
+    {
+        uint64_t n = this->get<uint64_t>();
+        if (n > uint64_t(m_end - m_ptr) / std::max<size_t>(element_size, 1))
+            throw Slic3r::FileIOError("Corrupted layer cache record");
+        return size_t(n);
+    }
+
+    void get(Point &pt)
+    {
+        pt.x() = this->get<coord_t>();
+        pt.y() = this->get<coord_t>();
+    }
+    void get(Points &pts)
+    {
+        pts.resize(this->get_size(sizeof(Point)));
+        std::memcpy(reinterpret_cast<char*>(pts.data()), this->take(pts.size() * sizeof(Point)), pts.size() * sizeof(Point));
+    }
+    void get(BoundingBox &bbox)
+    {
+        this->get(bbox.min);
+        this->get(bbox.max);
+        bbox.defined = this->get<uint8_t>() != 0;
+    }
+    void get(ExPolygon &expoly)
+    {
+        this->get(expoly.contour.points);
+        expoly.holes.resize(this->get_size(sizeof(uint64_t)));
+        for (Polygon &hole : expoly.holes)
+            this->get(hole.points);
+    }
+    void get(ExPolygons &expolys)
+    {
+        expolys.resize(this->get_size(2 * sizeof(uint64_t)));
+        for (ExPolygon &expoly : expolys)
+            this->get(expoly);
+    }
+    void get(Surfaces &surfaces)
+    {
+        surfaces.resize(this->get_size(2 * sizeof(uint64_t)));
+        for (Surface &surface : surfaces) {
+            this->get(surface.expolygon);
+            surface.surface_type     = SurfaceType(this->get<uint8_t>());
+            surface.thickness        = this->get<double>();
+            surface.thickness_layers = this->get<unsigned short>();
+            surface.bridge_angle     = this->get<double>();
+            surface.extra_perimeters = this->get<unsigned short>();
+        }
+    }
+    void get(Polyline &polyline)
+    {
+        this->get(polyline.points);
+        polyline.fitting_result.resize(this->get_size(2 * sizeof(uint64_t)));
+        for (PathFittingData &fitting : polyline.fitting_result) {
+            fitting.start_point_index = size_t(this->get<uint64_t>());
+            fitting.end_point_index   = size_t(this->get<uint64_t>());
+            fitting.path_type         = this->get<EMovePathType>();
+            ArcSegment &arc = fitting.arc_data;
+            arc.is_arc = this->get<uint8_t>() != 0;
+            if (arc.is_arc) {
+                arc.length            = this->get<double>();
+                arc.angle_radians     = this->get<double>();
+                arc.polar_start_theta = this->get<double>();
+                arc.polar_end_theta   = this->get<double>();
+                this->get(arc.start_point);
+                this->get(arc.end_point);
+                arc.direction         = this->get<ArcDirection>();
+                arc.radius            = this->get<double>();
+                this->get(arc.center);
+            }
+        }
+    }
+    void get(Polylines &polylines)
+    {
+        polylines.resize(this->get_size(2 * sizeof(uint64_t)));
+        for (Polyline &polyline : polylines)
+            this->get(polyline);
+    }
+    void get(ExtrusionPath &path)
+    {
+        this->get(path.polyline);
+        path.mm3_per_mm = this->get<double>();
+        path.width      = this->get<float>();
+        path.height     = this->get<float>();
+        path.set_extrusion_role(this->get<ExtrusionRole>());
+        path.set_force_no_extrusion(this->get<uint8_t>() != 0);
+        if (this->get<uint8_t>() == 0)
+            path.ExtrusionPath::set_reverse();
+    }
+    void get(ExtrusionPaths &paths)
+    {
+        paths.resize(this->get_size(2 * sizeof(uint64_t)));
+        for (ExtrusionPath &path : paths)
+            this->get(path);
+    }
+    // Appends the entities to the collection.
+    void get(ExtrusionEntityCollection &collection)
+    {
+        collection.no_sort = this->get<uint8_t>() != 0;
+        size_t num_entities = this->get_size(1);
+        collection.entities.reserve(collection.entities.size() + num_entities);
+        for (size_t i = 0; i < num_entities; ++ i)
+            collection.entities.push_back(this->get_entity());
+    }
+    ExtrusionEntity* get_entity()
+    {
+        switch (this->get<LayerCacheEntityType>()) {
+        case LayerCacheEntityType::Path: {
+            auto path = std::make_unique<ExtrusionPath>();
+            this->get(*path);
+            return path.release();
+        }
+        case LayerCacheEntityType::PathOriented: {
+            auto path = std::make_unique<ExtrusionPathOriented>(erNone, -1., -1.f, -1.f);
+            this->get(*path);
+            return path.release();
+        }
+        case LayerCacheEntityType::MultiPath: {
+            auto multipath = std::make_unique<ExtrusionMultiPath>();
+            if (this->get<uint8_t>() == 0)
+                multipath->set_reverse();
+            this->get(multipath->paths);
+            return multipath.release();
+        }
+        case LayerCacheEntityType::Loop: {
+            auto loop = std::make_unique<ExtrusionLoop>();
+            loop->set_loop_role(this->get<ExtrusionLoopRole>());
+            this->get(loop->paths);
+            return loop.release();
+        }
+        case LayerCacheEntityType::Collection: {
+            auto collection = std::make_unique<ExtrusionEntityCollection>();
+            this->get(*collection);
+            return collection.release();
+        }
+        }
+        throw Slic3r::FileIOError("Unknown extrusion entity type in layer cache record");
+    }
+
+private:
+    const char* take(size_t n)
+    {
+        if (n > size_t(m_end - m_ptr))
+            throw Slic3r::FileIOError("Truncated layer cache record");
+        const char *ptr = m_ptr;
+        m_ptr += n;
+        return ptr;
+    }
+
+    const char *m_ptr;
+    const char *m_end;
+};
+
+} // namespace
+
+static void encode_layer_info(Encoder &enc, const Layer &layer, size_t interface_id)
+{
+    enc.put(int64_t(layer.id()));
+    enc.put_size(interface_id);
+    enc.put(double(layer.height));
+    enc.put(double(layer.print_z));
+    enc.put(double(layer.slice_z));
+    enc.put_size(layer.region_count());
+    for (size_t i = 0; i < layer.region_count(); ++ i)
+        enc.put_size(layer.get_region(int(i))->region().config_hash());
+}
+
+static LayerCacheLayerInfo decode_layer_info(Decoder &dec)
+{
+    LayerCacheLayerInfo info;
+    info.id           = int(dec.get<int64_t>());
+    info.interface_id = size_t(dec.get<uint64_t>());
+    info.height       = dec.get<double>();
+    info.print_z      = dec.get<double>();
+    info.slice_z      = dec.get<double>();
+    info.region_config_hashes.resize(dec.get_size(sizeof(uint64_t)));
+    for (size_t &hash : info.region_config_hashes)
+        hash = size_t(dec.get<uint64_t>());
+    return info;
+}
+
+static void encode_layer_data(Encoder &enc, const Layer &layer)
+{
+    enc.put(layer.lslices);
+    enc.put_size(layer.lslices_bboxes.size());
+    for (const BoundingBox &bbox : layer.lslices_bboxes)
+        enc.put(bbox);
+    enc.put(layer.loverhangs);
+    enc.put(layer.loverhangs_bbox);
+    for (size_t i = 0; i < layer.region_count(); ++ i) {
+        const LayerRegion &layerm = *layer.get_region(int(i));
+        enc.put(layerm.slices.surfaces);
+        enc.put(layerm.raw_slices);
+        enc.put(layerm.thin_fills);
+        enc.put(layerm.fill_expolygons);
+        enc.put(layerm.fill_surfaces.surfaces);
+        enc.put(layerm.fill_no_overlap_expolygons);
+        enc.put(layerm.unsupported_bridge_edges);
+        enc.put(layerm.perimeters);
+        enc.put(layerm.fills);
+    }
+}
+
+static void decode_layer_data(Decoder &dec, Layer &layer)
+{
+    dec.get(layer.lslices);
+    layer.lslices_bboxes.resize(dec.get_size(2 * sizeof(Point) + 1));
+    for (BoundingBox &bbox : layer.lslices_bboxes)
+        dec.get(bbox);
+    dec.get(layer.loverhangs);
+    dec.get(layer.loverhangs_bbox);
+    for (size_t i = 0; i < layer.region_count(); ++ i) {
+        LayerRegion &layerm = *layer.get_region(int(i));
+        dec.get(layerm.slices.surfaces);
+        dec.get(layerm.raw_slices);
+        dec.get(layerm.thin_fills);
+        dec.get(layerm.fill_expolygons);
+        dec.get(layerm.fill_surfaces.surfaces);
+        dec.get(layerm.fill_no_overlap_expolygons);
+        dec.get(layerm.unsupported_bridge_edges);
+        dec.get(layerm.perimeters);
+        dec.get(layerm.fills);
+    }
+}
+
+std::string encode_cached_layer(const Layer &layer)
+{
+    std::string out;
+    Encoder     enc(out);
+    encode_layer_info(enc, layer, 0);
+    encode_layer_data(enc, layer);
+    return out;
+}
+
+std::string encode_cached_support_layer(const SupportLayer &support_layer)
+{
+    std::string out;
+    Encoder     enc(out);
+    encode_layer_info(enc, support_layer, support_layer.interface_id());
+    encode_layer_data(enc, support_layer);
+    enc.put(uint8_t(support_layer.support_type));
+    enc.put(support_layer.support_islands);
+    enc.put(support_layer.support_fills);
+    return out;
+}
+
+std::string encode_cached_first_layer_groups(const std::vector<groupedVolumeSlices> &groups)
+{
+    std::string out;
+    Encoder     enc(out);
+    enc.put_size(groups.size());
+    for (const groupedVolumeSlices &group : groups) {
+        enc.put(int64_t(group.groupId));
+        enc.put_size(group.volume_ids.size());
+        for (const ObjectID &volume_id : group.volume_ids)
+            enc.put_size(volume_id.id);
+        enc.put(group.slices);
+    }
+    return out;
+}
+
+std::string encode_cached_extrusions(const ExtrusionEntityCollection &extrusions)
+{
+    std::string out;
+    Encoder     enc(out);
+    enc.put(extrusions);
+    return out;
+}
+
+LayerCacheLayerInfo decode_cached_layer_info(std::string_view record)
+{
+    Decoder dec(record);
+    return decode_layer_info(dec);
+}
+
+void decode_cached_layer(std::string_view record, Layer &layer)
+{
+    Decoder dec(record);
+    LayerCacheLayerInfo info = decode_layer_info(dec);
+    if (info.region_config_hashes.size() != layer.region_count())
+        throw Slic3r::FileIOError("Layer cache record of layer " + std::to_string(info.id) + " does not match the layer regions");
+    decode_layer_data(dec, layer);
+    if (! dec.at_end())
+        throw Slic3r::FileIOError("Layer cache record of layer " + std::to_string(info.id) + " has trailing data");
+}
+
+void decode_cached_support_layer(std::string_view record, SupportLayer &support_layer)
+{
+    Decoder dec(record);
+    LayerCacheLayerInfo info = decode_layer_info(dec);
+    if (info.region_config_hashes.size() != support_layer.region_count())
+        throw Slic3r::FileIOError("Layer cache record of support layer " + std::to_string(info.id) + " does not match the layer regions");
+    decode_layer_data(dec, support_layer);
+    support_layer.support_type = SupportInnerType(dec.get<uint8_t>());
+    dec.get(support_layer.support_islands);
+    dec.get(support_layer.support_fills);
+    if (! dec.at_end())
+        throw Slic3r::FileIOError("Layer cache record of support layer " + std::to_string(info.id) + " has trailing data");
+}
+
+std::vector<groupedVolumeSlices> decode_cached_first_layer_groups(std::string_view record)
+{
+    Decoder dec(record);
+    std::vector<groupedVolumeSlices> groups(dec.get_size(3 * sizeof(uint64_t)));
+    for (groupedVolumeSlices &group : groups) {
+        group.groupId = int(dec.get<int64_t>());
+        group.volume_ids.resize(dec.get_size(sizeof(uint64_t)));
+        for (ObjectID &volume_id : group.volume_ids)
+            volume_id.id = size_t(dec.get<uint64_t>());
+        dec.get(group.slices);
+    }
+    return groups;
+}
+
+LayerCacheWriter::LayerCacheWriter(const std::string &path, uint64_t identify_id) : m_path(path), m_header{}, m_offset(sizeof(LayerCacheHeader))
+{
+    std::memcpy(m_header.magic, layer_cache_magic, sizeof(m_header.magic));
+    m_header.version     = LAYER_CACHE_VERSION;
+    m_header.byte_order  = layer_cache_byte_order;
+    m_header.coord_size  = uint32_t(sizeof(coord_t));
+    m_header.identify_id = identify_id;
+    m_ofs.open(path, std::ios::binary | std::ios::trunc);
+    // The header is written again by finish() once the table offset is known.
+    if (! m_ofs.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header)))
+        throw Slic3r::FileIOError("Failed to write layer cache " + m_path);
+}
+
+void LayerCacheWriter::append(LayerCacheRecordType type, std::string_view record)
+{
+    if (! m_ofs.write(record.data(), std::streamsize(record.size())))
+        throw Slic3r::FileIOError("Failed to write layer cache " + m_path);
+    m_crc.process_bytes(record.data(), record.size());
+    m_table.push_back({ type, 0, m_offset, record.size() });
+    m_offset += record.size();
+}
+
+void LayerCacheWriter::finish()
+{
+    m_header.num_records  = m_table.size();
+    m_header.table_offset = m_offset;
+    m_crc.process_bytes(m_table.data(), m_table.size() * sizeof(LayerCacheTableEntry));
+    m_header.checksum     = m_crc.checksum();
+    m_ofs.write(reinterpret_cast<const char*>(m_table.data()), std::streamsize(m_table.size() * sizeof(LayerCacheTableEntry)));
+    m_ofs.seekp(0);
+    m_ofs.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_ofs.close();
+    if (m_ofs.fail())
+        throw Slic3r::FileIOError("Failed to write layer cache " + m_path);
+}
+
+LayerCacheReader::LayerCacheReader(const std::string &path) : m_path(path)
+{
+    try {
+        m_file.open(path);
+    } catch (const std::exception &err) {
+        throw Slic3r::FileIOError("Cannot map layer cache " + path + ": " + err.what());
+    }
+    if (m_file.size() < sizeof(LayerCacheHeader))
+        throw Slic3r::FileIOError("Layer cache " + path + " is truncated");
+    std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+    if (std::memcmp(m_header.magic, layer_cache_magic, sizeof(m_header.magic)) != 0)
+        throw Slic3r::FileIOError(path + " is not a layer cache");
+    if (m_header.version != LAYER_CACHE_VERSION || m_header.byte_order != layer_cache_byte_order || m_header.coord_size != sizeof(coord_t))
+        throw Slic3r::FileIOError("Layer cache " + path + " was written by an incompatible version, version " + std::to_string(m_header.version));
+    if (m_header.table_offset < sizeof(LayerCacheHeader) || m_header.table_offset > m_file.size() ||
+        m_header.num_records != (m_file.size() - m_header.table_offset) / sizeof(LayerCacheTableEntry))
+        throw Slic3r::FileIOError("Layer cache " + path + " is truncated");
+    boost::crc_32_type crc;
+    crc.process_bytes(m_file.data() + sizeof(LayerCacheHeader), m_file.size() - sizeof(LayerCacheHeader));
+    if (crc.checksum() != m_header.checksum)
+        throw Slic3r::FileIOError("Layer cache " + path + " is corrupted");
+    m_table.resize(m_header.num_records);
+    std::memcpy(reinterpret_cast<char*>(m_table.data()), m_file.data() + m_header.table_offset, m_table.size() * sizeof(LayerCacheTableEntry));
+    for (const LayerCacheTableEntry &entry : m_table)
+        if (entry.offset < sizeof(LayerCacheHeader) || entry.offset > m_header.table_offset || entry.size > m_header.table_offset - entry.offset)
+            throw Slic3r::FileIOError("Layer cache " + path + " is corrupted");
+}
+
+std::vector<std::string_view> LayerCacheReader::records(LayerCacheRecordType type) const
+{
+    std::vector<std::string_view> out;
+    for (const LayerCacheTableEntry &entry : m_table)
+        if (entry.type == type)
+            out.emplace_back(m_file.data() + entry.offset, size_t(entry.size));
+    return out;
+}
+
+} // namespace Slic3r
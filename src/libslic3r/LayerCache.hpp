@@ -0,0 +1,127 @@
+#ifndef slic3r_LayerCache_hpp_
+#define slic3r_LayerCache_hpp_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/crc.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+
+class ExtrusionEntityCollection;
+class Layer;
+class SupportLayer;
+struct groupedVolumeSlices;
+
+// Binary cache of the layers of a PrintObject, written by Print::export_cached_data() and read back by
+// Print::load_cached_data(). The file is a sequence of records followed by a table of contents:
+//     LayerCacheHeader
+//     record, record, ...
+//     LayerCacheTableEntry[header.num_records]   at header.table_offset
+// Records are written as they are encoded, thus a writer keeps only a batch of layers in memory,
+// and a reader maps the file and decodes the records in parallel straight from the mapping.
+// Numbers are stored in the byte order of the writer, a reader refuses files of a different byte order
+// or coord_t size. The header holds a CRC-32 of everything following it, a reader refuses files
+// truncated or corrupted after they were written.
+static constexpr uint32_t LAYER_CACHE_VERSION = 3;
+
+enum class LayerCacheRecordType : uint32_t {
+    ObjectName,
+    Layer,
+    SupportLayer,
+    FirstLayerGroups,
+    // FillAdaptive::encode_octree(), stored in a file of its own by Print::adaptive_fill_octree().
+    AdaptiveOctree,
+};
+
+struct LayerCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t coord_size;
+    uint32_t checksum;
+    uint64_t identify_id;
+    uint64_t num_records;
+    uint64_t table_offset;
+};
+
+struct LayerCacheTableEntry
+{
+    LayerCacheRecordType type;
+    uint32_t             reserved;
+    uint64_t             offset;
+    uint64_t             size;
+};
+
+// Everything needed to create a layer and its regions before its record is decoded.
+struct LayerCacheLayerInfo
+{
+    int                   id           { 0 };
+    size_t                interface_id { 0 };
+    double                height       { 0. };
+    double                print_z      { 0. };
+    double                slice_z      { 0. };
+    // PrintRegion::config_hash() of the layer regions.
+    std::vector<size_t>   region_config_hashes;
+};
+
+// Encoding of the records. Encoding is thread safe for different layers.
+std::string encode_cached_layer(const Layer &layer);
+std::string encode_cached_support_layer(const SupportLayer &support_layer);
+// The volume_ids of the groups are expected to be indices into ModelObject::volumes.
+std::string encode_cached_first_layer_groups(const std::vector<groupedVolumeSlices> &groups);
+// Extrusions not owned by a layer, such as the skirt and the brim. Used to detect changes only, there is no decoding counterpart.
+std::string encode_cached_extrusions(const ExtrusionEntityCollection &extrusions);
+
+// Decoding of the records, throws Slic3r::FileIOError on malformed records.
+LayerCacheLayerInfo decode_cached_layer_info(std::string_view record);
+// The layer has to be created from decode_cached_layer_info() with its regions added in the same order.
+void decode_cached_layer(std::string_view record, Layer &layer);
+void decode_cached_support_layer(std::string_view record, SupportLayer &support_layer);
+std::vector<groupedVolumeSlices> decode_cached_first_layer_groups(std::string_view record);
+
+// Throws Slic3r::FileIOError on failure.
+class LayerCacheWriter
+{
+public:
+    LayerCacheWriter(const std::string &path, uint64_t identify_id);
+
+    void append(LayerCacheRecordType type, std::string_view record);
+    // Writes the table of contents and closes the file.
+    void finish();
+
+private:
+    std::string                       m_path;
+    boost::nowide::ofstream           m_ofs;
+    LayerCacheHeader                  m_header;
+    std::vector<LayerCacheTableEntry> m_table;
+    uint64_t                          m_offset;
+    boost::crc_32_type                m_crc;
+};
+
+// Maps a file written by LayerCacheWriter. Throws Slic3r::FileIOError if the file cannot be mapped,
+// was written by an incompatible version, is truncated or does not match its checksum.
+class LayerCacheReader
+{
+public:
+    explicit LayerCacheReader(const std::string &path);
+
+    uint64_t identify_id() const { return m_header.identify_id; }
+    // Records of the given type in the order they were appended. The views are valid for the lifetime of the reader.
+    std::vector<std::string_view> records(LayerCacheRecordType type) const;
+
+private:
+    std::string                          m_path;
+    boost::iostreams::mapped_file_source m_file;
+    LayerCacheHeader                     m_header;
+    std::vector<LayerCacheTableEntry>    m_table;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_LayerCache_hpp_
@@ -12,12 +12,15 @@
 #include "Thread.hpp"
 #include "Time.hpp"
 #include "GCode.hpp"
+#include "GCode/BinaryGCode.hpp"
 #include "GCode/WipeTower.hpp"
 #include "GCode/WipeTower2.hpp"
 #include "Utils.hpp"
 #include "PrintConfig.hpp"
 #include "MaterialType.hpp"
 #include "Model.hpp"
+#include "LayerCache.hpp"
+#include "libslic3r_version.h"
 #include "format.hpp"
 #include <float.h>
 
@@ -32,6 +35,8 @@
 
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 
 //BBS: add json support
 #include "nlohmann/json.hpp"
@@ -76,6 +81,12 @@ void Print::clear()
     m_print_regions.clear();
     m_model.clear_objects();
     m_statistics_by_extruder_count.clear();
+    if (m_gcode_export_cache)
+        m_gcode_export_cache->clear();
+    {
+        std::scoped_lock<std::mutex> octrees_lock(m_shared_adaptive_fill_octrees_mutex);
+        m_shared_adaptive_fill_octrees.clear();
+    }
 }
 
 bool Print::has_tpu_filament() const
@@ -89,13 +100,10 @@ bool Print::has_tpu_filament() const
     return false;
 }
 
-// Called by Print::apply().
-// This method only accepts PrintConfig option keys.
-bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+// Steps of the Print and of its objects depending on a PrintConfig option.
+// Returns false if the dependencies of the option are not known, all steps depend on it then.
+static bool print_config_option_steps(const t_config_option_key &opt_key, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps)
 {
-    if (opt_keys.empty())
-        return false;
-
     // Cache the plenty of parameters, which influence the G-code generator only,
     // or they are only notes not influencing the generated G-code.
     static std::unordered_set<std::string> steps_gcode = {
@@ -224,6 +232,7 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
         "activate_chamber_temp_control",
         "manual_filament_change",
         "disable_m73",
+        "orca_binary_gcode",
         "use_firmware_retraction",
         "enable_long_retraction_when_cut",
         "long_retractions_when_cut",
@@ -239,153 +248,166 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
 
     static std::unordered_set<std::string> steps_ignore;
 
+    if (steps_gcode.find(opt_key) != steps_gcode.end()) {
+        // These options only affect G-code export or they are just notes without influence on the generated G-code,
+        // so there is nothing to invalidate.
+        steps.emplace_back(psGCodeExport);
+    } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
+        // These steps have no influence on the G-code whatsoever. Just ignore them.
+    } else if (
+           opt_key == "skirt_type"
+        || opt_key == "skirt_loops"
+        || opt_key == "skirt_speed"
+        || opt_key == "skirt_height"
+        || opt_key == "min_skirt_length"
+        || opt_key == "single_loop_draft_shield"
+        || opt_key == "draft_shield"
+        || opt_key == "skirt_distance"
+        || opt_key == "skirt_start_angle"
+        || opt_key == "ooze_prevention"
+        || opt_key == "wipe_tower_x"
+        || opt_key == "wipe_tower_y"
+        || opt_key == "wipe_tower_rotation_angle") {
+        steps.emplace_back(psSkirtBrim);
+    } else if (
+           opt_key == "initial_layer_print_height"
+        || opt_key == "nozzle_diameter"
+        || opt_key == "filament_shrink"
+        || opt_key == "filament_shrinkage_compensation_z"
+        || opt_key == "resolution"
+        || opt_key == "precise_z_height"
+        // Spiral Vase forces different kind of slicing than the normal model:
+        // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
+        // Therefore toggling the Spiral Vase on / off requires complete reslicing.
+        || opt_key == "spiral_mode") {
+        osteps.emplace_back(posSlice);
+    } else if (
+           opt_key == "print_sequence"
+        || opt_key == "filament_type"
+        || opt_key == "chamber_temperature"
+        || opt_key == "nozzle_temperature_initial_layer"
+        || opt_key == "filament_minimal_purge_on_wipe_tower"
+        || opt_key == "filament_max_volumetric_speed"
+        || opt_key == "filament_adaptive_volumetric_speed"
+        || opt_key == "filament_loading_speed"
+        || opt_key == "filament_loading_speed_start"
+        || opt_key == "filament_unloading_speed"
+        || opt_key == "filament_unloading_speed_start"
+        || opt_key == "filament_toolchange_delay"
+        || opt_key == "filament_cooling_moves"
+        || opt_key == "filament_stamping_loading_speed"
+        || opt_key == "filament_stamping_distance"
+        || opt_key == "filament_cooling_initial_speed"
+        || opt_key == "filament_cooling_final_speed"
+        || opt_key == "filament_ramming_parameters"
+        || opt_key == "filament_multitool_ramming"
+        || opt_key == "filament_multitool_ramming_volume"
+        || opt_key == "filament_multitool_ramming_flow"
+        || opt_key == "filament_max_volumetric_speed"
+        || opt_key == "gcode_flavor"
+        || opt_key == "single_extruder_multi_material"
+        || opt_key == "nozzle_temperature"
+        // BBS
+        || opt_key == "supertack_plate_temp"
+        || opt_key == "cool_plate_temp"
+        || opt_key == "textured_cool_plate_temp"
+        || opt_key == "eng_plate_temp"
+        || opt_key == "hot_plate_temp"
+        || opt_key == "textured_plate_temp"
+        || opt_key == "enable_prime_tower"
+        || opt_key == "enable_wrapping_detection"
+        || opt_key == "prime_tower_enable_framework"
+        || opt_key == "prime_tower_width"
+        || opt_key == "prime_tower_brim_width"
+        || opt_key == "prime_tower_skip_points"
+        || opt_key == "prime_tower_flat_ironing"
+        || opt_key == "first_layer_print_sequence"
+        || opt_key == "other_layers_print_sequence"
+        || opt_key == "other_layers_print_sequence_nums" 
+        || opt_key == "extruder_ams_count"
+        || opt_key == "filament_map_mode"
+        || opt_key == "filament_map"
+        || opt_key == "filament_adhesiveness_category"
+        || opt_key == "wipe_tower_bridging"
+        || opt_key == "wipe_tower_extra_flow"
+        || opt_key == "wipe_tower_no_sparse_layers"
+        || opt_key == "flush_volumes_matrix"
+        || opt_key == "prime_volume"
+        || opt_key == "flush_into_infill"
+        || opt_key == "flush_into_support"
+        || opt_key == "initial_layer_infill_speed"
+        || opt_key == "travel_speed"
+        || opt_key == "travel_speed_z"
+        || opt_key == "initial_layer_speed"
+        || opt_key == "initial_layer_travel_speed"
+        || opt_key == "slow_down_layers"
+        || opt_key == "idle_temperature"
+        || opt_key == "wipe_tower_cone_angle"
+        || opt_key == "wipe_tower_extra_spacing"
+        || opt_key == "wipe_tower_max_purge_speed"
+        || opt_key == "wipe_tower_wall_type"
+        || opt_key == "wipe_tower_extra_rib_length"
+        || opt_key == "wipe_tower_rib_width"
+        || opt_key == "wipe_tower_fillet_wall"
+        || opt_key == "wipe_tower_filament"
+        || opt_key == "wiping_volumes_extruders"
+        || opt_key == "enable_filament_ramming"
+        || opt_key == "purge_in_prime_tower"
+        || opt_key == "z_offset"
+        || opt_key == "support_multi_bed_types"
+        ) {
+        steps.emplace_back(psWipeTower);
+        steps.emplace_back(psSkirtBrim);
+    } else if (opt_key == "filament_soluble"
+            || opt_key == "filament_is_support"
+            || opt_key == "filament_printable"
+            || opt_key == "filament_change_length"
+            || opt_key == "independent_support_layer_height") {
+        steps.emplace_back(psWipeTower);
+        // Soluble support interface / non-soluble base interface produces non-soluble interface layers below soluble interface layers.
+        // Thus switching between soluble / non-soluble interface layer material may require recalculation of supports.
+        //FIXME Killing supports on any change of "filament_soluble" is rough. We should check for each object whether that is necessary.
+        osteps.emplace_back(posSupportMaterial);
+        osteps.emplace_back(posSimplifySupportPath);
+    } else if (
+           opt_key == "initial_layer_line_width"
+        || opt_key == "min_layer_height"
+        || opt_key == "max_layer_height"
+        //|| opt_key == "resolution"
+        //BBS: when enable arc fitting, we must re-generate perimeter
+        || opt_key == "enable_arc_fitting"
+        || opt_key == "print_order"
+        || opt_key == "wall_sequence") {
+        osteps.emplace_back(posPerimeters);
+        osteps.emplace_back(posEstimateCurledExtrusions);
+        osteps.emplace_back(posInfill);
+        osteps.emplace_back(posSupportMaterial);
+			osteps.emplace_back(posSimplifyPath);
+        osteps.emplace_back(posSimplifyInfill);
+        osteps.emplace_back(posSimplifySupportPath);
+        steps.emplace_back(psSkirtBrim);
+    }
+    else if (opt_key == "z_hop_types") {
+        osteps.emplace_back(posDetectOverhangsForLift);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Called by Print::apply().
+// This method only accepts PrintConfig option keys.
+bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+{
+    if (opt_keys.empty())
+        return false;
+
     std::vector<PrintStep> steps;
     std::vector<PrintObjectStep> osteps;
     bool invalidated = false;
 
     for (const t_config_option_key &opt_key : opt_keys) {
-        if (steps_gcode.find(opt_key) != steps_gcode.end()) {
-            // These options only affect G-code export or they are just notes without influence on the generated G-code,
-            // so there is nothing to invalidate.
-            steps.emplace_back(psGCodeExport);
-        } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
-            // These steps have no influence on the G-code whatsoever. Just ignore them.
-        } else if (
-               opt_key == "skirt_type"
-            || opt_key == "skirt_loops"
-            || opt_key == "skirt_speed"
-            || opt_key == "skirt_height"
-            || opt_key == "min_skirt_length"
-            || opt_key == "single_loop_draft_shield"
-            || opt_key == "draft_shield"
-            || opt_key == "skirt_distance"
-            || opt_key == "skirt_start_angle"
-            || opt_key == "ooze_prevention"
-            || opt_key == "wipe_tower_x"
-            || opt_key == "wipe_tower_y"
-            || opt_key == "wipe_tower_rotation_angle") {
-            steps.emplace_back(psSkirtBrim);
-        } else if (
-               opt_key == "initial_layer_print_height"
-            || opt_key == "nozzle_diameter"
-            || opt_key == "filament_shrink"
-            || opt_key == "filament_shrinkage_compensation_z"
-            || opt_key == "resolution"
-            || opt_key == "precise_z_height"
-            // Spiral Vase forces different kind of slicing than the normal model:
-            // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
-            // Therefore toggling the Spiral Vase on / off requires complete reslicing.
-            || opt_key == "spiral_mode") {
-            osteps.emplace_back(posSlice);
-        } else if (
-               opt_key == "print_sequence"
-            || opt_key == "filament_type"
-            || opt_key == "chamber_temperature"
-            || opt_key == "nozzle_temperature_initial_layer"
-            || opt_key == "filament_minimal_purge_on_wipe_tower"
-            || opt_key == "filament_max_volumetric_speed"
-            || opt_key == "filament_adaptive_volumetric_speed"
-            || opt_key == "filament_loading_speed"
-            || opt_key == "filament_loading_speed_start"
-            || opt_key == "filament_unloading_speed"
-            || opt_key == "filament_unloading_speed_start"
-            || opt_key == "filament_toolchange_delay"
-            || opt_key == "filament_cooling_moves"
-            || opt_key == "filament_stamping_loading_speed"
-            || opt_key == "filament_stamping_distance"
-            || opt_key == "filament_cooling_initial_speed"
-            || opt_key == "filament_cooling_final_speed"
-            || opt_key == "filament_ramming_parameters"
-            || opt_key == "filament_multitool_ramming"
-            || opt_key == "filament_multitool_ramming_volume"
-            || opt_key == "filament_multitool_ramming_flow"
-            || opt_key == "filament_max_volumetric_speed"
-            || opt_key == "gcode_flavor"
-            || opt_key == "single_extruder_multi_material"
-            || opt_key == "nozzle_temperature"
-            // BBS
-            || opt_key == "supertack_plate_temp"
-            || opt_key == "cool_plate_temp"
-            || opt_key == "textured_cool_plate_temp"
-            || opt_key == "eng_plate_temp"
-            || opt_key == "hot_plate_temp"
-            || opt_key == "textured_plate_temp"
-            || opt_key == "enable_prime_tower"
-            || opt_key == "enable_wrapping_detection"
-            || opt_key == "prime_tower_enable_framework"
-            || opt_key == "prime_tower_width"
-            || opt_key == "prime_tower_brim_width"
-            || opt_key == "prime_tower_skip_points"
-            || opt_key == "prime_tower_flat_ironing"
-            || opt_key == "first_layer_print_sequence"
-            || opt_key == "other_layers_print_sequence"
-            || opt_key == "other_layers_print_sequence_nums" 
-            || opt_key == "extruder_ams_count"
-            || opt_key == "filament_map_mode"
-            || opt_key == "filament_map"
-            || opt_key == "filament_adhesiveness_category"
-            || opt_key == "wipe_tower_bridging"
-            || opt_key == "wipe_tower_extra_flow"
-            || opt_key == "wipe_tower_no_sparse_layers"
-            || opt_key == "flush_volumes_matrix"
-            || opt_key == "prime_volume"
-            || opt_key == "flush_into_infill"
-            || opt_key == "flush_into_support"
-            || opt_key == "initial_layer_infill_speed"
-            || opt_key == "travel_speed"
-            || opt_key == "travel_speed_z"
-            || opt_key == "initial_layer_speed"
-            || opt_key == "initial_layer_travel_speed"
-            || opt_key == "slow_down_layers"
-            || opt_key == "idle_temperature"
-            || opt_key == "wipe_tower_cone_angle"
-            || opt_key == "wipe_tower_extra_spacing"
-            || opt_key == "wipe_tower_max_purge_speed"
-            || opt_key == "wipe_tower_wall_type"
-            || opt_key == "wipe_tower_extra_rib_length"
-            || opt_key == "wipe_tower_rib_width"
-            || opt_key == "wipe_tower_fillet_wall"
-            || opt_key == "wipe_tower_filament"
-            || opt_key == "wiping_volumes_extruders"
-            || opt_key == "enable_filament_ramming"
-            || opt_key == "purge_in_prime_tower"
-            || opt_key == "z_offset"
-            || opt_key == "support_multi_bed_types"
-            ) {
-            steps.emplace_back(psWipeTower);
-            steps.emplace_back(psSkirtBrim);
-        } else if (opt_key == "filament_soluble"
-                || opt_key == "filament_is_support"
-                || opt_key == "filament_printable"
-                || opt_key == "filament_change_length"
-                || opt_key == "independent_support_layer_height") {
-            steps.emplace_back(psWipeTower);
-            // Soluble support interface / non-soluble base interface produces non-soluble interface layers below soluble interface layers.
-            // Thus switching between soluble / non-soluble interface layer material may require recalculation of supports.
-            //FIXME Killing supports on any change of "filament_soluble" is rough. We should check for each object whether that is necessary.
-            osteps.emplace_back(posSupportMaterial);
-            osteps.emplace_back(posSimplifySupportPath);
-        } else if (
-               opt_key == "initial_layer_line_width"
-            || opt_key == "min_layer_height"
-            || opt_key == "max_layer_height"
-            //|| opt_key == "resolution"
-            //BBS: when enable arc fitting, we must re-generate perimeter
-            || opt_key == "enable_arc_fitting"
-            || opt_key == "print_order"
-            || opt_key == "wall_sequence") {
-            osteps.emplace_back(posPerimeters);
-            osteps.emplace_back(posEstimateCurledExtrusions);
-            osteps.emplace_back(posInfill);
-            osteps.emplace_back(posSupportMaterial);
-			osteps.emplace_back(posSimplifyPath);
-            osteps.emplace_back(posSimplifyInfill);
-            osteps.emplace_back(posSimplifySupportPath);
-            steps.emplace_back(psSkirtBrim);
-        }
-        else if (opt_key == "z_hop_types") {
-            osteps.emplace_back(posDetectOverhangsForLift);
-        } else {
+        if (! print_config_option_steps(opt_key, steps, osteps)) {
             // for legacy, if we can't handle this option let's invalidate all steps
             //FIXME invalidate all steps of all objects as well?
             invalidated |= this->invalidate_all_steps();
@@ -1939,6 +1961,91 @@ void  PrintObject::copy_layers_overhang_from_shared_object()
 }
 
 
+std::string PrintObject::slice_cache_key() const
+{
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+    auto update = [&ctx](const void *data, size_t size) { MD5_Update(&ctx, data, size); };
+    auto update_size = [&update](uint64_t size) { update(&size, sizeof(size)); };
+    auto update_string = [&update, &update_size](const std::string &str) {
+        update_size(str.size());
+        update(str.data(), str.size());
+    };
+    auto update_bits = [&update, &update_size](const std::vector<bool> &bits) {
+        std::vector<unsigned char> bytes((bits.size() + 7) / 8, 0);
+        for (size_t i = 0; i < bits.size(); ++ i)
+            if (bits[i])
+                bytes[i / 8] |= 1 << (i % 8);
+        update_size(bits.size());
+        update(bytes.data(), bytes.size());
+    };
+    auto update_config = [&update_size, &update_string](const ConfigBase &config, const std::function<bool(const std::string&)> &filter = {}) {
+        t_config_option_keys keys = config.keys();
+        std::sort(keys.begin(), keys.end());
+        update_size(keys.size());
+        for (const std::string &opt_key : keys)
+            if (! filter || filter(opt_key)) {
+                update_string(opt_key);
+                update_string(config.opt_serialize(opt_key));
+            }
+    };
+    auto update_facets = [&update, &update_size, &update_bits](const FacetsAnnotation &facets) {
+        const TriangleSelector::TriangleSplittingData &data = facets.get_data();
+        update_size(data.triangles_to_split.size());
+        for (const TriangleSelector::TriangleBitStreamMapping &mapping : data.triangles_to_split) {
+            update(&mapping.triangle_idx, sizeof(mapping.triangle_idx));
+            update(&mapping.bitstream_start_idx, sizeof(mapping.bitstream_start_idx));
+        }
+        update_bits(data.bitstream);
+        update_bits(data.used_states);
+    };
+
+    // A different build may slice differently.
+    update_string(SLIC3R_VERSION);
+    update_size(LAYER_CACHE_VERSION);
+
+    update_config(m_print->config(), [](const std::string &opt_key) {
+        std::vector<PrintStep>       steps;
+        std::vector<PrintObjectStep> osteps;
+        return ! print_config_option_steps(opt_key, steps, osteps) || ! osteps.empty();
+    });
+    update_config(m_config);
+    update_size(this->num_printing_regions());
+    for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id)
+        update_config(this->printing_region(region_id).config());
+    update(m_trafo.data(), sizeof(double) * 16);
+
+    const ModelObject &model_object = *this->model_object();
+    update_config(model_object.config.get());
+    update_size(model_object.layer_height_profile.get().size());
+    update(model_object.layer_height_profile.get().data(), model_object.layer_height_profile.get().size() * sizeof(coordf_t));
+    update_size(model_object.layer_config_ranges.size());
+    for (const auto &[range, range_config] : model_object.layer_config_ranges) {
+        update(&range.first, sizeof(range.first));
+        update(&range.second, sizeof(range.second));
+        update_config(range_config.get());
+    }
+    update_size(model_object.volumes.size());
+    for (const ModelVolume *volume : model_object.volumes) {
+        const int type = int(volume->type());
+        update(&type, sizeof(type));
+        const indexed_triangle_set &its = volume->mesh().its;
+        update_size(its.vertices.size());
+        update(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+        update_size(its.indices.size());
+        update(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+        update(volume->get_transformation().get_matrix().data(), sizeof(double) * 16);
+        update_config(volume->config.get());
+        update_facets(volume->supported_facets);
+        update_facets(volume->seam_facets);
+        update_facets(volume->mmu_segmentation_facets);
+        update_facets(volume->fuzzy_skin_facets);
+    }
+
+    return md5_final_hex(ctx);
+}
+
+
 // BBS
 BoundingBox PrintObject::get_first_layer_bbox(float& a, float& layer_height, std::string& name)
 {
@@ -1988,6 +2095,56 @@ std::map<ObjectID, unsigned int> getObjectExtruderMap(const Print& print) {
     return objectExtruderMap;
 }
 
+void Print::process_objects(const std::function<void(PrintObject*)> &object_steps)
+{
+    // The progress of an object running behind the others would make the status go back and forth.
+    // Plain status updates lower than the highest one reported are dropped, warnings and updates with flags pass.
+    // The chains report their status concurrently, while the callback expects a single caller at a time.
+    status_callback_type status_callback = m_status_callback;
+    std::mutex           status_mutex;
+    int                  max_percent = -1;
+    if (status_callback)
+        m_status_callback = [&status_callback, &status_mutex, &max_percent](const SlicingStatus &status) {
+            std::lock_guard<std::mutex> lock(status_mutex);
+            if (status.flags == SlicingStatus::DEFAULT && status.percent >= 0) {
+                if (status.percent < max_percent)
+                    return;
+                max_percent = status.percent;
+            }
+            status_callback(status);
+        };
+    ScopeGuard restore_status_callback([this, &status_callback]() { m_status_callback = status_callback; });
+
+    // Tall objects are started first, so that they do not end up as the tail the other objects wait for.
+    PrintObjectPtrs objects = m_objects;
+    std::stable_sort(objects.begin(), objects.end(), [](const PrintObject *lhs, const PrintObject *rhs) { return lhs->height() > rhs->height(); });
+
+    // Exceptions are not let through to the task group. Cancelling the task group would cut short the parallel loops
+    // of the other objects, which would then mark their steps done with some layers not processed.
+    std::exception_ptr error;
+    std::mutex         error_mutex;
+    std::atomic<bool>  failed(false);
+    tbb::task_group    task_group;
+    for (PrintObject *obj : objects)
+        task_group.run([&object_steps, &error, &error_mutex, &failed, obj]() {
+            if (failed.load(std::memory_order_relaxed))
+                return;
+            try {
+                // Waiting for the layers of a step must not pick up the steps of another object.
+                tbb::this_task_arena::isolate([&object_steps, obj]() { object_steps(obj); });
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (! error)
+                    error = std::current_exception();
+                failed = true;
+            }
+        });
+    task_group.wait();
+    if (error)
+        std::rethrow_exception(error);
+    BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << ": steps of " << objects.size() << " objects finished";
+}
+
 // Slicing process, running at a background thread.
 void Print::process(long long *time_cost_with_cache, bool use_cache)
 {
@@ -2104,74 +2261,55 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": total object counts %1% in current print, need to slice %2%")%m_objects.size()%need_slicing_objects.size();
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
     if (!use_cache) {
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->make_perimeters();
-            }
-            else {
-                if (obj->set_started(posSlice))
-                    obj->set_done(posSlice);
-                if (obj->set_started(posPerimeters))
-                    obj->set_done(posPerimeters);
+        //objects to be sliced from scratch are looked up in the slice cache, the steps up to the ironing are skipped for the ones found.
+        //the support reads the skirt and the layers of the other objects, which are not a part of the cache key, thus it is generated again.
+        std::vector<PrintObject*> slice_cache_misses;
+        if (!m_slice_cache_dir.empty()) {
+            for (PrintObject *obj : m_objects) {
+                if (need_slicing_objects.count(obj) == 0 || obj->is_step_done(posSlice))
+                    continue;
+                if (this->load_slice_cache(obj)) {
+                    for (PrintObjectStep step : { posSlice, posPerimeters, posPrepareInfill, posInfill, posIroning })
+                        if (obj->set_started(step))
+                            obj->set_done(step);
+                }
+                else
+                    slice_cache_misses.push_back(obj);
             }
         }
-        for (PrintObject *obj : m_objects) {
+        // The support of an object reads the layers of the other objects, thus it waits for all of them to be sliced.
+        this->process_objects([&need_slicing_objects](PrintObject *obj) {
             if (need_slicing_objects.count(obj) != 0) {
+                obj->make_perimeters();
                 obj->estimate_curled_extrusions();
-            }
-            else {
-                if (obj->set_started(posEstimateCurledExtrusions))
-                    obj->set_done(posEstimateCurledExtrusions);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
                 obj->infill();
-            }
-            else {
-                if (obj->set_started(posPrepareInfill))
-                    obj->set_done(posPrepareInfill);
-                if (obj->set_started(posInfill))
-                    obj->set_done(posInfill);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
                 obj->ironing();
             }
             else {
-                if (obj->set_started(posIroning))
-                    obj->set_done(posIroning);
+                for (PrintObjectStep step : { posSlice, posPerimeters, posEstimateCurledExtrusions, posPrepareInfill, posInfill, posIroning })
+                    if (obj->set_started(step))
+                        obj->set_done(step);
             }
-        }
-
-        tbb::parallel_for(tbb::blocked_range<int>(0, int(m_objects.size())),
-            [this, need_slicing_objects](const tbb::blocked_range<int>& range) {
-                for (int i = range.begin(); i < range.end(); i++) {
-                    PrintObject* obj = m_objects[i];
-                    if (need_slicing_objects.count(obj) != 0) {
-                        obj->generate_support_material();
-                    }
-                    else {
-                        if (obj->set_started(posSupportMaterial))
-                            obj->set_done(posSupportMaterial);
-                    }
-                }
-            }
-        );
-
-        for (PrintObject* obj : m_objects) {
+        });
+        this->process_objects([&need_slicing_objects](PrintObject *obj) {
             if (need_slicing_objects.count(obj) != 0) {
+                obj->generate_support_material();
                 obj->detect_overhangs_for_lift();
             }
             else {
-                if (obj->set_started(posDetectOverhangsForLift))
-                    obj->set_done(posDetectOverhangsForLift);
+                for (PrintObjectStep step : { posSupportMaterial, posDetectOverhangsForLift })
+                    if (obj->set_started(step))
+                        obj->set_done(step);
             }
-        }
+        });
+
+        for (PrintObject* obj : slice_cache_misses)
+            this->store_slice_cache(obj);
+        if (!m_slice_cache_dir.empty())
+            this->trim_slice_cache();
     }
     else {
-        for (PrintObject *obj : m_objects) {
+        this->process_objects([&re_slicing_objects](PrintObject *obj) {
             if (re_slicing_objects.count(obj) == 0) {
                 if (obj->set_started(posSlice))
                     obj->set_done(posSlice);
@@ -2183,20 +2321,26 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
                     obj->set_done(posInfill);
                 if (obj->set_started(posIroning))
                     obj->set_done(posIroning);
+            }
+            else {
+                obj->make_perimeters();
+                obj->infill();
+                obj->ironing();
+            }
+        });
+        this->process_objects([&re_slicing_objects](PrintObject *obj) {
+            if (re_slicing_objects.count(obj) == 0) {
                 if (obj->set_started(posSupportMaterial))
                     obj->set_done(posSupportMaterial);
                 if (obj->set_started(posDetectOverhangsForLift))
                     obj->set_done(posDetectOverhangsForLift);
             }
             else {
-                obj->make_perimeters();
-                obj->infill();
-                obj->ironing();
                 obj->generate_support_material();
                 obj->detect_overhangs_for_lift();
                 obj->estimate_curled_extrusions();
             }
-        }
+        });
     }
 
     for (PrintObject *obj : m_objects)
@@ -2414,6 +2558,14 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     BOOST_LOG_TRIVIAL(info) << "Slicing process finished." << log_memory_info();
 }
 
+void Print::enable_gcode_export_cache(bool enable)
+{
+    if (! enable)
+        m_gcode_export_cache.reset();
+    else if (! m_gcode_export_cache)
+        m_gcode_export_cache = std::make_shared<GCodeExportCache>();
+}
+
 // G-code export process, running at a background thread.
 // The export_gcode may die for various reasons (fails to process filename_format,
 // write error into the G-code, cannot execute post-processing scripts).
@@ -3378,6 +3530,11 @@ std::string Print::output_filename(const std::string &filename_base) const
     config.set_key_value("plate_number", new ConfigOptionString(get_plate_number_formatted()));
     config.set_key_value("model_name", new ConfigOptionString(get_model_name()));
 
+    if (m_config.orca_binary_gcode) {
+        // The binary container is not a G-code any printer reads, don't let it pass for one.
+        boost::filesystem::path filename = this->PrintBase::output_filename(m_config.filename_format.value, BINARY_GCODE_EXTENSION, filename_base, &config);
+        return filename.replace_extension(BINARY_GCODE_EXTENSION).string();
+    }
     return this->PrintBase::output_filename(m_config.filename_format.value, ".gcode", filename_base, &config);
 }
 
@@ -4305,7 +4462,311 @@ static void from_json(const json& j, groupedVolumeSlices& firstlayer_group)
     }
 }
 
-int Print::export_cached_data(const std::string& directory, bool with_space)
+//volume ids of the first layer groups are saved as indices into ModelObject::volumes
+static std::vector<groupedVolumeSlices> first_layer_groups_to_save(const PrintObject* obj)
+{
+    std::vector<groupedVolumeSlices> groups = obj->firstLayerObjGroups();
+    //BBS: support shared object logic
+    const PrintObject* shared_object = obj->get_shared_object();
+    if (!shared_object)
+        shared_object = obj;
+    const ModelVolumePtrs& volumes_ptr = shared_object->model_object()->volumes;
+    for (groupedVolumeSlices& group : groups)
+        for (ObjectID& obj_id : group.volume_ids)
+            for (size_t index = 0; index < volumes_ptr.size(); index ++)
+                if (volumes_ptr[index]->id() == obj_id) {
+                    obj_id.id = index;
+                    break;
+                }
+    return groups;
+}
+
+//write the layers in batches, each batch is encoded in parallel and appended to the file before the next one is encoded
+void Print::export_cached_object(PrintObject* obj, const std::string& file_name, size_t identify_id, bool with_support_layers)
+{
+    static constexpr size_t batch_size = 256;
+    LayerCacheWriter writer(file_name, identify_id);
+    writer.append(LayerCacheRecordType::ObjectName, obj->model_object()->name);
+
+    std::vector<std::string> records;
+    auto append_layers = [&writer, &records](LayerCacheRecordType type, size_t count, auto encode) {
+        for (size_t batch_begin = 0; batch_begin < count; batch_begin += batch_size) {
+            records.assign(std::min(batch_size, count - batch_begin), std::string());
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, records.size()),
+                [&records, batch_begin, &encode](const tbb::blocked_range<size_t>& range) {
+                    for (size_t index = range.begin(); index < range.end(); ++ index)
+                        records[index] = encode(batch_begin + index);
+                }
+            );
+            for (const std::string& record : records)
+                writer.append(type, record);
+        }
+    };
+    append_layers(LayerCacheRecordType::Layer, obj->layer_count(),
+        [obj](size_t index) { return encode_cached_layer(*obj->get_layer(index)); });
+    if (with_support_layers)
+        append_layers(LayerCacheRecordType::SupportLayer, obj->support_layer_count(),
+            [obj](size_t index) { return encode_cached_support_layer(*obj->get_support_layer(index)); });
+    writer.append(LayerCacheRecordType::FirstLayerGroups, encode_cached_first_layer_groups(first_layer_groups_to_save(obj)));
+    writer.finish();
+}
+
+int Print::load_cached_object(PrintObject* obj, const std::string& file_name)
+{
+    auto find_region = [](PrintObject* object, size_t config_hash) -> const PrintRegion* {
+        int regions_count = object->num_printing_regions();
+        for (int index = 0; index < regions_count; index++ )
+        {
+            const PrintRegion&  print_region = object->printing_region(index);
+            if (print_region.config_hash() == config_hash ) {
+                return &print_region;
+            }
+        }
+        return NULL;
+    };
+
+    try {
+        LayerCacheReader reader(file_name);
+        std::vector<std::string_view> name_records = reader.records(LayerCacheRecordType::ObjectName);
+        std::vector<std::string_view> layer_records = reader.records(LayerCacheRecordType::Layer);
+        std::vector<std::string_view> support_layer_records = reader.records(LayerCacheRecordType::SupportLayer);
+        std::vector<std::string_view> firstlayer_group_records = reader.records(LayerCacheRecordType::FirstLayerGroups);
+        std::string name = name_records.empty() ? std::string() : std::string(name_records.front());
+
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(":will load %1%, identify_id %2%, layer_count %3%, support_layer_count %4%")
+            %name %reader.identify_id() %layer_records.size() %support_layer_records.size();
+
+        //create layer and layer regions, only the layer info at the start of the records is decoded here
+        Layer* previous_layer = NULL;
+        for (size_t index = 0; index < layer_records.size(); index++)
+        {
+            LayerCacheLayerInfo info = decode_cached_layer_info(layer_records[index]);
+            Layer* new_layer = obj->add_layer(info.id, info.height, info.print_z, info.slice_z);
+            if (!new_layer) {
+                BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":create_layer failed, out of memory");
+                return CLI_OUT_OF_MEMORY;
+            }
+            if (previous_layer) {
+                previous_layer->upper_layer = new_layer;
+                new_layer->lower_layer = previous_layer;
+            }
+            previous_layer = new_layer;
+
+            for (size_t region_index = 0; region_index < info.region_config_hashes.size(); region_index++)
+            {
+                const PrintRegion *print_region = find_region(obj, info.region_config_hashes[region_index]);
+                if (!print_region){
+                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":can not find print region of object %1%, layer %2%, print_z %3%, layer_region %4%")
+                        %name % index %new_layer->print_z %region_index;
+                    return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
+                }
+                new_layer->add_region(print_region);
+            }
+        }
+
+        //decode the layers parallel straight from the mapped file
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, obj->layer_count()),
+            [&layer_records, obj](const tbb::blocked_range<size_t>& layer_range) {
+                for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index)
+                    decode_cached_layer(layer_records[layer_index], *obj->get_layer(layer_index));
+            }
+        );
+
+        Layer* previous_support_layer = NULL;
+        for (size_t index = 0; index < support_layer_records.size(); index++)
+        {
+            LayerCacheLayerInfo info = decode_cached_layer_info(support_layer_records[index]);
+            SupportLayer* new_support_layer = obj->add_support_layer(info.id, int(info.interface_id), info.height, info.print_z);
+            if (!new_support_layer) {
+                BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":add_support_layer failed, out of memory");
+                return CLI_OUT_OF_MEMORY;
+            }
+            if (previous_support_layer) {
+                previous_support_layer->upper_layer = new_support_layer;
+                new_support_layer->lower_layer = previous_support_layer;
+            }
+            previous_support_layer = new_support_layer;
+        }
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, obj->support_layer_count()),
+            [&support_layer_records, obj](const tbb::blocked_range<size_t>& support_layer_range) {
+                for (size_t layer_index = support_layer_range.begin(); layer_index < support_layer_range.end(); ++ layer_index)
+                    decode_cached_support_layer(support_layer_records[layer_index], *obj->get_support_layer(layer_index));
+            }
+        );
+
+        //load first group volumes
+        std::vector<groupedVolumeSlices>& firstlayer_objgroups = obj->firstLayerObjGroupsMod();
+        for (std::string_view record : firstlayer_group_records)
+            for (groupedVolumeSlices& firstlayer_group : decode_cached_first_layer_groups(record)) {
+                //convert the id
+                ModelVolumePtrs& volumes_ptr = obj->model_object()->volumes;
+                for (ObjectID& obj_id : firstlayer_group.volume_ids)
+                {
+                    if (obj_id.id >= volumes_ptr.size()) {
+                        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": can not find volume_id %1% from object file %2% in firstlayer groups, volume_count %3%!")
+                            %obj_id.id %file_name %volumes_ptr.size();
+                        return CLI_IMPORT_CACHE_LOAD_FAILED;
+                    }
+                    obj_id = volumes_ptr[obj_id.id]->id();
+                }
+                firstlayer_objgroups.push_back(std::move(firstlayer_group));
+            }
+    }
+    catch(std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load from "<<file_name<<" got a generic exception, reason = " << err.what();
+        return CLI_IMPORT_CACHE_LOAD_FAILED;
+    }
+    return 0;
+}
+
+bool Print::load_slice_cache(PrintObject* obj)
+{
+    std::string file_name = (boost::filesystem::path(m_slice_cache_dir) / (obj->slice_cache_key() + ".bin")).string();
+    if (!fs::exists(file_name))
+        return false;
+
+    obj->clear_layers();
+    obj->clear_support_layers();
+    obj->firstLayerObjGroupsMod().clear();
+    if (this->load_cached_object(obj, file_name) != 0) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": can not use slice cache %1% of object %2%, slice it again") %file_name %obj->model_object()->name;
+        obj->clear_layers();
+        obj->clear_support_layers();
+        obj->firstLayerObjGroupsMod().clear();
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": loaded object %1% from slice cache %2%") %obj->model_object()->name %file_name;
+    ++ m_slice_cache_hits;
+    //the modification time orders the entries for trim_slice_cache()
+    boost::system::error_code ec;
+    boost::filesystem::last_write_time(file_name, std::time(nullptr), ec);
+    return true;
+}
+
+void Print::store_slice_cache(PrintObject* obj)
+{
+    //written under a temporary name and renamed, so that concurrent runs never see a partial file
+    boost::filesystem::path file_path = boost::filesystem::path(m_slice_cache_dir) / (obj->slice_cache_key() + ".bin");
+    boost::filesystem::path tmp_path = file_path.parent_path() / boost::filesystem::unique_path(file_path.filename().string() + ".%%%%-%%%%.tmp");
+    try {
+        boost::filesystem::create_directories(m_slice_cache_dir);
+        this->export_cached_object(obj, tmp_path.string(), 0, false);
+        if (std::error_code ec = rename_file(tmp_path.string(), file_path.string()); ec)
+            throw Slic3r::FileIOError(ec.message());
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": stored object %1% to slice cache %2%") %obj->model_object()->name %file_path.string();
+    }
+    catch (std::exception &err) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed to store object %1% to slice cache %2%: %3%") %obj->model_object()->name %file_path.string() %err.what();
+        boost::system::error_code ec;
+        boost::filesystem::remove(tmp_path, ec);
+    }
+}
+
+void Print::trim_slice_cache()
+{
+    if (m_slice_cache_max_size == 0)
+        return;
+    struct Entry {
+        boost::filesystem::path path;
+        std::time_t             time;
+        uintmax_t               size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t          total_size = 0;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(m_slice_cache_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        //files being written by other runs are left alone
+        const boost::filesystem::path &path = it->path();
+        if (path.extension() != ".bin" && path.extension() != ".octree")
+            continue;
+        boost::system::error_code ec_file;
+        Entry entry { path, boost::filesystem::last_write_time(path, ec_file), boost::filesystem::file_size(path, ec_file) };
+        if (! ec_file) {
+            total_size += entry.size;
+            entries.emplace_back(std::move(entry));
+        }
+    }
+    if (total_size <= m_slice_cache_max_size)
+        return;
+    std::sort(entries.begin(), entries.end(), [](const Entry &l, const Entry &r) { return l.time < r.time; });
+    for (const Entry &entry : entries) {
+        if (total_size <= m_slice_cache_max_size)
+            break;
+        boost::system::error_code ec_remove;
+        if (boost::filesystem::remove(entry.path, ec_remove)) {
+            total_size -= entry.size;
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": removed %1% from slice cache") %entry.path.string();
+        }
+    }
+}
+
+FillAdaptive::OctreePtr Print::adaptive_fill_octree(const std::string &key, const std::function<FillAdaptive::OctreePtr()> &build)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_shared_adaptive_fill_octrees_mutex);
+        if (auto it = m_shared_adaptive_fill_octrees.find(key); it != m_shared_adaptive_fill_octrees.end())
+            if (FillAdaptive::OctreePtr octree = it->second.lock())
+                return octree;
+    }
+
+    FillAdaptive::OctreePtr octree;
+    boost::filesystem::path file_path;
+    if (! m_slice_cache_dir.empty()) {
+        file_path = boost::filesystem::path(m_slice_cache_dir) / (key + ".octree");
+        if (fs::exists(file_path)) {
+            try {
+                LayerCacheReader reader(file_path.string());
+                std::vector<std::string_view> records = reader.records(LayerCacheRecordType::AdaptiveOctree);
+                if (records.size() != 1)
+                    throw Slic3r::FileIOError("Missing adaptive infill octree");
+                octree = FillAdaptive::decode_octree(records.front());
+                boost::system::error_code ec;
+                boost::filesystem::last_write_time(file_path, std::time(nullptr), ec);
+                BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": loaded adaptive infill octree from slice cache %1%") %file_path.string();
+            }
+            catch (std::exception &err) {
+                BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": can not use adaptive infill octree %1%, build it again: %2%") %file_path.string() %err.what();
+            }
+        }
+    }
+
+    if (! octree) {
+        octree = build();
+        if (! file_path.empty()) {
+            //written under a temporary name and renamed, so that concurrent runs never see a partial file
+            boost::filesystem::path tmp_path = file_path.parent_path() / boost::filesystem::unique_path(file_path.filename().string() + ".%%%%-%%%%.tmp");
+            try {
+                boost::filesystem::create_directories(m_slice_cache_dir);
+                LayerCacheWriter writer(tmp_path.string(), 0);
+                writer.append(LayerCacheRecordType::AdaptiveOctree, FillAdaptive::encode_octree(*octree));
+                writer.finish();
+                if (std::error_code ec = rename_file(tmp_path.string(), file_path.string()); ec)
+                    throw Slic3r::FileIOError(ec.message());
+            }
+            catch (std::exception &err) {
+                BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed to store adaptive infill octree to slice cache %1%: %2%") %file_path.string() %err.what();
+                boost::system::error_code ec;
+                boost::filesystem::remove(tmp_path, ec);
+            }
+        }
+    }
+
+    std::scoped_lock<std::mutex> lock(m_shared_adaptive_fill_octrees_mutex);
+    // Another object may have published the same octree in the meantime, share that one.
+    std::weak_ptr<FillAdaptive::Octree> &published = m_shared_adaptive_fill_octrees[key];
+    if (FillAdaptive::OctreePtr other = published.lock())
+        return other;
+    published = octree;
+    for (auto it = m_shared_adaptive_fill_octrees.begin(); it != m_shared_adaptive_fill_octrees.end();)
+        it = it->second.expired() ? m_shared_adaptive_fill_octrees.erase(it) : std::next(it);
+    return octree;
+}
+
+int Print::export_cached_data(const std::string& directory, bool with_space, bool as_json)
 {
     int ret = 0;
     boost::filesystem::path directory_path(directory);
@@ -4354,6 +4815,7 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
         return;
     };
 
+
     //firstly clear this directory
     if (fs::exists(directory_path)) {
         fs::remove_all(directory_path);
@@ -4383,10 +4845,22 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
         const PrintInstance &print_instance = obj->instances()[0];
         const ModelInstance *model_instance = print_instance.model_instance;
         size_t identify_id = (model_instance->loaded_id > 0)?model_instance->loaded_id: model_instance->id().id;
-        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
+        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+(as_json ? ".json" : ".bin");
 
         BOOST_LOG_TRIVIAL(info) << boost::format("begin to dump object %1%, identify_id %2% to %3%")%model_obj->name %identify_id %file_name;
 
+        if (!as_json) {
+            try {
+                this->export_cached_object(obj, file_name, identify_id);
+                count ++;
+            }
+            catch(std::exception &err) {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": save to "<<file_name<<" got a generic exception, reason = " << err.what();
+                ret = CLI_EXPORT_CACHE_WRITE_FAILED;
+            }
+            continue;
+        }
+
         try {
             json root_json, layers_json = json::array(), support_layers_json = json::array(), first_layer_groups = json::array();
 
@@ -4497,29 +4971,7 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
             } // for each layer*/
             root_json[JSON_SUPPORT_LAYERS] = std::move(support_layers_json);
 
-            const std::vector<groupedVolumeSlices> &first_layer_obj_groups =  obj->firstLayerObjGroups();
-            for (size_t s_group_index = 0; s_group_index < first_layer_obj_groups.size(); ++ s_group_index) {
-                groupedVolumeSlices group = first_layer_obj_groups[s_group_index];
-
-                //convert the id
-                for (ObjectID& obj_id : group.volume_ids)
-                {
-                    const ModelVolume* currentModelVolumePtr = nullptr;
-                    //BBS: support shared object logic
-                    const PrintObject* shared_object = obj->get_shared_object();
-                    if (!shared_object)
-                        shared_object = obj;
-                    const ModelVolumePtrs& volumes_ptr = shared_object->model_object()->volumes;
-                    size_t volume_count = volumes_ptr.size();
-                    for (size_t index = 0; index < volume_count; index ++) {
-                        currentModelVolumePtr = volumes_ptr[index];
-                        if (currentModelVolumePtr->id() == obj_id) {
-                            obj_id.id = index;
-                            break;
-                        }
-                    }
-                }
-
+            for (const groupedVolumeSlices& group : first_layer_groups_to_save(obj)) {
                 json first_layer_group_json;
 
                 first_layer_group_json = group;
@@ -4612,7 +5064,17 @@ int Print::load_cached_data(const std::string& directory)
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": object %1%'s loaded_id is 0, need to use the instance_id %2%")%model_obj->name %identify_id;
             //continue;
         }
-        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
+        //the binary cache is preferred, the json one is written for debugging only
+        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".bin";
+        if (fs::exists(file_name)) {
+            ret = this->load_cached_object(obj, file_name);
+            if (ret)
+                return ret;
+            count ++;
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": load object %1% from %2% successfully.")%count%file_name;
+            continue;
+        }
+        file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
 
         if (!fs::exists(file_name)) {
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(": file %1% not exist, maybe a shared object, skip it")%file_name;
@@ -29,6 +29,7 @@
 namespace Slic3r {
 
 class GCode;
+class GCodeExportCache;
 class Layer;
 class ModelObject;
 class Print;
@@ -64,7 +65,7 @@ enum SupportNecessaryType {
 namespace FillAdaptive {
     struct Octree;
     struct OctreeDeleter;
-    using OctreePtr = std::unique_ptr<Octree, OctreeDeleter>;
+    using OctreePtr = std::shared_ptr<Octree>;
 };
 
 namespace FillLightning {
@@ -457,6 +458,10 @@ public:
     void         clear_shared_object();
     void         copy_layers_from_shared_object();
     void         copy_layers_overhang_from_shared_object();
+    // Digest of everything the layers of this object depend on up to posIroning: the meshes, transformations,
+    // painted facets and configs of its volumes, the object and region configs and the print config options not
+    // limited to the wipe tower, skirt, brim or G-code export. Stable across runs, see Print::set_slice_cache_dir().
+    std::string  slice_cache_key() const;
 
     // BBS: Boundingbox of the first layer
     BoundingBox                 firstLayerObjectBrimBoundingBox;
@@ -561,6 +566,9 @@ private:
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
     // so that next call to make_perimeters() performs a union() before computing loops
     bool                    				m_typed_slices = false;
+    // Run clip_fill_surfaces(), discover_horizontal_shells() and combine_infill() serially, layer by layer,
+    // as they were before being parallelized. Set by the tests to verify the parallel versions against.
+    bool                                    m_serial_fill_surfaces = false;
 
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> m_adaptive_fill_octrees;
     FillLightning::GeneratorPtr m_lightning_generator;
@@ -586,6 +594,9 @@ private:
     // This was a per-object setting and now we default enable it.
     static bool clip_multipart_objects;
     static bool infill_only_where_needed;
+
+    // For the tests only, see m_serial_fill_surfaces.
+    void set_serial_fill_surfaces(bool serial) { m_serial_fill_surfaces = serial; }
 };
 
 struct FakeWipeTower
@@ -908,9 +919,31 @@ public:
     // Exports G-code into a file name based on the path_template, returns the file path of the generated G-code file.
     // If preview_data is not null, the preview_data is filled in for the G-code visualization (not used by the command line Slic3r).
     std::string         export_gcode(const std::string& path_template, GCodeProcessorResult* result, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
+    // Writes the layers of the objects into dir_path, in the binary format of LayerCache.hpp or as JSON for debugging.
     //return 0 means successful
-    int                 export_cached_data(const std::string& dir_path, bool with_space=false);
+    int                 export_cached_data(const std::string& dir_path, bool with_space=false, bool as_json=false);
     int                 load_cached_data(const std::string& directory);
+    // Directory of a slice cache shared by all runs, empty to disable it. process() loads the layers of objects sliced
+    // before with the same PrintObject::slice_cache_key() from there instead of running posSlice to posIroning,
+    // and stores the layers of the objects it sliced. The support depends on the skirt and on the other objects,
+    // it is generated again.
+    void                set_slice_cache_dir(const std::string& dir) { m_slice_cache_dir = dir; }
+    const std::string&  slice_cache_dir() const { return m_slice_cache_dir; }
+    // Upper bound of the size of the slice cache directory in bytes, 0 for no limit. Once process() stored new entries,
+    // the least recently used entries are removed until the directory fits.
+    void                set_slice_cache_max_size(size_t bytes) { m_slice_cache_max_size = bytes; }
+    size_t              slice_cache_max_size() const { return m_slice_cache_max_size; }
+    // Number of objects process() loaded from the slice cache since the Print was created.
+    size_t              slice_cache_hits() const { return m_slice_cache_hits; }
+    // Keep the G-code of the layers and the state of the G-code generator after each of them between exports,
+    // so that the next export regenerates the G-code from the first changed layer only. Costs memory in the order
+    // of the size of the G-code, thus it is meant for the interactive use.
+    void                enable_gcode_export_cache(bool enable);
+    bool                gcode_export_cache_enabled() const { return m_gcode_export_cache != nullptr; }
+    // Octree of the adaptive or support cubic infill with the given key, see PrintObject::prepare_adaptive_infill_data().
+    // Shared by the objects of the print holding an octree of the same key and looked up in the slice cache,
+    // built by build() and stored to the slice cache otherwise. Thread safe.
+    FillAdaptive::OctreePtr adaptive_fill_octree(const std::string &key, const std::function<FillAdaptive::OctreePtr()> &build);
 
     // methods for handling state
     bool                is_step_done(PrintStep step) const { return Inherited::is_step_done(step); }
@@ -1119,6 +1152,18 @@ private:
     bool                has_tpu_filament() const;
     bool                invalidate_state_by_config_options(const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
 
+    // Layers of a single object in the format of LayerCache.hpp, loading returns 0 or a CLI error code.
+    // The slice cache leaves out the support layers, they are generated again on a cache hit.
+    void                export_cached_object(PrintObject* obj, const std::string& file_name, size_t identify_id, bool with_support_layers = true);
+    int                 load_cached_object(PrintObject* obj, const std::string& file_name);
+    bool                load_slice_cache(PrintObject* obj);
+    void                store_slice_cache(PrintObject* obj);
+    void                trim_slice_cache();
+    // Runs the chain of steps of each object as a task of its own on the TBB pool. An object does not wait for the other objects
+    // to finish a step before starting its next step, thus the objects and the layers of their steps interleave.
+    // The first error or cancellation is rethrown once all the chains stopped.
+    void                process_objects(const std::function<void(PrintObject*)> &object_steps);
+
     void                _make_skirt();
     void                _make_wipe_tower();
     void                finalize_first_layer_convex_hull();
@@ -1131,6 +1176,14 @@ private:
     PrintRegionConfig                       m_default_region_config;
     PrintObjectPtrs                         m_objects;
     PrintRegionPtrs                         m_print_regions;
+    std::string                             m_slice_cache_dir;
+    size_t                                  m_slice_cache_max_size { size_t(2048) << 20 };
+    size_t                                  m_slice_cache_hits { 0 };
+    // Shared pointer, so that GCodeExportCache may stay an incomplete type here.
+    std::shared_ptr<GCodeExportCache>       m_gcode_export_cache;
+    // Octrees held by the objects by their keys.
+    std::mutex                                                  m_shared_adaptive_fill_octrees_mutex;
+    std::map<std::string, std::weak_ptr<FillAdaptive::Octree>>  m_shared_adaptive_fill_octrees;
     
     //SoftFever
     bool m_isBBLPrinter;
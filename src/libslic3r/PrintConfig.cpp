@@ -4918,6 +4918,17 @@ void PrintConfigDef::init_fff_params()
     def->mode = comAdvanced;
     def->set_default_value(new ConfigOptionBool(false));
 
+    // Not named binary_gcode, so that the option of the same name of PrusaSlicer profiles for the libbgcode format
+    // does not enable this container.
+    def = this->add("orca_binary_gcode", coBool);
+    def->label = L("Binary G-code (OrcaSlicer only)");
+    def->tooltip = L("Export the G-code in a compressed binary container of OrcaSlicer with the .orcabgc extension instead of an ASCII G-code. "
+                     "The file is several times smaller and keeps the statistics, thumbnails, configuration and a layer index in blocks of their own. "
+                     "It is not the binary G-code of PrusaSlicer and no printer firmware reads it, it can only be opened by OrcaSlicer, "
+                     "thus sending or uploading the G-code to a printer is disabled while this option is enabled.");
+    def->mode = comAdvanced;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("seam_position", coEnum);
     def->label = L("Seam position");
     def->category = L("Quality");
@@ -9688,6 +9699,26 @@ CLIActionsConfigDef::CLIActionsConfigDef()
     def->tooltip = L("Send progress to pipe.");
     def->cli_params = "pipename";
     def->set_default_value(new ConfigOptionString());
+
+    def = this->add("quote_batch", coString);
+    def->label = L("Quote batch");
+    def->tooltip = L("Slice all 3MF projects of a directory in parallel and write one invoice quote per project into the output directory. Requires --job-profile.");
+    def->cli_params = "directory";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("quote_gcode", coString);
+    def->label = L("Quote G-code archive");
+    def->tooltip = L("Price all G-code files of a directory from the statistics embedded into their header and footer, without processing the moves. "
+                     "Writes one invoice quote per file into the output directory. Requires --job-profile.");
+    def->cli_params = "directory";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("quote_estimate", coBool);
+    def->label = L("Quick quote");
+    def->tooltip = L("Estimate filament and print time of the loaded models from their meshes and the print settings without slicing. "
+                     "Writes estimate.json into the output directory, priced with --job-profile if given. "
+                     "Uses the coefficients of --estimate-calibration if given.");
+    def->set_default_value(new ConfigOptionBool(false));
 }
 
 //BBS: remove unused command currently
@@ -10007,6 +10038,59 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = "Allow filaments with high/low temperature to be printed together.";
     def->cli_params = "option";
     def->set_default_value(new  ConfigOptionBool(false));
+
+    def = this->add("export_slicedata_json", coBool);
+    // debugging only, don't need translation
+    def->label = "Export slicing data as JSON";
+    def->tooltip = "Export the slicing data of --export-slicedata as JSON instead of the binary format, for debugging.";
+    def->cli_params = "option";
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("slice_cache", coString);
+    def->label = L("Slice cache");
+    def->tooltip = L("Directory of a slice cache shared by all runs. Objects sliced before with the same geometry, painting and settings "
+                     "are loaded from the cache instead of being sliced again, the other objects are added to it.");
+    def->cli_params = "directory";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("slice_cache_size", coInt);
+    def->label = L("Slice cache size");
+    def->tooltip = L("Upper bound of the size of the slice cache. The least recently used objects are removed from the cache "
+                     "once it grows larger. 0 for no limit.");
+    def->sidetext = "MB";
+    def->min = 0;
+    def->cli_params = "size";
+    def->set_default_value(new ConfigOptionInt(2048));
+
+    def = this->add("job_profile", coString);
+    def->label = L("Invoice job profile");
+    def->tooltip = L("Price every sliced plate with the rates of this job profile and write quote.json to the output directory.");
+    def->cli_params = "job_profile.json";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("estimate_calibration", coString);
+    def->label = L("Estimate calibration");
+    def->tooltip = L("Coefficients of the estimator of --quote-estimate. Slicing with --slice adds every sliced plate to the samples "
+                     "of this file and fits the coefficients to them again.");
+    def->cli_params = "calibration.json";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("quote_sweep", coString);
+    def->label = L("Quote sweep");
+    def->tooltip = L("Together with --job-profile, also price every sliced plate for each combination of the given option values, "
+                     "for example \"sparse_infill_density=15%,30%,50%;layer_height=0.2,0.28\". "
+                     "Writes plate_<n>.sweep.json and the G-code of every variant to the output directory.");
+    def->cli_params = "\"option=value,value;option=value,value\"";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("quote_jobs", coInt);
+    def->label = L("Quote batch jobs");
+    def->tooltip = L("Number of projects sliced at the same time by --quote-batch, of G-code files read at the same time by --quote-gcode, "
+                     "or of variant groups sliced at the same time by --quote-sweep. "
+                     "0 means half of the CPU cores for --quote-batch, as each slicing process is multi-threaded itself, and all of them otherwise.");
+    def->cli_params = "count";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
 }
 
 const CLIActionsConfigDef    cli_actions_config_def;
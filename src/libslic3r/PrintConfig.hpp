@@ -1345,6 +1345,7 @@ PRINT_CONFIG_CLASS_DEFINE(
     ((ConfigOptionFloatOrPercent,      initial_layer_travel_speed))
     ((ConfigOptionBool,                bbl_calib_mark_logo))
     ((ConfigOptionBool,                disable_m73))
+    ((ConfigOptionBool,                orca_binary_gcode))
 
     // Orca: mmu
     ((ConfigOptionFloat,               cooling_tube_retraction))
@@ -21,6 +21,7 @@
 #include "Format/STL.hpp"
 #include "format.hpp"
 #include "AABBTreeLines.hpp"
+#include "libslic3r_version.h"
 
 #include <float.h>
 #include <oneapi/tbb/blocked_range.h>
@@ -907,9 +908,35 @@ std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare
     for (size_t i = 1; i < overhangs.size(); ++ i)
         append(overhangs.front(), std::move(overhangs[i]));
 
+    // An octree depends on the rotated mesh, the overhangs and its line spacing only. Its key identifies it across
+    // the objects of the print and across reslices not changing these, for example of speeds or infill angles.
+    MD5_CTX mesh_ctx;
+    MD5_Init(&mesh_ctx);
+    {
+        auto update_size = [&mesh_ctx](uint64_t size) { MD5_Update(&mesh_ctx, &size, sizeof(size)); };
+        // A different build may build a different octree.
+        const std::string_view version(SLIC3R_VERSION);
+        update_size(version.size());
+        MD5_Update(&mesh_ctx, version.data(), version.size());
+        update_size(mesh.vertices.size());
+        MD5_Update(&mesh_ctx, mesh.vertices.data(), mesh.vertices.size() * sizeof(stl_vertex));
+        update_size(mesh.indices.size());
+        MD5_Update(&mesh_ctx, mesh.indices.data(), mesh.indices.size() * sizeof(stl_triangle_vertex_indices));
+        update_size(overhangs.front().size());
+        MD5_Update(&mesh_ctx, overhangs.front().data(), overhangs.front().size() * sizeof(Vec3d));
+    }
+    auto octree = [this, &mesh, &overhangs, &mesh_ctx](double line_spacing, bool support_overhangs_only) {
+        MD5_CTX ctx = mesh_ctx;
+        MD5_Update(&ctx, &line_spacing, sizeof(line_spacing));
+        MD5_Update(&ctx, &support_overhangs_only, sizeof(support_overhangs_only));
+        return m_print->adaptive_fill_octree(md5_final_hex(ctx), [&mesh, &overhangs, line_spacing, support_overhangs_only]() {
+            return build_octree(mesh, overhangs.front(), line_spacing, support_overhangs_only);
+        });
+    };
+
     return std::make_pair(
-        adaptive_line_spacing ? build_octree(mesh, overhangs.front(), adaptive_line_spacing, false) : OctreePtr(),
-        support_line_spacing  ? build_octree(mesh, overhangs.front(), support_line_spacing, true) : OctreePtr());
+        adaptive_line_spacing ? octree(adaptive_line_spacing, false) : OctreePtr(),
+        support_line_spacing  ? octree(support_line_spacing, true) : OctreePtr());
 }
 
 FillLightning::GeneratorPtr PrintObject::prepare_lightning_infill_data()
@@ -3527,42 +3554,48 @@ void PrintObject::clip_fill_surfaces()
             has_infill = true;
             break;
         }
-    if (! has_infill)
+    if (! has_infill || m_layers.size() < 2)
         return;
 
     // We only want infill under ceilings; this is almost like an
     // internal support material.
-    // Proceed top-down, skipping the bottom layer.
-    Polygons upper_internal;
-    for (int layer_id = int(m_layers.size()) - 1; layer_id > 0; -- layer_id) {
-        Layer *layer       = m_layers[layer_id];
-        Layer *lower_layer = m_layers[layer_id - 1];
+    // The clipped internal surfaces of a layer are a part of the fill surfaces, which the perimeters to support are found against
+    // when the layer becomes the upper layer, thus the layers are clipped one after the other. Only the surfaces of the lower layers,
+    // which are read before the layers are clipped, are collected in parallel.
+    // overhangs[i]: areas of layer i to be supported by layer i - 1.
+    // upper_internals[i]: internal surfaces of layer i, then their part supporting the layers above.
+    // lower_fill_surfaces[i]: fill surfaces of layer i before it was clipped.
+    std::vector<Polygons> overhangs(m_layers.size());
+    std::vector<Polygons> upper_internals(m_layers.size());
+    std::vector<Polygons> lower_fill_surfaces(m_layers.size());
+    auto collect_lower_surfaces = [this, &upper_internals, &lower_fill_surfaces](size_t layer_id) {
+        for (const LayerRegion *layerm : m_layers[layer_id]->m_regions)
+            for (const Surface &surface : layerm->fill_surfaces.surfaces) {
+                Polygons polygons = to_polygons(surface.expolygon);
+                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
+                    polygons_append(upper_internals[layer_id], polygons);
+                polygons_append(lower_fill_surfaces[layer_id], std::move(polygons));
+            }
+    };
+    auto collect_overhangs = [this, &overhangs, &lower_fill_surfaces](size_t layer_id) {
+        const Layer *layer = m_layers[layer_id];
         // Detect things that we need to support.
         // Cummulative fill surfaces.
         Polygons fill_surfaces;
         // Solid surfaces to be supported.
-        Polygons overhangs;
+        Polygons &layer_overhangs = overhangs[layer_id];
         for (const LayerRegion *layerm : layer->m_regions)
             for (const Surface &surface : layerm->fill_surfaces.surfaces) {
                 Polygons polygons = to_polygons(surface.expolygon);
                 if (surface.is_solid())
-                    polygons_append(overhangs, polygons);
+                    polygons_append(layer_overhangs, polygons);
                 polygons_append(fill_surfaces, std::move(polygons));
             }
-        Polygons lower_layer_fill_surfaces;
-        Polygons lower_layer_internal_surfaces;
-        for (const LayerRegion *layerm : lower_layer->m_regions)
-            for (const Surface &surface : layerm->fill_surfaces.surfaces) {
-                Polygons polygons = to_polygons(surface.expolygon);
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    polygons_append(lower_layer_internal_surfaces, polygons);
-                polygons_append(lower_layer_fill_surfaces, std::move(polygons));
-            }
         // We also need to support perimeters when there's at least one full unsupported loop
         {
             // Get perimeters area as the difference between slices and fill_surfaces
             // Only consider the area that is not supported by lower perimeters
-            Polygons perimeters = intersection(diff(layer->lslices, fill_surfaces), lower_layer_fill_surfaces);
+            Polygons perimeters = intersection(diff(layer->lslices, fill_surfaces), lower_fill_surfaces[layer_id - 1]);
             // Only consider perimeter areas that are at least one extrusion width thick.
             //FIXME Offset2 eats out from both sides, while the perimeters are create outside in.
             //Should the pw not be half of the current value?
@@ -3570,19 +3603,26 @@ void PrintObject::clip_fill_surfaces()
             for (const LayerRegion *layerm : layer->m_regions)
                 pw = std::min(pw, (float)layerm->flow(frPerimeter).scaled_width());
             // Append such thick perimeters to the areas that need support
-            polygons_append(overhangs, opening(perimeters, pw));
+            polygons_append(layer_overhangs, opening(perimeters, pw));
         }
-        // Merge the new overhangs, find new internal infill.
-        polygons_append(upper_internal, std::move(overhangs));
+    };
+    // Merge the overhangs of layer_id, find new internal infill of the layer below.
+    Polygons upper_internal;
+    auto propagate_overhangs = [&overhangs, &upper_internals, &upper_internal](size_t layer_id) {
+        polygons_append(upper_internal, std::move(overhangs[layer_id]));
         const auto closing_radius = scaled<float>(2.f);
         upper_internal = intersection(
             // Regularize the overhang regions, so that the infill areas will not become excessively jagged.
             smooth_outward(
                 closing(upper_internal, closing_radius, ClipperLib::jtSquare, 0.),
                 scaled<coord_t>(0.1)),
-            lower_layer_internal_surfaces);
-        // Apply new internal infill to regions.
-        for (LayerRegion *layerm : lower_layer->m_regions) {
+            upper_internals[layer_id - 1]);
+        upper_internals[layer_id - 1] = upper_internal;
+    };
+    // Apply new internal infill to regions.
+    auto apply_internal_infill = [this, &upper_internals](size_t layer_id) {
+        const Polygons &upper_internal = upper_internals[layer_id];
+        for (LayerRegion *layerm : m_layers[layer_id]->m_regions) {
             if (layerm->region().config().sparse_infill_density.value == 0)
                 continue;
             Polygons internal;
@@ -3599,6 +3639,28 @@ void PrintObject::clip_fill_surfaces()
             layerm->export_region_fill_surfaces_to_svg_debug("6_clip_fill_surfaces");
 #endif
         }
+    };
+
+    if (m_serial_fill_surfaces) {
+        for (size_t layer_id = 1; layer_id < m_layers.size(); ++ layer_id)
+            collect_lower_surfaces(layer_id - 1);
+    } else {
+        // The layer below layer_id is clipped after its surfaces were collected, thus they may be collected in advance.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_layers.size() - 1),
+            [this, &collect_lower_surfaces](const tbb::blocked_range<size_t> &range) {
+                for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+                    m_print->throw_if_canceled();
+                    collect_lower_surfaces(layer_id);
+                }
+            });
+    }
+    m_print->throw_if_canceled();
+
+    // Proceed top-down, skipping the bottom layer.
+    for (size_t layer_id = m_layers.size() - 1; layer_id > 0; -- layer_id) {
+        collect_overhangs(layer_id);
+        propagate_overhangs(layer_id);
+        apply_internal_infill(layer_id - 1);
         m_print->throw_if_canceled();
     }
 }
@@ -3608,26 +3670,69 @@ void PrintObject::discover_horizontal_shells()
     BOOST_LOG_TRIVIAL(trace) << "discover_horizontal_shells()";
 
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
-        for (size_t i = 0; i < m_layers.size(); ++ i) {
-            m_print->throw_if_canceled();
-            Layer 					*layer  = m_layers[i];
-            LayerRegion             *layerm = layer->regions()[region_id];
+        // Insert a solid internal layer. Mark stInternal surfaces as stInternalSolid.
+        auto mark_extra_solid_infills = [this, region_id](size_t i) {
+            LayerRegion             *layerm = m_layers[i]->regions()[region_id];
             const PrintRegionConfig &region_config = layerm->region().config();
-
             if (!region_config.extra_solid_infills.value.empty() &&
                 check_layer_id_pattern(region_config.extra_solid_infills.value, i)) {
-                // Insert a solid internal layer. Mark stInternal surfaces as stInternalSolid.
                 for (Surface& surface : layerm->fill_surfaces.surfaces)
                     if (surface.surface_type == stInternal)
                         surface.surface_type = stInternalSolid;
             }
+        };
+        // Merge a shell scattered to layer i into its internal solid surfaces.
+        auto apply_internal_solid = [this, region_id](size_t i, Polygons &new_internal_solid) {
+            LayerRegion *layerm = m_layers[i]->regions()[region_id];
+            // internal-solid are the union of the existing internal-solid surfaces
+            // and new ones
+            SurfaceCollection backup = std::move(layerm->fill_surfaces);
+            polygons_append(new_internal_solid, to_polygons(backup.filter_by_type(stInternalSolid)));
+            ExPolygons internal_solid = union_ex(new_internal_solid);
+            // assign new internal-solid surfaces to layer
+            layerm->fill_surfaces.set(internal_solid, stInternalSolid);
+            // subtract intersections from layer surfaces to get resulting internal surfaces
+            Polygons polygons_internal = to_polygons(std::move(internal_solid));
+            ExPolygons internal = diff_ex(backup.filter_by_type(stInternal), polygons_internal, ApplySafetyOffset::Yes);
+            // assign resulting internal surfaces to layer
+            layerm->fill_surfaces.append(internal, stInternal);
+            polygons_append(polygons_internal, to_polygons(std::move(internal)));
+            // assign top and bottom surfaces to layer
+            backup.keep_types({ stTop, stBottom, stBottomBridge });
+            std::vector<SurfacesPtr> top_bottom_groups;
+            backup.group(&top_bottom_groups);
+            for (SurfacesPtr &group : top_bottom_groups)
+                layerm->fill_surfaces.append(
+                    diff_ex(group, polygons_internal),
+                    // Use an existing surface as a template, it carries the bridge angle etc.
+                    *group.front());
+        };
+        // Index of the neighbor layer past the last one, which receives the shells of a top / bottom surface of layer i.
+        auto shell_end = [this, region_id](size_t i, SurfaceType type) {
+            const Layer             *layer         = m_layers[i];
+            const PrintRegionConfig &region_config = layer->regions()[region_id]->region().config();
+            const int      num_solid_layers = (type == stTop) ? region_config.top_shell_layers.value : region_config.bottom_shell_layers.value;
+            const coordf_t print_z          = layer->print_z;
+            const coordf_t bottom_z         = layer->bottom_z();
+            int n = (type == stTop) ? int(i) - 1 : int(i) + 1;
+            while ((type == stTop) ?
+                       (n >= 0                   && (int(i) - n < num_solid_layers ||
+                                                     print_z - m_layers[n]->print_z < region_config.top_shell_thickness.value - EPSILON)) :
+                       (n < int(m_layers.size()) && (n - int(i) < num_solid_layers ||
+                                                     m_layers[n]->bottom_z() - bottom_z < region_config.bottom_shell_thickness.value - EPSILON)))
+                (type == stTop) ? -- n : ++ n;
+            return n;
+        };
+        // Scatter the top / bottom surfaces of layer i to its neighbor layers, emit_shell(n, shell) receives the shells.
+        auto scatter_shells = [this, region_id, &shell_end](size_t i, const std::function<void(size_t, Polygons&&)> &emit_shell) {
+            Layer 					*layer  = m_layers[i];
+            LayerRegion             *layerm = layer->regions()[region_id];
+            const PrintRegionConfig &region_config = layerm->region().config();
 
             // If ensure_vertical_shell_thickness, then the rest has already been performed by discover_vertical_shells().
             if (region_config.ensure_vertical_shell_thickness.value == evstAll)
-                continue;
+                return;
 
-            coordf_t print_z  = layer->print_z;
-            coordf_t bottom_z = layer->bottom_z();
             for (size_t idx_surface_type = 0; idx_surface_type < 3; ++ idx_surface_type) {
                 m_print->throw_if_canceled();
                 SurfaceType type = (idx_surface_type == 0) ? stTop : (idx_surface_type == 1) ? stBottom : stBottomBridge;
@@ -3659,14 +3764,9 @@ void PrintObject::discover_horizontal_shells()
                     continue;
 //                Slic3r::debugf "Layer %d has %s surfaces\n", $i, ($type == stTop) ? 'top' : 'bottom';
 
-                // Scatter top / bottom regions to other layers. Scattering process is inherently serial, it is difficult to parallelize without locking.
-                for (int n = (type == stTop) ? int(i) - 1 : int(i) + 1;
-                	(type == stTop) ?
-                		(n >= 0                   && (int(i) - n < num_solid_layers ||
-                								 	  print_z - m_layers[n]->print_z < region_config.top_shell_thickness.value - EPSILON)) :
-                		(n < int(m_layers.size()) && (n - int(i) < num_solid_layers ||
-                									  m_layers[n]->bottom_z() - bottom_z < region_config.bottom_shell_thickness.value - EPSILON));
-                	(type == stTop) ? -- n : ++ n)
+                // Scatter top / bottom regions to other layers.
+                const int n_end = shell_end(i, type);
+                for (int n = (type == stTop) ? int(i) - 1 : int(i) + 1; n != n_end; (type == stTop) ? -- n : ++ n)
                 {
 //                    Slic3r::debugf "  looking for neighbors on layer %d...\n", $n;
                     // Reference to the lower layer of a TOP surface, or an upper layer of a BOTTOM surface.
@@ -3694,7 +3794,7 @@ void PrintObject::discover_horizontal_shells()
                         // No internal solid needed on this layer. In order to decide whether to continue
                         // searching on the next neighbor (thus enforcing the configured number of solid
                         // layers, use different strategies according to configured infill density:
-                        
+                
                         // Orca: Also use the same strategy if the user has selected to further reduce
                         // the amount of solid infill on walls.
                         if (region_config.sparse_infill_density.value == 0 || region_config.ensure_vertical_shell_thickness.value == evstCriticalOnly || region_config.ensure_vertical_shell_thickness.value == evstNone) {
@@ -3772,32 +3872,74 @@ void PrintObject::discover_horizontal_shells()
                         }
                     }
 
-                    // internal-solid are the union of the existing internal-solid surfaces
-                    // and new ones
-                    SurfaceCollection backup = std::move(neighbor_layerm->fill_surfaces);
-                    polygons_append(new_internal_solid, to_polygons(backup.filter_by_type(stInternalSolid)));
-                    ExPolygons internal_solid = union_ex(new_internal_solid);
-                    // assign new internal-solid surfaces to layer
-                    neighbor_layerm->fill_surfaces.set(internal_solid, stInternalSolid);
-                    // subtract intersections from layer surfaces to get resulting internal surfaces
-                    Polygons polygons_internal = to_polygons(std::move(internal_solid));
-                    ExPolygons internal = diff_ex(backup.filter_by_type(stInternal), polygons_internal, ApplySafetyOffset::Yes);
-                    // assign resulting internal surfaces to layer
-                    neighbor_layerm->fill_surfaces.append(internal, stInternal);
-                    polygons_append(polygons_internal, to_polygons(std::move(internal)));
-                    // assign top and bottom surfaces to layer
-                    backup.keep_types({ stTop, stBottom, stBottomBridge });
-                    std::vector<SurfacesPtr> top_bottom_groups;
-                    backup.group(&top_bottom_groups);
-                    for (SurfacesPtr &group : top_bottom_groups)
-                        neighbor_layerm->fill_surfaces.append(
-                            diff_ex(group, polygons_internal),
-                            // Use an existing surface as a template, it carries the bridge angle etc.
-                            *group.front());
+                    emit_shell(size_t(n), std::move(new_internal_solid));
                 }
-		EXTERNAL:;
+        EXTERNAL:;
             } // foreach type (stTop, stBottom, stBottomBridge)
-        } // for each layer
+        };
+
+        if (m_serial_fill_surfaces) {
+            // The shells are applied as they are found, thus the later layers find their shells against the surfaces
+            // already split by the shells of the earlier layers.
+            for (size_t i = 0; i < m_layers.size(); ++ i) {
+                m_print->throw_if_canceled();
+                mark_extra_solid_infills(i);
+                scatter_shells(i, [&apply_internal_solid](size_t n, Polygons &&shell) { apply_internal_solid(n, shell); });
+            }
+            continue;
+        }
+
+        // The shells of a layer are found against the surfaces of its neighbors already split by the shells of the layers below,
+        // thus two layers are only processed in parallel if the windows of the layers they read and write are disjoint.
+        // windows[i]: the first and the last layer touched by layer i. A layer without top / bottom surfaces scatters nothing,
+        // and it does not gain any, thus its window is the layer itself.
+        std::vector<std::pair<size_t, size_t>> windows(m_layers.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_layers.size()),
+            [this, region_id, &shell_end, &windows](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i) {
+                    const LayerRegion       *layerm        = m_layers[i]->regions()[region_id];
+                    const PrintRegionConfig &region_config = layerm->region().config();
+                    auto has_surfaces = [layerm](SurfaceType type) { return layerm->slices.has(type) || layerm->fill_surfaces.has(type); };
+                    windows[i] = { i, i };
+                    if (region_config.ensure_vertical_shell_thickness.value == evstAll)
+                        continue;
+                    if (region_config.top_shell_layers.value > 0 && has_surfaces(stTop))
+                        windows[i].first = size_t(shell_end(i, stTop) + 1);
+                    if (region_config.bottom_shell_layers.value > 0 && (has_surfaces(stBottom) || has_surfaces(stBottomBridge)))
+                        windows[i].second = size_t(shell_end(i, stBottom) - 1);
+                }
+            });
+        m_print->throw_if_canceled();
+
+        // Each layer goes to the wave following the last wave of the layers below it, which touch its window.
+        std::vector<std::vector<size_t>> waves;
+        {
+            std::vector<size_t> layer_waves(m_layers.size());
+            size_t              max_reach_up = 0;
+            for (size_t i = 0; i < m_layers.size(); ++ i) {
+                size_t wave = 0;
+                for (size_t j = i; j > 0 && j - 1 + max_reach_up >= windows[i].first; -- j)
+                    if (windows[j - 1].second >= windows[i].first)
+                        wave = std::max(wave, layer_waves[j - 1] + 1);
+                layer_waves[i] = wave;
+                max_reach_up   = std::max(max_reach_up, windows[i].second - i);
+                if (wave == waves.size())
+                    waves.emplace_back();
+                waves[wave].emplace_back(i);
+            }
+        }
+
+        for (const std::vector<size_t> &wave : waves) {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, wave.size()),
+                [this, &wave, &mark_extra_solid_infills, &scatter_shells, &apply_internal_solid](const tbb::blocked_range<size_t> &range) {
+                    for (size_t k = range.begin(); k < range.end(); ++ k) {
+                        m_print->throw_if_canceled();
+                        mark_extra_solid_infills(wave[k]);
+                        scatter_shells(wave[k], [&apply_internal_solid](size_t n, Polygons &&shell) { apply_internal_solid(n, shell); });
+                    }
+                });
+            m_print->throw_if_canceled();
+        }
     }     // for each region
 
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
@@ -3868,72 +4010,85 @@ void PrintObject::combine_infill()
             combine[m_layers.size() - 1] = num_layers;
         }
 
+        // The combinations do not share layers, thus they are processed in parallel.
+        std::vector<size_t> combined_layers;
+        for (size_t layer_idx = 0; layer_idx < m_layers.size(); ++ layer_idx)
+            if (combine[layer_idx] > 1)
+                combined_layers.emplace_back(layer_idx);
+
         // loop through layers to which we have assigned layers to combine
-        for (size_t layer_idx = 0; layer_idx < m_layers.size(); ++ layer_idx) {
-            m_print->throw_if_canceled();
-            size_t num_layers = combine[layer_idx];
-			if (num_layers <= 1)
-                continue;
-            // Get all the LayerRegion objects to be combined.
-            std::vector<LayerRegion*> layerms;
-            layerms.reserve(num_layers);
-			for (size_t i = layer_idx + 1 - num_layers; i <= layer_idx; ++ i)
-                layerms.emplace_back(m_layers[i]->regions()[region_id]);
-            // We need to perform a multi-layer intersection, so let's split it in pairs.
-            // Initialize the intersection with the candidates of the lowest layer.
-            ExPolygons intersection = to_expolygons(layerms.front()->fill_surfaces.filter_by_type(surface_type));
-            // Start looping from the second layer and intersect the current intersection with it.
-            for (size_t i = 1; i < layerms.size(); ++ i)
-                intersection = intersection_ex(layerms[i]->fill_surfaces.filter_by_type(surface_type), intersection);
-            double area_threshold = layerms.front()->infill_area_threshold();
-            if (! intersection.empty() && area_threshold > 0.)
-                intersection.erase(std::remove_if(intersection.begin(), intersection.end(),
-                    [area_threshold](const ExPolygon &expoly) { return expoly.area() <= area_threshold; }),
-                    intersection.end());
-            if (intersection.empty())
-                continue;
-//            Slic3r::debugf "  combining %d %s regions from layers %d-%d\n",
-//                scalar(@$intersection),
-//                ($type == stInternal ? 'internal' : 'internal-solid'),
-//                $layer_idx-($every-1), $layer_idx;
-            // intersection now contains the regions that can be combined across the full amount of layers,
-            // so let's remove those areas from all layers.
-            Polygons intersection_with_clearance;
-            intersection_with_clearance.reserve(intersection.size());
-            float clearance_offset =
-                0.5f * layerms.back()->flow(frPerimeter).scaled_width() +
-             // Because fill areas for rectilinear and honeycomb are grown
-             // later to overlap perimeters, we need to counteract that too.
-                ((infill_pattern == ipRectilinear   ||
-                  infill_pattern == ipMonotonic     ||
-                  infill_pattern == ipGrid          ||
-                  infill_pattern == ipLateralLattice     ||
-                  infill_pattern == ipLine          ||
-                  infill_pattern == ipHoneycomb     ||
-                  infill_pattern == ipLateralHoneycomb) ? 1.5f : 0.5f) *
-                    layerms.back()->flow(frSolidInfill).scaled_width();
-            for (ExPolygon &expoly : intersection)
-                polygons_append(intersection_with_clearance, offset(expoly, clearance_offset));
-            for (LayerRegion *layerm : layerms) {
-                Polygons internal = to_polygons(std::move(layerm->fill_surfaces.filter_by_type(surface_type)));
-                layerm->fill_surfaces.remove_type(surface_type);
-                layerm->fill_surfaces.append(diff_ex(internal, intersection_with_clearance), surface_type);
-                if (layerm == layerms.back()) {
-                    // Apply surfaces back with adjusted depth to the uppermost layer.
-                    Surface templ(surface_type, ExPolygon());
-                    templ.thickness = 0.;
-                    for (LayerRegion *layerm2 : layerms)
-                        templ.thickness += layerm2->layer()->height;
-                    templ.thickness_layers = (unsigned short)layerms.size();
-                    layerm->fill_surfaces.append(intersection, templ);
-                } else {
-                    // Save void surfaces.
-                    layerm->fill_surfaces.append(
-                        intersection_ex(internal, intersection_with_clearance),
-                        stInternalVoid);
+        auto combine_layers =
+            [this, region_id, surface_type, infill_pattern, &combine, &combined_layers](const tbb::blocked_range<size_t> &range) {
+                for (size_t combined_layer_idx = range.begin(); combined_layer_idx < range.end(); ++ combined_layer_idx) {
+                    m_print->throw_if_canceled();
+                    size_t layer_idx  = combined_layers[combined_layer_idx];
+                    size_t num_layers = combine[layer_idx];
+                    // Get all the LayerRegion objects to be combined.
+                    std::vector<LayerRegion*> layerms;
+                    layerms.reserve(num_layers);
+                    for (size_t i = layer_idx + 1 - num_layers; i <= layer_idx; ++ i)
+                        layerms.emplace_back(m_layers[i]->regions()[region_id]);
+                    // We need to perform a multi-layer intersection, so let's split it in pairs.
+                    // Initialize the intersection with the candidates of the lowest layer.
+                    ExPolygons intersection = to_expolygons(layerms.front()->fill_surfaces.filter_by_type(surface_type));
+                    // Start looping from the second layer and intersect the current intersection with it.
+                    for (size_t i = 1; i < layerms.size(); ++ i)
+                        intersection = intersection_ex(layerms[i]->fill_surfaces.filter_by_type(surface_type), intersection);
+                    double area_threshold = layerms.front()->infill_area_threshold();
+                    if (! intersection.empty() && area_threshold > 0.)
+                        intersection.erase(std::remove_if(intersection.begin(), intersection.end(),
+                            [area_threshold](const ExPolygon &expoly) { return expoly.area() <= area_threshold; }),
+                            intersection.end());
+                    if (intersection.empty())
+                        continue;
+        //            Slic3r::debugf "  combining %d %s regions from layers %d-%d\n",
+        //                scalar(@$intersection),
+        //                ($type == stInternal ? 'internal' : 'internal-solid'),
+        //                $layer_idx-($every-1), $layer_idx;
+                    // intersection now contains the regions that can be combined across the full amount of layers,
+                    // so let's remove those areas from all layers.
+                    Polygons intersection_with_clearance;
+                    intersection_with_clearance.reserve(intersection.size());
+                    float clearance_offset =
+                        0.5f * layerms.back()->flow(frPerimeter).scaled_width() +
+                     // Because fill areas for rectilinear and honeycomb are grown
+                     // later to overlap perimeters, we need to counteract that too.
+                        ((infill_pattern == ipRectilinear   ||
+                          infill_pattern == ipMonotonic     ||
+                          infill_pattern == ipGrid          ||
+                          infill_pattern == ipLateralLattice     ||
+                          infill_pattern == ipLine          ||
+                          infill_pattern == ipHoneycomb     ||
+                          infill_pattern == ipLateralHoneycomb) ? 1.5f : 0.5f) *
+                            layerms.back()->flow(frSolidInfill).scaled_width();
+                    for (ExPolygon &expoly : intersection)
+                        polygons_append(intersection_with_clearance, offset(expoly, clearance_offset));
+                    for (LayerRegion *layerm : layerms) {
+                        Polygons internal = to_polygons(std::move(layerm->fill_surfaces.filter_by_type(surface_type)));
+                        layerm->fill_surfaces.remove_type(surface_type);
+                        layerm->fill_surfaces.append(diff_ex(internal, intersection_with_clearance), surface_type);
+                        if (layerm == layerms.back()) {
+                            // Apply surfaces back with adjusted depth to the uppermost layer.
+                            Surface templ(surface_type, ExPolygon());
+                            templ.thickness = 0.;
+                            for (LayerRegion *layerm2 : layerms)
+                                templ.thickness += layerm2->layer()->height;
+                            templ.thickness_layers = (unsigned short)layerms.size();
+                            layerm->fill_surfaces.append(intersection, templ);
+                        } else {
+                            // Save void surfaces.
+                            layerm->fill_surfaces.append(
+                                intersection_ex(internal, intersection_with_clearance),
+                                stInternalVoid);
+                        }
+                    }
                 }
-            }
-        }
+            };
+        if (m_serial_fill_surfaces)
+            combine_layers(tbb::blocked_range<size_t>(0, combined_layers.size()));
+        else
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, combined_layers.size()), combine_layers);
+        m_print->throw_if_canceled();
     }
 }
 
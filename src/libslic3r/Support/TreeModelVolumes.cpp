@@ -11,6 +11,7 @@
 
 #include "../BuildVolume.hpp"
 #include "../ClipperUtils.hpp"
+#include "../Exception.hpp"
 #include "../Flow.hpp"
 #include "../Layer.hpp"
 #include "../Point.hpp"
@@ -861,24 +862,78 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
-void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
+TreeModelVolumes::CacheStats TreeModelVolumes::cache_stats() const
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    CacheStats out;
+    for (const RadiusLayerPolygonCache *cache : {
+            &m_collision_cache, &m_collision_cache_holefree, &m_avoidance_cache, &m_avoidance_cache_slow,
+            &m_avoidance_cache_to_model, &m_avoidance_cache_to_model_slow, &m_placeable_areas_cache,
+            &m_avoidance_cache_holefree, &m_avoidance_cache_holefree_to_model,
+            &m_wall_restrictions_cache, &m_wall_restrictions_cache_min })
+        out += cache->stats();
+    return out;
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache::LayerSlot& TreeModelVolumes::RadiusLayerPolygonCache::get_allocate_layer(LayerIndex layer_idx)
+{
+    assert(layer_idx >= 0);
+    if (size_t(layer_idx) >= LAYERS_PER_CHUNK * MAX_CHUNKS)
+        throw RuntimeError("Tree support: Too many layers for the collision cache");
+    std::atomic<Chunk*> &slot  = m_storage->chunks[size_t(layer_idx) / LAYERS_PER_CHUNK];
+    Chunk               *chunk = slot.load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        // Racing threads allocate a chunk each, only the first one to publish it wins.
+        auto fresh = std::make_unique<Chunk>();
+        if (slot.compare_exchange_strong(chunk, fresh.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+            chunk = fresh.release();
     }
+    // Publish the layer count for getMaxCalculatedLayer() and sorted().
+    for (LayerIndex num_layers = m_storage->num_layers.load(std::memory_order_relaxed);
+         num_layers <= layer_idx && ! m_storage->num_layers.compare_exchange_weak(num_layers, layer_idx + 1, std::memory_order_release, std::memory_order_relaxed);) ;
+    return (*chunk)[size_t(layer_idx) % LAYERS_PER_CHUNK];
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons)
+{
+    LayerSlot &layer = this->get_allocate_layer(layer_idx);
+    std::unique_lock<std::shared_mutex> lock(layer.mutex, std::try_to_lock);
+    if (! lock.owns_lock()) {
+        m_storage->inserts_contended.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+    layer.data.emplace(radius, std::move(polygons));
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear()
+{
+    for (std::atomic<Chunk*> &chunk : m_storage->chunks)
+        delete chunk.exchange(nullptr, std::memory_order_relaxed);
+    m_storage->num_layers.store(0, std::memory_order_relaxed);
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_all_but_radius0()
+{
+    for (std::atomic<Chunk*> &chunk : m_storage->chunks)
+        if (Chunk *c = chunk.load(std::memory_order_relaxed); c)
+            for (LayerSlot &layer : *c) {
+                LayerData &l = layer.data;
+                auto begin = l.begin();
+                auto end = l.end();
+                if (begin != end && ++ begin != end)
+                    l.erase(begin, end);
+            }
 }
 
 // For debugging purposes, sorted by layer index, then by radius.
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
-    }
+    for (LayerIndex layer_idx = 0; layer_idx < m_storage->num_layers.load(std::memory_order_acquire); ++ layer_idx)
+        if (const LayerSlot *layer = this->find_layer(layer_idx); layer) {
+            std::shared_lock<std::shared_mutex> lock(layer->mutex);
+            for (auto &radius_polygons : layer->data)
+                out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
+        }
     assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
     return out;
 }
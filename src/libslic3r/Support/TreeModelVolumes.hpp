@@ -9,7 +9,13 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
@@ -169,6 +175,24 @@ public:
 
     Polygon m_bed_area;
 
+    // Counters of the contended lock acquisitions of the RadiusLayerPolygonCaches, reported with the tree support timings.
+    // An acquisition is contended if the lock of a layer was held by another thread at the time of the acquisition.
+    // Only the contended acquisitions are counted, as they wait for the lock anyway, while counting every acquisition
+    // would make the threads contend on the shared counters.
+    struct CacheStats {
+        size_t lookups_contended    { 0 };
+        size_t inserts_contended    { 0 };
+
+        CacheStats& operator+=(const CacheStats &rhs) {
+            lookups_contended += rhs.lookups_contended;
+            inserts_contended += rhs.inserts_contended;
+            return *this;
+        }
+    };
+
+    // Sum of the counters of all the caches since construction, not reset by clear().
+    CacheStats cache_stats() const;
+
 private:
     // Caching polygons for a range of layers.
     class LayerPolygonCache {
@@ -197,43 +221,55 @@ private:
      * \brief Convenience typedef for the keys to the caches
      */
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
+
+    // Read mostly cache of polygons indexed by layer and radius, shared by the threads precalculating and querying
+    // the collision and avoidance areas. Each layer is guarded by a lock of its own, thus threads working on different
+    // layers never wait for each other. The layers are allocated in chunks published atomically, thus looking up
+    // a layer does not take any lock and a layer once allocated stays at the same address.
     class RadiusLayerPolygonCache {
         // Map from radius to Polygons. Cache of one layer collision regions.
-        using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
         // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
+        using LayerData = std::map<coord_t, Polygons>;
+        struct LayerSlot {
+            mutable std::shared_mutex   mutex;
+            LayerData                   data;
+        };
+        static constexpr const size_t   LAYERS_PER_CHUNK = 256;
+        static constexpr const size_t   MAX_CHUNKS       = 1024;
+        using Chunk = std::array<LayerSlot, LAYERS_PER_CHUNK>;
+        struct Storage {
+            ~Storage() { for (std::atomic<Chunk*> &chunk : chunks) delete chunk.load(std::memory_order_relaxed); }
+            std::array<std::atomic<Chunk*>, MAX_CHUNKS> chunks {};
+            // One past the highest layer inserted into.
+            std::atomic<LayerIndex>                     num_layers { 0 };
+            mutable std::atomic<size_t>                 lookups_contended { 0 };
+            std::atomic<size_t>                         inserts_contended { 0 };
+        };
     public:
-        RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        RadiusLayerPolygonCache() : m_storage(std::make_unique<Storage>()) {}
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_storage(std::exchange(rhs.m_storage, std::make_unique<Storage>())) {}
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { std::swap(m_storage, rhs.m_storage); return *this; }
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->insert(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->insert(LayerIndex(d.first), radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->insert(LayerIndex(first_layer_idx ++), radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
-            allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->insert(i ++, radius, std::move(d));
         }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
@@ -241,25 +277,25 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const LayerSlot *layer = this->find_layer(key.second);
+            if (layer == nullptr)
                 return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
+            std::shared_lock<std::shared_mutex> lock = this->lock_shared(*layer);
+            auto it = layer->data.find(key.first);
+            return it == layer->data.end() ? 
                 std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
         }
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
         std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const LayerSlot *layer = this->find_layer(key.second);
+            if (layer == nullptr)
                 return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
+            std::shared_lock<std::shared_mutex> lock = this->lock_shared(*layer);
+            if (layer->data.empty())
                 return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
+            auto it = layer->data.lower_bound(key.first);
+            if (it == layer->data.end() || it->first != key.first) {
+                if (it == layer->data.begin())
                     return {};
                 -- it;
             }
@@ -273,37 +309,49 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
+            auto layer_idx = m_storage->num_layers.load(std::memory_order_acquire) - 1;
             for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
-                    break;
+                if (const LayerSlot *layer = this->find_layer(layer_idx); layer) {
+                    std::shared_lock<std::shared_mutex> lock = this->lock_shared(*layer);
+                    if (layer->data.find(radius) != layer->data.end())
+                        break;
+                }
             // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
-            return layer_idx == 0 ? -1 : layer_idx;
+            return layer_idx <= 0 ? -1 : layer_idx;
         }
 
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
+        // Not thread safe, to be called while no other thread accesses the cache.
+        void clear();
+        void clear_all_but_radius0();
+
+        CacheStats stats() const {
+            return { m_storage->lookups_contended.load(std::memory_order_relaxed), m_storage->inserts_contended.load(std::memory_order_relaxed) };
         }
 
     private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
+        // Returns nullptr if the chunk of the layer was not allocated yet.
+        const LayerSlot*    find_layer(LayerIndex layer_idx) const {
+            if (layer_idx < 0 || size_t(layer_idx) >= LAYERS_PER_CHUNK * MAX_CHUNKS)
+                return nullptr;
+            const Chunk *chunk = m_storage->chunks[size_t(layer_idx) / LAYERS_PER_CHUNK].load(std::memory_order_acquire);
+            return chunk ? &(*chunk)[size_t(layer_idx) % LAYERS_PER_CHUNK] : nullptr;
+        }
+        std::shared_lock<std::shared_mutex> lock_shared(const LayerSlot &layer) const {
+            std::shared_lock<std::shared_mutex> lock(layer.mutex, std::try_to_lock);
+            if (! lock.owns_lock()) {
+                m_storage->lookups_contended.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+            }
+            return lock;
         }
-        void                allocate_layers(size_t num_layers);
+        void                insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons);
+        LayerSlot&          get_allocate_layer(LayerIndex layer_idx);
 
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+        // Never null, the storage is swapped on move, thus a moved from cache is empty.
+        std::unique_ptr<Storage> m_storage;
     };
 
 
@@ -3523,13 +3523,16 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
             auto dur_place = 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_place - t_path).count();
             auto dur_draw = 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_draw - t_place).count();
             auto dur_total = 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_draw - t_start).count();
+            TreeModelVolumes::CacheStats cache_stats = volumes.cache_stats();
             BOOST_LOG_TRIVIAL(info) <<
                 "Total time used creating Tree support for the currently grouped meshes: " << dur_total << " ms. "
                 "Different subtasks:\nCalculating Avoidance: " << dur_pre_gen << " ms "
                 "Creating inital influence areas: " << dur_gen << " ms "
                 "Influence area creation: " << dur_path << "ms "
                 "Placement of Points in InfluenceAreas: " << dur_place << "ms "
-                "Drawing result as support " << dur_draw << " ms";
+                "Drawing result as support " << dur_draw << " ms\n"
+                "Collision and avoidance caches: " << cache_stats.lookups_contended << " contended lookups, " <<
+                cache_stats.inserts_contended << " contended inserts";
     //        if (config.branch_radius==2121)
     //            BOOST_LOG_TRIVIAL(error) << "Why ask questions when you already know the answer twice.\n (This is not a real bug, please dont report it.)";
             
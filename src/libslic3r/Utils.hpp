@@ -72,6 +72,7 @@
 #define CLI_SLICING_ERROR                  -100
 #define CLI_GCODE_PATH_CONFLICTS           -101
 #define CLI_GCODE_PATH_IN_UNPRINTABLE_AREA -102
+#define CLI_EXPORT_QUOTE_ERROR             -103
 
 
 namespace boost { namespace filesystem { class directory_entry; }}
@@ -689,6 +690,8 @@ inline std::string get_bbl_remain_time_dhms(float time_in_secs)
 }
 
 bool bbl_calc_md5(std::string &filename, std::string &md5_out);
+// Finishes the MD5 context, returns the digest as 32 lower case hexadecimal digits.
+std::string md5_final_hex(MD5_CTX &ctx);
 
 inline std::string filter_characters(const std::string& str, const std::string& filterChars)
 {
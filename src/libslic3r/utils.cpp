@@ -1555,6 +1555,16 @@ bool bbl_calc_md5(std::string &filename, std::string &md5_out)
     return true;
 }
 
+std::string md5_final_hex(MD5_CTX &ctx)
+{
+    unsigned char digest[16];
+    MD5_Final(digest, &ctx);
+    char key[33];
+    for (int i = 0; i < 16; ++ i)
+        sprintf(&key[i * 2], "%02x", (unsigned int) digest[i]);
+    return std::string(key, 32);
+}
+
 // SoftFever: copy directory recursively
 void copy_directory_recursively(const boost::filesystem::path &source, const boost::filesystem::path &target, std::function<bool(const std::string)> filter)
 {
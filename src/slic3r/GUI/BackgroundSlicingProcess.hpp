@@ -84,7 +84,8 @@ public:
 	// Stop the background processing and finalize the bacgkround processing thread, remove temp files.
 	~BackgroundSlicingProcess();
 
-	void set_fff_print(Print *print) { m_fff_print = print; }
+	// The G-code is exported again after each change, let the export regenerate the changed layers only.
+	void set_fff_print(Print *print) { m_fff_print = print; if (print) print->enable_gcode_export_cache(true); }
     void set_sla_print(SLAPrint *print) { m_sla_print = print; m_sla_print->set_printer(&m_sla_archive); }
 	void set_thumbnail_cb(ThumbnailsGeneratorCallback cb) { m_thumbnail_cb = cb; }
 	void set_gcode_result(GCodeProcessorResult* result) { m_gcode_result = result; }
@@ -484,8 +484,8 @@ void GCodeViewer::SequentialView::Marker::render(int canvas_width, int canvas_he
 
 void GCodeViewer::SequentialView::GCodeWindow::load_gcode(const std::string& filename, const std::vector<size_t> &lines_ends)
 {
-    assert(! m_file.is_open());
-    if (m_file.is_open())
+    assert(! m_file.is_open() && ! m_binary_reader);
+    if (m_file.is_open() || m_binary_reader)
         return;
 
     m_filename   = filename;
@@ -496,8 +496,13 @@ void GCodeViewer::SequentialView::GCodeWindow::load_gcode(const std::string& fil
 
     try
     {
-        m_file.open(boost::filesystem::path(m_filename));
-        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": mapping file " << m_filename;
+        if (BinaryGCodeReader::is_binary_gcode(m_filename)) {
+            m_binary_reader = std::make_unique<BinaryGCodeReader>(m_filename);
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": reading binary G-code " << m_filename;
+        } else {
+            m_file.open(boost::filesystem::path(m_filename));
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": mapping file " << m_filename;
+        }
     }
     catch (...)
     {
@@ -514,12 +519,22 @@ void GCodeViewer::SequentialView::GCodeWindow::render(float top, float bottom, f
     auto update_lines = [this](uint64_t start_id, uint64_t end_id) {
         std::vector<Line> ret;
         ret.reserve(end_id - start_id + 1);
+        // Text of the visible lines, a binary G-code decompresses just the blocks holding them.
+        const size_t     text_start = start_id <= 1 ? 0 : m_lines_ends[start_id - 2];
+        const size_t     text_size  = m_lines_ends[end_id - 1] - text_start;
+        std::string      binary_text;
+        std::string_view text;
+        if (m_binary_reader) {
+            binary_text = m_binary_reader->gcode_text(text_start, text_size);
+            text        = binary_text;
+        } else
+            text = std::string_view(m_file.data() + text_start, text_size);
         for (uint64_t id = start_id; id <= end_id; ++id) {
             // read line from file
             const size_t start        = id == 1 ? 0 : m_lines_ends[id - 2];
             const size_t original_len = m_lines_ends[id - 1] - start;
             const size_t len          = std::min(original_len, (size_t) 55);
-            std::string  gline(m_file.data() + start, len);
+            std::string  gline(text.substr(start - text_start, len));
 
             // If original line is longer than 55 characters, truncate and append "..."
             if (original_len > 55)
@@ -676,6 +691,7 @@ void GCodeViewer::SequentialView::GCodeWindow::stop_mapping_file()
         m_file.close();
         BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": finished mapping file " << m_filename;
     }
+    m_binary_reader.reset();
 }
 void GCodeViewer::SequentialView::render(const bool has_render_path, float legend_height, int canvas_width, int canvas_height, int right_margin, const EViewType& view_type)
 {
@@ -2077,7 +2093,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
     };
 
     // format data into the buffers to be rendered as lines
-    auto add_vertices_as_line = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, VertexBuffer& vertices) {
+    auto add_vertices_as_line = [&gcode_result](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, VertexBuffer& vertices) {
         auto add_vertex = [&vertices](const Vec3f& position) {
             // add position
             vertices.push_back(position.x());
@@ -2086,10 +2102,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
         };
         // x component of the normal to the current segment (the normal is parallel to the XY plane)
         //BBS: Has modified a lot for this function to support arc move
-        size_t loop_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points.size() : 0;
+        const GCodeProcessorResult::InterpolationPoints interpolation_points = gcode_result.interpolation_points(curr);
+        size_t loop_num = curr.is_arc_move_with_interpolation_points() ? interpolation_points.size() : 0;
         for (size_t i = 0; i < loop_num + 1; i++) {
-            const Vec3f &previous = (i == 0? prev.position : curr.interpolation_points[i-1]);
-            const Vec3f &current = (i == loop_num? curr.position : curr.interpolation_points[i]);
+            const Vec3f &previous = (i == 0? prev.position : interpolation_points[i-1]);
+            const Vec3f &current = (i == loop_num? curr.position : interpolation_points[i]);
             // add previous vertex
             add_vertex(previous);
             // add current vertex
@@ -2097,7 +2114,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
         }
     };
     //BBS: modify a lot to support arc travel
-    auto add_indices_as_line = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_line = [&gcode_result](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer,
         size_t& vbuffer_size, unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
 
             if (buffer.paths.empty() || prev.type != curr.type || !buffer.paths.back().matches(curr)) {
@@ -2106,7 +2123,8 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
             }
 
             Path& last_path = buffer.paths.back();
-            size_t loop_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points.size() : 0;
+            const GCodeProcessorResult::InterpolationPoints interpolation_points = gcode_result.interpolation_points(curr);
+            size_t loop_num = curr.is_arc_move_with_interpolation_points() ? interpolation_points.size() : 0;
             for (size_t i = 0; i < loop_num + 1; i++) {
                 //BBS: add previous index
                 indices.push_back(static_cast<IBufferType>(indices.size()));
@@ -2118,7 +2136,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
     };
 
     // format data into the buffers to be rendered as solid.
-    auto add_vertices_as_solid = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer, unsigned int vbuffer_id, VertexBuffer& vertices, size_t move_id) {
+    auto add_vertices_as_solid = [&gcode_result](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer, unsigned int vbuffer_id, VertexBuffer& vertices, size_t move_id) {
         auto store_vertex = [](VertexBuffer& vertices, const Vec3f& position, const Vec3f& normal) {
             // append position
             vertices.push_back(position.x());
@@ -2137,10 +2155,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
 
         Path& last_path = buffer.paths.back();
         //BBS: Has modified a lot for this function to support arc move
-        size_t loop_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points.size() : 0;
+        const GCodeProcessorResult::InterpolationPoints interpolation_points = gcode_result.interpolation_points(curr);
+        size_t loop_num = curr.is_arc_move_with_interpolation_points() ? interpolation_points.size() : 0;
         for (size_t i = 0; i < loop_num + 1; i++) {
-            const Vec3f &prev_position = (i == 0? prev.position : curr.interpolation_points[i-1]);
-            const Vec3f &curr_position = (i == loop_num? curr.position : curr.interpolation_points[i]);
+            const Vec3f &prev_position = (i == 0? prev.position : interpolation_points[i-1]);
+            const Vec3f &curr_position = (i == loop_num? curr.position : interpolation_points[i]);
 
             const Vec3f dir = (curr_position - prev_position).normalized();
             const Vec3f right = Vec3f(dir.y(), -dir.x(), 0.0f).normalized();
@@ -2231,10 +2250,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
             std::array<IBufferType, 8> first_seg_v_offsets = convert_vertices_offset(vbuffer_size, { 0, 1, 2, 3, 4, 5, 6, 7 });
             std::array<IBufferType, 8> non_first_seg_v_offsets = convert_vertices_offset(vbuffer_size, { -4, 0, -2, 1, 2, 3, 4, 5 });
 
-            size_t loop_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points.size() : 0;
+            const GCodeProcessorResult::InterpolationPoints interpolation_points = gcode_result.interpolation_points(curr);
+            size_t loop_num = curr.is_arc_move_with_interpolation_points() ? interpolation_points.size() : 0;
             for (size_t i = 0; i < loop_num + 1; i++) {
-                const Vec3f &prev_position = (i == 0? prev.position : curr.interpolation_points[i-1]);
-                const Vec3f &curr_position = (i == loop_num? curr.position : curr.interpolation_points[i]);
+                const Vec3f &prev_position = (i == 0? prev.position : interpolation_points[i-1]);
+                const Vec3f &curr_position = (i == loop_num? curr.position : interpolation_points[i]);
 
                 const Vec3f dir = (curr_position - prev_position).normalized();
                 const Vec3f right = Vec3f(dir.y(), -dir.x(), 0.0f).normalized();
@@ -2417,14 +2437,14 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
 
         //if (wxGetApp().is_gcode_viewer())
         //if (m_only_gcode_in_preview)
-        //    for (int i = 0; i < move.interpolation_points.size(); i++)
-        //        m_paths_bounding_box.merge(move.interpolation_points[i].cast<double>());
+        //    for (const Vec3f& point : gcode_result.interpolation_points(move))
+        //        m_paths_bounding_box.merge(point.cast<double>());
         //else {
             if (move.type == EMoveType::Extrude && move.width != 0.0f && move.height != 0.0f)
-                for (int i = 0; i < move.interpolation_points.size(); i++) {
-                    m_paths_bounding_box.merge(move.interpolation_points[i].cast<double>());
+                for (const Vec3f& point : gcode_result.interpolation_points(move)) {
+                    m_paths_bounding_box.merge(point.cast<double>());
                     //BBS: use convex_hull for toolpath outside check
-                    pts.emplace_back(Point(scale_(move.interpolation_points[i].x()), scale_(move.interpolation_points[i].y())));
+                    pts.emplace_back(Point(scale_(point.x()), scale_(point.y())));
                 }
         //}
     }
@@ -2524,7 +2544,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
         // if adding the vertices for the current segment exceeds the threshold size of the current vertex buffer
         // add another vertex buffer
         // BBS: get the point number and then judge whether the remaining buffer is enough
-        size_t points_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points.size() + 1 : 1;
+        size_t points_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points_count + 1 : 1;
         size_t vertices_size_to_add = (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::BatchedModel) ? t_buffer.model.data.vertices_size_bytes() : points_num * t_buffer.max_vertices_per_segment_size_bytes();
         if (v_multibuffer.back().size() * sizeof(float) > t_buffer.vertices.max_size_bytes() - vertices_size_to_add) {
             v_multibuffer.push_back(VertexBuffer());
@@ -2611,11 +2631,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
                 size_t temp_offset = prev_sub_path.last.s_id - curr_s_id;
                 for (size_t i = prev_sub_path.last.s_id; i > curr_s_id; i--) {
                     size_t move_id = m_ssid_to_moveid_map[i];
-                    temp_offset += (gcode_result.moves[move_id].is_arc_move() ? gcode_result.moves[move_id].interpolation_points.size() : 0);
+                    temp_offset += (gcode_result.moves[move_id].is_arc_move() ? gcode_result.moves[move_id].interpolation_points_count : 0);
                 }
                 if (is_internal_point) {
                     size_t move_id = m_ssid_to_moveid_map[curr_s_id];
-                    temp_offset += (gcode_result.moves[move_id].interpolation_points.size() - interpolation_point_id);
+                    temp_offset += (gcode_result.moves[move_id].interpolation_points_count - interpolation_point_id);
                 }
                 const size_t next_1st_offset = temp_offset * 6 * vertex_size_floats;
                 // offset into the vertex buffer of the right vertex of the previous segment
@@ -2653,11 +2673,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
                 size_t temp_offset = prev_sub_path.last.s_id - curr_s_id;
                 for (size_t i = prev_sub_path.last.s_id; i > curr_s_id; i--) {
                     size_t move_id = m_ssid_to_moveid_map[i];
-                    temp_offset += (gcode_result.moves[move_id].is_arc_move() ? gcode_result.moves[move_id].interpolation_points.size() : 0);
+                    temp_offset += (gcode_result.moves[move_id].is_arc_move() ? gcode_result.moves[move_id].interpolation_points_count : 0);
                 }
                 if (is_internal_point) {
                     size_t move_id = m_ssid_to_moveid_map[curr_s_id];
-                    temp_offset += (gcode_result.moves[move_id].interpolation_points.size() - interpolation_point_id);
+                    temp_offset += (gcode_result.moves[move_id].interpolation_points_count - interpolation_point_id);
                 }
                 const size_t next_1st_offset = temp_offset * 6 * vertex_size_floats;
                 // offset into the vertex buffer of the left vertex of the previous segment
@@ -2700,7 +2720,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
                 size_t curr_s_id = path.sub_paths.front().first.s_id + j;
                 size_t move_id = m_ssid_to_moveid_map[curr_s_id];
                 int interpolation_points_num = gcode_result.moves[move_id].is_arc_move_with_interpolation_points()?
-                                                    gcode_result.moves[move_id].interpolation_points.size() : 0;
+                                                    gcode_result.moves[move_id].interpolation_points_count : 0;
                 int loop_num = interpolation_points_num;
                 //BBS: select the subpaths which contains the previous/next segments
                 if (!path.sub_paths[prev_sub_path_id].contains(curr_s_id))
@@ -2721,15 +2741,15 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
                 for (int k = 0; k <= loop_num; k++) {
                     const Vec3f& prev = k==0?
                                         gcode_result.moves[move_id - 1].position :
-                                        gcode_result.moves[move_id].interpolation_points[k-1];
+                                        gcode_result.interpolation_points(gcode_result.moves[move_id])[k-1];
                     const Vec3f& curr = k==interpolation_points_num?
                                         gcode_result.moves[move_id].position :
-                                        gcode_result.moves[move_id].interpolation_points[k];
+                                        gcode_result.interpolation_points(gcode_result.moves[move_id])[k];
                     const Vec3f& next = k < interpolation_points_num - 1?
-                                        gcode_result.moves[move_id].interpolation_points[k+1]:
+                                        gcode_result.interpolation_points(gcode_result.moves[move_id])[k+1]:
                                         (k == interpolation_points_num - 1? gcode_result.moves[move_id].position :
                                         (gcode_result.moves[move_id + 1].is_arc_move_with_interpolation_points()?
-                                        gcode_result.moves[move_id + 1].interpolation_points[0] :
+                                        gcode_result.interpolation_points(gcode_result.moves[move_id + 1])[0] :
                                         gcode_result.moves[move_id + 1].position));
 
                     const Vec3f prev_dir = (curr - prev).normalized();
@@ -2921,7 +2941,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result, const
         // if adding the indices for the current segment exceeds the threshold size of the current index buffer
         // create another index buffer
         // BBS: get the point number and then judge whether the remaining buffer is enough
-        size_t points_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points.size() + 1 : 1;
+        size_t points_num = curr.is_arc_move_with_interpolation_points() ? curr.interpolation_points_count + 1 : 1;
         size_t indiced_size_to_add = (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::BatchedModel) ? t_buffer.model.data.indices_size_bytes() : points_num * t_buffer.max_indices_per_segment_size_bytes();
         if (i_multibuffer.back().size() * sizeof(IBufferType) >= IBUFFER_THRESHOLD_BYTES - indiced_size_to_add) {
             i_multibuffer.push_back(IndexBuffer());
@@ -3450,7 +3470,7 @@ m_no_render_path = false;
                                     size_t move_id = m_ssid_to_moveid_map[i];
                                     const GCodeProcessorResult::MoveVertex& curr = m_gcode_result->moves[move_id];
                                     if (curr.is_arc_move()) {
-                                        offset += curr.interpolation_points.size();
+                                        offset += curr.interpolation_points_count;
                                     }
                                 }
                                 offset = 2 * offset - 1;
@@ -3462,7 +3482,7 @@ m_no_render_path = false;
                                     size_t move_id = m_ssid_to_moveid_map[i];
                                     const GCodeProcessorResult::MoveVertex& curr = m_gcode_result->moves[move_id];
                                     if (curr.is_arc_move()) {
-                                        offset += curr.interpolation_points.size();
+                                        offset += curr.interpolation_points_count;
                                     }
                                 }
                                 offset = indices_count * (offset - 1) + (indices_count - 2);
@@ -3563,7 +3583,7 @@ m_no_render_path = false;
                 size_t move_id = m_ssid_to_moveid_map[i];
                 const GCodeProcessorResult::MoveVertex& curr = m_gcode_result->moves[move_id];
                 if (curr.is_arc_move()) {
-                    segments_count += curr.interpolation_points.size();
+                    segments_count += curr.interpolation_points_count;
                 }
             }
             size_in_indices = buffer.indices_per_segment() * segments_count;
@@ -2,6 +2,7 @@
 #define slic3r_GCodeViewer_hpp_
 
 #include "3DScene.hpp"
+#include "libslic3r/GCode/BinaryGCode.hpp"
 #include "libslic3r/GCode/GCodeProcessor.hpp"
 #include "libslic3r/GCode/ThumbnailData.hpp"
 #include "IMSlider.hpp"
@@ -644,6 +645,8 @@ public:
             size_t m_last_lines_size{ 0 };
             std::string m_filename;
             boost::iostreams::mapped_file_source m_file;
+            // Opened instead of mapping the file for a binary G-code, the line ends are offsets into its G-code text.
+            std::unique_ptr<BinaryGCodeReader> m_binary_reader;
             // map for accessing data in file by line number
             std::vector<size_t> m_lines_ends;
             // current visible lines
@@ -9,23 +9,85 @@
 #include <wx/txtstrm.h>
 #include <sstream>
 #include <iomanip>
-#include <regex>
 #include <numeric>
+#include <set>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
 
 #include "I18N.hpp"
+#include "GUI.hpp"
 #include "GUI_App.hpp"
+#include "GLToolbar.hpp"
+#include "PartPlate.hpp"
+#include "Plater.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/AppConfig.hpp"
+#include "libslic3r/InvoiceJobStore.hpp"
 #include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/Utils.hpp"
 
 namespace Slic3r {
 namespace GUI {
 
-InvoiceDialog::InvoiceDialog(wxWindow* parent, const PrintStatistics* stats)
+// Job profiles used to be stored as "invoice_job_<profile>_<field>" keys of the "app" section of AppConfig
+// with the list of profiles in "invoice_profiles", move them into the store once.
+static void migrate_legacy_job_profiles(AppConfig &config, InvoiceJobStore &store)
+{
+    const std::string profiles = config.get("invoice_profiles");
+    if (profiles.empty())
+        return;
+
+    static const std::set<std::string> string_fields { "customer_name", "customer_email", "customer_phone", "job_name", "job_description" };
+    const std::map<std::string, std::string> &app = config.get_section("app");
+    std::vector<std::string> legacy_keys;
+    std::stringstream ss(profiles);
+    std::string profile_name;
+    while (std::getline(ss, profile_name, ';')) {
+        if (profile_name.empty() || store.has(profile_name))
+            continue;
+        const std::string prefix = "invoice_job_" + profile_name + "_";
+        nlohmann::json j = nlohmann::json::object();
+        for (auto it = app.lower_bound(prefix); it != app.end() && boost::starts_with(it->first, prefix); ++ it) {
+            const std::string field = it->first.substr(prefix.size());
+            if (string_fields.count(field))
+                j[field] = it->second;
+            else if (! it->second.empty()) {
+                try {
+                    j[field] = std::stod(it->second);
+                } catch (const std::exception &) {
+                }
+            }
+            legacy_keys.emplace_back(it->first);
+        }
+        store.save(profile_name, invoice_job_profile_from_json(j));
+    }
+    for (const std::string &key : legacy_keys)
+        config.erase("app", key);
+    config.erase("app", "invoice_profiles");
+    config.save();
+    BOOST_LOG_TRIVIAL(info) << "Moved " << store.size() << " invoice job profiles to " << store.path();
+}
+
+static InvoiceJobStore& invoice_job_store()
+{
+    static InvoiceJobStore store = []() {
+        InvoiceJobStore job_store((boost::filesystem::path(data_dir()) / "invoice" / "job_profiles.jsonl").string());
+        if (AppConfig *config = wxGetApp().app_config)
+            migrate_legacy_job_profiles(*config, job_store);
+        return job_store;
+    }();
+    return store;
+}
+
+InvoiceDialog::InvoiceDialog(wxWindow* parent, const PrintStatistics* stats, const GCodeProcessorResult* gcode_result,
+                             const std::map<int, std::string>& object_names)
     : DPIDialog(parent, wxID_ANY, _L("Invoice Generator - 3D Print Cost Calculator"),
                 wxDefaultPosition, wxSize(900, 800),
                 wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER)
     , m_stats(stats)
+    , m_plates_timer(this)
 {
     SetFont(wxGetApp().normal_font());
     
@@ -33,31 +95,9 @@ InvoiceDialog::InvoiceDialog(wxWindow* parent, const PrintStatistics* stats)
     wxGetApp().UpdateDarkUI(this);
 #endif
 
-    // Initialize default job profile
-    m_current_job.parts_per_plate = 1;
-    m_current_job.num_plates = 1;
-    m_current_job.failure_rate = 5.0;
-    m_current_job.labor_rate = 20.0;
-    m_current_job.prep_time = 15.0;
-    m_current_job.setup_time = 10.0;
-    m_current_job.finishing_per_part = 5.0;
-    m_current_job.finishing_per_plate = 0.0;
-    m_current_job.printer_cost = 300.0;
-    m_current_job.printer_lifespan = 15000.0;
-    m_current_job.maintenance_cost = 0.10;
-    m_current_job.power_watts = 130.0;
-    m_current_job.electricity_cost = 0.15;
-    m_current_job.bed_cost = 30.0;
-    m_current_job.bed_lifespan = 5000.0;
-    m_current_job.nozzle_cost = 2.0;
-    m_current_job.nozzle_lifespan_kg = 25.0;
-    m_current_job.solvent_cost = 0.0;
-    m_current_job.solving_time = 0.0;
-    m_current_job.tank_power = 0.0;
-    m_current_job.finishing_materials = 0.0;
-    m_current_job.markup_percent = 50.0;
-
     populate_filament_data();
+    if (gcode_result)
+        m_object_usage = invoice_object_usage(*gcode_result, object_names);
     build_ui();
     load_global_settings();
     
@@ -81,23 +121,6 @@ wxString InvoiceDialog::format_time(const std::string& time_str) const
     return wxString::FromUTF8(time_str);
 }
 
-double InvoiceDialog::parse_time_to_hours(const std::string& time_str) const
-{
-    double hours = 0.0;
-    std::regex day_regex("(\\d+)\\s*d");
-    std::regex hour_regex("(\\d+)\\s*h");
-    std::regex min_regex("(\\d+)\\s*m");
-    std::regex sec_regex("(\\d+)\\s*s");
-    std::smatch match;
-    
-    if (std::regex_search(time_str, match, day_regex)) hours += std::stod(match[1]) * 24.0;
-    if (std::regex_search(time_str, match, hour_regex)) hours += std::stod(match[1]);
-    if (std::regex_search(time_str, match, min_regex)) hours += std::stod(match[1]) / 60.0;
-    if (std::regex_search(time_str, match, sec_regex)) hours += std::stod(match[1]) / 3600.0;
-    
-    return hours;
-}
-
 void InvoiceDialog::populate_filament_data()
 {
     m_filament_data.clear();
@@ -106,78 +129,9 @@ void InvoiceDialog::populate_filament_data()
     PresetBundle* presets = wxGetApp().preset_bundle;
     if (!presets) return;
 
-    for (auto const& [extruder_id, usage] : m_stats->filament_stats) {
-        FilamentData data;
-        data.extruder_id = extruder_id;
-        
-        std::string filament_name = "Unknown";
-        std::string color = "#808080";
-        double cost_per_kg = 20.0;
-        double density = 1.24;
-        double diameter = 1.75;
-        
-        auto get_val = [&](const std::string& key, size_t idx) -> std::string {
-            auto opt = presets->project_config.option(key);
-            if (!opt) return "";
-
-            if (auto opt_str = dynamic_cast<const ConfigOptionStrings*>(opt)) {
-                if (idx < opt_str->values.size()) return opt_str->values[idx];
-            }
-            else if (auto opt_floats = dynamic_cast<const ConfigOptionFloats*>(opt)) {
-                if (idx < opt_floats->values.size()) return std::to_string(opt_floats->values[idx]);
-            }
-            else if (auto opt_ints = dynamic_cast<const ConfigOptionInts*>(opt)) {
-                if (idx < opt_ints->values.size()) return std::to_string(opt_ints->values[idx]);
-            }
-            return "";
-        };
-
-        if (extruder_id < presets->filament_presets.size()) {
-            filament_name = presets->filament_presets[extruder_id];
-        } else {
-            filament_name = "Filament " + std::to_string(extruder_id + 1);
-        }
-        
-        std::string col = get_val("filament_colour", extruder_id);
-        if (!col.empty()) color = col;
-        
-        std::string cost_str = get_val("filament_cost", extruder_id);
-        if (!cost_str.empty()) cost_per_kg = std::stod(cost_str);
-        
-        std::string dens_str = get_val("filament_density", extruder_id);
-        if (!dens_str.empty()) density = std::stod(dens_str);
-        
-        std::string diam_str = get_val("filament_diameter", extruder_id);
-        if (!diam_str.empty()) diameter = std::stod(diam_str);
-        
-        data.name = filament_name;
-        data.color = color;
-        data.cost_per_kg = cost_per_kg;
-        
-        double radius = diameter / 2.0;
-        double area = 3.14159265359 * radius * radius;
-        double volume_mm3 = usage * area; 
-        data.weight_g = volume_mm3 * density / 1000.0; 
-        
-        if (m_stats->filament_stats.size() == 1 && m_stats->total_weight > 0) {
-             data.weight_g = m_stats->total_weight;
-        }
-
-        data.calculated_cost = (data.weight_g / 1000.0) * data.cost_per_kg;
-        
-        m_filament_data.push_back(data);
-    }
-    
-    if (m_filament_data.empty() && m_stats->total_weight > 0) {
-        FilamentData data;
-        data.extruder_id = 0;
-        data.name = "Default Filament";
-        data.color = "#808080";
-        data.weight_g = m_stats->total_weight;
-        data.cost_per_kg = 20.0;
-        data.calculated_cost = (data.weight_g / 1000.0) * data.cost_per_kg;
-        m_filament_data.push_back(data);
-    }
+    m_filament_data = invoice_filament_usage(*m_stats, presets->project_config, presets->filament_presets);
+    for (auto& data : m_filament_data)
+        data.cost = (data.weight_g / 1000.0) * data.cost_per_kg;
 }
 
 void InvoiceDialog::build_ui()
@@ -195,6 +149,8 @@ void InvoiceDialog::build_ui()
     build_postprocess_tab(notebook);
     build_markup_tab(notebook);
     build_results_tab(notebook);
+    if (m_object_usage.size() > 1)
+        build_objects_tab(notebook);
     
     main_sizer->Add(notebook, 1, wxEXPAND | wxALL, 5);
     
@@ -285,6 +241,16 @@ void InvoiceDialog::build_job_info_tab(wxNotebook* notebook)
     m_failure_rate = new wxSpinCtrlDouble(panel, wxID_ANY, "5.0", wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0.0, 50.0, 5.0, 1.0);
     grid->Add(m_failure_rate, 1, wxEXPAND);
     
+    grid->Add(new wxStaticText(panel, wxID_ANY, _L("Project:")), 0, wxALIGN_CENTER_VERTICAL);
+    m_chk_all_plates = new wxCheckBox(panel, wxID_ANY, _L("Quote all plates"));
+    m_chk_all_plates->SetToolTip(_L("Price every plate of the project with its own print time, filament and number of parts, "
+                                    "instead of multiplying the current plate. Plates which are not sliced yet are sliced in the background."));
+    grid->Add(m_chk_all_plates, 1, wxEXPAND);
+    
+    grid->AddSpacer(0);
+    m_lbl_plates_status = new wxStaticText(panel, wxID_ANY, "");
+    grid->Add(m_lbl_plates_status, 1, wxEXPAND);
+    
     sizer->Add(grid, 1, wxEXPAND | wxALL, 10);
     
     wxStaticBoxSizer* stats_box = new wxStaticBoxSizer(wxVERTICAL, panel, _L("Slicer Statistics"));
@@ -304,6 +270,9 @@ void InvoiceDialog::build_job_info_tab(wxNotebook* notebook)
     
     panel->SetSizer(sizer);
     notebook->AddPage(panel, _L("Job Parameters"));
+    
+    m_chk_all_plates->Bind(wxEVT_CHECKBOX, &InvoiceDialog::on_quote_all_plates, this);
+    Bind(wxEVT_TIMER, &InvoiceDialog::on_plates_timer, this);
 }
 
 void InvoiceDialog::build_materials_tab(wxNotebook* notebook)
@@ -493,6 +462,48 @@ void InvoiceDialog::build_results_tab(wxNotebook* notebook)
     notebook->AddPage(panel, _L("Results"));
 }
 
+void InvoiceDialog::build_objects_tab(wxNotebook* notebook)
+{
+    wxPanel* panel = new wxPanel(notebook);
+    wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
+
+    m_objects_grid = new wxGrid(panel, wxID_ANY);
+    m_objects_grid->CreateGrid(0, 6);
+    m_objects_grid->SetColLabelValue(0, _L("Object"));
+    m_objects_grid->SetColLabelValue(1, _L("Weight (g)"));
+    m_objects_grid->SetColLabelValue(2, _L("Print Time (h)"));
+    m_objects_grid->SetColLabelValue(3, _L("Material Cost"));
+    m_objects_grid->SetColLabelValue(4, _L("Subtotal"));
+    m_objects_grid->SetColLabelValue(5, _L("Price"));
+    m_objects_grid->EnableEditing(false);
+
+    sizer->Add(new wxStaticText(panel, wxID_ANY, _L("Share of the plate cost of every object, including its share of flushes and of the wipe tower.")), 0, wxALL, 10);
+    sizer->Add(m_objects_grid, 1, wxEXPAND | wxALL, 10);
+
+    panel->SetSizer(sizer);
+    notebook->AddPage(panel, _L("Objects"));
+}
+
+void InvoiceDialog::update_objects_grid()
+{
+    if (m_objects_grid == nullptr)
+        return;
+    if (m_objects_grid->GetNumberRows() > 0)
+        m_objects_grid->DeleteRows(0, m_objects_grid->GetNumberRows());
+
+    m_objects_grid->AppendRows(m_object_costs.size());
+    for (size_t i = 0; i < m_object_costs.size(); ++i) {
+        const auto& cost = m_object_costs[i];
+        m_objects_grid->SetCellValue(i, 0, wxString::FromUTF8(cost.name));
+        m_objects_grid->SetCellValue(i, 1, wxString::Format("%.2f", cost.weight_g));
+        m_objects_grid->SetCellValue(i, 2, wxString::Format("%.2f", cost.print_time_hours));
+        m_objects_grid->SetCellValue(i, 3, wxString::Format("$%.2f", cost.material_cost));
+        m_objects_grid->SetCellValue(i, 4, wxString::Format("$%.2f", cost.subtotal));
+        m_objects_grid->SetCellValue(i, 5, wxString::Format("$%.2f", cost.price));
+    }
+    m_objects_grid->AutoSizeColumns();
+}
+
 void InvoiceDialog::update_materials_grid()
 {
     if (m_materials_grid->GetNumberRows() > 0)
@@ -506,7 +517,7 @@ void InvoiceDialog::update_materials_grid()
         m_materials_grid->SetCellValue(i, 1, data.color);
         m_materials_grid->SetCellValue(i, 2, wxString::Format("%.2f", data.weight_g));
         m_materials_grid->SetCellValue(i, 3, wxString::Format("%.2f", data.cost_per_kg));
-        m_materials_grid->SetCellValue(i, 4, wxString::Format("%.2f", data.calculated_cost));
+        m_materials_grid->SetCellValue(i, 4, wxString::Format("%.2f", data.cost));
         
         m_materials_grid->SetReadOnly(i, 0);
         m_materials_grid->SetReadOnly(i, 1);
@@ -527,107 +538,208 @@ void InvoiceDialog::on_filament_cost_changed(wxGridEvent& event)
         wxString val = m_materials_grid->GetCellValue(row, col);
         if (val.ToDouble(&new_cost)) {
             m_filament_data[row].cost_per_kg = new_cost;
-            m_filament_data[row].calculated_cost = (m_filament_data[row].weight_g / 1000.0) * new_cost;
-            m_materials_grid->SetCellValue(row, 4, wxString::Format("%.2f", m_filament_data[row].calculated_cost));
+            m_filament_data[row].cost = (m_filament_data[row].weight_g / 1000.0) * new_cost;
+            m_current_job.filament_costs[m_filament_data[row].extruder_id] = new_cost;
+            m_materials_grid->SetCellValue(row, 4, wxString::Format("%.2f", m_filament_data[row].cost));
             calculate_costs();
         }
     }
 }
 
-void InvoiceDialog::calculate_costs()
+void InvoiceDialog::collect_job_profile()
 {
-    double total_material_cost = 0.0;
-    for (const auto& data : m_filament_data) {
-        total_material_cost += data.calculated_cost;
+    m_current_job.customer_name = into_u8(m_txt_customer_name->GetValue());
+    m_current_job.customer_email = into_u8(m_txt_customer_email->GetValue());
+    m_current_job.customer_phone = into_u8(m_txt_customer_phone->GetValue());
+    m_current_job.job_name = into_u8(m_txt_job_name->GetValue());
+    m_current_job.job_description = into_u8(m_txt_job_description->GetValue());
+
+    m_current_job.parts_per_plate = m_parts_per_plate->GetValue();
+    m_current_job.num_plates = m_num_plates->GetValue();
+    m_current_job.failure_rate = m_failure_rate->GetValue();
+    
+    m_current_job.labor_rate = m_labor_rate->GetValue();
+    m_current_job.prep_time = m_prep_time->GetValue();
+    m_current_job.setup_time = m_setup_time->GetValue();
+    m_current_job.finishing_per_part = m_finishing_per_part->GetValue();
+    m_current_job.finishing_per_plate = m_finishing_per_plate->GetValue();
+    
+    m_current_job.printer_cost = m_printer_cost->GetValue();
+    m_current_job.printer_lifespan = m_printer_lifespan->GetValue();
+    m_current_job.maintenance_cost = m_maintenance_cost->GetValue();
+    m_current_job.power_watts = m_power_watts->GetValue();
+    m_current_job.electricity_cost = m_electricity_cost->GetValue();
+    
+    m_current_job.bed_cost = m_bed_cost->GetValue();
+    m_current_job.bed_lifespan = m_bed_lifespan->GetValue();
+    m_current_job.nozzle_cost = m_nozzle_cost->GetValue();
+    m_current_job.nozzle_lifespan_kg = m_nozzle_lifespan_kg->GetValue();
+    
+    m_current_job.solvent_cost = m_solvent_cost->GetValue();
+    m_current_job.solving_time = m_solving_time->GetValue();
+    m_current_job.tank_power = m_tank_power->GetValue();
+    m_current_job.finishing_materials = m_finishing_materials->GetValue();
+    
+    m_current_job.markup_percent = m_markup_percent->GetValue();
+}
+
+bool InvoiceDialog::collect_plate_quotes()
+{
+    m_plate_quotes.clear();
+    PresetBundle* presets = wxGetApp().preset_bundle;
+    Plater* plater = wxGetApp().plater();
+    if (!presets || !plater)
+        return true;
+
+    PartPlateList& plate_list = plater->get_partplate_list();
+    int num_plates = 0;
+    int num_stale = stale_plates(num_plates);
+    for (int i = 0; i < plate_list.get_plate_count(); ++i) {
+        PartPlate* plate = plate_list.get_plate(i);
+        const Print* print = plate_print(plate);
+        if (print == nullptr)
+            continue;
+        // Every plate is priced for a single copy with its own number of parts.
+        InvoiceJobProfile plate_job = m_current_job;
+        plate_job.num_plates = 1;
+        plate_job.parts_per_plate = std::max(1, plate->printable_instance_size());
+        const PrintStatistics& stats = print->print_statistics();
+        InvoicePlateQuote plate_quote;
+        plate_quote.plate_id = i + 1;
+        plate_quote.quote = calculate_invoice_quote(plate_job, invoice_time_to_hours(stats.estimated_normal_print_time),
+                                                    invoice_filament_usage(stats, presets->project_config, presets->filament_presets));
+        m_plate_quotes.emplace_back(std::move(plate_quote));
     }
-    m_lbl_total_material_cost->SetLabel(wxString::Format("$%.2f", total_material_cost));
-    
-    double print_time_hours = 0.0;
-    if (m_stats) {
-        print_time_hours = parse_time_to_hours(m_stats->estimated_normal_print_time);
-        m_lbl_print_time->SetLabel(format_time(m_stats->estimated_normal_print_time));
-        m_lbl_total_weight->SetLabel(wxString::Format("%.2f g", m_stats->total_weight));
+
+    if (num_stale > 0) {
+        if (m_plates_slicing_failed) {
+            // Don't restart slicing of plates that failed or whose slicing was canceled until the user asks for a new quote.
+            m_lbl_plates_status->SetLabel(wxString::Format(_L("Slicing failed or was canceled, %d of %d plates not quoted"), num_stale, num_plates));
+        } else {
+            m_lbl_plates_status->SetLabel(wxString::Format(_L("Slicing %d of %d plates..."), num_stale, num_plates));
+            if (!m_plates_timer.IsRunning()) {
+                // The background slicing process skips plates with a valid result.
+                wxPostEvent(plater, SimpleEvent(EVT_GLTOOLBAR_SLICE_ALL));
+                m_plates_idle_ticks = 0;
+                m_plates_timer.Start(500);
+            }
+        }
+        return false;
     }
-    
-    int parts_per_plate = m_parts_per_plate->GetValue();
-    int num_plates = m_num_plates->GetValue();
-    double failure_rate = m_failure_rate->GetValue() / 100.0;
-    
-    double labor_rate = m_labor_rate->GetValue();
-    double prep_time = m_prep_time->GetValue();
-    double setup_time = m_setup_time->GetValue();
-    double finishing_per_part = m_finishing_per_part->GetValue();
-    double finishing_per_plate = m_finishing_per_plate->GetValue();
-    
-    double printer_cost = m_printer_cost->GetValue();
-    double printer_lifespan = m_printer_lifespan->GetValue();
-    double maintenance_cost = m_maintenance_cost->GetValue();
-    double power_watts = m_power_watts->GetValue();
-    double electricity_cost = m_electricity_cost->GetValue();
-    
-    double bed_cost = m_bed_cost->GetValue();
-    double bed_lifespan = m_bed_lifespan->GetValue();
-    double nozzle_cost = m_nozzle_cost->GetValue();
-    double nozzle_lifespan_kg = m_nozzle_lifespan_kg->GetValue();
-    
-    double solvent_cost = m_solvent_cost->GetValue();
-    double solving_time = m_solving_time->GetValue();
-    double tank_power = m_tank_power->GetValue();
-    double finishing_materials = m_finishing_materials->GetValue();
-    
-    double markup_percent = m_markup_percent->GetValue() / 100.0;
-    
-    m_calc_material_cost = total_material_cost;
-    
-    double labor_time_minutes = prep_time + setup_time + (finishing_per_part * parts_per_plate) + finishing_per_plate;
-    m_calc_labor_cost = (labor_time_minutes / 60.0) * labor_rate;
-    
-    double depreciation_per_hour = printer_cost / printer_lifespan;
-    double power_cost_per_hour = (power_watts / 1000.0) * electricity_cost;
-    double machine_hourly_rate = depreciation_per_hour + maintenance_cost + power_cost_per_hour;
-    m_calc_machine_cost = machine_hourly_rate * print_time_hours;
-    
-    double c_bed = (bed_cost / bed_lifespan) * print_time_hours;
-    double total_filament_kg = 0.0;
-    for(const auto& d : m_filament_data) total_filament_kg += d.weight_g / 1000.0;
-    double c_nozzle = (nozzle_cost / nozzle_lifespan_kg) * total_filament_kg;
-    m_calc_tooling_cost = c_bed + c_nozzle;
-    
-    double c_tank_power = (tank_power / 1000.0) * electricity_cost * solving_time;
-    m_calc_postprocess_cost = c_tank_power + finishing_materials; 
-    
-    m_calc_subtotal = m_calc_material_cost + m_calc_labor_cost + m_calc_machine_cost + m_calc_tooling_cost + m_calc_postprocess_cost;
-    
-    m_calc_failure_adjustment = 0.0;
-    if (failure_rate < 1.0) {
-        m_calc_failure_adjustment = (m_calc_subtotal / (1.0 - failure_rate)) - m_calc_subtotal;
+    m_plates_timer.Stop();
+    m_lbl_plates_status->SetLabel(wxString::Format(_L("%d plates quoted"), num_plates));
+    return true;
+}
+
+// Print of a plate with printable instances and a valid slicing result, nullptr otherwise.
+const Print* InvoiceDialog::plate_print(PartPlate* plate)
+{
+    if (!plate->has_printable_instances() || !plate->is_slice_result_valid())
+        return nullptr;
+    PrintBase* print_base = nullptr;
+    GCodeResult* gcode_result = nullptr;
+    plate->get_print(&print_base, &gcode_result, nullptr);
+    return dynamic_cast<const Print*>(print_base);
+}
+
+int InvoiceDialog::stale_plates(int& num_plates)
+{
+    num_plates = 0;
+    Plater* plater = wxGetApp().plater();
+    if (!plater)
+        return 0;
+    PartPlateList& plate_list = plater->get_partplate_list();
+    int num_stale = 0;
+    for (int i = 0; i < plate_list.get_plate_count(); ++i) {
+        PartPlate* plate = plate_list.get_plate(i);
+        if (!plate->has_printable_instances())
+            continue;
+        ++num_plates;
+        if (plate_print(plate) == nullptr)
+            ++num_stale;
     }
-    
-    double total_plate_cost = m_calc_subtotal + m_calc_failure_adjustment;
-    m_calc_cost_per_part = (parts_per_plate > 0) ? total_plate_cost / parts_per_plate : total_plate_cost;
-    
-    m_calc_markup_amount = m_calc_cost_per_part * markup_percent;
-    m_calc_final_price = m_calc_cost_per_part + m_calc_markup_amount;
-    
-    int total_parts = parts_per_plate * num_plates;
-    m_calc_total_job_cost = m_calc_final_price * total_parts;
-    m_calc_print_time_hours = print_time_hours;
-    
-    m_lbl_material_cost->SetLabel(wxString::Format("$%.2f", m_calc_material_cost));
-    m_lbl_labor_cost->SetLabel(wxString::Format("$%.2f", m_calc_labor_cost));
-    m_lbl_machine_cost->SetLabel(wxString::Format("$%.2f", m_calc_machine_cost));
-    m_lbl_tooling_cost->SetLabel(wxString::Format("$%.2f", m_calc_tooling_cost));
-    m_lbl_postprocess_cost->SetLabel(wxString::Format("$%.2f", m_calc_postprocess_cost));
-    m_lbl_subtotal->SetLabel(wxString::Format("$%.2f", m_calc_subtotal));
-    m_lbl_failure_adjustment->SetLabel(wxString::Format("+$%.2f", m_calc_failure_adjustment));
-    m_lbl_cost_per_part->SetLabel(wxString::Format("$%.2f", m_calc_cost_per_part));
-    m_lbl_markup_amount->SetLabel(wxString::Format("+$%.2f", m_calc_markup_amount));
-    m_lbl_final_price->SetLabel(wxString::Format("$%.2f", m_calc_final_price));
-    m_lbl_total_job_cost->SetLabel(wxString::Format("$%.2f (%d parts)", m_calc_total_job_cost, total_parts));
+    return num_stale;
+}
+
+void InvoiceDialog::on_quote_all_plates(wxCommandEvent& event)
+{
+    m_quote_all_plates = m_chk_all_plates->GetValue();
+    m_plates_slicing_failed = false;
+    m_parts_per_plate->Enable(!m_quote_all_plates);
+    m_num_plates->Enable(!m_quote_all_plates);
+    if (!m_quote_all_plates) {
+        m_plates_timer.Stop();
+        m_plate_quotes.clear();
+        m_lbl_plates_status->SetLabel("");
+        populate_filament_data();
+        update_materials_grid();
+    }
+    calculate_costs();
+}
+
+void InvoiceDialog::on_plates_timer(wxTimerEvent& event)
+{
+    int num_plates = 0;
+    if (stale_plates(num_plates) == 0) {
+        // collect_plate_quotes() stops the timer.
+        calculate_costs();
+        return;
+    }
+    Plater* plater = wxGetApp().plater();
+    if (plater && plater->is_background_process_slicing()) {
+        m_plates_idle_ticks = 0;
+        return;
+    }
+    // The first tick may come before the posted slice all event started the background process.
+    if (++ m_plates_idle_ticks < 2)
+        return;
+    // The background process stopped with printable plates left unsliced: slicing failed or was canceled.
+    m_plates_timer.Stop();
+    m_plates_slicing_failed = true;
+    calculate_costs();
+}
+
+void InvoiceDialog::calculate_costs()
+{
+    collect_job_profile();
+
+    if (m_quote_all_plates) {
+        bool ready = collect_plate_quotes();
+        m_quote = sum_invoice_plate_quotes(m_current_job, m_plate_quotes);
+        m_lbl_print_time->SetLabel(format_time(get_time_dhms(float(m_quote.print_time_hours * 3600.))) + (ready ? "" : " *"));
+        m_lbl_total_weight->SetLabel(wxString::Format("%.2f g", m_quote.total_weight_g));
+        m_filament_data = m_quote.filaments;
+        update_materials_grid();
+        m_object_costs.clear();
+    } else {
+        double print_time_hours = 0.0;
+        if (m_stats) {
+            print_time_hours = invoice_time_to_hours(m_stats->estimated_normal_print_time);
+            m_lbl_print_time->SetLabel(format_time(m_stats->estimated_normal_print_time));
+            m_lbl_total_weight->SetLabel(wxString::Format("%.2f g", m_stats->total_weight));
+        }
+        m_quote = calculate_invoice_quote(m_current_job, print_time_hours, m_filament_data);
+        m_object_costs = calculate_invoice_object_costs(m_quote, m_current_job, m_object_usage);
+    }
+    update_objects_grid();
+    
+    m_lbl_total_material_cost->SetLabel(wxString::Format("$%.2f", m_quote.material_cost));
+    m_lbl_material_cost->SetLabel(wxString::Format("$%.2f", m_quote.material_cost));
+    m_lbl_labor_cost->SetLabel(wxString::Format("$%.2f", m_quote.labor_cost));
+    m_lbl_machine_cost->SetLabel(wxString::Format("$%.2f", m_quote.machine_cost));
+    m_lbl_tooling_cost->SetLabel(wxString::Format("$%.2f", m_quote.tooling_cost));
+    m_lbl_postprocess_cost->SetLabel(wxString::Format("$%.2f", m_quote.postprocess_cost));
+    m_lbl_subtotal->SetLabel(wxString::Format("$%.2f", m_quote.subtotal));
+    m_lbl_failure_adjustment->SetLabel(wxString::Format("+$%.2f", m_quote.failure_adjustment));
+    m_lbl_cost_per_part->SetLabel(wxString::Format("$%.2f", m_quote.cost_per_part));
+    m_lbl_markup_amount->SetLabel(wxString::Format("+$%.2f", m_quote.markup_amount));
+    m_lbl_final_price->SetLabel(wxString::Format("$%.2f", m_quote.final_price));
+    m_lbl_total_job_cost->SetLabel(wxString::Format("$%.2f (%d parts)", m_quote.total_job_cost, m_quote.total_parts));
 }
 
 void InvoiceDialog::on_calculate(wxCommandEvent& event)
 {
+    m_plates_slicing_failed = false;
     calculate_costs();
 }
 
@@ -641,7 +753,7 @@ void InvoiceDialog::load_global_settings()
     std::string last_profile = config->get("invoice", "last_profile");
     if (!last_profile.empty()) {
         load_job_profile(last_profile);
-        m_combo_job_profiles->SetValue(last_profile);
+        m_combo_job_profiles->SetValue(from_u8(last_profile));
     }
 }
 
@@ -651,153 +763,99 @@ void InvoiceDialog::save_global_settings()
     if (!config) return;
     
     config->set("invoice", "business_name", m_txt_business_name->GetValue().ToStdString());
-    config->set("invoice", "last_profile", m_combo_job_profiles->GetValue().ToStdString());
+    config->set("invoice", "last_profile", into_u8(m_combo_job_profiles->GetValue()));
     config->save();
 }
 
 void InvoiceDialog::load_job_profile(const std::string& profile_name)
 {
-    AppConfig* config = wxGetApp().app_config;
-    if (!config || profile_name.empty()) return;
-    
-    std::string prefix = "invoice_job_" + profile_name + "_";
-    
-    auto get_str = [&](const std::string& key) { return config->get(prefix + key); };
-    auto get_int = [&](const std::string& key, int def) { 
-        std::string v = get_str(key); return v.empty() ? def : std::stoi(v); 
-    };
-    auto get_dbl = [&](const std::string& key, double def) { 
-        std::string v = get_str(key); return v.empty() ? def : std::stod(v); 
-    };
-    
-    m_txt_customer_name->SetValue(get_str("customer_name"));
-    m_txt_customer_email->SetValue(get_str("customer_email"));
-    m_txt_customer_phone->SetValue(get_str("customer_phone"));
-    m_txt_job_name->SetValue(get_str("job_name"));
-    m_txt_job_description->SetValue(get_str("job_description"));
-    
-    m_parts_per_plate->SetValue(get_int("parts_per_plate", 1));
-    m_num_plates->SetValue(get_int("num_plates", 1));
-    m_failure_rate->SetValue(get_dbl("failure_rate", 5.0));
-    
-    m_labor_rate->SetValue(get_dbl("labor_rate", 20.0));
-    m_prep_time->SetValue(get_dbl("prep_time", 15.0));
-    m_setup_time->SetValue(get_dbl("setup_time", 10.0));
-    m_finishing_per_part->SetValue(get_dbl("finishing_per_part", 5.0));
-    m_finishing_per_plate->SetValue(get_dbl("finishing_per_plate", 0.0));
-    
-    m_printer_cost->SetValue(get_dbl("printer_cost", 300.0));
-    m_printer_lifespan->SetValue(get_dbl("printer_lifespan", 15000.0));
-    m_maintenance_cost->SetValue(get_dbl("maintenance_cost", 0.10));
-    m_power_watts->SetValue(get_dbl("power_watts", 130.0));
-    m_electricity_cost->SetValue(get_dbl("electricity_cost", 0.15));
-    
-    m_bed_cost->SetValue(get_dbl("bed_cost", 30.0));
-    m_bed_lifespan->SetValue(get_dbl("bed_lifespan", 5000.0));
-    m_nozzle_cost->SetValue(get_dbl("nozzle_cost", 2.0));
-    m_nozzle_lifespan_kg->SetValue(get_dbl("nozzle_lifespan_kg", 25.0));
-    
-    m_solvent_cost->SetValue(get_dbl("solvent_cost", 0.0));
-    m_solving_time->SetValue(get_dbl("solving_time", 0.0));
-    m_tank_power->SetValue(get_dbl("tank_power", 0.0));
-    m_finishing_materials->SetValue(get_dbl("finishing_materials", 0.0));
-    
-    m_markup_percent->SetValue(get_dbl("markup_percent", 50.0));
+    if (profile_name.empty()) return;
+
+    std::optional<InvoiceJobProfile> job;
+    try {
+        job = invoice_job_store().load(profile_name);
+    } catch (const std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << err.what();
+    }
+    if (!job) return;
+    m_current_job = *job;
+
+    m_txt_customer_name->SetValue(from_u8(job->customer_name));
+    m_txt_customer_email->SetValue(from_u8(job->customer_email));
+    m_txt_customer_phone->SetValue(from_u8(job->customer_phone));
+    m_txt_job_name->SetValue(from_u8(job->job_name));
+    m_txt_job_description->SetValue(from_u8(job->job_description));
+    
+    m_parts_per_plate->SetValue(job->parts_per_plate);
+    m_num_plates->SetValue(job->num_plates);
+    m_failure_rate->SetValue(job->failure_rate);
+    
+    m_labor_rate->SetValue(job->labor_rate);
+    m_prep_time->SetValue(job->prep_time);
+    m_setup_time->SetValue(job->setup_time);
+    m_finishing_per_part->SetValue(job->finishing_per_part);
+    m_finishing_per_plate->SetValue(job->finishing_per_plate);
+    
+    m_printer_cost->SetValue(job->printer_cost);
+    m_printer_lifespan->SetValue(job->printer_lifespan);
+    m_maintenance_cost->SetValue(job->maintenance_cost);
+    m_power_watts->SetValue(job->power_watts);
+    m_electricity_cost->SetValue(job->electricity_cost);
+    
+    m_bed_cost->SetValue(job->bed_cost);
+    m_bed_lifespan->SetValue(job->bed_lifespan);
+    m_nozzle_cost->SetValue(job->nozzle_cost);
+    m_nozzle_lifespan_kg->SetValue(job->nozzle_lifespan_kg);
+    
+    m_solvent_cost->SetValue(job->solvent_cost);
+    m_solving_time->SetValue(job->solving_time);
+    m_tank_power->SetValue(job->tank_power);
+    m_finishing_materials->SetValue(job->finishing_materials);
+    
+    m_markup_percent->SetValue(job->markup_percent);
+
+    for (InvoiceFilamentUsage &filament : m_filament_data)
+        if (auto it = job->filament_costs.find(filament.extruder_id); it != job->filament_costs.end())
+            filament.cost_per_kg = it->second;
+    update_materials_grid();
     
     calculate_costs();
 }
 
 void InvoiceDialog::save_job_profile(const std::string& profile_name)
 {
-    AppConfig* config = wxGetApp().app_config;
-    if (!config || profile_name.empty()) return;
-    
-    std::string prefix = "invoice_job_" + profile_name + "_";
-    
-    auto set_val = [&](const std::string& key, const std::string& val) { config->set(prefix + key, val); };
-    
-    set_val("customer_name", m_txt_customer_name->GetValue().ToStdString());
-    set_val("customer_email", m_txt_customer_email->GetValue().ToStdString());
-    set_val("customer_phone", m_txt_customer_phone->GetValue().ToStdString());
-    set_val("job_name", m_txt_job_name->GetValue().ToStdString());
-    set_val("job_description", m_txt_job_description->GetValue().ToStdString());
-    
-    set_val("parts_per_plate", std::to_string(m_parts_per_plate->GetValue()));
-    set_val("num_plates", std::to_string(m_num_plates->GetValue()));
-    set_val("failure_rate", std::to_string(m_failure_rate->GetValue()));
-    
-    set_val("labor_rate", std::to_string(m_labor_rate->GetValue()));
-    set_val("prep_time", std::to_string(m_prep_time->GetValue()));
-    set_val("setup_time", std::to_string(m_setup_time->GetValue()));
-    set_val("finishing_per_part", std::to_string(m_finishing_per_part->GetValue()));
-    set_val("finishing_per_plate", std::to_string(m_finishing_per_plate->GetValue()));
-    
-    set_val("printer_cost", std::to_string(m_printer_cost->GetValue()));
-    set_val("printer_lifespan", std::to_string(m_printer_lifespan->GetValue()));
-    set_val("maintenance_cost", std::to_string(m_maintenance_cost->GetValue()));
-    set_val("power_watts", std::to_string(m_power_watts->GetValue()));
-    set_val("electricity_cost", std::to_string(m_electricity_cost->GetValue()));
-    
-    set_val("bed_cost", std::to_string(m_bed_cost->GetValue()));
-    set_val("bed_lifespan", std::to_string(m_bed_lifespan->GetValue()));
-    set_val("nozzle_cost", std::to_string(m_nozzle_cost->GetValue()));
-    set_val("nozzle_lifespan_kg", std::to_string(m_nozzle_lifespan_kg->GetValue()));
-    
-    set_val("solvent_cost", std::to_string(m_solvent_cost->GetValue()));
-    set_val("solving_time", std::to_string(m_solving_time->GetValue()));
-    set_val("tank_power", std::to_string(m_tank_power->GetValue()));
-    set_val("finishing_materials", std::to_string(m_finishing_materials->GetValue()));
-    
-    set_val("markup_percent", std::to_string(m_markup_percent->GetValue()));
-    
-    std::string profiles_str = config->get("invoice_profiles");
-    std::vector<std::string> profiles;
-    std::stringstream ss(profiles_str);
-    std::string item;
-    bool found = false;
-    while (std::getline(ss, item, ';')) {
-        if (item == profile_name) found = true;
-        profiles.push_back(item);
-    }
-    if (!found) {
-        profiles.push_back(profile_name);
-        std::string new_list;
-        for (const auto& p : profiles) new_list += p + ";";
-        config->set("invoice_profiles", new_list);
+    if (profile_name.empty()) return;
+
+    collect_job_profile();
+    try {
+        invoice_job_store().save(profile_name, m_current_job);
+    } catch (const std::exception &err) {
+        show_error(this, err.what());
+        return;
     }
-    
-    config->save();
     refresh_job_profiles_combo();
 }
 
 void InvoiceDialog::delete_job_profile(const std::string& profile_name)
 {
-    AppConfig* config = wxGetApp().app_config;
-    if (!config || profile_name.empty()) return;
-    
-    std::string profiles_str = config->get("invoice_profiles");
-    std::string new_list;
-    std::stringstream ss(profiles_str);
-    std::string item;
-    while (std::getline(ss, item, ';')) {
-        if (item != profile_name) new_list += item + ";";
+    if (profile_name.empty()) return;
+
+    try {
+        invoice_job_store().erase(profile_name);
+    } catch (const std::exception &err) {
+        show_error(this, err.what());
     }
-    config->set("invoice_profiles", new_list);
-    config->save();
     refresh_job_profiles_combo();
 }
 
 void InvoiceDialog::refresh_job_profiles_combo()
 {
     m_combo_job_profiles->Clear();
-    AppConfig* config = wxGetApp().app_config;
-    if (!config) return;
-    
-    std::string profiles_str = config->get("invoice_profiles");
-    std::stringstream ss(profiles_str);
-    std::string item;
-    while (std::getline(ss, item, ';')) {
-        if (!item.empty()) m_combo_job_profiles->Append(item);
+    try {
+        for (const std::string &name : invoice_job_store().names())
+            m_combo_job_profiles->Append(from_u8(name));
+    } catch (const std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << err.what();
     }
 }
 
@@ -805,8 +863,11 @@ void InvoiceDialog::on_save_job(wxCommandEvent& event)
 {
     wxTextEntryDialog dlg(this, _L("Enter name for this job profile:"), _L("Save Job Profile"));
     if (dlg.ShowModal() == wxID_OK) {
-        save_job_profile(dlg.GetValue().ToStdString());
-        save_global_settings();
+        const std::string name = into_u8(dlg.GetValue());
+        save_job_profile(name);
+        // The profile itself lives in the job store, AppConfig is flushed by the application as usual.
+        if (AppConfig* config = wxGetApp().app_config)
+            config->set("invoice", "last_profile", name);
     }
 }
 
@@ -814,7 +875,7 @@ void InvoiceDialog::on_load_job(wxCommandEvent& event)
 {
     wxString val = m_combo_job_profiles->GetValue();
     if (!val.IsEmpty()) {
-        load_job_profile(val.ToStdString());
+        load_job_profile(into_u8(val));
     }
 }
 
@@ -823,7 +884,7 @@ void InvoiceDialog::on_delete_job(wxCommandEvent& event)
     wxString val = m_combo_job_profiles->GetValue();
     if (!val.IsEmpty()) {
         if (wxMessageBox(_L("Are you sure you want to delete this profile?"), _L("Confirm Delete"), wxYES_NO | wxICON_QUESTION) == wxYES) {
-            delete_job_profile(val.ToStdString());
+            delete_job_profile(into_u8(val));
             m_combo_job_profiles->SetValue("");
         }
     }
@@ -914,12 +975,11 @@ void InvoiceDialog::export_to_excel(const wxString& path)
     file << "<Cell><Data ss:Type=\"String\">Total</Data></Cell>\n";
     file << "</Row>\n";
     
-    int total_parts = m_parts_per_plate->GetValue() * m_num_plates->GetValue();
     file << "<Row>\n";
     file << "<Cell><Data ss:Type=\"String\">3D Printed Parts</Data></Cell>\n";
-    file << "<Cell><Data ss:Type=\"Number\">" << total_parts << "</Data></Cell>\n";
-    file << "<Cell ss:StyleID=\"sCurrency\"><Data ss:Type=\"Number\">" << m_calc_final_price << "</Data></Cell>\n";
-    file << "<Cell ss:StyleID=\"sCurrency\"><Data ss:Type=\"Number\">" << m_calc_total_job_cost << "</Data></Cell>\n";
+    file << "<Cell><Data ss:Type=\"Number\">" << m_quote.total_parts << "</Data></Cell>\n";
+    file << "<Cell ss:StyleID=\"sCurrency\"><Data ss:Type=\"Number\">" << m_quote.final_price << "</Data></Cell>\n";
+    file << "<Cell ss:StyleID=\"sCurrency\"><Data ss:Type=\"Number\">" << m_quote.total_job_cost << "</Data></Cell>\n";
     file << "</Row>\n";
     
     file << "<Row><Cell><Data ss:Type=\"String\"></Data></Cell></Row>\n";
@@ -951,17 +1011,24 @@ void InvoiceDialog::export_to_excel(const wxString& path)
         file << "</Row>\n";
     };
     
-    add_cost_row("Material Cost", m_calc_material_cost);
-    add_cost_row("Labor Cost", m_calc_labor_cost);
-    add_cost_row("Machine Cost", m_calc_machine_cost);
-    add_cost_row("Tooling Cost", m_calc_tooling_cost);
-    add_cost_row("Post-Processing Cost", m_calc_postprocess_cost);
+    add_cost_row("Material Cost", m_quote.material_cost);
+    add_cost_row("Labor Cost", m_quote.labor_cost);
+    add_cost_row("Machine Cost", m_quote.machine_cost);
+    add_cost_row("Tooling Cost", m_quote.tooling_cost);
+    add_cost_row("Post-Processing Cost", m_quote.postprocess_cost);
     file << "<Row><Cell><Data ss:Type=\"String\"></Data></Cell></Row>\n";
-    add_cost_row("Subtotal", m_calc_subtotal);
-    add_cost_row("Failure Adjustment", m_calc_failure_adjustment);
-    add_cost_row("Markup Amount", m_calc_markup_amount);
+    add_cost_row("Subtotal", m_quote.subtotal);
+    add_cost_row("Failure Adjustment", m_quote.failure_adjustment);
+    add_cost_row("Markup Amount", m_quote.markup_amount);
     file << "<Row><Cell><Data ss:Type=\"String\"></Data></Cell></Row>\n";
-    add_cost_row("Total Job Cost", m_calc_total_job_cost);
+    add_cost_row("Total Job Cost", m_quote.total_job_cost);
+    
+    if (!m_object_costs.empty()) {
+        file << "<Row><Cell><Data ss:Type=\"String\"></Data></Cell></Row>\n";
+        file << "<Row ss:StyleID=\"sBold\"><Cell><Data ss:Type=\"String\">Cost Per Object (one plate)</Data></Cell></Row>\n";
+        for (const auto& cost : m_object_costs)
+            add_cost_row(escape_xml(cost.name), cost.price);
+    }
     
     file << "</Table>\n";
     file << "</Worksheet>\n";
@@ -9,74 +9,25 @@
 #include <string>
 #include "GUI_Utils.hpp"
 #include "wxExtensions.hpp"
+#include "libslic3r/InvoiceCost.hpp"
 
 namespace Slic3r {
 
 // Forward declarations
 struct PrintStatistics;
+struct GCodeProcessorResult;
+class Print;
 
 namespace GUI {
 
-// Structure to hold per-filament data
-struct FilamentData {
-    size_t extruder_id;
-    std::string name;
-    std::string color;
-    double weight_g;        // grams used
-    double cost_per_kg;     // $/kg from profile or user-set
-    double calculated_cost; // computed cost
-};
-
-// Structure to hold job profile
-struct JobProfile {
-    std::string job_name;
-    std::string customer_name;
-    std::string customer_email;
-    std::string customer_phone;
-    std::string job_description;
-    
-    // Job parameters
-    int parts_per_plate;
-    int num_plates;
-    double failure_rate;
-    
-    // Labor
-    double labor_rate;
-    double prep_time;
-    double setup_time;
-    double finishing_per_part;
-    double finishing_per_plate;
-    
-    // Machine
-    double printer_cost;
-    double printer_lifespan;
-    double maintenance_cost;
-    double power_watts;
-    double electricity_cost;
-    
-    // Tooling
-    double bed_cost;
-    double bed_lifespan;
-    double nozzle_cost;
-    double nozzle_lifespan_kg;
-    
-    // Post-Processing
-    double solvent_cost;
-    double solving_time;
-    double tank_power;
-    double finishing_materials;
-    
-    // Markup
-    double markup_percent;
-    
-    // Per-filament cost overrides (extruder_id -> cost_per_kg)
-    std::map<size_t, double> filament_costs;
-};
+class PartPlate;
 
 class InvoiceDialog : public DPIDialog
 {
 public:
-    InvoiceDialog(wxWindow* parent, const PrintStatistics* stats);
+    // gcode_result and object_names are optional, they enable the per object split of the quote.
+    InvoiceDialog(wxWindow* parent, const PrintStatistics* stats, const GCodeProcessorResult* gcode_result = nullptr,
+                  const std::map<int, std::string>& object_names = {});
     ~InvoiceDialog() = default;
 
 protected:
@@ -93,18 +44,25 @@ private:
     void build_postprocess_tab(wxNotebook* notebook);
     void build_markup_tab(wxNotebook* notebook);
     void build_results_tab(wxNotebook* notebook);
+    void build_objects_tab(wxNotebook* notebook);
     
     void load_global_settings();
     void save_global_settings();
     void load_job_profile(const std::string& profile_name);
     void save_job_profile(const std::string& profile_name);
     void delete_job_profile(const std::string& profile_name);
-    std::vector<std::string> get_saved_job_profiles();
     void refresh_job_profiles_combo();
     
     void populate_filament_data();
     void update_materials_grid();
+    void update_objects_grid();
+    void collect_job_profile();
     void calculate_costs();
+    // Quote every plate of the project, returns false if some plates still need slicing.
+    bool collect_plate_quotes();
+    // Number of plates with printable instances not sliced yet, num_plates receives the number of plates with printable instances.
+    int stale_plates(int& num_plates);
+    static const Print* plate_print(PartPlate* plate);
     
     void on_calculate(wxCommandEvent& event);
     void on_save_job(wxCommandEvent& event);
@@ -112,21 +70,25 @@ private:
     void on_delete_job(wxCommandEvent& event);
     void on_export_invoice(wxCommandEvent& event);
     void on_filament_cost_changed(wxGridEvent& event);
+    void on_quote_all_plates(wxCommandEvent& event);
+    void on_plates_timer(wxTimerEvent& event);
     
     void export_to_excel(const wxString& path);
     std::string escape_xml(const std::string& str) const;
     
     wxString format_time(const std::string& time_str) const;
-    double parse_time_to_hours(const std::string& time_str) const;
 
     // Print statistics from slicer
     const PrintStatistics* m_stats;
     
     // Filament data
-    std::vector<FilamentData> m_filament_data;
+    std::vector<InvoiceFilamentUsage> m_filament_data;
+
+    // Filament and time of each labeled object, empty if not available
+    std::vector<InvoiceObjectUsage> m_object_usage;
     
     // Current job profile
-    JobProfile m_current_job;
+    InvoiceJobProfile m_current_job;
 
     // === Customer/Vendor Info Controls ===
     wxTextCtrl* m_txt_business_name;
@@ -143,6 +105,8 @@ private:
     wxSpinCtrl* m_parts_per_plate;
     wxSpinCtrl* m_num_plates;
     wxSpinCtrlDouble* m_failure_rate;
+    wxCheckBox* m_chk_all_plates;
+    wxStaticText* m_lbl_plates_status;
 
     // === Materials Controls ===
     wxGrid* m_materials_grid;
@@ -194,6 +158,9 @@ private:
     wxStaticText* m_lbl_final_price;
     wxStaticText* m_lbl_total_job_cost;
 
+    // === Objects Display ===
+    wxGrid* m_objects_grid { nullptr };
+
     // === Buttons ===
     wxButton* m_btn_calculate;
     wxButton* m_btn_save_job;
@@ -203,18 +170,18 @@ private:
     wxButton* m_btn_close;
     
     // Cached calculation results for export
-    double m_calc_material_cost = 0.0;
-    double m_calc_labor_cost = 0.0;
-    double m_calc_machine_cost = 0.0;
-    double m_calc_tooling_cost = 0.0;
-    double m_calc_postprocess_cost = 0.0;
-    double m_calc_subtotal = 0.0;
-    double m_calc_failure_adjustment = 0.0;
-    double m_calc_cost_per_part = 0.0;
-    double m_calc_markup_amount = 0.0;
-    double m_calc_final_price = 0.0;
-    double m_calc_total_job_cost = 0.0;
-    double m_calc_print_time_hours = 0.0;
+    InvoiceQuote m_quote;
+    std::vector<InvoiceObjectCost> m_object_costs;
+
+    // Quote of all plates of the project instead of the current plate.
+    bool m_quote_all_plates { false };
+    std::vector<InvoicePlateQuote> m_plate_quotes;
+    // Polls the plates sliced by the background slicing process.
+    wxTimer m_plates_timer;
+    // Ticks of m_plates_timer with the background slicing process idle.
+    int m_plates_idle_ticks { 0 };
+    // Slicing of some plates failed or was canceled, don't restart it until the user asks for a new quote.
+    bool m_plates_slicing_failed { false };
 };
 
 } // namespace GUI
@@ -1964,7 +1964,7 @@ wxBoxSizer* MainFrame::create_side_tools()
         const Print& print = plate_list.get_current_fff_print();
         const PrintStatistics* stats = &print.print_statistics();
         
-        InvoiceDialog dlg(this, stats);
+        InvoiceDialog dlg(this, stats, plate_list.get_curr_plate()->get_slice_result(), invoice_object_names(print));
         dlg.ShowModal();
     });
     
@@ -4546,6 +4546,9 @@ struct Plater::priv
     //BBS: add popup object table logic
     bool PopupObjectTable(int object_id, int volume_id, const wxPoint& position);
     void on_action_send_to_printer(bool isall = false);
+    // Shows an error and returns true if the G-code is exported in the binary container of orca_binary_gcode,
+    // which no printer reads and thus is never sent to one.
+    bool binary_gcode_blocks_sending();
     void on_action_send_to_multi_machine(SimpleEvent&);
     int update_print_required_data(Slic3r::DynamicPrintConfig config, Slic3r::Model model, Slic3r::PlateDataPtrs plate_data_list, std::string file_name, std::string file_path);
 private:
@@ -9521,6 +9524,8 @@ void Plater::priv::on_action_publish(wxCommandEvent &event)
 
 void Plater::priv::on_action_print_plate(SimpleEvent&)
 {
+    if (binary_gcode_blocks_sending())
+        return;
     if (q != nullptr) {
         BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << ":received print plate event\n" ;
     }
@@ -9540,6 +9545,8 @@ void Plater::priv::on_action_print_plate(SimpleEvent&)
 
 void Plater::priv::on_action_send_to_multi_machine(SimpleEvent&)
 {
+    if (binary_gcode_blocks_sending())
+        return;
     if (!m_send_multi_dlg)
         m_send_multi_dlg = new SendMultiMachinePage(q);
     m_send_multi_dlg->prepare(partplate_list.get_curr_plate_index());
@@ -9600,6 +9607,8 @@ int Plater::priv::update_print_required_data(Slic3r::DynamicPrintConfig config,
 
 void Plater::priv::on_action_send_to_printer(bool isall)
 {
+    if (binary_gcode_blocks_sending())
+        return;
 	if (!m_send_to_sdcard_dlg) m_send_to_sdcard_dlg = new SendToPrinterDialog(q);
     if (isall) {
         m_send_to_sdcard_dlg->prepare(PLATE_ALL_IDX);
@@ -9611,6 +9620,16 @@ void Plater::priv::on_action_send_to_printer(bool isall)
 	m_send_to_sdcard_dlg->ShowModal();
 }
 
+bool Plater::priv::binary_gcode_blocks_sending()
+{
+    const DynamicPrintConfig &config = wxGetApp().preset_bundle->printers.get_edited_preset().config;
+    if (! config.has("orca_binary_gcode") || ! config.opt_bool("orca_binary_gcode"))
+        return false;
+    show_error(q, _L("The G-code is exported in the binary G-code container of OrcaSlicer, which printers cannot read. "
+                     "Disable \"Binary G-code (OrcaSlicer only)\" in the printer settings to send the G-code to a printer."));
+    return true;
+}
+
 
 void Plater::priv::on_action_select_sliced_plate(wxCommandEvent &evt)
 {
@@ -9622,6 +9641,8 @@ void Plater::priv::on_action_select_sliced_plate(wxCommandEvent &evt)
 
 void Plater::priv::on_action_print_all(SimpleEvent&)
 {
+    if (binary_gcode_blocks_sending())
+        return;
     if (q != nullptr) {
         BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << ":received print all event\n" ;
     }
@@ -14227,6 +14248,9 @@ void Plater::send_to_printer(bool isall)
 //BBS export gcode 3mf to file
 void Plater::export_gcode_3mf(bool export_all)
 {
+    // The sliced file is sent to the printers as is.
+    if (p->binary_gcode_blocks_sending())
+        return;
     if (p->model.objects.empty())
         return;
 
@@ -15341,6 +15365,8 @@ void Plater::reslice_SLA_until_step(SLAPrintObjectStep step, const ModelObject &
 }
 void Plater::send_gcode_legacy(int plate_idx, Export3mfProgressFn proFn, bool use_3mf)
 {
+    if (p->binary_gcode_blocks_sending())
+        return;
     // if physical_printer is selected, send gcode for this printer
     // DynamicPrintConfig* physical_printer_config = wxGetApp().preset_bundle->physical_printers.get_selected_printer_config();
     DynamicPrintConfig* physical_printer_config = &Slic3r::GUI::wxGetApp().preset_bundle->printers.get_edited_preset().config;
@@ -15450,6 +15476,8 @@ void Plater::send_gcode_legacy(int plate_idx, Export3mfProgressFn proFn, bool us
 }
 int Plater::send_gcode(int plate_idx, Export3mfProgressFn proFn)
 {
+    if (p->binary_gcode_blocks_sending())
+        return -1;
     int result = 0;
     /* generate 3mf */
     set_print_job_plate_idx(plate_idx);
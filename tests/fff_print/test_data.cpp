@@ -292,6 +292,13 @@ std::string gcode(Print & print)
 	return str;
 }
 
+std::string gcode_without_timestamp(std::string gcode)
+{
+    if (size_t pos = gcode.find("; generated by "); pos != std::string::npos)
+        gcode.erase(pos, gcode.find('\n', pos) - pos);
+    return gcode;
+}
+
 Slic3r::Model model(const std::string &model_name, TriangleMesh &&_mesh)
 {
     Slic3r::Model result;
@@ -5,6 +5,7 @@
 
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillAdaptive.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Print.hpp"
@@ -190,6 +191,34 @@ TEST_CASE("Fill: Pattern Path Length", "[Fill]") {
     }
 }
 
+TEST_CASE("Fill: Adaptive cubic octree survives encoding", "[Fill]") {
+    indexed_triangle_set mesh = its_make_cube(20., 20., 20.);
+    its_transform(mesh, Transform3d(FillAdaptive::transform_to_octree()), true);
+    FillAdaptive::OctreePtr octree  = FillAdaptive::build_octree(mesh, {}, 2., false);
+    const std::string       encoded = FillAdaptive::encode_octree(*octree);
+    FillAdaptive::OctreePtr decoded = FillAdaptive::decode_octree(encoded);
+    REQUIRE(FillAdaptive::encode_octree(*decoded) == encoded);
+
+    auto fill = [](FillAdaptive::Octree *octree) {
+        std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(ipAdaptiveCubic));
+        filler->spacing           = 0.45;
+        filler->z                 = 10.;
+        filler->adapt_fill_octree = octree;
+        FillParams fill_params;
+        fill_params.density = 0.2f;
+        Slic3r::Surface surface(stInternal, ExPolygon(Polygon::new_scale({ Vec2d(-8, -8), Vec2d(8, -8), Vec2d(8, 8), Vec2d(-8, 8) })));
+        return filler->fill_surface(&surface, fill_params);
+    };
+    Polylines expected = fill(octree.get());
+    Polylines restored = fill(decoded.get());
+    REQUIRE(! expected.empty());
+    REQUIRE(restored.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++ i)
+        REQUIRE(restored[i].points == expected[i].points);
+
+    REQUIRE_THROWS_AS(FillAdaptive::decode_octree(std::string_view(encoded).substr(0, encoded.size() - 1)), Slic3r::FileIOError);
+}
+
 /*
 {
     my $collection = Slic3r::Polyline::Collection->new(
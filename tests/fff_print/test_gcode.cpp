@@ -2,7 +2,14 @@
 
 #include <memory>
 
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/BinaryGCode.hpp"
+#include "libslic3r/GCode/ExportStats.hpp"
+
+#include "test_data.hpp"
 
 using namespace Slic3r;
 
@@ -20,3 +27,258 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("Tokenized G-code buffer", "[GCode]") {
+	const std::string gcode = "G1 X10 Y20.5 F3000\nG92 E0\r\n; comment only\nM106 S255\n\nG1 E-0.8 ; retract\nG1 X1 Q5";
+	GIVEN("a buffer parsed directly and the same buffer tokenized and replayed") {
+		auto collect = [](std::vector<std::string> &raw, std::vector<Vec3f> &pos) {
+			return [&raw, &pos](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+				raw.emplace_back(line.raw() + "|" + std::string(line.cmd()) + "|" + std::to_string(line.has_e()) + std::to_string(line.has_unknown_axis()));
+				pos.emplace_back(line.new_X(reader), line.new_Y(reader), line.new_E(reader));
+			};
+		};
+		std::vector<std::string> raw_parsed, raw_replayed;
+		std::vector<Vec3f>       pos_parsed, pos_replayed;
+		GCodeReader parser, replayer;
+		parser.parse_buffer(gcode, collect(raw_parsed, pos_parsed));
+		replayer.parse_buffer(gcode, GCodeReader::tokenize_buffer(gcode), collect(raw_replayed, pos_replayed));
+		THEN("the lines and the reader positions are the same") {
+			REQUIRE(raw_replayed.size() == 7);
+			REQUIRE(raw_replayed == raw_parsed);
+			REQUIRE(pos_replayed == pos_parsed);
+			REQUIRE(replayer.x() == parser.x());
+			REQUIRE(replayer.e() == parser.e());
+		}
+	}
+}
+
+SCENARIO("G-code file tokenized in parallel chunks", "[GCode]") {
+	const std::string gcode = "N10 G1 X10 Y20 F3000\r\nG92 E0\n\n; comment only\nN11 G1 X1 E0.5 ; extrude\nM106 S255\nG1 Z0.4";
+	const std::string path  = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("gcode_chunks_%%%%-%%%%.gcode")).string();
+	{
+		boost::nowide::ofstream ofs(path, std::ios::binary);
+		ofs << gcode;
+	}
+	GIVEN("a file parsed sequentially and the same file parsed by chunks of a few bytes") {
+		auto collect = [](std::vector<std::string> &raw, std::vector<Vec3f> &pos) {
+			return [&raw, &pos](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+				raw.emplace_back(line.raw());
+				pos.emplace_back(line.new_X(reader), line.new_Z(reader), line.new_E(reader));
+			};
+		};
+		std::vector<std::string> raw_sequential, raw_parallel;
+		std::vector<Vec3f>       pos_sequential, pos_parallel;
+		std::vector<size_t>      lines_ends_sequential, lines_ends_parallel;
+		GCodeReader sequential, parallel;
+		sequential.parse_file(path, collect(raw_sequential, pos_sequential), lines_ends_sequential);
+		parallel.parse_file_parallel(path, collect(raw_parallel, pos_parallel), lines_ends_parallel, 8);
+		THEN("the lines, the line ends and the reader positions are the same") {
+			REQUIRE(raw_parallel.size() == 7);
+			REQUIRE(raw_parallel == raw_sequential);
+			REQUIRE(pos_parallel == pos_sequential);
+			REQUIRE(lines_ends_parallel == lines_ends_sequential);
+			REQUIRE(parallel.z() == sequential.z());
+		}
+	}
+	GIVEN("a callback quitting the parsing after three lines") {
+		auto quit_after_three = [](std::vector<std::string> &raw) {
+			return [&raw](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+				raw.emplace_back(line.raw());
+				if (raw.size() == 3)
+					reader.quit_parsing();
+			};
+		};
+		std::vector<std::string> raw_sequential, raw_parallel;
+		std::vector<size_t>      lines_ends_sequential, lines_ends_parallel;
+		GCodeReader sequential, parallel;
+		sequential.parse_file(path, quit_after_three(raw_sequential), lines_ends_sequential);
+		parallel.parse_file_parallel(path, quit_after_three(raw_parallel), lines_ends_parallel, 8);
+		THEN("the parallel parsing stops at the same line") {
+			REQUIRE(raw_parallel.size() == 3);
+			REQUIRE(raw_parallel == raw_sequential);
+		}
+	}
+	boost::filesystem::remove(path);
+}
+
+SCENARIO("Binary G-code", "[GCode]") {
+	const std::string header    = "; HEADER_BLOCK_START\n; generated by test\n; HEADER_BLOCK_END\n\n";
+	const std::string thumbnail = "; THUMBNAIL_BLOCK_START\n\n;\n; thumbnail begin 2x3 12\n; UE5HREFUQQ==\n; thumbnail end\n; THUMBNAIL_BLOCK_END\n";
+	const std::string start     = "\nG28\nG1 Z5 F3000\n";
+	const std::string config    = "; CONFIG_BLOCK_START\n; layer_height = 0.2\n; CONFIG_BLOCK_END\n";
+	std::vector<std::string> layers;
+	for (int i = 0; i < 5; ++ i) {
+		std::string layer = ";LAYER_CHANGE\n;Z:" + std::to_string(0.2 * (i + 1)) + "\n";
+		for (int j = 0; j < 10; ++ j)
+			layer += "G1 X" + std::to_string(10 + j) + " Y" + std::to_string(20 + i) + " E" + std::to_string(0.1 * j) + "\n";
+		layers.emplace_back(std::move(layer));
+	}
+	std::string gcode = header + thumbnail + start;
+	for (const std::string &layer : layers)
+		gcode += layer;
+	gcode += config;
+
+	const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("binary_gcode_%%%%-%%%%.bgcode")).string();
+	GIVEN("a G-code written in short chunks into small blocks") {
+		{
+			BinaryGCodeWriter writer(path, 128);
+			writer.add_metadata(BinaryGCodeBlockType::PrintMetadata, "; total layer number: 5\n");
+			for (size_t i = 0; i < gcode.size(); i += 7)
+				writer.append_gcode(std::string_view(gcode).substr(i, 7));
+			writer.finish();
+		}
+		BinaryGCodeReader reader(path);
+		THEN("the G-code blocks hold the G-code without the thumbnail and config blocks") {
+			REQUIRE(BinaryGCodeReader::is_binary_gcode(path));
+			REQUIRE(reader.gcode_blocks_count() > 1);
+			std::string decoded;
+			for (size_t i = 0; i < reader.gcode_blocks_count(); ++ i)
+				decoded += reader.gcode_block(i);
+			REQUIRE(decoded == gcode.substr(0, gcode.size() - config.size()).erase(header.size(), thumbnail.size()));
+		}
+		THEN("any range of the G-code text is read, including ranges spanning several blocks") {
+			const std::string decoded = gcode.substr(0, gcode.size() - config.size()).erase(header.size(), thumbnail.size());
+			REQUIRE(reader.gcode_size() == decoded.size());
+			for (size_t offset : { size_t(0), size_t(5), size_t(127), size_t(200) })
+				for (size_t size : { size_t(0), size_t(1), size_t(64), size_t(300) })
+					if (offset + size <= decoded.size())
+						REQUIRE(reader.gcode_text(offset, size) == decoded.substr(offset, size));
+			REQUIRE(reader.gcode_text(0, decoded.size()) == decoded);
+		}
+		THEN("the blocks parsed in parallel give the lines and line ends of the G-code text as a text file") {
+			const std::string text_path = path + ".gcode";
+			{
+				boost::nowide::ofstream ofs(text_path, std::ios::binary);
+				ofs << gcode.substr(0, gcode.size() - config.size()).erase(header.size(), thumbnail.size());
+			}
+			std::vector<std::string> raw_text, raw_blocks;
+			std::vector<size_t>      lines_ends_text, lines_ends_blocks;
+			GCodeReader text, blocks;
+			text.parse_file_parallel(text_path, [&raw_text](GCodeReader&, const GCodeReader::GCodeLine &line) { raw_text.emplace_back(line.raw()); }, lines_ends_text);
+			blocks.parse_chunks_parallel(reader.gcode_blocks_count(), [&reader](size_t idx) { return reader.gcode_block(idx); },
+				[&raw_blocks](GCodeReader&, const GCodeReader::GCodeLine &line) { raw_blocks.emplace_back(line.raw()); }, lines_ends_blocks);
+			boost::filesystem::remove(text_path);
+			REQUIRE(raw_blocks == raw_text);
+			REQUIRE(lines_ends_blocks == lines_ends_text);
+		}
+		THEN("the metadata, config and thumbnail are blocks of their own") {
+			REQUIRE(reader.metadata(BinaryGCodeBlockType::PrintMetadata) == "; total layer number: 5\n");
+			REQUIRE(reader.metadata(BinaryGCodeBlockType::SlicerConfig) == config);
+			std::vector<BinaryGCodeThumbnail> thumbnails = reader.thumbnails();
+			REQUIRE(thumbnails.size() == 1);
+			REQUIRE(thumbnails.front().tag == "thumbnail");
+			REQUIRE(thumbnails.front().width == 2);
+			REQUIRE(thumbnails.front().height == 3);
+			REQUIRE(thumbnails.front().data == "PNGDATA");
+		}
+	}
+	boost::filesystem::remove(path);
+}
+
+SCENARIO("Binary G-code output file name", "[GCode]") {
+	DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+	config.set_deserialize_strict({ { "filename_format", "{input_filename_base}.gcode" } });
+	GIVEN("a print with the binary G-code container disabled") {
+		Print print;
+		Model model;
+		Test::init_print({ Test::TestMesh::cube_20x20x20 }, print, model, config);
+		THEN("the output keeps the G-code extension") {
+			REQUIRE(boost::filesystem::path(print.output_filename("cube")).extension() == ".gcode");
+		}
+	}
+	GIVEN("a print with the binary G-code container enabled") {
+		config.set_deserialize_strict({ { "orca_binary_gcode", 1 } });
+		Print print;
+		Model model;
+		Test::init_print({ Test::TestMesh::cube_20x20x20 }, print, model, config);
+		THEN("the output gets the extension of the container, whatever the filename format") {
+			REQUIRE(boost::filesystem::path(print.output_filename("cube")).extension() == BINARY_GCODE_EXTENSION);
+		}
+	}
+}
+
+SCENARIO("Incremental G-code export", "[GCode]") {
+	DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+	config.set_deserialize_strict({ { "layer_height", 0.2 } });
+	Print print;
+	Model model;
+	Test::init_print({ Test::TestMesh::cube_20x20x20 }, print, model, config);
+	print.enable_gcode_export_cache(true);
+	const std::string first = Test::gcode_without_timestamp(Test::gcode(print));
+	GIVEN("a print exported with the G-code export cache enabled") {
+		WHEN("it is exported again without a change") {
+			const std::string cached = Test::gcode_without_timestamp(Test::gcode(print));
+			THEN("the G-code spliced from the cache is the same") {
+				REQUIRE(cached == first);
+			}
+		}
+		WHEN("a pause is added at half of the height") {
+			model.plates_custom_gcodes[model.curr_plate_index] = { CustomGCode::SingleExtruder, { { 10., CustomGCode::PausePrint, 1, "", "" } } };
+			print.apply(model, config);
+			const std::string incremental = Test::gcode_without_timestamp(Test::gcode(print));
+			print.enable_gcode_export_cache(false);
+			const std::string full = Test::gcode_without_timestamp(Test::gcode(print));
+			THEN("the G-code is the same as the G-code exported without the cache") {
+				REQUIRE(incremental != first);
+				REQUIRE(incremental == full);
+			}
+		}
+	}
+}
+
+SCENARIO("G-code export stats", "[GCode]") {
+	GIVEN("stats of a stage measured twice with allocations counted in between") {
+		GCodeExportStats stats;
+		for (int i = 0; i < 2; ++ i) {
+			auto timer = stats.measure(GCodeExportStats::CoolingParse);
+			AllocationCounters &counters = thread_allocation_counters();
+			counters.allocations += 3;
+			counters.bytes       += 100;
+		}
+		THEN("the calls and allocations are summed for the stage only") {
+			REQUIRE(stats.stage(GCodeExportStats::CoolingParse).calls == 2);
+			REQUIRE(stats.stage(GCodeExportStats::CoolingParse).allocations == 6);
+			REQUIRE(stats.stage(GCodeExportStats::CoolingParse).bytes == 200);
+			REQUIRE(stats.stage(GCodeExportStats::Generate).calls == 0);
+		}
+		THEN("stats are added up") {
+			GCodeExportStats total(stats);
+			total += stats;
+			REQUIRE(total.stage(GCodeExportStats::CoolingParse).calls == 4);
+			total.reset();
+			REQUIRE(total.stage(GCodeExportStats::CoolingParse).calls == 0);
+		}
+	}
+}
+
+SCENARIO("Batched time block solver", "[GCode]") {
+	GIVEN("blocks accelerating, cruising, decelerating, too short to cruise and without acceleration") {
+		std::vector<GCodeProcessor::TimeBlock> blocks;
+		auto add_block = [&blocks](float entry, float cruise, float exit, float acceleration, float distance) {
+			GCodeProcessor::TimeBlock block;
+			block.feedrate_profile = { entry, cruise, exit };
+			block.acceleration     = acceleration;
+			block.distance         = distance;
+			blocks.emplace_back(block);
+		};
+		add_block(0.f, 100.f, 0.f, 1000.f, 50.f);
+		add_block(20.f, 200.f, 20.f, 1000.f, 2.f);
+		add_block(50.f, 50.f, 50.f, 1000.f, 10.f);
+		add_block(10.f, 150.f, 80.f, 2500.f, 0.5f);
+		add_block(30.f, 60.f, 30.f, 0.f, 5.f);
+		add_block(0.f, 0.f, 0.f, 1000.f, 0.f);
+		add_block(120.f, 120.f, 0.f, 500.f, 3.f);
+		GCodeProcessor::TimeBlockBatch batch;
+		for (const GCodeProcessor::TimeBlock &block : blocks)
+			batch.append(block);
+		std::vector<float> times;
+		batch.solve(times);
+		THEN("the times are the same as of the blocks solved one by one") {
+			REQUIRE(times.size() == blocks.size());
+			for (size_t i = 0; i < blocks.size(); ++ i) {
+				blocks[i].calculate_trapezoid();
+				REQUIRE(times[i] == blocks[i].time());
+			}
+		}
+	}
+}
@@ -3,6 +3,9 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include <boost/filesystem.hpp>
 
 #include "test_data.hpp"
 
@@ -138,3 +141,205 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: Cached slicing data", "[Print]") {
+    GIVEN("sliced 20mm cube") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.process();
+        const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orca-slice-cache-%%%%-%%%%");
+        WHEN("the layers are exported to the binary cache and loaded by another print") {
+            REQUIRE(print.export_cached_data(dir.string()) == 0);
+            Slic3r::Print loaded;
+            loaded.apply(model, config);
+            loaded.set_status_silent();
+            int ret = loaded.load_cached_data(dir.string());
+            boost::filesystem::remove_all(dir);
+            THEN("the layers, their slices and extrusions are restored") {
+                REQUIRE(ret == 0);
+                const PrintObject &object = *print.objects().front();
+                const PrintObject &loaded_object = *loaded.objects().front();
+                REQUIRE(loaded_object.layer_count() == object.layer_count());
+                REQUIRE(loaded_object.support_layer_count() == object.support_layer_count());
+                for (size_t i = 0; i < object.layer_count(); ++ i) {
+                    const Layer &layer = *object.layers()[i];
+                    const Layer &loaded_layer = *loaded_object.layers()[i];
+                    CHECK(loaded_layer.print_z == layer.print_z);
+                    CHECK(area(loaded_layer.lslices) == area(layer.lslices));
+                    REQUIRE(loaded_layer.region_count() == layer.region_count());
+                    for (size_t r = 0; r < layer.region_count(); ++ r) {
+                        CHECK(loaded_layer.get_region(int(r))->perimeters.flatten().entities.size() == layer.get_region(int(r))->perimeters.flatten().entities.size());
+                        CHECK(loaded_layer.get_region(int(r))->fills.flatten().total_volume() == Approx(layer.get_region(int(r))->fills.flatten().total_volume()));
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Slice cache", "[Print]") {
+    GIVEN("20mm cube sliced with an empty slice cache") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        // Grid infill is not reversible.
+        config.set_deserialize_strict({ { "sparse_infill_pattern", "grid" } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orca-slice-cache-%%%%-%%%%");
+        Slic3r::ScopeGuard remove_dir([&dir]() { boost::filesystem::remove_all(dir); });
+        print.set_slice_cache_dir(dir.string());
+        print.process();
+        const std::string key = print.objects().front()->slice_cache_key();
+        THEN("the layers of the object are stored in the cache") {
+            REQUIRE(print.slice_cache_hits() == 0);
+            REQUIRE(boost::filesystem::exists(dir / (key + ".bin")));
+        }
+        WHEN("the same model is sliced by another print") {
+            Slic3r::Print cached;
+            cached.set_slice_cache_dir(dir.string());
+            cached.apply(model, config);
+            cached.set_status_silent();
+            cached.process();
+            THEN("the object is loaded from the cache and gets the same layers") {
+                const PrintObject &object = *print.objects().front();
+                const PrintObject &cached_object = *cached.objects().front();
+                REQUIRE(cached.slice_cache_hits() == 1);
+                REQUIRE(cached_object.slice_cache_key() == key);
+                REQUIRE(cached_object.layer_count() == object.layer_count());
+                for (size_t i = 0; i < object.layer_count(); ++ i)
+                    CHECK(area(cached_object.layers()[i]->lslices) == area(object.layers()[i]->lslices));
+            }
+            THEN("the G-code is the same as the G-code of the print sliced without the cache") {
+                REQUIRE(gcode_without_timestamp(Slic3r::Test::gcode(cached)) == gcode_without_timestamp(Slic3r::Test::gcode(print)));
+            }
+        }
+        WHEN("the cache entry is corrupted and the same model is sliced by another print") {
+            {
+                boost::filesystem::fstream f(dir / (key + ".bin"), std::ios::in | std::ios::out | std::ios::binary);
+                f.seekp(-1, std::ios::end);
+                f.put('\x5a');
+            }
+            Slic3r::Print other;
+            other.set_slice_cache_dir(dir.string());
+            other.apply(model, config);
+            other.set_status_silent();
+            other.process();
+            THEN("the entry is refused and the object is sliced again") {
+                REQUIRE(other.slice_cache_hits() == 0);
+                REQUIRE(other.objects().front()->layer_count() == print.objects().front()->layer_count());
+            }
+        }
+        WHEN("an option of the walls changes") {
+            config.set_deserialize_strict({ { "wall_loops", 5 } });
+            Slic3r::Print other;
+            other.apply(model, config);
+            THEN("the object gets another key") {
+                REQUIRE(other.objects().front()->slice_cache_key() != key);
+            }
+        }
+        WHEN("the least recently used entry does not fit into the size limit of the cache") {
+            Slic3r::DynamicPrintConfig other_config = config;
+            other_config.set_deserialize_strict({ { "wall_loops", 5 } });
+            Slic3r::Print other;
+            other.set_slice_cache_dir(dir.string());
+            other.apply(model, other_config);
+            other.set_status_silent();
+            other.process();
+            const boost::filesystem::path other_path = dir / (other.objects().front()->slice_cache_key() + ".bin");
+            REQUIRE(boost::filesystem::exists(other_path));
+            boost::filesystem::last_write_time(other_path, boost::filesystem::last_write_time(other_path) - 3600);
+            Slic3r::Print cached;
+            cached.set_slice_cache_dir(dir.string());
+            cached.set_slice_cache_max_size(size_t(boost::filesystem::file_size(dir / (key + ".bin"))));
+            cached.apply(model, config);
+            cached.set_status_silent();
+            cached.process();
+            THEN("it is removed and the entry just used is kept") {
+                REQUIRE(cached.slice_cache_hits() == 1);
+                REQUIRE(boost::filesystem::exists(dir / (key + ".bin")));
+                REQUIRE(! boost::filesystem::exists(other_path));
+            }
+        }
+        WHEN("an option of the G-code export only changes") {
+            config.set_deserialize_strict({ { "machine_start_gcode", "G28 ; home" } });
+            Slic3r::Print other;
+            other.apply(model, config);
+            THEN("the object keeps its key") {
+                REQUIRE(other.objects().front()->slice_cache_key() == key);
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Tree support of an object from the slice cache", "[Print]") {
+    GIVEN("overhang with tree support and a skirt sliced with an empty slice cache") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "enable_support", 1 }, { "support_type", "tree(auto)" }, { "skirt_loops", 1 }, { "skirt_height", 1 } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::overhang}, print, model, config);
+        const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orca-slice-cache-%%%%-%%%%");
+        Slic3r::ScopeGuard remove_dir([&dir]() { boost::filesystem::remove_all(dir); });
+        print.set_slice_cache_dir(dir.string());
+        print.process();
+        WHEN("the skirt height changes and the model is sliced with and without the cache") {
+            config.set_deserialize_strict({ { "skirt_height", 3 } });
+            Slic3r::Print cached;
+            cached.set_slice_cache_dir(dir.string());
+            cached.apply(model, config);
+            const std::string cached_gcode = gcode_without_timestamp(Slic3r::Test::gcode(cached));
+            Slic3r::Print fresh;
+            fresh.apply(model, config);
+            const std::string fresh_gcode = gcode_without_timestamp(Slic3r::Test::gcode(fresh));
+            THEN("the object is loaded from the cache and the G-code is the same") {
+                REQUIRE(cached.slice_cache_hits() == 1);
+                REQUIRE(! cached.objects().front()->support_layers().empty());
+                REQUIRE(cached_gcode == fresh_gcode);
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Adaptive cubic octree in the slice cache", "[Print]") {
+    GIVEN("20mm cube with adaptive cubic infill sliced with an empty slice cache") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "sparse_infill_pattern", "adaptivecubic" }, { "sparse_infill_density", "20%" } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orca-slice-cache-%%%%-%%%%");
+        Slic3r::ScopeGuard remove_dir([&dir]() { boost::filesystem::remove_all(dir); });
+        print.set_slice_cache_dir(dir.string());
+        print.process();
+        auto num_octrees = [&dir]() {
+            size_t cnt = 0;
+            for (const boost::filesystem::directory_entry &entry : boost::filesystem::directory_iterator(dir))
+                cnt += entry.path().extension() == ".octree";
+            return cnt;
+        };
+        THEN("the octree is stored in the cache") {
+            REQUIRE(num_octrees() == 1);
+        }
+        WHEN("an option not affecting the octree changes and the model is sliced by another print") {
+            config.set_deserialize_strict({ { "sparse_infill_speed", "123" }, { "infill_direction", "30" } });
+            Slic3r::Print other;
+            other.set_slice_cache_dir(dir.string());
+            other.apply(model, config);
+            other.set_status_silent();
+            other.process();
+            THEN("the object is sliced again with the cached octree and gets the same infill") {
+                const PrintObject &object = *print.objects().front();
+                const PrintObject &other_object = *other.objects().front();
+                REQUIRE(other_object.slice_cache_key() != object.slice_cache_key());
+                REQUIRE(num_octrees() == 1);
+                REQUIRE(other_object.layer_count() == object.layer_count());
+                for (size_t i = 0; i < object.layer_count(); ++ i)
+                    for (size_t r = 0; r < object.layers()[i]->region_count(); ++ r)
+                        CHECK(other_object.layers()[i]->get_region(int(r))->fills.flatten().total_volume() ==
+                              Approx(object.layers()[i]->get_region(int(r))->fills.flatten().total_volume()));
+            }
+        }
+    }
+}
@@ -3,6 +3,7 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Utils.hpp"
 
 #include "test_data.hpp"
 
@@ -87,3 +88,63 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject]") {
 #endif
     }
 }
+
+SCENARIO("PrintObject: fill surfaces processed in parallel match the serial processing", "[PrintObject]") {
+    GIVEN("20mm cube with a modifier of a denser infill and fewer shells over a quarter of its upper half") {
+        // Types and shapes of the fill surfaces of each layer region.
+        using FillSurfaces = std::vector<std::vector<std::pair<SurfaceType, ExPolygon>>>;
+        auto fill_surfaces = [](bool serial) {
+            DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+            config.set_deserialize_strict({
+                { "layer_height",                    0.2 },
+                { "sparse_infill_density",           "15%" },
+                { "top_shell_layers",                5 },
+                { "bottom_shell_layers",             4 },
+                { "ensure_vertical_shell_thickness", "ensure_moderate" },
+                { "infill_combination",              1 }
+            });
+            DynamicPrintConfig modifier_config;
+            modifier_config.set_deserialize_strict({
+                { "sparse_infill_density",           "40%" },
+                { "top_shell_layers",                3 }
+            });
+            Slic3r::Print print;
+            Slic3r::Model model;
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+            ModelObject *object   = model.objects.front();
+            ModelVolume *modifier = object->add_volume(make_cube(10., 10., 10.), ModelVolumeType::PARAMETER_MODIFIER);
+            modifier->set_offset(object->volumes.front()->get_offset() + Vec3d(5., 5., 5.));
+            modifier->config.apply(modifier_config);
+            print.apply(model, config);
+
+            print.get_object(0)->set_serial_fill_surfaces(serial);
+            // Enables clip_fill_surfaces(). The switch is process wide, restore it even if the processing throws.
+            Slic3r::ScopeGuard restore_switch([]() { PrintObject::infill_only_where_needed = false; });
+            PrintObject::infill_only_where_needed = true;
+            print.process();
+
+            FillSurfaces out;
+            for (const Layer *layer : print.objects().front()->layers())
+                for (const LayerRegion *layerm : layer->regions()) {
+                    std::vector<std::pair<SurfaceType, ExPolygon>> &surfaces = out.emplace_back();
+                    for (const Surface &surface : layerm->fill_surfaces.surfaces)
+                        surfaces.emplace_back(surface.surface_type, surface.expolygon);
+                }
+            return out;
+        };
+        WHEN("the object is sliced with the parallel and with the serial processing of the fill surfaces") {
+            const FillSurfaces parallel = fill_surfaces(false);
+            const FillSurfaces serial   = fill_surfaces(true);
+            THEN("Both have the same layer regions") {
+                REQUIRE(parallel.size() == serial.size());
+                REQUIRE(parallel.size() > 100);
+            }
+            THEN("The fill surfaces of each layer region are the same") {
+                for (size_t i = 0; i < std::min(parallel.size(), serial.size()); ++ i) {
+                    INFO("Layer region " << i);
+                    REQUIRE(parallel[i] == serial[i]);
+                }
+            }
+        }
+    }
+}
@@ -10,6 +10,7 @@
 #include "libslic3r/Geometry/ConvexHull.hpp"
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/ShortestPath.hpp"
+#include "libslic3r/ArcFitter.hpp"
 
 //#include <random>
 //#include "libnest2d/tools/benchmark.h"
@@ -286,6 +287,46 @@ TEST_CASE("smallest_enclosing_circle_welzl", "[Geometry]") {
     REQUIRE(num_on_boundary == 3);
 }
 
+SCENARIO("Arc fitting", "[Geometry]") {
+    auto same_fitting = [](const std::vector<PathFittingData> &lhs, const std::vector<PathFittingData> &rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const PathFittingData &l, const PathFittingData &r) {
+            return l.start_point_index == r.start_point_index && l.end_point_index == r.end_point_index && l.path_type == r.path_type &&
+                   l.arc_data.center == r.arc_data.center && l.arc_data.radius == r.arc_data.radius && l.arc_data.angle_radians == r.arc_data.angle_radians;
+        });
+    };
+    GIVEN("Paths of arcs, of a wavy line and of an arc with noise and repeated points") {
+        std::vector<Points> paths(3);
+        for (int i = 0; i < 200; ++ i) {
+            double a = 0.03 * i;
+            paths[0].emplace_back(Point::new_scale(20. * cos(a), 20. * sin(a)));
+            if (i == 100)
+                // Tangent discontinuity between two arcs.
+                paths[0].emplace_back(Point::new_scale(20. * cos(a), 20. * sin(a) - 5.));
+            paths[1].emplace_back(Point::new_scale(0.5 * i, 2. * sin(0.2 * i)));
+            paths[2].emplace_back(Point::new_scale(15. * cos(a) + 0.02 * sin(7. * i), 15. * sin(a) + 0.02 * cos(5. * i)));
+            if (i % 13 == 0)
+                paths[2].emplace_back(paths[2].back());
+        }
+        WHEN("the paths are fitted by the batched and by the pointwise fitter") {
+            THEN("both fit the same arcs and lines") {
+                for (double tolerance : { scaled<double>(0.0125), scaled<double>(0.05) })
+                    for (const Points &path : paths) {
+                        std::vector<PathFittingData> batched, pointwise;
+                        ArcFitter::do_arc_fitting(path, batched, tolerance);
+                        ArcFitter::do_arc_fitting_pointwise(path, pointwise, tolerance);
+                        REQUIRE(! batched.empty());
+                        REQUIRE(same_fitting(batched, pointwise));
+                    }
+            }
+            THEN("the arcs are fitted as arc moves") {
+                std::vector<PathFittingData> result;
+                ArcFitter::do_arc_fitting(paths[0], result, scaled<double>(0.0125));
+                REQUIRE(std::count_if(result.begin(), result.end(), [](PathFittingData &data) { return data.is_arc_move(); }) >= 2);
+            }
+        }
+    }
+}
+
 SCENARIO("Path chaining", "[Geometry]") {
 	GIVEN("A path") {
 		Points points = { Point(26,26),Point(52,26),Point(0,26),Point(26,52),Point(26,0),Point(0,52),Point(52,52),Point(52,0) };
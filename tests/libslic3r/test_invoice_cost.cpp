@@ -0,0 +1,287 @@
+#include <catch2/catch.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "libslic3r/Exception.hpp"
+#include "libslic3r/InvoiceCost.hpp"
+#include "libslic3r/InvoiceEstimate.hpp"
+#include "libslic3r/InvoiceJobStore.hpp"
+#include "libslic3r/InvoiceSweep.hpp"
+#include "libslic3r/PrintConfig.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/GCode/GCodeMetadata.hpp"
+
+using namespace Slic3r;
+
+TEST_CASE("Invoice print time parsing", "[Invoice]") {
+    REQUIRE(invoice_time_to_hours("") == Approx(0.));
+    REQUIRE(invoice_time_to_hours("45s") == Approx(45. / 3600.));
+    REQUIRE(invoice_time_to_hours("2h 30m 0s") == Approx(2.5));
+    REQUIRE(invoice_time_to_hours("1d 1h 0m 36s") == Approx(25.01));
+}
+
+TEST_CASE("Invoice quote", "[Invoice]") {
+    InvoiceJobProfile job;
+    job.parts_per_plate = 4;
+    job.num_plates      = 2;
+    job.failure_rate    = 0.;
+    job.markup_percent  = 50.;
+
+    InvoiceFilamentUsage pla;
+    pla.extruder_id = 0;
+    pla.weight_g    = 200.;
+    pla.cost_per_kg = 25.;
+
+    SECTION("cost breakdown of one plate") {
+        InvoiceQuote quote = calculate_invoice_quote(job, 10., { pla });
+        REQUIRE(quote.material_cost == Approx(5.));
+        // prep 15 + setup 10 + 4 * 5 finishing minutes at 20 per hour
+        REQUIRE(quote.labor_cost == Approx(15.));
+        // depreciation 0.02 + maintenance 0.1 + power 0.0195 per hour
+        REQUIRE(quote.machine_cost == Approx(1.395));
+        // bed wear 10 * 30 / 5000, nozzle wear 0.2 kg * 2 / 25
+        REQUIRE(quote.tooling_cost == Approx(0.076));
+        REQUIRE(quote.subtotal == Approx(21.471));
+        REQUIRE(quote.failure_adjustment == Approx(0.));
+        REQUIRE(quote.cost_per_part == Approx(21.471 / 4.));
+        REQUIRE(quote.final_price == Approx(1.5 * 21.471 / 4.));
+        REQUIRE(quote.total_parts == 8);
+        REQUIRE(quote.total_job_cost == Approx(8. * 1.5 * 21.471 / 4.));
+    }
+    SECTION("failure rate scales the plate cost") {
+        job.failure_rate = 20.;
+        InvoiceQuote quote = calculate_invoice_quote(job, 10., { pla });
+        REQUIRE(quote.subtotal + quote.failure_adjustment == Approx(quote.subtotal / 0.8));
+    }
+    SECTION("job profile overrides the filament cost") {
+        job.filament_costs[0] = 50.;
+        InvoiceQuote quote = calculate_invoice_quote(job, 0., { pla });
+        REQUIRE(quote.filaments.front().cost_per_kg == Approx(50.));
+        REQUIRE(quote.material_cost == Approx(10.));
+    }
+}
+
+TEST_CASE("Invoice job profile JSON round trip", "[Invoice]") {
+    InvoiceJobProfile job;
+    job.customer_name     = "ACME";
+    job.parts_per_plate   = 12;
+    job.labor_rate        = 42.5;
+    job.filament_costs[2] = 31.;
+
+    InvoiceJobProfile loaded = invoice_job_profile_from_json(invoice_job_profile_to_json(job));
+    REQUIRE(loaded.customer_name == "ACME");
+    REQUIRE(loaded.parts_per_plate == 12);
+    REQUIRE(loaded.labor_rate == Approx(42.5));
+    REQUIRE(loaded.filament_costs.at(2) == Approx(31.));
+
+    // Missing keys keep their defaults.
+    InvoiceJobProfile partial = invoice_job_profile_from_json(nlohmann::json::parse(R"({ "markup_percent": 10 })"));
+    REQUIRE(partial.markup_percent == Approx(10.));
+    REQUIRE(partial.printer_cost == Approx(InvoiceJobProfile().printer_cost));
+}
+
+TEST_CASE("Invoice from embedded G-code statistics", "[Invoice]") {
+    GCodeMetadata metadata;
+    parse_gcode_metadata(
+        "; HEADER_BLOCK_START\n"
+        "; total layer number: 120\n"
+        "; filament_density: 1.24,1.27\n"
+        "; HEADER_BLOCK_END\n"
+        "G1 X10 Y10 E1 ; not metadata = 1\n"
+        "; EXECUTABLE_BLOCK_END\n"
+        "; filament used [mm] = 1000.00, 0, 50.00\n"
+        "; filament used [cm3] = 2.40, 0, 0.12\n"
+        "; filament used [g] = 2.98, 0, 0.15\n"
+        "; total filament used [g] = 3.13\n"
+        "; estimated printing time (normal mode) = 1h 30m 0s\n"
+        "; CONFIG_BLOCK_START\n"
+        "; filament_colour = #FF0000;#00FF00;#0000FF\n"
+        "; filament_cost = 20,30,40\n"
+        "; filament_settings_id = \"PLA\";\"PETG\";\"TPU\"\n"
+        "; CONFIG_BLOCK_END\n",
+        metadata);
+
+    REQUIRE(metadata.total_layers == 120);
+    REQUIRE(metadata.filament_used_g.size() == 3);
+    REQUIRE(metadata.total_filament_used_g == Approx(3.13));
+    REQUIRE(metadata.print_time_hours() == Approx(1.5));
+    REQUIRE(metadata.filament_density.size() == 2);
+
+    std::vector<InvoiceFilamentUsage> usage = invoice_filament_usage(metadata);
+    REQUIRE(usage.size() == 2);
+    REQUIRE(usage[1].extruder_id == 2);
+    REQUIRE(usage[1].name == "TPU");
+    REQUIRE(usage[1].color == "#0000FF");
+    REQUIRE(usage[1].cost_per_kg == Approx(40.));
+    REQUIRE(usage[1].weight_g == Approx(0.15));
+
+    SECTION("BBL printers put the print time into the header") {
+        GCodeMetadata bbl;
+        parse_gcode_metadata("; model printing time: 1h 0m 0s; total estimated time: 1h 6m 0s\n"
+                             "; filament used [g] = 1.00\n", bbl);
+        REQUIRE(bbl.print_time_hours() == Approx(1.1));
+    }
+}
+
+TEST_CASE("Invoice split between the objects of a plate", "[Invoice]") {
+    InvoiceJobProfile job;
+    job.markup_percent = 100.;
+
+    InvoiceFilamentUsage pla;
+    pla.extruder_id = 0;
+    pla.weight_g    = 110.;
+    pla.cost_per_kg = 20.;
+    InvoiceQuote quote = calculate_invoice_quote(job, 3., { pla });
+
+    InvoiceObjectUsage small, big;
+    small.name             = "small";
+    small.print_time_hours = 1.;
+    small.filaments        = { pla };
+    small.filaments.front().weight_g = 25.;
+    big.name             = "big";
+    big.print_time_hours = 1.5;
+    big.filaments        = { pla };
+    big.filaments.front().weight_g = 75.;
+
+    std::vector<InvoiceObjectCost> costs = calculate_invoice_object_costs(quote, job, { small, big });
+    REQUIRE(costs.size() == 2);
+    // Unlabeled filament and time are spread proportionally.
+    REQUIRE(costs[0].material_cost == Approx(quote.material_cost * 0.25));
+    REQUIRE(costs[1].machine_cost == Approx((quote.machine_cost + quote.tooling_cost) * 0.6));
+    REQUIRE(costs[0].labor_cost == Approx(quote.labor_cost / 2.));
+    REQUIRE(costs[0].subtotal + costs[1].subtotal == Approx(quote.subtotal));
+    REQUIRE(costs[0].price + costs[1].price == Approx(quote.final_price * job.parts_per_plate));
+}
+
+TEST_CASE("Invoice of all plates of a project", "[Invoice]") {
+    InvoiceJobProfile job;
+    job.num_plates = 1;
+
+    InvoiceFilamentUsage pla;
+    pla.extruder_id = 0;
+    pla.weight_g    = 100.;
+    pla.cost_per_kg = 20.;
+    InvoiceFilamentUsage petg = pla;
+    petg.extruder_id = 1;
+
+    InvoiceJobProfile plate1_job = job;
+    plate1_job.parts_per_plate = 2;
+    InvoiceJobProfile plate2_job = job;
+    plate2_job.parts_per_plate = 6;
+    std::vector<InvoicePlateQuote> plates = {
+        { 1, "plate_1.gcode", calculate_invoice_quote(plate1_job, 2., { pla }) },
+        { 2, "plate_2.gcode", calculate_invoice_quote(plate2_job, 5., { pla, petg }) },
+    };
+
+    InvoiceQuote quote = sum_invoice_plate_quotes(job, plates);
+    REQUIRE(quote.total_parts == 8);
+    REQUIRE(quote.print_time_hours == Approx(7.));
+    REQUIRE(quote.filaments.size() == 2);
+    REQUIRE(quote.filaments.front().weight_g == Approx(200.));
+    REQUIRE(quote.material_cost == Approx(6.));
+    REQUIRE(quote.subtotal == Approx(plates[0].quote.subtotal + plates[1].quote.subtotal));
+    REQUIRE(quote.total_job_cost == Approx(plates[0].quote.total_job_cost + plates[1].quote.total_job_cost));
+}
+
+TEST_CASE("Invoice job profile store", "[Invoice]") {
+    const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("invoice_jobs_%%%%-%%%%.jsonl")).string();
+
+    InvoiceJobProfile job;
+    job.customer_name   = "ACME";
+    job.parts_per_plate = 3;
+    {
+        InvoiceJobStore store(path);
+        REQUIRE(store.empty());
+        store.save("acme\tbrackets", job);
+        job.parts_per_plate = 5;
+        store.save("acme\tbrackets", job);
+        store.save("other", InvoiceJobProfile());
+        REQUIRE(store.erase("other"));
+        REQUIRE(! store.erase("other"));
+        REQUIRE(store.load("acme\tbrackets")->parts_per_plate == 5);
+    }
+
+    SECTION("the index is rebuilt from the file") {
+        InvoiceJobStore store(path);
+        REQUIRE(store.names() == std::vector<std::string>{ "acme\tbrackets" });
+        REQUIRE(store.load("acme\tbrackets")->customer_name == "ACME");
+        REQUIRE(store.load("acme\tbrackets")->parts_per_plate == 5);
+        REQUIRE(! store.load("other"));
+    }
+    SECTION("compaction keeps the live profiles") {
+        InvoiceJobStore store(path);
+        for (int i = 0; i < 100; ++ i)
+            store.save("tmp", job);
+        store.compact();
+        REQUIRE(store.size() == 2);
+        REQUIRE(boost::filesystem::file_size(path) < 1024 * 4);
+        REQUIRE(InvoiceJobStore(path).load("tmp")->parts_per_plate == 5);
+    }
+    SECTION("an interrupted append is dropped") {
+        {
+            boost::nowide::ofstream ofs(path, std::ios::binary | std::ios::app);
+            ofs << "\"broken\"\t{\"customer_na";
+        }
+        InvoiceJobStore store(path);
+        REQUIRE(store.names() == std::vector<std::string>{ "acme\tbrackets" });
+        store.save("next", job);
+        REQUIRE(InvoiceJobStore(path).size() == 2);
+    }
+    boost::filesystem::remove(path);
+}
+
+TEST_CASE("Invoice sweep specification", "[Invoice]") {
+    std::vector<InvoiceSweepAxis> axes = parse_invoice_sweep(" sparse_infill_density = 15%, 30%,50% ; layer_height=0.2,0.28;");
+    REQUIRE(axes.size() == 2);
+    REQUIRE(axes[0].opt_key == "sparse_infill_density");
+    REQUIRE(axes[0].values == std::vector<std::string>{ "15%", "30%", "50%" });
+    REQUIRE(axes[1].opt_key == "layer_height");
+    REQUIRE(axes[1].values.size() == 2);
+
+    REQUIRE(parse_invoice_sweep("").empty());
+    REQUIRE_THROWS_AS(parse_invoice_sweep("layer_height"), RuntimeError);
+    REQUIRE_THROWS_AS(parse_invoice_sweep("no_such_option=1"), RuntimeError);
+    REQUIRE_THROWS_AS(parse_invoice_sweep("layer_height=thick"), RuntimeError);
+}
+
+TEST_CASE("Invoice analytic estimate", "[Invoice]") {
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({ { "layer_height", 0.2 }, { "wall_loops", 2 }, { "top_shell_layers", 4 }, { "bottom_shell_layers", 4 },
+                                    { "top_shell_thickness", 0 }, { "bottom_shell_thickness", 0 }, { "sparse_infill_density", "20%" } });
+    InvoiceEstimator estimator(config);
+    InvoiceEstimateFeatures cube = estimator.features(its_make_cube(20., 20., 20.));
+    REQUIRE(cube.volume_mm3 == Approx(8000.));
+    REQUIRE(cube.layers == Approx(100.));
+    REQUIRE(cube.solid_infill_mm3 == Approx(2. * 400. * 4. * 0.2));
+    REQUIRE(cube.sparse_infill_mm3 == Approx(0.2 * (8000. - cube.perimeter_mm3 - cube.solid_infill_mm3)));
+    REQUIRE(cube.perimeter_time_s > 0.);
+
+    InvoiceEstimate estimate = estimator.estimate(cube);
+    REQUIRE(estimate.extruded_volume_mm3 < cube.volume_mm3);
+    REQUIRE(estimate.print_time_s > cube.perimeter_time_s + cube.solid_infill_time_s + cube.sparse_infill_time_s);
+
+    SECTION("calibration recovers the coefficients of consistent samples") {
+        InvoiceEstimateCoefficients truth;
+        truth.volume = { 1.1, 0.9, 1.3 };
+        truth.time   = { 1.5, 1.2, 2.0, 3.0, 300. };
+        std::vector<InvoiceEstimateSample> samples;
+        for (int i = 1; i <= 200; ++ i) {
+            InvoiceEstimateFeatures f;
+            f.perimeter_mm3        = 100. * i;
+            f.solid_infill_mm3     = 50. * (i % 7 + 1);
+            f.sparse_infill_mm3    = 30. * (i % 13 + 1);
+            f.perimeter_time_s     = 60. * i;
+            f.solid_infill_time_s  = 40. * (i % 5 + 1);
+            f.sparse_infill_time_s = 20. * (i % 11 + 1);
+            f.layers               = 10. * (i % 17 + 1);
+            f.volume_mm3           = f.perimeter_mm3 + f.solid_infill_mm3 + f.sparse_infill_mm3;
+            samples.push_back({ f, InvoiceEstimator(config, truth).estimate(f).extruded_volume_mm3, InvoiceEstimator(config, truth).estimate(f).print_time_s });
+        }
+        InvoiceEstimateCoefficients fitted = fit_invoice_estimate(samples);
+        for (size_t i = 0; i < 3; ++ i)
+            REQUIRE(fitted.volume[i] == Approx(truth.volume[i]).epsilon(0.1));
+        for (size_t i = 0; i < 5; ++ i)
+            REQUIRE(fitted.time[i] == Approx(truth.time[i]).epsilon(0.1));
+    }
+}